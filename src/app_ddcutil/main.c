@@ -52,6 +52,7 @@
 #include "base/core.h"
 #include "base/ddc_errno.h"
 #include "base/ddc_packets.h"
+#include "base/detection_timing.h"
 #include "base/display_retry_data.h"
 #include "base/displays.h"
 #ifdef USE_LIBDRM
@@ -1213,6 +1214,8 @@ main(int argc, char *argv[]) {
       else {     // normal case
          ddc_ensure_displays_detected();
          ddc_report_displays(/*include_invalid_displays=*/ true, 0);
+         if (parsed_cmd->flags & CMD_FLAG_DETECT_TIMINGS)
+            report_detection_timings(0);
       }
 
       rpt_set_ornamentation_enabled(saved_prefix_report_output);
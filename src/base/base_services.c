@@ -13,6 +13,7 @@
 
 #include "core.h"
 #include "ddc_packets.h"
+#include "detection_timing.h"
 #include "displays.h"
 #ifdef USE_LIBDRM
 #include "drm_connector_state.h"
@@ -22,6 +23,7 @@
 #include "execution_stats.h"
 #include "flock.h"
 #include "feature_metadata.h"
+#include "feature_value_cache.h"
 #include "i2c_bus_base.h"
 #include "linux_errno.h"
 #include "monitor_model_key.h"
@@ -30,6 +32,7 @@
 #include "rtti.h"
 #include "sleep.h"
 #include "tuned_sleep.h"
+#include "worker_pool.h"
 
 #include "base_services.h"
 
@@ -44,8 +47,10 @@ void init_base_services() {
    init_monitor_model_key();
    init_base_dynamic_features();
    init_ddc_packets();
+   init_detection_timing();
    init_dsa2();
    init_execution_stats();
+   init_feature_value_cache();
    // init_linux_errno();
    init_per_display_data();
    init_per_thread_data();
@@ -59,6 +64,7 @@ void init_base_services() {
    init_drm_connector_state();
 #endif
    init_flock();
+   init_worker_pool();
 
    DBGF(debug, "Done");
 }
@@ -69,6 +75,7 @@ void terminate_base_services() {
    bool debug = false;
    DBGF(debug, "Starting");
 
+   terminate_worker_pool();
    terminate_per_thread_data();
    terminate_per_display_data();
    terminate_execution_stats();
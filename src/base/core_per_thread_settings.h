@@ -17,7 +17,9 @@
  *
  *   Additionally, struct Thread_Output_Settings maintains the DDCA_Error_Detail
  *   chain for the thread.  This is always initialized to NULL, so requires no
- *   special initialization handling.
+ *   special initialization handling.  To avoid allocation on failure paths, the
+ *   internal Error_Info can be saved instead, and converted to a
+ *   DDCA_Error_Detail only if the client asks for it.
  * */
 
 // Copyright (C)2014 -2022 Sanford Rockowitz <rockowitz@minsoft.com>
@@ -31,12 +33,15 @@
 
 #include "ddcutil_types.h"
 
+struct error_info;
+
 typedef struct {
    FILE *              fout;
    FILE *              ferr;
    DDCA_Output_Level   output_level;
    // bool             report_ddc_errors;  // unused, ddc error reporting left as global
    DDCA_Error_Detail * error_detail;
+   struct error_info * error_info;     // not yet converted to error_detail
    intmax_t            tid;
 } Thread_Output_Settings;
 
@@ -0,0 +1,289 @@
+/** @file detection_timing.c
+ *
+ *  Records the elapsed time of each phase of display detection, per I2C bus,
+ *  and reports the resulting timeline.
+ *
+ *  Phases are recorded only between calls to #dtim_start_detection() and
+ *  #dtim_end_detection().  The records of the most recent detection cycle
+ *  are retained for reporting.  Timestamps use the monotonic clock, so are
+ *  comparable across the threads that check buses in parallel.
+ */
+
+// Copyright (C) 2025 Sanford Rockowitz <rockowitz@minsoft.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/** \cond */
+#include <assert.h>
+#include <glib-2.0/glib.h>
+#include <stdlib.h>
+/** \endcond */
+
+#include "util/report_util.h"
+#include "util/timestamp.h"
+
+#include "base/core.h"
+#include "base/rtti.h"
+
+#include "base/detection_timing.h"
+
+// Trace class for this file
+static DDCA_Trace_Group TRACE_GROUP = DDCA_TRC_BASE;
+
+typedef struct {
+   int        busno;
+   Dtim_Phase phase;
+   uint64_t   start_nanos;
+   uint64_t   end_nanos;
+} Dtim_Record;
+
+static GMutex   dtim_mutex;
+static GArray * dtim_records = NULL;     // array of Dtim_Record
+static bool     dtim_active = false;
+static uint64_t dtim_detection_start = 0;
+static uint64_t dtim_detection_end = 0;
+static int      dtim_detection_ct = 0;
+
+
+static const char * dtim_phase_names[] = {
+      "enumerate buses",
+      "sysfs lookups",
+      "sysfs EDID",
+      "open and flock",
+      "x50 EDID read",
+      "x37 probe",
+      "DPMS check",
+      "DDC check (x10)",
+      "unsupported feature check",
+      "VCP version",
+      "phantom filter",
+};
+static_assert(G_N_ELEMENTS(dtim_phase_names) == DTIM_PHASE_CT, "dtim_phase_names size");
+
+
+const char * dtim_phase_name(Dtim_Phase phase) {
+   return (phase >= 0 && phase < DTIM_PHASE_CT) ? dtim_phase_names[phase] : "unknown";
+}
+
+
+/** Marks the start of a display detection cycle.
+ *  Records from any prior cycle are discarded.
+ *
+ *  If a cycle is already in progress, e.g. one begun by the I2C bus scan
+ *  that precedes display detection, it continues and its records are kept.
+ */
+void dtim_start_detection() {
+   bool debug = false;
+   DBGTRC_STARTING(debug, TRACE_GROUP, "");
+
+   g_mutex_lock(&dtim_mutex);
+   if (dtim_active) {
+      g_mutex_unlock(&dtim_mutex);
+      DBGTRC_DONE(debug, TRACE_GROUP, "Continuing current cycle");
+      return;
+   }
+   if (!dtim_records)
+      dtim_records = g_array_new(false, false, sizeof(Dtim_Record));
+   g_array_set_size(dtim_records, 0);
+   dtim_detection_start = cur_monotonic_nanosec();
+   dtim_detection_end = 0;
+   dtim_detection_ct++;
+   dtim_active = true;
+   g_mutex_unlock(&dtim_mutex);
+
+   DBGTRC_DONE(debug, TRACE_GROUP, "");
+}
+
+
+/** Marks the end of a display detection cycle. */
+void dtim_end_detection() {
+   bool debug = false;
+   g_mutex_lock(&dtim_mutex);
+   if (dtim_active) {
+      dtim_detection_end = cur_monotonic_nanosec();
+      dtim_active = false;
+   }
+   int record_ct = (dtim_records) ? dtim_records->len : 0;
+   g_mutex_unlock(&dtim_mutex);
+   DBGTRC_EXECUTED(debug, TRACE_GROUP, "Recorded %d phases", record_ct);
+}
+
+
+/** Records a completed detection phase.  The phase ends now.
+ *  Does nothing if no detection cycle is in progress.
+ *
+ *  @param  busno        I2C bus number, #DTIM_ALL_BUSES if not bus specific
+ *  @param  phase        phase id
+ *  @param  start_nanos  monotonic timestamp at which the phase began,
+ *                       as returned by #DTIM_START()
+ */
+void dtim_record_phase(int busno, Dtim_Phase phase, uint64_t start_nanos) {
+   uint64_t end_nanos = cur_monotonic_nanosec();
+   g_mutex_lock(&dtim_mutex);
+   if (dtim_active) {
+      Dtim_Record rec = {busno, phase, start_nanos, end_nanos};
+      g_array_append_val(dtim_records, rec);
+   }
+   g_mutex_unlock(&dtim_mutex);
+}
+
+
+static gint dtim_compare_by_bus_and_start(gconstpointer a, gconstpointer b) {
+   const Dtim_Record * r1 = a;
+   const Dtim_Record * r2 = b;
+   if (r1->busno != r2->busno)
+      return (r1->busno < r2->busno) ? -1 : 1;
+   if (r1->start_nanos != r2->start_nanos)
+      return (r1->start_nanos < r2->start_nanos) ? -1 : 1;
+   return 0;
+}
+
+
+typedef struct {
+   uint64_t nanos;
+   int      delta;     // +1 phase starts, -1 phase ends
+} Dtim_Event;
+
+
+static gint dtim_compare_events(gconstpointer a, gconstpointer b) {
+   const Dtim_Event * e1 = a;
+   const Dtim_Event * e2 = b;
+   if (e1->nanos != e2->nanos)
+      return (e1->nanos < e2->nanos) ? -1 : 1;
+   return e1->delta - e2->delta;    // ends before starts at the same instant
+}
+
+
+/** Calculates the time within [start,end] during which at most one
+ *  recorded phase was executing.
+ */
+static uint64_t dtim_serial_nanos(GArray * records, uint64_t start, uint64_t end) {
+   GArray * events = g_array_sized_new(false, false, sizeof(Dtim_Event), 2*records->len);
+   for (int ndx = 0; ndx < records->len; ndx++) {
+      Dtim_Record * rec = &g_array_index(records, Dtim_Record, ndx);
+      Dtim_Event e1 = {rec->start_nanos, 1};
+      Dtim_Event e2 = {rec->end_nanos, -1};
+      g_array_append_val(events, e1);
+      g_array_append_val(events, e2);
+   }
+   g_array_sort(events, dtim_compare_events);
+
+   uint64_t serial = 0;
+   uint64_t prev = start;
+   int active = 0;
+   for (int ndx = 0; ndx < events->len; ndx++) {
+      Dtim_Event * e = &g_array_index(events, Dtim_Event, ndx);
+      uint64_t t = CLAMP(e->nanos, start, end);
+      if (active <= 1)
+         serial += t - prev;
+      prev = t;
+      active += e->delta;
+   }
+   serial += end - prev;
+   g_array_free(events, true);
+   return serial;
+}
+
+
+#define MS(_nanos) ((_nanos)/1000000.0)
+
+/** Reports the phase timings of the most recent display detection cycle.
+ *
+ *  For each bus, lists each phase with its starting offset from the
+ *  start of detection.  Also reports totals by phase, the critical path
+ *  (the bus that completed last), the degree of parallel overlap, and the
+ *  fraction of wall time during which at most one phase was executing.
+ *
+ *  @param  depth  logical indentation depth
+ */
+void report_detection_timings(int depth) {
+   int d1 = depth+1;
+   int d2 = depth+2;
+   rpt_label(depth, "Display detection timings:");
+
+   g_mutex_lock(&dtim_mutex);
+   if (!dtim_records || dtim_detection_ct == 0 || dtim_active) {
+      rpt_label(d1, (dtim_active) ? "Display detection in progress"
+                                  : "Display detection has not occurred");
+      g_mutex_unlock(&dtim_mutex);
+      return;
+   }
+   GArray * records = g_array_sized_new(false, false, sizeof(Dtim_Record), dtim_records->len);
+   g_array_append_vals(records, dtim_records->data, dtim_records->len);
+   uint64_t start = dtim_detection_start;
+   uint64_t end   = dtim_detection_end;
+   g_mutex_unlock(&dtim_mutex);
+
+   uint64_t wall = end - start;
+   g_array_sort(records, dtim_compare_by_bus_and_start);
+
+   rpt_vstring(d1, "Wall time:  %.3f ms", MS(wall));
+   rpt_nl();
+   rpt_label(d1, "Timeline (offset from start of detection, duration, phase):");
+
+   uint64_t total_busy = 0;
+   uint64_t phase_nanos[DTIM_PHASE_CT] = {0};
+   int      phase_cts[DTIM_PHASE_CT] = {0};
+   uint64_t phase_max[DTIM_PHASE_CT] = {0};
+   int      critical_busno = DTIM_ALL_BUSES;
+   uint64_t critical_end = 0;
+   uint64_t critical_busy = 0;
+
+   int ndx = 0;
+   while (ndx < records->len) {
+      int busno = g_array_index(records, Dtim_Record, ndx).busno;
+      if (busno == DTIM_ALL_BUSES)
+         rpt_label(d1, "All buses:");
+      else
+         rpt_vstring(d1, "/dev/i2c-%d:", busno);
+      uint64_t bus_busy = 0;
+      uint64_t bus_end = 0;
+      for (; ndx < records->len && g_array_index(records, Dtim_Record, ndx).busno == busno; ndx++) {
+         Dtim_Record * rec = &g_array_index(records, Dtim_Record, ndx);
+         uint64_t duration = rec->end_nanos - rec->start_nanos;
+         rpt_vstring(d2, "+%9.3f ms  %9.3f ms  %s",
+               MS(rec->start_nanos - start), MS(duration), dtim_phase_name(rec->phase));
+         bus_busy += duration;
+         bus_end = MAX(bus_end, rec->end_nanos);
+         phase_nanos[rec->phase] += duration;
+         phase_cts[rec->phase]++;
+         phase_max[rec->phase] = MAX(phase_max[rec->phase], duration);
+      }
+      rpt_vstring(d2, "Busy: %.3f ms, completed at +%.3f ms", MS(bus_busy), MS(bus_end - start));
+      total_busy += bus_busy;
+      if (busno != DTIM_ALL_BUSES && bus_end > critical_end) {
+         critical_end = bus_end;
+         critical_busno = busno;
+         critical_busy = bus_busy;
+      }
+   }
+   rpt_nl();
+
+   rpt_label(d1, "Totals by phase:");
+   rpt_vstring(d2, "%-28s  %5s  %11s  %11s", "Phase", "Count", "Total ms", "Max ms");
+   for (int phase = 0; phase < DTIM_PHASE_CT; phase++) {
+      if (phase_cts[phase] > 0)
+         rpt_vstring(d2, "%-28s  %5d  %11.3f  %11.3f",
+               dtim_phase_name(phase), phase_cts[phase], MS(phase_nanos[phase]), MS(phase_max[phase]));
+   }
+   rpt_nl();
+
+   if (critical_busno != DTIM_ALL_BUSES)
+      rpt_vstring(d1, "Critical path:     /dev/i2c-%d, completed at +%.3f ms, busy %.3f ms",
+            critical_busno, MS(critical_end - start), MS(critical_busy));
+   if (wall > 0) {
+      uint64_t serial = dtim_serial_nanos(records, start, end);
+      rpt_vstring(d1, "Parallel overlap:  %.2f  (total phase time / wall time)",
+            (double) total_busy / wall);
+      rpt_vstring(d1, "Serial fraction:   %.1f%%  (wall time with at most one phase active)",
+            100.0 * serial / wall);
+   }
+   g_array_free(records, true);
+}
+
+#undef MS
+
+
+void init_detection_timing() {
+   RTTI_ADD_FUNC(dtim_start_detection);
+   RTTI_ADD_FUNC(dtim_end_detection);
+}
@@ -0,0 +1,49 @@
+/** @file detection_timing.h
+ *
+ *  Records the elapsed time of each phase of display detection, per I2C bus,
+ *  and reports the resulting timeline.
+ */
+
+// Copyright (C) 2025 Sanford Rockowitz <rockowitz@minsoft.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef DETECTION_TIMING_H_
+#define DETECTION_TIMING_H_
+
+/** \cond */
+#include <inttypes.h>
+#include <stdbool.h>
+/** \endcond */
+
+#include "util/timestamp.h"
+
+/** Pseudo bus number for phases that are not specific to a single bus */
+#define DTIM_ALL_BUSES -1
+
+typedef enum {
+   DTIM_PHASE_BUS_ENUM,           ///< enumerate /dev/i2c-N devices
+   DTIM_PHASE_SYSFS,              ///< sysfs driver and DRM connector lookups
+   DTIM_PHASE_SYSFS_EDID,         ///< read EDID from sysfs
+   DTIM_PHASE_OPEN,               ///< open and flock /dev/i2c-N
+   DTIM_PHASE_X50_EDID,           ///< read EDID using slave address x50
+   DTIM_PHASE_X37_PROBE,          ///< probe slave address x37
+   DTIM_PHASE_DPMS,               ///< check DPMS state
+   DTIM_PHASE_DDC_CHECK,          ///< check DDC communication using feature x10
+   DTIM_PHASE_UNSUPPORTED_CHECK,  ///< determine how unsupported features are reported
+   DTIM_PHASE_VCP_VERSION,        ///< read VCP version
+   DTIM_PHASE_PHANTOM_FILTER,     ///< filter phantom displays
+} Dtim_Phase;
+#define DTIM_PHASE_CT (DTIM_PHASE_PHANTOM_FILTER+1)
+
+const char * dtim_phase_name(Dtim_Phase phase);
+
+void dtim_start_detection();
+void dtim_end_detection();
+void dtim_record_phase(int busno, Dtim_Phase phase, uint64_t start_nanos);
+void report_detection_timings(int depth);
+void init_detection_timing();
+
+/** Returns a timestamp to be passed to #dtim_record_phase() when the phase ends */
+#define DTIM_START() cur_monotonic_nanosec()
+
+#endif /* DETECTION_TIMING_H_ */
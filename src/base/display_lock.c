@@ -95,7 +95,6 @@ static bool lock_rec_matches_dref(Display_Lock_Record * dlr, Display_Ref * dref)
 
 static GPtrArray * lock_records = NULL;   // array of Diaplay_Lock_Record *
 static GMutex descriptors_mutex;          // single threads access to lock records
-static GMutex master_display_lock_mutex;
 
 
 // must be called when lock not held by current thread, o.w. deadlock
@@ -116,6 +115,8 @@ Display_Lock_Record * create_display_lock_record(DDCA_IO_Path io_path) {
    memcpy(new_desc->marker, DISPLAY_LOCK_MARKER, 4);
    new_desc->io_path           = io_path;
    g_mutex_init(&new_desc->display_mutex);
+   g_cond_init(&new_desc->display_cond);
+   g_queue_init(&new_desc->waiters);
    return new_desc;
 }
 
@@ -186,9 +187,16 @@ do { \
 
 
 /** Locks a distinct display.
+ *
+ *  Threads waiting for the lock are queued, and the lock is granted in the
+ *  order in which the threads asked for it.  A waiting thread blocks on a
+ *  condition variable until the lock is released, rather than repeatedly
+ *  trying the lock and sleeping.
  *
  *  \param  dlr              Display_Lock_Record distinct display identifier
  *  \param  flags              if **DDISP_WAIT** set, wait for locking
+ *                             indefinitely, otherwise wait at most
+ *                             DEFAULT_OPEN_MAX_WAIT_MILLISEC
  *  \retval NULL               success
  *  \retval Error_Info(DDCRC_LOCKED)       locking failed, display already locked by another
  *                                         thread and DDISP_WAIT not set
@@ -206,13 +214,11 @@ lock_display(
    Error_Info * err = NULL;
    // TODO:  If this function is exposed in API, change assert to returning illegal argument status code
    TRACED_ASSERT(memcmp(dlr->marker, DISPLAY_LOCK_MARKER, 4) == 0);
-   bool self_thread = false;
+   GThread * self = g_thread_self();
    bool locked = false;
-   g_mutex_lock(&master_display_lock_mutex);
-   if (dlr->display_mutex_thread == g_thread_self() )
-      self_thread = true;
-   g_mutex_unlock(&master_display_lock_mutex);
-   if (self_thread) {
+   g_mutex_lock(&dlr->display_mutex);
+   if (dlr->display_mutex_thread == self) {
+      g_mutex_unlock(&dlr->display_mutex);
       EMIT_BACKTRACE(DDCA_SYSLOG_ERROR,
             "Attempting to lock display already locked by current thread, tid=%jd", TID());
       err = errinfo_new(DDCRC_ALREADY_OPEN, __func__,   // is there a better status code?
@@ -220,47 +226,52 @@ lock_display(
       goto bye;
    }
 
-   if (flags & DDISP_WAIT) {
-      g_mutex_lock(&dlr->display_mutex);
+   int waitct = 0;
+   bool timed_out = false;
+   gint64 end_time = g_get_monotonic_time() +
+                     DEFAULT_OPEN_MAX_WAIT_MILLISEC * G_TIME_SPAN_MILLISECOND;
+   g_queue_push_tail(&dlr->waiters, self);
+   while (!timed_out && (dlr->locked || g_queue_peek_head(&dlr->waiters) != self)) {
+      waitct++;
+      DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE, "Waiting for lock, dpath=%s, waiters=%d",
+            dpath_short_name_t(&dlr->io_path), g_queue_get_length(&dlr->waiters));
+      if (flags & DDISP_WAIT)
+         g_cond_wait(&dlr->display_cond, &dlr->display_mutex);
+      else
+         timed_out = !g_cond_wait_until(&dlr->display_cond, &dlr->display_mutex, end_time);
+   }
+   // recheck, the lock may have become available as the wait timed out
+   if (!dlr->locked && g_queue_peek_head(&dlr->waiters) == self) {
       locked = true;
+      dlr->locked = true;
+      dlr->display_mutex_thread = self;
+      dlr->linux_thread_id = get_thread_id();
    }
-   else {
-      int lock_max_wait_millisec = DEFAULT_OPEN_MAX_WAIT_MILLISEC;
-      int lock_wait_interval_millisec = DEFAULT_OPEN_WAIT_INTERVAL_MILLISEC;
-      int total_wait_millisec = 0;
-      int tryctr = 0;
-
-      while (!locked && total_wait_millisec < lock_max_wait_millisec) {
-         tryctr++;
-         locked = g_mutex_trylock(&dlr->display_mutex);
-         if (!locked) {
-            DBGTRC_NOPREFIX(true, DDCA_TRC_NONE, "g_mutex_trylock() failed, dref=%s", 
-                  dpath_short_name_t(&dlr->io_path));
-            SLEEP_MILLIS_WITH_STATS(lock_wait_interval_millisec);
-            total_wait_millisec += lock_wait_interval_millisec;
-         }
-      }
-
-      if (locked) {  // note that this thread owns the lock
-          if (tryctr > 1) {
-             EMIT_BACKTRACE(DDCA_SYSLOG_NOTICE, PRItid"Locked %s after %d tries",
-                   TID(), dpath_short_name_t(&dlr->io_path), tryctr);
-          }
-      }
-      else {
-         EMIT_BACKTRACE(DDCA_SYSLOG_ERROR, PRItid"Failed to Lock %s after %d tries. Locked by thread"PRItid,
-               TID(), dpath_short_name_t(&dlr->io_path), tryctr, dlr->linux_thread_id);
-         err = errinfo_new(DDCRC_LOCKED, __func__, "Locking failed for %s after %d tries. Locked by thread"PRItid,
-               dpath_short_name_t(&dlr->io_path), tryctr, dlr->linux_thread_id);
+   g_queue_remove(&dlr->waiters, self);
+   if (!locked) {
+      // the next waiter may now be at the head of the queue
+      g_cond_broadcast(&dlr->display_cond);
+   }
+   intmax_t owner_tid = dlr->linux_thread_id;
+   int waiter_ct = g_queue_get_length(&dlr->waiters);
+   g_mutex_unlock(&dlr->display_mutex);
+
+   if (locked) {
+      if (waitct > 0) {
+         EMIT_BACKTRACE(DDCA_SYSLOG_NOTICE, PRItid"Locked %s after waiting %d time(s)",
+               TID(), dpath_short_name_t(&dlr->io_path), waitct);
       }
    }
-
-bye:
-   if (locked) {  // note that this thread owns the lock
-        dlr->display_mutex_thread = g_thread_self();
-        dlr->linux_thread_id = get_thread_id();
+   else {
+      EMIT_BACKTRACE(DDCA_SYSLOG_ERROR,
+            PRItid"Failed to Lock %s after %d millisec. Locked by thread"PRItid", %d other waiters",
+            TID(), dpath_short_name_t(&dlr->io_path), DEFAULT_OPEN_MAX_WAIT_MILLISEC,
+            owner_tid, waiter_ct);
+      err = errinfo_new(DDCRC_LOCKED, __func__, "Locking failed for %s after %d millisec. Locked by thread"PRItid,
+            dpath_short_name_t(&dlr->io_path), DEFAULT_OPEN_MAX_WAIT_MILLISEC, owner_tid);
    }
 
+bye:
    // need a new DDC status code
    // DBGTRC_RET_ERRINFO(debug, TRACE_GROUP, err, "dlr->io_path=%s", dpath_short_name_t(&dlr->io_path));
    DBGTRC_RET_ERRINFO(debug, TRACE_GROUP, err, "");
@@ -448,7 +459,7 @@ unlock_display(Display_Lock_Record * dlr) {
 
    // TODO:  If this function is exposed in API, change assert to returning illegal argument status code
    TRACED_ASSERT(memcmp(dlr->marker, DISPLAY_LOCK_MARKER, 4) == 0);
-   g_mutex_lock(&master_display_lock_mutex);
+   g_mutex_lock(&dlr->display_mutex);
    intmax_t current_thread_id = dlr->linux_thread_id;
    // DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE, "old linux_thread_id = %jd", dlr->linux_thread_id);
    if (dlr->display_mutex_thread != g_thread_self()) {
@@ -458,10 +469,11 @@ unlock_display(Display_Lock_Record * dlr) {
    else {
       dlr->display_mutex_thread = NULL;
       dlr->linux_thread_id = 0;
+      dlr->locked = false;
       current_thread_id = 0;
-      g_mutex_unlock(&dlr->display_mutex);
+      g_cond_broadcast(&dlr->display_cond);
    }
-   g_mutex_unlock(&master_display_lock_mutex);
+   g_mutex_unlock(&dlr->display_mutex);
    DBGTRC_RET_ERRINFO(debug, TRACE_GROUP, err, "dlr->io_path=%s, final linux_thread_id=%d",
          dpath_repr_t(&dlr->io_path), current_thread_id);
    return err;
@@ -500,36 +512,6 @@ unlock_display_by_dpath(
 }
 
 
-#ifdef BAD
-/** Unlocks all distinct displays.
- *
- *  The function is used during reinitialization.
- *
- *  BUG: DO NOT USE
- */
-void unlock_all_distinct_displays() {
-   bool debug = false;
-   DBGTRC_STARTING(debug, TRACE_GROUP, "");
-   g_mutex_lock(&master_display_lock_mutex);   // are both locks needed?
-   g_mutex_lock(&descriptors_mutex);
-    for (int ndx=0; ndx < lock_records->len; ndx++) {
-       Display_Lock_Record * cur = g_ptr_array_index(lock_records, ndx);
-       DBGTRC_NOPREFIX(debug, TRACE_GROUP, "%2d - %p  %-28s",
-                                           ndx, cur,
-                                           dpath_repr_t(&cur->io_path) );
-
-       // WRONG: Attempt to unlock mutex that was not locked
-       //        Aborted (core dumped)
-       // Calling g_mutex_unlock() on a mutex that is not locked by the current thread leads to undefined behaviour.
-       g_mutex_unlock(&cur->display_mutex);
-    }
-    g_mutex_unlock(&descriptors_mutex);
-    g_mutex_unlock(&master_display_lock_mutex);
-    DBGTRC_DONE(debug, TRACE_GROUP, "");
- }
-#endif
-
-
 /** Emits a report of all distinct display descriptors.
  *
  *  \param depth logical indentation depth
@@ -542,10 +524,11 @@ dbgrpt_display_locks(int depth) {
    rpt_label(depth,"index  lock-record-ptr  dpath                         display_mutex_thread");
    for (int ndx=0; ndx < lock_records->len; ndx++) {
       Display_Lock_Record * cur = g_ptr_array_index(lock_records, ndx);
-      rpt_vstring(d1, "%2d - %p  %-28s  thread ptr=%p, thread id=%jd",
+      rpt_vstring(d1, "%2d - %p  %-28s  thread ptr=%p, thread id=%jd, waiters=%d",
                        ndx, cur,
                        dpath_repr_t(&cur->io_path),
-                       (void*) &cur->display_mutex_thread, cur->linux_thread_id );
+                       (void*) &cur->display_mutex_thread, cur->linux_thread_id,
+                       g_queue_get_length(&cur->waiters) );
    }
    g_mutex_unlock(&descriptors_mutex);
 }
@@ -576,11 +559,17 @@ int unlock_all_displays_for_current_thread() {
       }
 
       // DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE, "old linux_thread_id = %jd", dlr->linux_thread_id);
-       if (dlr->display_mutex_thread == g_thread_self()) {
+       g_mutex_lock(&dlr->display_mutex);
+       bool owned = (dlr->display_mutex_thread == g_thread_self());
+       if (owned) {
           unlocked_ct++;
           dlr->display_mutex_thread = NULL;
           dlr->linux_thread_id = 0;
-          g_mutex_unlock(&dlr->display_mutex);
+          dlr->locked = false;
+          g_cond_broadcast(&dlr->display_cond);
+       }
+       g_mutex_unlock(&dlr->display_mutex);
+       if (owned) {
           SYSLOG2(DDCA_SYSLOG_NOTICE, "Unlocked display %s on current thread "PRItid,
                 dpath_repr_t(&dlr->io_path), TID() );
        }
@@ -25,8 +25,11 @@ typedef enum {
 typedef struct {
    char         marker[4];
    DDCA_IO_Path io_path;
-   GMutex       display_mutex;
-   GThread *    display_mutex_thread;     // thread owning mutex
+   GMutex       display_mutex;            // guards the following fields
+   GCond        display_cond;             // signalled when lock released or waiter leaves
+   GQueue       waiters;                  // GThread * of threads waiting, in arrival order
+   bool         locked;
+   GThread *    display_mutex_thread;     // thread owning lock
    intmax_t     linux_thread_id;
 } Display_Lock_Record;
 
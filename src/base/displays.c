@@ -30,6 +30,7 @@
 #include "public/ddcutil_status_codes.h"
 
 #include "core.h"
+#include "feature_metadata.h"
 #include "i2c_bus_base.h"
 #include "monitor_model_key.h"
 #include "per_display_data.h"
@@ -711,6 +712,8 @@ Display_Ref * copy_display_ref(Display_Ref * dref) {
       copy->vcp_version_cmdline = dref->vcp_version_cmdline;
       copy->flags = dref->flags & ~DREF_DYNAMIC_FEATURES_CHECKED;
       copy->capabilities_string = g_strdup(dref->capabilities_string);
+      copy->capabilities_feature_ids_set = dref->capabilities_feature_ids_set;
+      copy->capabilities_feature_ids = dref->capabilities_feature_ids;
       if (dref->pedid) {
          copy->pedid = copy_parsed_edid(dref->pedid);
       }
@@ -766,6 +769,7 @@ DDCA_Status free_display_ref(Display_Ref * dref) {
                DBGTRC(debug, DDCA_TRC_NONE, "Freeing dref->pedid = %p", dref->pedid);
                free_parsed_edid(dref->pedid);  // private copy
             }
+            free_feature_metadata_table(dref->metadata_table);
             dfr_free(dref->dfr);
             free(dref->drm_connector);
             free(dref->communication_error_summary);
@@ -1461,6 +1465,7 @@ const char * watch_mode_name(DDC_Watch_Mode mode) {
    case Watch_Mode_Poll:     result = "Watch_Mode_Poll";     break;
    case Watch_Mode_Xevent:   result = "Watch_Mode_Xevent";   break;
    case Watch_Mode_Udev:     result = "Watch_Mode_Udev";     break;
+   case Watch_Mode_Drm:      result = "Watch_Mode_Drm";      break;
    case Watch_Mode_Dynamic:  result = "Watch_Mode_Dynamic";  break;
    }
    return result;
@@ -11,6 +11,7 @@
 #include <stdbool.h>
 
 #include "util/coredefs.h"
+#include "util/data_structures.h"
 #include "util/edid.h"
 /** \endcond */
 
@@ -190,6 +191,8 @@ typedef struct _display_ref {
    DDCA_MCCS_Version_Spec   vcp_version_cmdline;
    Dref_Flags               flags;
    char *                   capabilities_string;   // added 4/2017, private copy
+   bool                     capabilities_feature_ids_set;
+   Bit_Set_256              capabilities_feature_ids;  // features in capabilities vcp segment
    Parsed_Edid *            pedid;                 // added 4/2017
    Monitor_Model_Key *      mmid;                  // will be set iff pedid
    int                      dispno;
@@ -199,6 +202,7 @@ typedef struct _display_ref {
    struct _display_ref *    actual_display;        // if dispno == -2
    DDCA_IO_Path *           actual_display_path;   // alt to actual_display
    struct Per_Display_Data* pdd;
+   struct Feature_Metadata_Table* metadata_table;  // built on first use
    char *                   drm_connector;         // e.g. card0-HDMI-A-1  // REDUNDANT - IDENTICAL TO Bus_Info.drm_connector
    int                      drm_connector_id;      // identical to Bus_Info.drm_connector_id
    Drm_Connector_Found_By   drm_connector_found_by;  // identical to Bus_Info.drm_connector_found_by
@@ -305,6 +309,7 @@ typedef enum {
    Watch_Mode_Poll,
    Watch_Mode_Xevent,
    Watch_Mode_Udev,
+   Watch_Mode_Drm,      ///< DRM uevents, connector properties read using libdrm
 } DDC_Watch_Mode;
 
 const char * watch_mode_name(DDC_Watch_Mode mode);
@@ -170,7 +170,11 @@ static void dbgrpt_enum_metadata(Enum_Metadata * meta, int depth) {
  }
 
 
- static void free_drm_connector_state(void * cs) {
+ /** Frees a #Drm_Connector_State.  Usable as a GDestroyNotify.
+  *
+  *  @param cs  pointer to #Drm_Connector_State
+  */
+ void free_drm_connector_state(void * cs) {
     bool debug = false;
     Drm_Connector_State * cstate = (Drm_Connector_State*) cs;
     if (cstate) {
@@ -242,6 +246,89 @@ static void store_property_value(
 }
 
 
+/** Collects the state of a single DRM connector.
+ *
+ *  @param  fd            file descriptor of open DRM device
+ *  @param  cardno        DRM card number
+ *  @param  connector_id  DRM connector id
+ *  @param  probe         if true, use drmModeGetConnector(), which forces a probe
+ *                        of the connector (possibly reading the EDID over I2C),
+ *                        if false, use drmModeGetConnectorCurrent(), which
+ *                        returns the state the kernel currently holds
+ *  @return newly allocated #Drm_Connector_State, NULL if connector not found
+ */
+static Drm_Connector_State *
+get_connector_state(int fd, int cardno, uint32_t connector_id, bool probe) {
+   bool debug = false;
+   DBGTRC_STARTING(debug, TRACE_GROUP, "fd=%d, cardno=%d, connector_id=%d, probe=%s",
+         fd, cardno, connector_id, sbool(probe));
+   int d1 = 1;
+   int d2 = 2;
+
+   /* Doc for drmModeGetConnector in xf86drmMode.h:
+    *
+    * Retrieve all information about the connector connectorId. This will do a
+    * forced probe on the connector to retrieve remote information such as EDIDs
+    * from the display device.
+    */
+   drmModeConnector * conn = (probe) ? drmModeGetConnector(fd, connector_id)
+                                     : drmModeGetConnectorCurrent(fd, connector_id);
+   if (!conn) {
+      DBGTRC_DONE(debug, TRACE_GROUP, "Cannot retrieve DRM connector id %d errno=%s",
+                                      connector_id, linux_errno_name(errno));
+      return NULL;
+   }
+   DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE, "got drmModeConnector conn = %p", conn);
+
+   if (debug)
+     report_drmModeConnector(fd, conn, d1) ;
+   Drm_Connector_State * connector_state = calloc(1,sizeof(Drm_Connector_State));
+   connector_state->cardno       = cardno;
+   connector_state->connector_id = connector_id;
+   if (debug) {
+      int depth=2;
+      rpt_structure_loc("drmModeConnector", conn, depth);
+      rpt_vstring(d1, "%-20s %d",       "connector_id:", conn->connector_id);
+      rpt_vstring(d1, "%-20s %d - %s",  "connector_type:",    conn->connector_type,  drm_connector_type_name(conn->connector_type));
+      rpt_vstring(d1, "%-20s %d",       "connector_type_id:", conn->connector_type_id);
+      rpt_vstring(d1, "%-20s %d - %s",  "connection:",        conn->connection, connector_status_name(conn->connection));
+   }
+   connector_state->connector_type = conn->connector_type;;
+   connector_state->connector_type_id = conn->connector_type_id;
+   connector_state->connection = conn->connection;
+   drmModeConnector * p = conn;
+   if (debug)
+      rpt_vstring(d1, "%-20s %d",  "count_props", p->count_props);
+   for (int ndx = 0; ndx < p->count_props; ndx++) {
+        uint64_t curval = p->prop_values[ndx];   // coverity workaround
+        if (debug) {
+           rpt_vstring(d2, "index=%d, property id (props)=%" PRIu32 ", property value (prop_values)=%" PRIu64 ,
+                            ndx, p->props[ndx], curval);
+        }
+        int id = p->props[ndx];
+        if (id == EDID_PROP_ID         ||      //  1
+            id == DPMS_PROP_ID         ||      //  2
+            id == LINK_STATUS_PROP_ID  ||      //  5
+            id == SUBCONNECTOR_PROP_ID)        // 69
+        {
+           drmModePropertyPtr metadata_ptr = drmModeGetProperty(fd, p->props[ndx]);
+           if (metadata_ptr) {
+              uint64_t  prop_value = p->prop_values[ndx];
+              if (debug)
+                 report_property_value(fd, metadata_ptr, prop_value, d2);
+              store_property_value(fd, connector_state, metadata_ptr, prop_value);
+              drmModeFreeProperty(metadata_ptr);
+           }
+        }
+   } // for
+   DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE, "calling drmModeFreeConnector(%p)", conn);
+   drmModeFreeConnector(conn);
+
+   DBGTRC_DONE(debug, TRACE_GROUP, "Returning: %p", connector_state);
+   return connector_state;
+}
+
+
 // Returns array of DRM_Connector_State for one card
 DDCA_Status get_connector_state_array(int fd, int cardno, GPtrArray* collector) {
    bool debug = false;
@@ -267,65 +354,14 @@ DDCA_Status get_connector_state_array(int fd, int cardno, GPtrArray* collector)
 
       DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE, "Scanning connectors for card %d ...", cardno);
       for (int i = 0; i < res->count_connectors; ++i) {
-         DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE, "calling drmModeGetConnector for id %d", res->connectors[i]);
-
-         /* Doc for drmModeGetConnector in xf86drmMode.h:
-          *
-          * Retrieve all information about the connector connectorId. This will do a
-          * forced probe on the connector to retrieve remote information such as EDIDs
-          * from the display device.
-          */
-         drmModeConnector * conn = drmModeGetConnector(fd, res->connectors[i]);
-         if (!conn) {
+         DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE, "calling get_connector_state() for id %d", res->connectors[i]);
+         Drm_Connector_State * connector_state =
+               get_connector_state(fd, cardno, res->connectors[i], /*probe*/ true);
+         if (!connector_state) {
             rpt_vstring(d1, "Cannot retrieve DRM connector id %d errno=%s",
                             res->connectors[i], linux_errno_name(errno));
             continue;
          }
-         DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE, "got drmModeConnector conn = %p", conn);
-
-         if (debug)
-           report_drmModeConnector(fd, conn, d1) ;
-         Drm_Connector_State * connector_state = calloc(1,sizeof(Drm_Connector_State));
-         connector_state->cardno       = cardno;
-         connector_state->connector_id = res->connectors[i];
-         if (debug) {
-            int depth=2;
-            rpt_structure_loc("drmModeConnector", conn, depth);
-            rpt_vstring(d1, "%-20s %d",       "connector_id:", conn->connector_id);
-            rpt_vstring(d1, "%-20s %d - %s",  "connector_type:",    conn->connector_type,  drm_connector_type_name(conn->connector_type));
-            rpt_vstring(d1, "%-20s %d",       "connector_type_id:", conn->connector_type_id);
-            rpt_vstring(d1, "%-20s %d - %s",  "connection:",        conn->connection, connector_status_name(conn->connection));
-         }
-         connector_state->connector_type = conn->connector_type;;
-         connector_state->connector_type_id = conn->connector_type_id;
-         connector_state->connection = conn->connection;
-         drmModeConnector * p = conn;
-         if (debug)
-            rpt_vstring(d1, "%-20s %d",  "count_props", p->count_props);
-         for (int ndx = 0; ndx < p->count_props; ndx++) {
-              uint64_t curval = p->prop_values[ndx];   // coverity workaround
-              if (debug) {
-                 rpt_vstring(d2, "index=%d, property id (props)=%" PRIu32 ", property value (prop_values)=%" PRIu64 ,
-                                  ndx, p->props[ndx], curval);
-              }
-              int id = p->props[ndx];
-              if (id == EDID_PROP_ID         ||      //  1
-                  id == DPMS_PROP_ID         ||      //  2
-                  id == LINK_STATUS_PROP_ID  ||      //  5
-                  id == SUBCONNECTOR_PROP_ID)        // 69
-              {
-                 drmModePropertyPtr metadata_ptr = drmModeGetProperty(fd, p->props[ndx]);
-                 if (metadata_ptr) {
-                    uint64_t  prop_value = p->prop_values[ndx];
-                    if (debug)
-                       report_property_value(fd, metadata_ptr, prop_value, d2);
-                    store_property_value(fd, connector_state, metadata_ptr, prop_value);
-                    drmModeFreeProperty(metadata_ptr);
-                 }
-              }
-         } // for
-         DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE, "calling drmModeFreeConnector(%p)", conn);
-         drmModeFreeConnector(conn);
          g_ptr_array_add(collector, connector_state);
       }
       drmModeFreeResources(res);
@@ -473,10 +509,24 @@ DDCA_Status get_drm_connector_states_by_fd(int fd, int cardno, GPtrArray* collec
 }
 
 
+/** Returns the current state of a single DRM connector.
+ *
+ *  Only the specified connector is queried, and the connector is not
+ *  probed, so the kernel's current view of the connector is returned
+ *  without any I2C traffic.  Suitable for repeated calls on a cached
+ *  file descriptor, e.g. when a DRM uevent names the connector that changed.
+ *
+ *  @param  fd            file descriptor of open DRM device
+ *  @param  cardno        DRM card number
+ *  @param  connector_id  DRM connector id
+ *  @return newly allocated #Drm_Connector_State, caller must free using
+ *          #free_drm_connector_state(), NULL if not found
+ */
 Drm_Connector_State * get_drm_connector_state_by_fd(int fd, int cardno, int connector_id) {
    bool debug = false;
-   DBGTRC_STARTING(debug, TRACE_GROUP, "Starting.  fd=%d, connector_id=%d", fd, connector_id);
+   DBGTRC_STARTING(debug, TRACE_GROUP, "Starting.  fd=%d, cardno=%d, connector_id=%d", fd, cardno, connector_id);
 
+#ifdef OLD
    GPtrArray * connector_state_array = g_ptr_array_new();
    g_ptr_array_set_free_func(connector_state_array, free_drm_connector_state);
    get_drm_connector_states_by_fd(fd, cardno, connector_state_array);
@@ -494,6 +544,9 @@ Drm_Connector_State * get_drm_connector_state_by_fd(int fd, int cardno, int conn
        }
       g_ptr_array_free(connector_state_array, true);
     }
+#endif
+   Drm_Connector_State * result = get_connector_state(fd, cardno, connector_id, /*probe*/ false);
+
    DBGTRC_DONE(debug, TRACE_GROUP, "Returning: %p", result);
    return result;
 }
@@ -733,6 +786,7 @@ Drm_Connector_State * find_drm_connector_state(Drm_Connector_Identifier cid) {
 void init_drm_connector_state() {
    RTTI_ADD_FUNC(drmModePropertyRes_to_enum_metadata);
    RTTI_ADD_FUNC(store_property_value);
+   RTTI_ADD_FUNC(get_connector_state);
    RTTI_ADD_FUNC(get_connector_state_array);
    RTTI_ADD_FUNC(get_drm_connector_states_by_fd);
    RTTI_ADD_FUNC(get_drm_connector_state_by_fd);
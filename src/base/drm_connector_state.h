@@ -30,6 +30,9 @@ typedef struct {
    uint64_t          subconnector;
 } Drm_Connector_State;
 
+void                  free_drm_connector_state(void * cs);
+Drm_Connector_State * get_drm_connector_state_by_fd(int fd, int cardno, int connector_id);
+int                   extract_cardno(const char * devname);
 void                  redetect_drm_connector_states();
 void                  report_drm_connector_states(int depth);
 void                  report_drm_connector_states_basic(bool refresh, int depth);
@@ -647,6 +647,31 @@ free_ddca_feature_metadata(DDCA_Feature_Metadata * metadata) {
 }
 
 
+/** Frees a #Feature_Metadata_Table, and any tables it replaced.
+ *
+ *  @param table  pointer to table, may be NULL
+ */
+void
+free_feature_metadata_table(Feature_Metadata_Table * table) {
+   while (table) {
+      assert(memcmp(table->marker, FEATURE_METADATA_TABLE_MARKER, 4) == 0);
+      Feature_Metadata_Table * prior = table->prior;
+      for (int ndx = 0; ndx < 256; ndx++) {
+         dfm_free(table->internal[ndx]);
+         DDCA_Feature_Metadata * ext = table->external[ndx];
+         if (ext) {
+            ext->feature_flags &= ~DDCA_PERSISTENT_METADATA;
+            free_ddca_feature_metadata(ext);
+            free(ext);
+         }
+      }
+      table->marker[3] = 'x';
+      free(table);
+      table = prior;
+   }
+}
+
+
 void init_feature_metadata() {
    RTTI_ADD_FUNC(dfm_free);
    RTTI_ADD_FUNC(dfm_from_dyn_feature_metadata);
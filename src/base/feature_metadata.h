@@ -164,6 +164,34 @@ void  dfm_set_feature_name(Display_Feature_Metadata * meta, const char * feature
 void  dfm_set_feature_desc(Display_Feature_Metadata * meta, const char * feature_desc);
 #endif
 
+
+// Feature_Metadata_Table
+
+#define FEATURE_METADATA_TABLE_MARKER "FMDT"
+/** Immutable per-display table of feature metadata, indexed by feature code.
+ *
+ *  Built once for a display from the internal feature tables, the user
+ *  defined features record, and the display's VCP version, so that lookups
+ *  on the I/O path reduce to an array index.  Entries are NULL for features
+ *  that are not defined.
+ *
+ *  A table is never modified after it is built.  If it is replaced because
+ *  the user defined features or VCP version changed, the prior table is
+ *  retained, since pointers into it may still be held.
+ */
+typedef
+struct Feature_Metadata_Table {
+   char                            marker[4];
+   DDCA_MCCS_Version_Spec          vcp_version;
+   Dynamic_Features_Rec *          dfr;                 // user defined features, may be NULL
+   Display_Feature_Metadata *      internal[256];
+   DDCA_Feature_Metadata *         external[256];       // DDCA_PERSISTENT_METADATA set
+   struct Feature_Metadata_Table * prior;
+} Feature_Metadata_Table;
+
+void
+free_feature_metadata_table(Feature_Metadata_Table * table);
+
 // Conversion functions
 
 DDCA_Feature_Metadata *
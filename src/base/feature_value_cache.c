@@ -0,0 +1,255 @@
+/** @file feature_value_cache.c
+ *
+ *  Optional per-display cache of non-table VCP feature values.
+ *
+ *  Clients such as status bar widgets may read the same features every
+ *  second.  When the cache is enabled, a value read from the display is
+ *  retained in the display's #Per_Display_Data and returned for subsequent
+ *  reads until its time to live expires.
+ *
+ *  The time to live is determined by the caller when the value is saved,
+ *  either from a per-feature override set by the client or from the
+ *  feature's class.  Values that never expire are used for static read-only
+ *  features, e.g. the VCP version.  Values of other features are invalidated
+ *  by any write to the display, since a write can change the value of other
+ *  features (e.g. setting a color preset changes the RGB gains), and when
+ *  feature x02 reports that values have been changed using the display's
+ *  own controls.
+ *
+ *  The cache is tagged with the id of the #Display_Ref that filled it, so
+ *  values are not returned for a different display that appears on the same
+ *  bus after a hotplug event.
+ */
+
+// Copyright (C) 2025 Sanford Rockowitz <rockowitz@minsoft.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/** \cond */
+#include <assert.h>
+#include <glib-2.0/glib.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+/** \endcond */
+
+#include "util/report_util.h"
+#include "util/timestamp.h"
+
+#include "base/core.h"
+#include "base/parms.h"
+#include "base/per_display_data.h"
+#include "base/rtti.h"
+
+#include "base/feature_value_cache.h"
+
+// Trace class for this file
+static DDCA_Trace_Group TRACE_GROUP = DDCA_TRC_NONE;
+
+bool feature_value_cache_enabled           = DEFAULT_FEATURE_VALUE_CACHE_ENABLED;
+int  feature_value_cache_default_ttl_millis = DEFAULT_FEATURE_VALUE_CACHE_TTL_MILLIS;
+
+typedef struct {
+   DDCA_Non_Table_Vcp_Value value;
+   uint64_t                 expires_nanos;   // monotonic time, ignored if forever
+   bool                     valid;
+   bool                     forever;
+} Cached_Feature_Value;
+
+typedef struct Feature_Value_Cache {
+   uint                     dref_id;         // Display_Ref for which values were cached
+   int                      hit_ct;
+   int                      miss_ct;
+   int                      invalidation_ct;
+   Cached_Feature_Value     values[256];
+} Feature_Value_Cache;
+
+// Guards all caches.  Operations are short and never perform I/O.
+static GMutex fvc_mutex;
+
+static int ttl_overrides[256];
+
+
+/** Returns the cache for a display, allocating it if necessary.
+ *  If the cache was filled for a different #Display_Ref it is cleared.
+ *
+ *  Must be called with **fvc_mutex** held.
+ *
+ *  @param  dref  display reference
+ *  @return cache, NULL if the display has no #Per_Display_Data
+ */
+static Feature_Value_Cache *
+get_cache(Display_Ref * dref) {
+   Per_Display_Data * pdd = dref->pdd;
+   if (!pdd)
+      return NULL;
+   Feature_Value_Cache * cache = pdd->value_cache;
+   if (!cache) {
+      cache = g_new0(Feature_Value_Cache, 1);
+      cache->dref_id = dref->dref_id;
+      pdd->value_cache = cache;
+   }
+   else if (cache->dref_id != dref->dref_id) {
+      memset(cache->values, 0, sizeof(cache->values));
+      cache->dref_id = dref->dref_id;
+   }
+   return cache;
+}
+
+
+/** Looks up a cached feature value.
+ *
+ *  @param  dref          display reference
+ *  @param  feature_code  VCP feature code
+ *  @param  value_loc     where to return the value
+ *  @return true if an unexpired value was found, false if not
+ */
+bool
+fvc_lookup(Display_Ref * dref, Byte feature_code, DDCA_Non_Table_Vcp_Value * value_loc) {
+   bool debug = false;
+   bool found = false;
+
+   g_mutex_lock(&fvc_mutex);
+   Feature_Value_Cache * cache = get_cache(dref);
+   if (cache) {
+      Cached_Feature_Value * cfv = &cache->values[feature_code];
+      if (cfv->valid && (cfv->forever || cur_monotonic_nanosec() < cfv->expires_nanos)) {
+         *value_loc = cfv->value;
+         found = true;
+         cache->hit_ct++;
+      }
+      else {
+         cfv->valid = false;
+         cache->miss_ct++;
+      }
+   }
+   g_mutex_unlock(&fvc_mutex);
+
+   DBGTRC_EXECUTED(debug, TRACE_GROUP, "dref=%s, feature_code=0x%02x, returning %s",
+                                       dref_repr_t(dref), feature_code, sbool(found));
+   return found;
+}
+
+
+/** Saves a feature value in the cache.
+ *
+ *  @param  dref          display reference
+ *  @param  feature_code  VCP feature code
+ *  @param  value         value read from the display
+ *  @param  ttl_millis    time to live in milliseconds, or #DDCA_CACHE_TTL_FOREVER,
+ *                        if 0 the value is not cached
+ */
+void
+fvc_save(Display_Ref * dref, Byte feature_code, DDCA_Non_Table_Vcp_Value * value, int ttl_millis) {
+   bool debug = false;
+   DBGTRC_EXECUTED(debug, TRACE_GROUP, "dref=%s, feature_code=0x%02x, ttl_millis=%d",
+                                       dref_repr_t(dref), feature_code, ttl_millis);
+   if (ttl_millis == 0)
+      return;
+
+   g_mutex_lock(&fvc_mutex);
+   Feature_Value_Cache * cache = get_cache(dref);
+   if (cache) {
+      Cached_Feature_Value * cfv = &cache->values[feature_code];
+      cfv->value = *value;
+      cfv->forever = (ttl_millis == DDCA_CACHE_TTL_FOREVER);
+      cfv->expires_nanos = (cfv->forever) ? 0
+                              : cur_monotonic_nanosec() + MILLIS2NANOS((uint64_t) ttl_millis);
+      cfv->valid = true;
+   }
+   g_mutex_unlock(&fvc_mutex);
+}
+
+
+/** Invalidates cached values for a display.
+ *
+ *  @param  dref             display reference
+ *  @param  include_forever  if false, values that never expire are retained
+ */
+void
+fvc_invalidate(Display_Ref * dref, bool include_forever) {
+   bool debug = false;
+   DBGTRC_EXECUTED(debug, TRACE_GROUP, "dref=%s, include_forever=%s",
+                                       dref_repr_t(dref), sbool(include_forever));
+
+   g_mutex_lock(&fvc_mutex);
+   Per_Display_Data * pdd = dref->pdd;
+   Feature_Value_Cache * cache = (pdd) ? pdd->value_cache : NULL;
+   if (cache) {
+      for (int ndx = 0; ndx < 256; ndx++) {
+         Cached_Feature_Value * cfv = &cache->values[ndx];
+         if (include_forever || !cfv->forever)
+            cfv->valid = false;
+      }
+      cache->invalidation_ct++;
+   }
+   g_mutex_unlock(&fvc_mutex);
+}
+
+
+/** Sets the time to live for a feature, overriding the default for its class.
+ *
+ *  @param  feature_code  VCP feature code
+ *  @param  ttl_millis    time to live in milliseconds, #DDCA_CACHE_TTL_FOREVER,
+ *                        or #DDCA_CACHE_TTL_DEFAULT to remove the override
+ *  @return prior setting
+ */
+int
+fvc_set_ttl_override(Byte feature_code, int ttl_millis) {
+   g_mutex_lock(&fvc_mutex);
+   int old = ttl_overrides[feature_code];
+   ttl_overrides[feature_code] = ttl_millis;
+   g_mutex_unlock(&fvc_mutex);
+   return old;
+}
+
+
+/** Gets the time to live override for a feature.
+ *
+ *  @param  feature_code  VCP feature code
+ *  @return time to live in milliseconds, #DDCA_CACHE_TTL_FOREVER,
+ *          or #DDCA_CACHE_TTL_DEFAULT if not overridden
+ */
+int
+fvc_get_ttl_override(Byte feature_code) {
+   g_mutex_lock(&fvc_mutex);
+   int result = ttl_overrides[feature_code];
+   g_mutex_unlock(&fvc_mutex);
+   return result;
+}
+
+
+/** Frees a #Feature_Value_Cache
+ *
+ *  @param  cache  pointer to instance, may be NULL
+ */
+void
+fvc_free(Feature_Value_Cache * cache) {
+   free(cache);
+}
+
+
+void
+dbgrpt_feature_value_cache(Feature_Value_Cache * cache, int depth) {
+   if (!cache) {
+      rpt_vstring(depth, "Feature value cache: not allocated");
+      return;
+   }
+   int valid_ct = 0;
+   for (int ndx = 0; ndx < 256; ndx++) {
+      if (cache->values[ndx].valid)
+         valid_ct++;
+   }
+   rpt_vstring(depth, "Feature value cache: dref_id=%d, valid values=%d, hits=%d, misses=%d, invalidations=%d",
+         cache->dref_id, valid_ct, cache->hit_ct, cache->miss_ct, cache->invalidation_ct);
+}
+
+
+void
+init_feature_value_cache() {
+   for (int ndx = 0; ndx < 256; ndx++)
+      ttl_overrides[ndx] = DDCA_CACHE_TTL_DEFAULT;
+
+   RTTI_ADD_FUNC(fvc_lookup);
+   RTTI_ADD_FUNC(fvc_save);
+   RTTI_ADD_FUNC(fvc_invalidate);
+}
@@ -0,0 +1,37 @@
+/** @file feature_value_cache.h
+ *
+ *  Optional per-display cache of non-table VCP feature values
+ */
+
+// Copyright (C) 2025 Sanford Rockowitz <rockowitz@minsoft.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef FEATURE_VALUE_CACHE_H_
+#define FEATURE_VALUE_CACHE_H_
+
+#include <stdbool.h>
+
+#include "public/ddcutil_types.h"
+
+#include "util/coredefs_base.h"
+
+#include "base/displays.h"
+
+struct Feature_Value_Cache;
+
+extern bool feature_value_cache_enabled;
+extern int  feature_value_cache_default_ttl_millis;
+
+bool fvc_lookup(Display_Ref * dref, Byte feature_code, DDCA_Non_Table_Vcp_Value * value_loc);
+void fvc_save(Display_Ref * dref, Byte feature_code, DDCA_Non_Table_Vcp_Value * value, int ttl_millis);
+void fvc_invalidate(Display_Ref * dref, bool include_forever);
+
+int  fvc_set_ttl_override(Byte feature_code, int ttl_millis);
+int  fvc_get_ttl_override(Byte feature_code);
+
+void fvc_free(struct Feature_Value_Cache * cache);
+void dbgrpt_feature_value_cache(struct Feature_Value_Cache * cache, int depth);
+
+void init_feature_value_cache();
+
+#endif /* FEATURE_VALUE_CACHE_H_ */
@@ -92,6 +92,7 @@
 #define DSA_CACHE_FILENAME "dsa"
 #define CAPABILITIES_CACHE_FILENAME "capabilities"
 #define DISPLAYS_CACHE_FILENAME "displays"
+#define ADAPTERS_CACHE_FILENAME "adapters"
 
 
 //
@@ -104,6 +105,7 @@
 #define DEFAULT_ENABLE_UDF true
 #define DEFAULT_ENABLE_CACHED_CAPABILITIES true
 #define DEFAULT_ENABLE_CACHED_DISPLAYS false
+#define DEFAULT_ENABLE_CACHED_ADAPTERS true
 #define DEFAULT_ENABLE_DSA2 true
 #define DEFAULT_ENABLE_FLOCK true
 #define DEFAULT_SETVCP_VERIFY true
@@ -116,6 +118,8 @@
 #else
 #define DEFAULT_WATCH_MODE Watch_Mode_Poll
 #endif
+/** Share display change detection with other libddcutil processes of the same user */
+#define DEFAULT_WATCH_BROKER_ENABLED false
 
 //
 // Asynchronous Initialization
@@ -123,10 +127,16 @@
 
 #define CHECK_ASYNC_NEVER 99
 /** Parallelize bus checks if at least this number of checkable /dev/i2c devices exist */
-#define DEFAULT_BUS_CHECK_ASYNC_THRESHOLD CHECK_ASYNC_NEVER
+#define DEFAULT_BUS_CHECK_ASYNC_THRESHOLD 2
 /** Parallelize DDC communication checks if at least this number of /dev/i2c devices have an EDID */
 // on workstation banner with 4 displays, async  detect: 1.7 sec, non-async 3.4 sec
-#define DEFAULT_DDC_CHECK_ASYNC_THRESHOLD 3
+#define DEFAULT_DDC_CHECK_ASYNC_THRESHOLD 2
+/** Maximum number of threads in the shared worker pool used for parallel checks */
+#define DEFAULT_WORKER_POOL_MAX_THREADS 8
+/** Number of threads that invoke display status callbacks */
+#define DEFAULT_CALLBACK_EXECUTOR_THREADS 2
+/** Maximum number of display status callback invocations awaiting execution */
+#define DEFAULT_CALLBACK_EXECUTOR_MAX_QUEUED 256
 
 
 //
@@ -137,6 +147,9 @@
 #define DEFAULT_OPEN_MAX_WAIT_MILLISEC 1000
 #define DEFAULT_OPEN_WAIT_INTERVAL_MILLISEC 100
 
+/** How long a closed /dev/i2c-N file descriptor is kept open for reuse, 0 to disable */
+#define DEFAULT_I2C_FD_POOL_MILLISEC 5000
+
 // Retry interval and max tries when checking that a display handle
 // is still valid
 #define CHECK_OPEN_BUS_ALIVE_RETRY_MILLISEC 1000
@@ -146,6 +159,17 @@
 #define DETECT_X37_MAX_TRIES 3
 #define DETECT_X37_RETRY_MILLISEC 400
 
+// Polling for VCP feature changes (features x02, x52)
+/** Polling interval immediately after a feature change is seen */
+#define DEFAULT_VCP_MONITOR_MIN_INTERVAL_MILLIS  250
+/** When no changes are seen the polling interval backs off to at most this value */
+#define DEFAULT_VCP_MONITOR_MAX_INTERVAL_MILLIS 4000
+
+// Feature value cache (see feature_value_cache.c)
+#define DEFAULT_FEATURE_VALUE_CACHE_ENABLED false
+/** How long a value read from a writable feature is used before it is reread */
+#define DEFAULT_FEATURE_VALUE_CACHE_TTL_MILLIS 3000
+
 
 //
 // *** Watching for display changes
@@ -178,6 +202,9 @@
 #define DEFAULT_FLOCK_POLL_MILLISEC      100
 #define DEFAULT_FLOCK_MAX_WAIT_MILLISEC 3000
 
+// Maximum time quiesce_api() waits for active API calls to complete
+#define QUIESCE_API_MAX_WAIT_MILLISEC   3000
+
 /** Maximum number of i2c buses this code supports */
 #define I2C_BUS_MAX 64
 
@@ -21,6 +21,7 @@
 #include "base/display_retry_data.h"    // temp circular
 #include "base/displays.h"
 #include "base/dsa2.h"
+#include "base/feature_value_cache.h"
 #include "base/parms.h"
 #include "base/per_display_data.h"
 #include "base/per_thread_data.h"
@@ -217,6 +218,7 @@ void pdd_cross_display_operation_block(const char * caller) {
 void per_display_data_destroy(void * data) {
    if (data) {
       Per_Display_Data * pdd = data;
+      fvc_free(pdd->value_cache);
       free(pdd);
    }
 }
@@ -370,6 +372,7 @@ void pdd_init_pdd(Per_Display_Data * pdd) {
    pdd->max_successful_sleep_multiplier = -1.0;
    pdd->total_successful_sleep_multiplier = 0;
    pdd->successful_sleep_multiplier_ct = 0;
+   pdd->max_fragment_size = 0;
 
    DBGTRC_DONE(debug, DDCA_TRC_NONE, "Device = %s, user_sleep_multiplier=%4.2f",
                       dpath_repr_t(&pdd->dpath), pdd->user_sleep_multiplier);
@@ -510,11 +513,13 @@ void dbgrpt_per_display_data(Per_Display_Data * pdd, int depth) {
    rpt_vstring(d1, "dsa2_enabled                                             : %s", sbool(pdd->dsa2_enabled));
    rpt_vstring(d1, "dynamic_sleep_active                                     : %s", sbool(pdd->dynamic_sleep_active));
    rpt_vstring(d1, "cur_loop_null_adjustment_occurred                        : %s", sbool(pdd->cur_loop_null_adjustment_occurred));
+   rpt_vstring(d1, "max_fragment_size                                        : %d", pdd->max_fragment_size);
    rpt_vstring(d1, "successful_sleep_multiplier_ct                           : %d", pdd->successful_sleep_multiplier_ct);
    rpt_vstring(d1, "total_successful_sleep_multiplier                        : %5.2f", pdd->total_successful_sleep_multiplier);
    rpt_vstring(d1, "average successful sleep _multiplier                     : %3.2f", pdd->total_successful_sleep_multiplier/pdd->successful_sleep_multiplier_ct);
    rpt_vstring(d1, "min_successful_sleep_multiplier                          : %3.2f", pdd->min_successful_sleep_multiplier);
    rpt_vstring(d1, "max_successful_sleep_multiplier                          : %3.2f", pdd->max_successful_sleep_multiplier);
+   dbgrpt_feature_value_cache(pdd->value_cache, d1);
 
    // Maxtries history
    for (int retry_type = 0; retry_type < 4; retry_type++) {
@@ -25,6 +25,7 @@
 // use struct instead of #include "dsa2.h", etc. to avoid circular includes
 struct DSA0_Data;
 struct Results_Table;
+struct Feature_Value_Cache;
 
 extern GHashTable *  per_display_data_hash;
 // extern GMutex     per_display_data_mutex;    // temp, replace by function calls
@@ -63,6 +64,8 @@ typedef struct Per_Display_Data {
    bool                   dsa2_enabled;
    bool                   dynamic_sleep_active;
    bool                   cur_loop_null_adjustment_occurred;
+   int                    max_fragment_size;         // largest multi-part read fragment seen, 0 if none
+   struct Feature_Value_Cache * value_cache;         // allocated when first used
 } Per_Display_Data;
 
 // For new displays
@@ -37,6 +37,7 @@ static DDCA_Trace_Group TRACE_GROUP = DDCA_TRC_SLEEP;
 //
 
 static bool deferred_sleep_enabled = false;
+static __thread bool thread_deferred_sleep_enabled = false;
 bool suppress_se_post_read = false;
 bool null_msg_adjustment_enabled = false;
 
@@ -61,6 +62,20 @@ bool is_deferred_sleep_enabled() {
 }
 
 
+/** Enables or disables deferred sleep for the current thread only, e.g. for
+ *  the duration of a batch operation.  Sleeps are deferred if deferred sleep
+ *  is enabled either globally or for the current thread.
+ *
+ *  @param  onoff  true to enable, false to disable
+ *  @return prior value
+ */
+bool enable_thread_deferred_sleep(bool onoff) {
+   bool old = thread_deferred_sleep_enabled;
+   thread_deferred_sleep_enabled = onoff;
+   return old;
+}
+
+
 /** Given a sleep event type, return its sleep time in milliseconds as per the
  *  DDC/CI spec, and also whether the sleep can be deferred.
  *
@@ -97,16 +112,16 @@ static int get_sleep_time(
       //  spec_sleep_time_millis = DDC_TIMEOUT_MILLIS_BETWEEN_GETVCP_WRITE_READ;
       spec_sleep_time_millis = DDC_TIMEOUT_MILLIS_DEFAULT;
       // spec_sleep_time_millis = 0; // *** TEMP ***
-      deferrable_sleep = deferred_sleep_enabled;
+      deferrable_sleep = deferred_sleep_enabled || thread_deferred_sleep_enabled;
       break;
    case SE_POST_WRITE: // post SET VCP FEATURE write, between SET TABLE write fragments, after final?
       // 4.4 Set VCP Feature:
       //   The host should wait at least 50ms to ensure next message is received by the display
       spec_sleep_time_millis = DDC_TIMEOUT_MILLIS_DEFAULT;
-      deferrable_sleep = deferred_sleep_enabled;
+      deferrable_sleep = deferred_sleep_enabled || thread_deferred_sleep_enabled;
       break;
    case SE_POST_READ:
-      deferrable_sleep = deferred_sleep_enabled;
+      deferrable_sleep = deferred_sleep_enabled || thread_deferred_sleep_enabled;
       spec_sleep_time_millis = DDC_TIMEOUT_MILLIS_DEFAULT;
       if (suppress_se_post_read) {
          DBGMSG("Suppressing SE_POST_READ");
@@ -116,7 +131,7 @@ static int get_sleep_time(
    case SE_POST_SAVE_SETTINGS:
       // 4.5 Save Current Settings:
       // The host should wait at least 200 ms before sending the next message to the display
-      deferrable_sleep = deferred_sleep_enabled;
+      deferrable_sleep = deferred_sleep_enabled || thread_deferred_sleep_enabled;
       spec_sleep_time_millis = DDC_TIMEOUT_MILLIS_POST_SAVE_SETTINGS; // per DDC spec
       break;
    case SE_PRE_MULTI_PART_READ:
@@ -22,6 +22,7 @@ extern bool null_msg_adjustment_enabled;
 
 bool enable_deferred_sleep(bool enable);
 bool is_deferred_sleep_enabled();
+bool enable_thread_deferred_sleep(bool enable);
 
 void check_deferred_sleep(
       Display_Handle * dh,
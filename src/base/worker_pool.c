@@ -0,0 +1,319 @@
+/** @file worker_pool.c
+ *
+ *  Bounded pool of worker threads shared by bus checks, initial display
+ *  checks, redetection, and display watch rechecks.
+ *
+ *  Work is submitted as a batch of tasks, e.g. one task per I2C bus.
+ *  Pool threads claim tasks from the batch in submission order.  While
+ *  waiting for the batch to complete, the submitting thread also claims
+ *  and executes tasks that have not yet been started.  Consequently no
+ *  thread sits idle while a batch still has unstarted work, a slow bus
+ *  does not hold up the remaining buses, and a batch submitted from within
+ *  a pool thread cannot deadlock.
+ *
+ *  Threads are created lazily and reused, so the number of threads never
+ *  exceeds #worker_pool_max_threads no matter how many buses exist.
+ */
+
+// Copyright (C) 2025 Sanford Rockowitz <rockowitz@minsoft.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/** \cond */
+#include <assert.h>
+#include <glib-2.0/glib.h>
+#include <stdlib.h>
+#include <string.h>
+/** \endcond */
+
+#include "util/debug_util.h"
+#include "util/report_util.h"
+#include "util/traced_function_stack.h"
+
+#include "base/core.h"
+#include "base/parms.h"
+#include "base/rtti.h"
+
+#include "base/worker_pool.h"
+
+// Trace class for this file
+static DDCA_Trace_Group TRACE_GROUP = DDCA_TRC_BASE;
+
+int worker_pool_max_threads = DEFAULT_WORKER_POOL_MAX_THREADS;
+
+static GThreadPool * worker_pool = NULL;
+static GMutex        worker_pool_mutex;
+static GPrivate      worker_thread_key;     // non-NULL iff current thread is a pool thread
+
+// Statistics, updated atomically
+static gint stats_batches;
+static gint stats_tasks;
+static gint stats_tasks_run_by_pool;
+static gint stats_tasks_run_by_submitter;
+static gint stats_active_tasks;
+static gint stats_max_active_tasks;
+
+
+typedef struct {
+   Worker_Task_Func func;
+   void *           data;
+   void *           result;
+} Worker_Task;
+
+
+#define WORKER_BATCH_MARKER "WBAT"
+struct Worker_Batch {
+   char        marker[4];
+   char *      name;
+   GPtrArray * tasks;              // array of Worker_Task *
+   guint       next_unclaimed;     // index of next task to be started
+   guint       completed_ct;
+   int         refct;              // submitter plus pending pool items
+   GMutex      mutex;
+   GCond       completed_cond;
+};
+
+
+static void
+wp_unref_batch(Worker_Batch * batch) {
+   g_mutex_lock(&batch->mutex);
+   int refct = --batch->refct;
+   g_mutex_unlock(&batch->mutex);
+   if (refct == 0) {
+      batch->marker[3] = 'x';
+      g_ptr_array_free(batch->tasks, true);
+      g_mutex_clear(&batch->mutex);
+      g_cond_clear(&batch->completed_cond);
+      free(batch->name);
+      free(batch);
+   }
+}
+
+
+/** Claims the next unstarted task in a batch.
+ *
+ *  @param  batch
+ *  @return task, NULL if all tasks have been claimed
+ */
+static Worker_Task *
+wp_claim_task(Worker_Batch * batch) {
+   Worker_Task * task = NULL;
+   g_mutex_lock(&batch->mutex);
+   if (batch->next_unclaimed < batch->tasks->len)
+      task = g_ptr_array_index(batch->tasks, batch->next_unclaimed++);
+   g_mutex_unlock(&batch->mutex);
+   return task;
+}
+
+
+static void
+wp_execute_task(Worker_Batch * batch, Worker_Task * task, bool by_pool) {
+   g_atomic_int_inc( (by_pool) ? &stats_tasks_run_by_pool : &stats_tasks_run_by_submitter);
+   int active = g_atomic_int_add(&stats_active_tasks, 1) + 1;
+   int max_active = g_atomic_int_get(&stats_max_active_tasks);
+   while (active > max_active &&
+          !g_atomic_int_compare_and_exchange(&stats_max_active_tasks, max_active, active))
+      max_active = g_atomic_int_get(&stats_max_active_tasks);
+
+   task->result = task->func(task->data);
+
+   g_atomic_int_add(&stats_active_tasks, -1);
+   g_mutex_lock(&batch->mutex);
+   batch->completed_ct++;
+   g_cond_broadcast(&batch->completed_cond);
+   g_mutex_unlock(&batch->mutex);
+}
+
+
+/** Function executed by pool threads.  Each queued item runs at
+ *  most one task, since the submitter may already have taken it.
+ *
+ *  @param data       #Worker_Batch
+ *  @param user_data  unused
+ */
+static void
+wp_pool_thread_func(gpointer data, gpointer user_data) {
+   Worker_Batch * batch = data;
+   assert(memcmp(batch->marker, WORKER_BATCH_MARKER, 4) == 0);
+   g_private_set(&worker_thread_key, GINT_TO_POINTER(1));
+
+   Worker_Task * task = wp_claim_task(batch);
+   if (task)
+      wp_execute_task(batch, task, true);
+   wp_unref_batch(batch);
+
+   // pool threads are reused, don't let one task's stack leak into the next
+   free_current_traced_function_stack();
+}
+
+
+static GThreadPool *
+wp_get_pool() {
+   g_mutex_lock(&worker_pool_mutex);
+   if (!worker_pool) {
+      GError * gerr = NULL;
+      worker_pool = g_thread_pool_new(wp_pool_thread_func,
+                                      NULL,                     // user_data
+                                      worker_pool_max_threads,
+                                      false,                    // exclusive
+                                      &gerr);
+      if (!worker_pool) {
+         SYSLOG2(DDCA_SYSLOG_ERROR, "g_thread_pool_new() failed: %s", gerr->message);
+         g_error_free(gerr);
+      }
+   }
+   g_mutex_unlock(&worker_pool_mutex);
+   return worker_pool;
+}
+
+
+/** Reports whether the current thread is a worker pool thread.
+ *
+ *  @return true/false
+ */
+bool wp_is_worker_thread() {
+   return g_private_get(&worker_thread_key);
+}
+
+
+/** Sets the maximum number of threads in the worker pool.
+ *
+ *  @param max_threads  maximum thread count, must be > 0
+ */
+void wp_set_max_threads(int max_threads) {
+   bool debug = false;
+   DBGTRC_STARTING(debug, TRACE_GROUP, "max_threads=%d", max_threads);
+   assert(max_threads > 0);
+
+   g_mutex_lock(&worker_pool_mutex);
+   worker_pool_max_threads = max_threads;
+   if (worker_pool)
+      g_thread_pool_set_max_threads(worker_pool, max_threads, NULL);
+   g_mutex_unlock(&worker_pool_mutex);
+
+   DBGTRC_DONE(debug, TRACE_GROUP, "");
+}
+
+
+/** Creates a new, empty batch of tasks.
+ *
+ *  @param  name  name used in debug messages
+ *  @return newly allocated #Worker_Batch
+ */
+Worker_Batch *
+wp_new_batch(const char * name) {
+   Worker_Batch * batch = calloc(1, sizeof(Worker_Batch));
+   memcpy(batch->marker, WORKER_BATCH_MARKER, 4);
+   batch->name = g_strdup(name);
+   batch->tasks = g_ptr_array_new_with_free_func(free);
+   batch->refct = 1;
+   g_mutex_init(&batch->mutex);
+   g_cond_init(&batch->completed_cond);
+   g_atomic_int_inc(&stats_batches);
+   return batch;
+}
+
+
+/** Adds a task to a batch.  Execution may begin immediately.
+ *
+ *  @param  batch
+ *  @param  func   function to execute
+ *  @param  data   argument passed to **func**
+ */
+void
+wp_batch_add(Worker_Batch * batch, Worker_Task_Func func, void * data) {
+   assert(batch && memcmp(batch->marker, WORKER_BATCH_MARKER, 4) == 0);
+   Worker_Task * task = calloc(1, sizeof(Worker_Task));
+   task->func = func;
+   task->data = data;
+
+   g_mutex_lock(&batch->mutex);
+   g_ptr_array_add(batch->tasks, task);
+   batch->refct++;
+   g_mutex_unlock(&batch->mutex);
+   g_atomic_int_inc(&stats_tasks);
+
+   GThreadPool * pool = wp_get_pool();
+   if (!pool || !g_thread_pool_push(pool, batch, NULL)) {
+      // submitter will execute the task in wp_batch_wait()
+      wp_unref_batch(batch);
+   }
+}
+
+
+/** Waits for all tasks in a batch to complete, executing unstarted
+ *  tasks in the current thread.  The batch is released.
+ *
+ *  @param  batch
+ *  @return array of values returned by the task functions, in the
+ *          order the tasks were added. Caller must free.
+ */
+GPtrArray *
+wp_batch_wait(Worker_Batch * batch) {
+   bool debug = false;
+   assert(batch && memcmp(batch->marker, WORKER_BATCH_MARKER, 4) == 0);
+   DBGTRC_STARTING(debug, TRACE_GROUP, "batch=%s, task count=%d", batch->name, batch->tasks->len);
+
+   Worker_Task * task;
+   while ( (task = wp_claim_task(batch)) )
+      wp_execute_task(batch, task, false);
+
+   g_mutex_lock(&batch->mutex);
+   while (batch->completed_ct < batch->tasks->len)
+      g_cond_wait(&batch->completed_cond, &batch->mutex);
+   GPtrArray * results = g_ptr_array_sized_new(batch->tasks->len);
+   for (int ndx = 0; ndx < batch->tasks->len; ndx++) {
+      Worker_Task * cur = g_ptr_array_index(batch->tasks, ndx);
+      g_ptr_array_add(results, cur->result);
+   }
+   g_mutex_unlock(&batch->mutex);
+
+   DBGTRC_DONE(debug, TRACE_GROUP, "batch=%s", batch->name);
+   wp_unref_batch(batch);
+   return results;
+}
+
+
+/** Executes a function on each item of an array using the worker pool,
+ *  and waits for completion.
+ *
+ *  @param  name   batch name, used in debug messages
+ *  @param  items  array of data pointers
+ *  @param  func   function to execute on each item
+ *  @return array of values returned by **func**, one per item, in order.
+ *          Caller must free.
+ */
+GPtrArray *
+wp_run_parallel(const char * name, GPtrArray * items, Worker_Task_Func func) {
+   Worker_Batch * batch = wp_new_batch(name);
+   for (int ndx = 0; ndx < items->len; ndx++)
+      wp_batch_add(batch, func, g_ptr_array_index(items, ndx));
+   return wp_batch_wait(batch);
+}
+
+
+void report_worker_pool_stats(int depth) {
+   int d1 = depth+1;
+   rpt_label(depth, "Worker pool:");
+   rpt_vstring(d1, "Maximum threads:              %d", worker_pool_max_threads);
+   rpt_vstring(d1, "Batches submitted:            %d", g_atomic_int_get(&stats_batches));
+   rpt_vstring(d1, "Tasks submitted:              %d", g_atomic_int_get(&stats_tasks));
+   rpt_vstring(d1, "Tasks run by pool threads:    %d", g_atomic_int_get(&stats_tasks_run_by_pool));
+   rpt_vstring(d1, "Tasks run by submitter:       %d", g_atomic_int_get(&stats_tasks_run_by_submitter));
+   rpt_vstring(d1, "Maximum concurrent tasks:     %d", g_atomic_int_get(&stats_max_active_tasks));
+}
+
+
+void init_worker_pool() {
+   RTTI_ADD_FUNC(wp_set_max_threads);
+   RTTI_ADD_FUNC(wp_batch_wait);
+}
+
+
+void terminate_worker_pool() {
+   g_mutex_lock(&worker_pool_mutex);
+   if (worker_pool) {
+      g_thread_pool_free(worker_pool, /*immediate*/ false, /*wait*/ true);
+      worker_pool = NULL;
+   }
+   g_mutex_unlock(&worker_pool_mutex);
+}
@@ -0,0 +1,37 @@
+/** @file worker_pool.h
+ *
+ *  Bounded pool of worker threads shared by bus checks, initial display
+ *  checks, redetection, and display watch rechecks.
+ */
+
+// Copyright (C) 2025 Sanford Rockowitz <rockowitz@minsoft.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef WORKER_POOL_H_
+#define WORKER_POOL_H_
+
+/** \cond */
+#include <glib-2.0/glib.h>
+#include <stdbool.h>
+/** \endcond */
+
+extern int worker_pool_max_threads;
+
+/** Signature of a function executed by the worker pool.
+ *  The value returned is collected by #wp_batch_wait().
+ */
+typedef void * (*Worker_Task_Func)(void * data);
+
+typedef struct Worker_Batch Worker_Batch;
+
+Worker_Batch * wp_new_batch(const char * name);
+void           wp_batch_add(Worker_Batch * batch, Worker_Task_Func func, void * data);
+GPtrArray *    wp_batch_wait(Worker_Batch * batch);
+GPtrArray *    wp_run_parallel(const char * name, GPtrArray * items, Worker_Task_Func func);
+bool           wp_is_worker_thread();
+void           wp_set_max_threads(int max_threads);
+void           report_worker_pool_stats(int depth);
+void           init_worker_pool();
+void           terminate_worker_pool();
+
+#endif /* WORKER_POOL_H_ */
@@ -472,7 +472,7 @@ char * commands_list_help =
 #ifdef DEPRECATED
        "   watch                                   Watch display for reported changes (under development)\n"
 #endif
-       "   discard (all|capabilities|dsa) cache(s) Delete cache files\n"
+       "   discard (all|capabilities|dsa|adapters) cache(s) Delete cache files\n"
        "   traceable-functions                     List traceable functions\n";
 
 #ifdef OLD
@@ -573,7 +573,8 @@ char * stats_multiple_call_option_help =
        "Stats:\n"
        "  The argument to --stats is a statistics class.  Specify the --stats option multiple\n"
        "  times to activate multiple statistics classes, e.g. \"--stats calls --stats errors\"\n"
-       "  Valid statistics classes are:  TRY, TRIES, ERRS, ERRORS, CALLS, ELAPSED, ALL.\n"
+       "  Valid statistics classes are:  TRY, TRIES, ERRS, ERRORS, CALLS, ELAPSED,\n"
+       "  DETECTION, ALL.\n"
        "  Statistics class names are not case sensitive and can abbreviated to 3 characters.\n"
        "  If no argument is specified, or ALL is specified, then all statistics classes are\n"
        "  output.\n"
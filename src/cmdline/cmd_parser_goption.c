@@ -111,6 +111,9 @@ stats_arg_func(const    gchar* option_name,
       else if ( streq(v2,"API") ){
          stats_work |= DDCA_STATS_API;
       }
+      else if ( is_abbrev(v2,"DETECTION",3) ){
+         stats_work |= DDCA_STATS_DETECTION;
+      }
       else
          ok = false;
       free(v2);
@@ -149,6 +152,9 @@ discard_cache_arg_func(
       else if (streq(v2,"DSA") || is_abbrev(v2, "SLEEP",3)) {
          discarded_caches_work |= DSA2_CACHE;
       }
+      else if ( is_abbrev(v2, "ADAPTERS",3)) {
+         discarded_caches_work |= ADAPTERS_CACHE;
+      }
       else
          ok = false;
       free(v2);
@@ -514,6 +520,10 @@ static bool parse_watch_mode(
 #endif
    // else if (is_abbrev(v2, "UDEV", 3))
    //    parsed_cmd->watch_mode = Watch_Mode_Udev;
+#ifdef USE_LIBDRM
+      else if (is_abbrev(v2, "DRM", 3))
+         parsed_cmd->watch_mode = Watch_Mode_Drm;
+#endif
       else if (is_abbrev(v2, "DYNAMIC", 3))
          parsed_cmd->watch_mode = Watch_Mode_Dynamic;
 
@@ -739,6 +749,8 @@ static bool parse_discard_args(Parsed_Cmd * parsed_cmd, GPtrArray* errmsgs) {
 #endif
          else if (is_abbrev(parsed_cmd->args[0], "DSA", 3) )
             parsed_cmd->discarded_cache_types = DSA2_CACHE;
+         else if (is_abbrev(parsed_cmd->args[0], "ADAPTERS", 3) )
+            parsed_cmd->discarded_cache_types = ADAPTERS_CACHE;
          else if (is_abbrev(parsed_cmd->args[0], "ALL", 3) )
             parsed_cmd->discarded_cache_types = ALL_CACHES;
          else
@@ -975,13 +987,19 @@ parse_command(
    const char * disable_cd_expl = (enable_cd_flag) ? "Disable cached displays" : "Disable cached displays (default)";
 // #endif
 
+   gboolean enable_ac_flag = DEFAULT_ENABLE_CACHED_ADAPTERS;
+   const char * enable_ac_expl =  (enable_ac_flag) ? "Enable cached I2C adapter classifications (default)" : "Enable cached I2C adapter classifications";
+   const char * disable_ac_expl = (enable_ac_flag) ? "Disable cached I2C adapter classifications" : "Disable cached I2C adapter classifications (default)";
+
    gboolean enable_flock_flag = DEFAULT_ENABLE_FLOCK;
    const char * enable_flock_expl =  (enable_flock_flag) ? "Enable cross-instance locking (default)" : "Enable cross-instance locking";
    const char * disable_flock_expl = (enable_flock_flag) ? "Disable cross-instance locking" : "Disable cross-instance locking (default)";
+   gint     i2c_fd_pool_millis_work = DEFAULT_I2C_FD_POOL_MILLISEC;
 
    gboolean quick_flag         = false;
    gboolean mock_data_flag     = false;
    gboolean profile_api_flag   = false;
+   gboolean detect_timings_flag = false;
    gboolean null_msg_for_unsupported_flag = false;
    gboolean enable_heuristic_unsupported_flag = true;
 
@@ -1029,14 +1047,22 @@ parse_command(
    case Watch_Mode_Xevent:   default_watch_mode_keyword = "XEVENT";  break;
    case Watch_Mode_Poll:     default_watch_mode_keyword = "POLL";    break;
    case Watch_Mode_Udev:     default_watch_mode_keyword = "UDEV";    break;
+   case Watch_Mode_Drm:      default_watch_mode_keyword = "DRM";     break;
    }
    char watch_mode_expl[80];
+#ifdef USE_LIBDRM
+#define DRM_WATCH_MODE_KEYWORD "|DRM"
+#else
+#define DRM_WATCH_MODE_KEYWORD ""
+#endif
 #ifdef USE_X11
-   g_snprintf(watch_mode_expl, 80, "DYNAMIC|XEVENT|POLL, default: %s", default_watch_mode_keyword);
+   g_snprintf(watch_mode_expl, 80, "DYNAMIC|XEVENT|POLL%s, default: %s", DRM_WATCH_MODE_KEYWORD, default_watch_mode_keyword);
 #else
-   g_snprintf(watch_mode_expl, 80, "DYNAMIC|POLL, default: %s", default_watch_mode_keyword);
+   g_snprintf(watch_mode_expl, 80, "DYNAMIC|POLL%s, default: %s", DRM_WATCH_MODE_KEYWORD, default_watch_mode_keyword);
 #endif
+#undef DRM_WATCH_MODE_KEYWORD
    gboolean enable_watch_displays = true;
+   gboolean watch_broker_flag = DEFAULT_WATCH_BROKER_ENABLED;
 #ifdef USE_X11
    gint     xevent_watch_loop_millis_work = DEFAULT_XEVENT_WATCH_LOOP_MILLISEC;
 #endif
@@ -1186,6 +1212,7 @@ parse_command(
                         G_OPTION_ARG_CALLBACK, stats_arg_func,    "Show detailed and internal performance statistics",  "stats type"},
       {"profile-api",'\0', G_OPTION_FLAG_HIDDEN,
                            G_OPTION_ARG_NONE, &profile_api_flag,      "Profile API calls", NULL},
+      {"timings", '\0', 0, G_OPTION_ARG_NONE, &detect_timings_flag,   "Report display detection timings (detect)", NULL},
       {"syslog",      '\0',0, G_OPTION_ARG_STRING,       &syslog_work,                    "system log level", valid_syslog_levels_string},
 
       // Performance
@@ -1199,6 +1226,11 @@ parse_command(
       {"disable-displays-cache", '\0', G_OPTION_FLAG_REVERSE|G_OPTION_FLAG_HIDDEN,
                             G_OPTION_ARG_NONE,     &enable_cd_flag,   disable_cd_expl ,   NULL},
 
+      {"enable-adapter-cache",
+                  '\0', 0, G_OPTION_ARG_NONE,     &enable_ac_flag,   enable_ac_expl,     NULL},
+      {"disable-adapter-cache", '\0', G_OPTION_FLAG_REVERSE,
+                           G_OPTION_ARG_NONE,     &enable_ac_flag,   disable_ac_expl ,   NULL},
+
       {"sleep-multiplier", '\0', 0,
                             G_OPTION_ARG_STRING,   &sleep_multiplier_work, "Multiplication factor for DDC sleeps", "number"},
 
@@ -1288,6 +1320,8 @@ parse_command(
             '\0', 0, G_OPTION_ARG_NONE,     &enable_flock_flag,   enable_flock_expl,     NULL},
       {"disable-flock", '\0', G_OPTION_FLAG_REVERSE,
                        G_OPTION_ARG_NONE,     &enable_flock_flag,   disable_flock_expl ,   NULL},
+      {"i2c-fd-pool-millisec", '\0', 0,
+                       G_OPTION_ARG_INT,      &i2c_fd_pool_millis_work, "How long to keep a closed I2C device open for reuse, 0 to disable", "milliseconds"},
 
       {"enable-try-get-edid-from-sysfs", '\0', 0,
                             G_OPTION_ARG_NONE,    &try_get_edid_from_sysfs,   enable_tgefs_expl, NULL},
@@ -1299,6 +1333,8 @@ parse_command(
                                 G_OPTION_ARG_NONE, &enable_watch_displays, "Do not watch for display change events", NULL },
       {"watch-mode", '\0', G_OPTION_FLAG_HIDDEN,
                            G_OPTION_ARG_STRING, &watch_mode_work, "How to watch for display changes",  watch_mode_expl},
+      {"watch-broker", '\0', 0,
+                           G_OPTION_ARG_NONE, &watch_broker_flag, "Share display change detection with other libddcutil processes", NULL},
 #ifdef USE_X11
       {"xevent-watch-loop-millisec", '\0', G_OPTION_FLAG_HIDDEN,
                            G_OPTION_ARG_INT, &xevent_watch_loop_millis_work, "Loop delay for mode XEVENT", "milliseconds"},
@@ -1690,6 +1726,7 @@ parse_command(
       LIBDDCUTIL_ONLY_OPTION("--libddcutil-trace-file", parsed_cmd->trace_destination);
 #ifdef WATCH_DISPLAYS
       LIBDDCUTIL_ONLY_OPTION("--disable-watch-displays", !enable_watch_displays);
+      LIBDDCUTIL_ONLY_OPTION("--watch-broker",          watch_broker_flag);
 #endif
       LIBDDCUTIL_ONLY_OPTION("--disable-api",           disable_api_flag);
    }
@@ -1760,6 +1797,7 @@ parse_command(
 
 #ifdef WATCH_DISPLAYS
    SET_CMDFLAG(CMD_FLAG_WATCH_DISPLAY_EVENTS,    enable_watch_displays);
+   SET_CMDFLAG(CMD_FLAG_WATCH_BROKER,            watch_broker_flag);
 #endif
    SET_CMDFLAG(CMD_FLAG_DISABLE_API,       disable_api_flag);
    SET_CMDFLAG(CMD_FLAG_X52_NO_FIFO,       x52_no_fifo_flag);
@@ -1769,6 +1807,7 @@ parse_command(
    SET_CMDFLAG(CMD_FLAG_QUICK,             quick_flag);
    SET_CMDFLAG(CMD_FLAG_MOCK,              mock_data_flag);
    SET_CMDFLAG(CMD_FLAG_PROFILE_API,       profile_api_flag);
+   SET_CMDFLAG(CMD_FLAG_DETECT_TIMINGS,    detect_timings_flag);
    SET_CMDFLAG(CMD_FLAG_TRACE_TO_SYSLOG_ONLY, trace_to_syslog_only_flag);
    SET_CMDFLAG(CMD_FLAG_STATS_TO_SYSLOG, stats_to_syslog_only_flag);
    SET_CMDFLAG(CMD_FLAG_NULL_MSG_INDICATES_UNSUPPORTED_FEATURE, null_msg_for_unsupported_flag);
@@ -1786,6 +1825,7 @@ parse_command(
 // #ifdef REMOVED
    SET_CLR_CMDFLAG(CMD_FLAG_ENABLE_CACHED_DISPLAYS, enable_cd_flag);
 // #endif
+   parsed_cmd->enable_adapter_cache = enable_ac_flag;
 
    SET_CMDFLAG2(CMD_FLAG2_F1,                f1_flag);
    SET_CMDFLAG2(CMD_FLAG2_F2,                f2_flag);
@@ -2102,6 +2142,14 @@ parse_command(
       parsed_cmd->poll_watch_loop_millisec = (uint16_t) poll_watch_loop_millis_work;
 #endif
 
+   if (i2c_fd_pool_millis_work < 0) {
+      EMIT_PARSER_ERROR(errmsgs,
+            "--i2c-fd-pool-millisec is negative: %d", i2c_fd_pool_millis_work);
+      parsing_ok = false;
+   }
+   else
+      parsed_cmd->i2c_fd_pool_millisec = i2c_fd_pool_millis_work;
+
    // All options processed.  Check for consistency, set defaults
 
    if (parser_mode == MODE_LIBDDCUTIL && rest_ct > 0) {
@@ -145,6 +145,8 @@ Parsed_Cmd *  new_parsed_cmd() {
    // parsed_cmd->watch_mode = Watch_Mode_Dynamic;
    parsed_cmd->xevent_watch_loop_millisec = DEFAULT_XEVENT_WATCH_LOOP_MILLISEC;
    parsed_cmd->poll_watch_loop_millisec   = DEFAULT_POLL_WATCH_LOOP_MILLISEC;
+   parsed_cmd->i2c_fd_pool_millisec       = DEFAULT_I2C_FD_POOL_MILLISEC;
+   parsed_cmd->enable_adapter_cache       = DEFAULT_ENABLE_CACHED_ADAPTERS;
    return parsed_cmd;
 }
 
@@ -264,6 +266,7 @@ void dbgrpt_parsed_cmd(Parsed_Cmd * parsed_cmd, int depth) {
       rpt_bool("quick",            NULL, parsed_cmd->flags & CMD_FLAG_QUICK,                    d1);
 
       RPT_CMDFLAG("watch hotplug events", CMD_FLAG_WATCH_DISPLAY_EVENTS,                d1);
+      RPT_CMDFLAG("share watching with other processes", CMD_FLAG_WATCH_BROKER,         d1);
       rpt_vstring(d1, "watch_mode                                               : %s",
             watch_mode_name(parsed_cmd->watch_mode));
       rpt_int( "xevent_watch_loop_millisec",     NULL,  parsed_cmd->xevent_watch_loop_millisec, d1);
@@ -323,6 +326,8 @@ void dbgrpt_parsed_cmd(Parsed_Cmd * parsed_cmd, int depth) {
                                  NULL, parsed_cmd->flags & CMD_FLAG_ENABLE_CACHED_CAPABILITIES, d1);
       rpt_bool("enable cached displays",
                                  NULL, parsed_cmd->flags & CMD_FLAG_ENABLE_CACHED_DISPLAYS,   d1);
+      rpt_bool("enable cached adapters",
+                                 NULL, parsed_cmd->enable_adapter_cache,                      d1);
       rpt_vstring(d1, "cache types:              0x%02x", parsed_cmd->cache_types);
       RPT_CMDFLAG("discard caches", CMD_FLAG_DISCARD_CACHES, d1);
       rpt_vstring(d1, "discarded cache types:    0x%02x", parsed_cmd->discarded_cache_types);
@@ -339,6 +344,7 @@ void dbgrpt_parsed_cmd(Parsed_Cmd * parsed_cmd, int depth) {
       rpt_bool("dsa2 enabled",      NULL, parsed_cmd->flags & CMD_FLAG_DSA2,                    d1);
       rpt_int("i2c_bus_check_async_min", NULL, parsed_cmd->i2c_bus_check_async_min,             d1);
       rpt_int("ddc_check_async_min", NULL, parsed_cmd->ddc_check_async_min,                     d1);
+      rpt_int("i2c_fd_pool_millisec", NULL, parsed_cmd->i2c_fd_pool_millisec,                   d1);
 
       dbgrpt_ntsa(d1, "ddc_disabled", parsed_cmd->ddc_disabled);
 
@@ -353,6 +359,7 @@ void dbgrpt_parsed_cmd(Parsed_Cmd * parsed_cmd, int depth) {
                                         parsed_cmd->max_tries[2] );
       rpt_str("max_retries",        NULL, buf,                                                  d1);
       rpt_bool("profile API",       NULL, parsed_cmd->flags & CMD_FLAG_PROFILE_API,             d1);
+      rpt_bool("detect timings",    NULL, parsed_cmd->flags & CMD_FLAG_DETECT_TIMINGS,          d1);
 
       rpt_nl();
       rpt_label(depth, "Tracing and Logging");
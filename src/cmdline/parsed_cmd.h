@@ -62,7 +62,7 @@ typedef enum {
    CMD_FLAG_VERIFY                   = 0x0040,
    CMD_FLAG_SKIP_DDC_CHECKS          = 0x0080,
 
-   CMD_FLAG_UNUSED1                  = 0x0100,
+   CMD_FLAG_DETECT_TIMINGS           = 0x0100,
    CMD_FLAG_REPORT_FREED_EXCP        = 0x0200,
    CMD_FLAG_NOTABLE                  = 0x0400,
    CMD_FLAG_THREAD_ID_TRACE          = 0x0800,
@@ -108,6 +108,7 @@ typedef enum {
 
    CMD_FLAG_MOCK           = 0x01000000000000,
    CMD_FLAG_PROFILE_API    = 0x02000000000000,
+   CMD_FLAG_WATCH_BROKER   = 0x04000000000000,
 
    CMD_FLAG_ENABLE_CACHED_DISPLAYS
                            = 0x10000000000000,
@@ -213,6 +214,7 @@ enum {NO_CACHES          = 0,
       CAPABILITIES_CACHE = 1,
       DISPLAYS_CACHE     = 2,
       DSA2_CACHE         = 4,
+      ADAPTERS_CACHE     = 8,
       ALL_CACHES         = 255
 } Cache_Types;
 
@@ -264,6 +266,8 @@ struct {
    DDC_Watch_Mode         watch_mode;
    uint16_t               xevent_watch_loop_millisec;
    uint16_t               poll_watch_loop_millisec;
+   int                    i2c_fd_pool_millisec;
+   bool                   enable_adapter_cache;
 
    // Tracing and logging
    DDCA_Trace_Group       traced_groups;
@@ -50,6 +50,7 @@
 
 #include "dynvcp/dyn_feature_files.h"
 
+#include "i2c/i2c_adapter_cache.h"
 #include "i2c/i2c_bus_core.h"
 #include "i2c/i2c_edid.h"
 #include "i2c/i2c_execute.h"
@@ -65,6 +66,7 @@
 #include "ddc_vcp.h"
 
 #ifdef WATCH_DISPLAYS
+#include "dw/dw_broker.h"
 #include "dw/dw_common.h"
 #include "dw/dw_main.h"
 #include "dw/dw_poll.h"
@@ -115,6 +117,10 @@ i2c_discard_caches(Cache_Types caches) {
       DBGMSF(debug, "Erasing dynamic sleep cache");
       dsa2_erase_persistent_stats();
    }
+   if (caches & ADAPTERS_CACHE) {
+      DBGMSF(debug, "Erasing I2C adapter cache");
+      i2c_erase_adapter_cache();
+   }
 }
 
 
@@ -381,6 +387,7 @@ STATIC void
 init_display_watch_options(Parsed_Cmd* parsed_cmd) {
    watch_displays_mode        = parsed_cmd->watch_mode;
    enable_watch_displays      = parsed_cmd->flags & CMD_FLAG_WATCH_DISPLAY_EVENTS;
+   watch_broker_enabled       = parsed_cmd->flags & CMD_FLAG_WATCH_BROKER;
    poll_watch_loop_millisec   = parsed_cmd->poll_watch_loop_millisec;
    xevent_watch_loop_millisec = parsed_cmd->xevent_watch_loop_millisec;
 
@@ -465,6 +472,8 @@ init_experimental_options(Parsed_Cmd* parsed_cmd) {
         flock_poll_millisec = parsed_cmd->i3;
    if (parsed_cmd->flags2 & CMD_FLAG2_I4_SET)
         flock_max_wait_millisec = parsed_cmd->i4;
+   i2c_fd_pool_millisec = parsed_cmd->i2c_fd_pool_millisec;
+   adapter_cache_enabled = parsed_cmd->enable_adapter_cache;
    // if (parsed_cmd->flags & CMD_FLAG_FL1_SET)
    //     dsa2_step_floor = dsa2_multiplier_to_step(parsed_cmd->fl1);
    if (parsed_cmd->flags2 & CMD_FLAG2_I5_SET) {
@@ -46,6 +46,7 @@
 
 #include "base/core.h"
 #include "base/ddc_packets.h"
+#include "base/detection_timing.h"
 #include "base/dsa2.h"
 #include "base/feature_metadata.h"
 #include "base/linux_errno.h"
@@ -53,6 +54,7 @@
 #include "base/parms.h"
 #include "base/per_display_data.h"
 #include "base/rtti.h"
+#include "base/worker_pool.h"
 
 #include "vcp/vcp_feature_codes.h"
 
@@ -98,8 +100,10 @@ static bool allow_asleep = true;
 int  dispno_max = 0;                      // highest assigned display number
 bool publish_all_display_refs = false;    // hack for command C1
 
+static gint display_set_generation = 0;
 
-/** Performs initial checks in a thread
+
+/** Performs initial checks in a worker pool thread
  *
  *  @param data display reference
  */
@@ -114,12 +118,12 @@ threaded_initial_checks_by_dref(gpointer data) {
    Error_Info * erec = ddc_initial_checks_by_dref(dref, false);
    ERRINFO_FREE_WITH_REPORT(erec, debug);
    DBGTRC_DONE(debug, TRACE_GROUP, "Returning NULL. dref = %s,", dref_repr_t(dref) );
-   free_current_traced_function_stack();
    return NULL;
 }
 
 
-/** Spawns threads to perform initial checks and waits for them all to complete.
+/** Performs initial checks on each display using the shared worker pool,
+ *  and waits for them all to complete.
  *
  *  @param all_displays #GPtrArray of pointers to #Display_Ref
  */
@@ -129,25 +133,13 @@ ddc_async_scan(GPtrArray * all_displays) {
    DBGTRC_STARTING(debug, TRACE_GROUP, "all_displays=%p, display_count=%d",
                                        all_displays, all_displays->len);
 
-   GPtrArray * threads = g_ptr_array_new();
    for (int ndx = 0; ndx < all_displays->len; ndx++) {
       Display_Ref * dref = g_ptr_array_index(all_displays, ndx);
       TRACED_ASSERT( memcmp(dref->marker, DISPLAY_REF_MARKER, 4) == 0 );
-
-      GThread * th =
-      g_thread_new(
-            dref_repr_t(dref),                // thread name
-            threaded_initial_checks_by_dref,
-            dref);                            // pass pointer to display ref as data
-      g_ptr_array_add(threads, th);
    }
-   DBGMSF(debug, "Started %d threads", threads->len);
-   for (int ndx = 0; ndx < threads->len; ndx++) {
-      GThread * thread = g_ptr_array_index(threads, ndx);
-      g_thread_join(thread);  // implicitly unrefs the GThread
-   }
-   DBGMSF(debug, "Threads joined");
-   g_ptr_array_free(threads, true);
+   GPtrArray * results = wp_run_parallel("ddc_async_scan", all_displays,
+                                         threaded_initial_checks_by_dref);
+   g_ptr_array_free(results, true);
 
    DBGTRC_DONE(debug, TRACE_GROUP, "");
 }
@@ -314,8 +306,8 @@ void dbgrpt_bus_open_errors(GPtrArray * open_errors, int depth) {
 
 /** Sets the threshold for async display examination.
  *  If the number of /dev/i2c devices for which DDC communication is to be
- *  checked is greater than or equal to the threshold value, examine each
- *  device in a separate thread.
+ *  checked is greater than or equal to the threshold value, examine the
+ *  devices in parallel using the shared worker pool.
  *
  *  @param threshold  threshold value
  */
@@ -379,6 +371,7 @@ ddc_detect_all_displays(GPtrArray ** i2c_open_errors_loc) {
    DBGTRC_STARTING(debug, TRACE_GROUP, "display_caching_enabled=%s, detect_usb_displays=%s",
          sbool(display_caching_enabled), sbool(detect_usb_displays));
 
+   dtim_start_detection();
    dispno_max = 0;
    GPtrArray * bus_open_errors = g_ptr_array_new();
    g_ptr_array_set_free_func(bus_open_errors, (GDestroyNotify) free_bus_open_error);
@@ -423,14 +416,17 @@ ddc_detect_all_displays(GPtrArray ** i2c_open_errors_loc) {
 #ifdef USE_X11
          bool asleep = dpms_state&DPMS_STATE_X11_ASLEEP;
          if (!asleep & !(dpms_state&DPMS_STATE_X11_CHECKED)) {
+             uint64_t phase_start = DTIM_START();
              if (dpms_check_drm_asleep_by_dref(dref)) {
                 dpms_state |= DPMS_SOME_DRM_ASLEEP;
              }
              else {
                 all_displays_asleep = false;
              }
+             dtim_record_phase(businfo->busno, DTIM_PHASE_DPMS, phase_start);
          }
 #else
+         uint64_t phase_start = DTIM_START();
          if (dpms_check_drm_asleep_by_dref(dref)) {
             dpms_state |= DPMS_SOME_DRM_ASLEEP;
             dref->flags |= DREF_DPMS_SUSPEND_STANDBY_OFF;
@@ -438,6 +434,7 @@ ddc_detect_all_displays(GPtrArray ** i2c_open_errors_loc) {
           else {
              all_displays_asleep = false;
           }
+         dtim_record_phase(businfo->busno, DTIM_PHASE_DPMS, phase_start);
 #endif
 
          // dbgrpt_display_ref(dref,5);
@@ -570,7 +567,9 @@ ddc_detect_all_displays(GPtrArray ** i2c_open_errors_loc) {
       }
    }
 
+   uint64_t phase_start = DTIM_START();
    bool phantom_displays_found = filter_phantom_displays(display_list);
+   dtim_record_phase(DTIM_ALL_BUSES, DTIM_PHASE_PHANTOM_FILTER, phase_start);
    if (phantom_displays_found) {
       // in case a display other than the last was marked phantom
       int next_valid_display = 1;
@@ -589,6 +588,8 @@ ddc_detect_all_displays(GPtrArray ** i2c_open_errors_loc) {
       *i2c_open_errors_loc = NULL;
    }
 
+   dtim_end_detection();
+
    if (debug) {
       DBGMSG("Displays detected:");
       ddc_dbgrpt_drefs("display_list:", display_list, 1);
@@ -600,6 +601,24 @@ ddc_detect_all_displays(GPtrArray ** i2c_open_errors_loc) {
 }
 
 
+/** Records that the set of detected displays, or the information
+ *  reported for them, has changed.
+ */
+void
+ddc_mark_display_set_changed() {
+   g_atomic_int_inc(&display_set_generation);
+}
+
+
+/** Returns a counter that is incremented each time the set of detected
+ *  displays changes.
+ */
+int
+ddc_get_display_set_generation() {
+   return g_atomic_int_get(&display_set_generation);
+}
+
+
 /** Initializes the master display list in global variable #all_display_refs
  *  and records open errors in global variable #display_open_errors.
  *
@@ -614,6 +633,7 @@ ddc_ensure_displays_detected() {
    if (!all_display_refs) {
       // i2c_detect_buses();  // called in ddc_detect_all_displays()
       all_display_refs = ddc_detect_all_displays(&display_open_errors);
+      ddc_mark_display_set_changed();
       if (publish_all_display_refs) {
          for (int ndx = 0; ndx < all_display_refs->len; ndx++)
             add_published_dref_id_by_dref(g_ptr_array_index(all_display_refs, ndx));
@@ -669,6 +689,7 @@ ddc_discard_detected_displays() {
          display_open_errors = NULL;
       }
    }
+   ddc_mark_display_set_changed();
    // free_sys_drm_connectors();
    i2c_discard_buses();
    DBGTRC_DONE(debug, TRACE_GROUP, "");
@@ -45,6 +45,8 @@ GPtrArray *  ddc_detect_all_displays(GPtrArray ** i2c_open_errors_loc);
 void         ddc_ensure_displays_detected();
 void         ddc_discard_detected_displays();
 bool         ddc_displays_already_detected();
+void         ddc_mark_display_set_changed();
+int          ddc_get_display_set_generation();
 #ifdef UNUSED
 Display_Ref* detect_display_by_businfo(I2C_Bus_Info * businfo);
 #endif
@@ -32,6 +32,7 @@
 #include "base/core.h"
 #include "base/displays.h"
 #include "base/ddc_packets.h"
+#include "base/detection_timing.h"
 #include "base/dsa2.h"
 #include "base/i2c_bus_base.h"
 #include "base/monitor_model_key.h"
@@ -429,6 +430,8 @@ ddc_initial_checks_by_dh(Display_Handle * dh, bool newly_added) {
    Error_Info * ddc_excp = NULL;
 
    bool saved_dynamic_sleep_active = pdd_is_dynamic_sleep_active(pdd);
+   int dtim_busno = (dref->io_path.io_mode == DDCA_IO_I2C) ? DREF_BUSNO(dref) : DTIM_ALL_BUSES;
+   uint64_t phase_start;
 
    if (debug)
       show_backtrace(0);
@@ -471,7 +474,9 @@ ddc_initial_checks_by_dh(Display_Handle * dh, bool newly_added) {
          uint16_t shsl;
          // DDCA_Vcp_Feature_Code fc = (iomode_is_i2c) ? 0xdf : 0x10;
          DDCA_Vcp_Feature_Code fc = 0x10;
+         phase_start = DTIM_START();
          ddc_excp = check_supported_feature(dh, newly_added, fc, &shsl);
+         dtim_record_phase(dtim_busno, DTIM_PHASE_DDC_CHECK, phase_start);
 
          Public_Status_Code psc = ERRINFO_STATUS(ddc_excp);
 
@@ -497,7 +502,9 @@ ddc_initial_checks_by_dh(Display_Handle * dh, bool newly_added) {
          if ( (dref->flags&DREF_DDC_COMMUNICATION_WORKING) &&
                dref->io_path.io_mode == DDCA_IO_I2C)
          {
+            phase_start = DTIM_START();
             check_how_unsupported_reported(dh);
+            dtim_record_phase(dtim_busno, DTIM_PHASE_UNSUPPORTED_CHECK, phase_start);
 
             if ( i2c_force_bus /* && psc == DDCRC_RETRIES */) {  // used only when testing
                DBGTRC_NOPREFIX(debug || true , TRACE_GROUP,
@@ -516,7 +523,9 @@ ddc_initial_checks_by_dh(Display_Handle * dh, bool newly_added) {
       // into other functions, e.g. ddca_get_feature_list_by_dref()
       if ( vcp_version_eq(dref->vcp_version_xdf, DDCA_VSPEC_UNQUERIED)) {
          // may have been forced by option --mccs
+         phase_start = DTIM_START();
          set_vcp_version_xdf_by_dh(dh);
+         dtim_record_phase(dtim_busno, DTIM_PHASE_VCP_VERSION, phase_start);
       }
    }
 
@@ -14,6 +14,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <glib-2.0/glib.h>
 
 #include "public/ddcutil_types.h"
 
@@ -40,14 +41,132 @@ int multi_part_null_adjustment_millis = 0;
 static DDCA_Trace_Group TRACE_GROUP = DDCA_TRC_DDC;
 
 
+/** Scans a possibly incomplete capabilities string for a parenthesized
+ *  segment, e.g. "vcp(", and reports whether the segment's closing
+ *  parenthesis has been received.
+ *
+ *  Only top level segments are considered, i.e. those directly within the
+ *  outer parentheses of the capabilities string, or at the outermost level
+ *  if the string lacks outer parentheses.
+ *
+ *  @param  bytes  capabilities string bytes, not null terminated
+ *  @param  len    number of bytes
+ *  @param  name   segment name, e.g. "vcp"
+ *  @return true if the entire segment has been received
+ */
+static bool
+capabilities_segment_received(const Byte * bytes, int len, const char * name) {
+   int namelen = strlen(name);
+   int depth = 0;
+   for (int pos = 0; pos < len; pos++) {
+      Byte ch = bytes[pos];
+      if (ch == '(') {
+         depth++;
+      }
+      else if (ch == ')') {
+         depth--;
+      }
+      else if (depth <= 1 && pos + namelen < len &&
+               (pos == 0 || bytes[pos-1] == '(' || bytes[pos-1] == ')' || bytes[pos-1] == ' ') &&
+               g_ascii_strncasecmp((const char *) bytes+pos, name, namelen) == 0 &&
+               bytes[pos+namelen] == '(')
+      {
+         int segment_depth = depth;
+         for (pos += namelen; pos < len; pos++) {
+            if (bytes[pos] == '(') {
+               depth++;
+            }
+            else if (bytes[pos] == ')') {
+               depth--;
+               if (depth == segment_depth)
+                  return true;
+            }
+         }
+         return false;
+      }
+   }
+   return false;
+}
+
+
+/** Checks whether a capabilities string has been completely received,
+ *  i.e. whether the parenthesis that opens the string has been closed
+ *  and is followed by at most trailing blanks and nulls.
+ *
+ *  The check is conservative.  Strings that do not start with "(" or
+ *  whose parentheses are unbalanced are never regarded as complete.
+ *
+ *  @param  bytes  capabilities string bytes, not null terminated
+ *  @param  len    number of bytes
+ *  @return true if complete, false if incomplete or unknown
+ */
+static bool
+capabilities_string_complete(const Byte * bytes, int len) {
+   int pos = 0;
+   while (pos < len && bytes[pos] == ' ')
+      pos++;
+   if (pos == len || bytes[pos] != '(')
+      return false;
+   int depth = 0;
+   for (; pos < len; pos++) {
+      if (bytes[pos] == '(') {
+         depth++;
+      }
+      else if (bytes[pos] == ')') {
+         depth--;
+         if (depth == 0)
+            break;
+      }
+   }
+   if (depth != 0)
+      return false;
+   for (pos++; pos < len; pos++) {
+      if (bytes[pos] != ' ' && bytes[pos] != '\0')
+         return false;
+   }
+   return true;
+}
+
+
+/** #Multi_Part_Read_Stop_Func that stops a capabilities read once all
+ *  the named segments have been received.
+ *
+ *  @param  accumulator  capabilities string bytes received so far
+ *  @param  arg          null terminated array of segment names, e.g. {"vcp", NULL}
+ *  @return true if all segments have been received
+ */
+bool
+capabilities_segments_received(Buffer * accumulator, void * arg) {
+   char ** segment_names = arg;
+   for (int ndx = 0; segment_names[ndx]; ndx++) {
+      if (!capabilities_segment_received(accumulator->bytes, accumulator->len, segment_names[ndx]))
+         return false;
+   }
+   return true;
+}
+
+
 /** Makes one attempt to read the entire capabilities string or table feature value
 *
+* Reading begins at the offset following the bytes already in the accumulator,
+* so that an attempt following a failed attempt resumes where the failed attempt
+* left off.
+*
+* The maximum fragment size returned by the display is recorded in its
+* #Per_Display_Data.  For capabilities, a fragment shorter than the maximum that
+* completes the capabilities string is treated as the final fragment, saving
+* the read of the terminating zero length fragment.
+*
 * @param  dh               display handle for open i2c device
 * @param  request_type     DDC_PACKET_TYPE_CAPABILITIES_REQUEST or DDC_PACKET_TYPE_TABLE_REQD_REQUEST
 * @param  request_subtype  VCP feature code for table read, ignore for capabilities
 * @param  write_read_flags if flag all_zero_response_ok is set, an all zero response is not regarded
 *                          as an error
-* @param  accumulator      buffer in which to return result (already allocated)
+* @param  stop_func        if non-NULL, called after each fragment is received, reading stops
+*                          when it returns true
+* @param  stop_func_arg    argument passed to **stop_func**
+* @param  accumulator      buffer in which to return result (already allocated),
+*                          may contain the bytes read by a prior attempt
 * @return #Error_Info struct with error detail, NULL if no error
 */
 static Error_Info *
@@ -56,24 +175,28 @@ try_multi_part_read(
       Byte                 request_type,
       Byte                 request_subtype,
       DDC_Write_Read_Flags write_read_flags,
+      Multi_Part_Read_Stop_Func stop_func,
+      void *               stop_func_arg,
       Buffer *             accumulator)
 {
    bool debug = false;
    DBGTRC_STARTING(debug, TRACE_GROUP,
-          "request_type=0x%02x, request_subtype=x%02x, all_zero_response_ok=%s, accumulator=%p",
+          "request_type=0x%02x, request_subtype=x%02x, all_zero_response_ok=%s, accumulator=%p, resume offset=%d",
           request_type, request_subtype,
-          sbool(write_read_flags & Write_Read_Flag_All_Zero_Response_Ok), accumulator);
+          sbool(write_read_flags & Write_Read_Flag_All_Zero_Response_Ok), accumulator, accumulator->len);
 
    Error_Info * excp = NULL;
    DDC_Packet * request_packet_ptr  = NULL;
    DDC_Packet * response_packet_ptr = NULL;
+   Per_Display_Data * pdd = dh->dref->pdd;
+   int  cur_offset = accumulator->len;
+   if (cur_offset > 0)   // all zero response acceptable only on first fragment
+      write_read_flags = write_read_flags & ~Write_Read_Flag_All_Zero_Response_Ok;
    request_packet_ptr = create_ddc_multi_part_read_request_packet(
                            request_type,
                            request_subtype,
-                           0,
+                           cur_offset,
                            "try_multi_part_read");
-   buffer_set_length(accumulator,0);
-   int  cur_offset = 0;
    bool complete   = false;
    while (!complete && !excp) {         // loop over fragments
       DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE, "Top of fragment loop");
@@ -141,6 +264,22 @@ try_multi_part_read(
                DBGMSG("cur_offset = %d", cur_offset);
             }
             write_read_flags = write_read_flags & ~Write_Read_Flag_All_Zero_Response_Ok;
+
+            if (fragment_size > pdd->max_fragment_size)
+               pdd->max_fragment_size = fragment_size;
+            if (request_type == DDC_PACKET_TYPE_CAPABILITIES_REQUEST &&
+                fragment_size < pdd->max_fragment_size &&
+                capabilities_string_complete(accumulator->bytes, accumulator->len))
+            {
+               DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE,
+                     "Short fragment completes capabilities string, max_fragment_size=%d",
+                     pdd->max_fragment_size);
+               complete = true;
+            }
+            else if (stop_func && stop_func(accumulator, stop_func_arg)) {
+               DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE, "stop_func() terminated read at offset %d", cur_offset);
+               complete = true;
+            }
          }
       }
       free_ddc_packet(response_packet_ptr);
@@ -161,6 +300,9 @@ try_multi_part_read(
 *  @param  request_type
 *  @param  request_subtype       VCP function code for table read, ignore for capabilities
 *  @param  write_read_flags
+*  @param  stop_func             if non-NULL, called after each fragment is received, the
+*                                read is terminated successfully when it returns true
+*  @param  stop_func_arg         argument passed to **stop_func**
 *  @param  buffer_loc            address at which to return newly allocated #Buffer in which
 *                                result is returned
 *  @retval  NULL    success
@@ -168,6 +310,9 @@ try_multi_part_read(
 *  @retval  #Ddc_Error containing status DDCRC_TRIES  maximum retries exceeded:
 *
 *  *buffer_loc is set iff returned value is NULL
+*
+*  A retry resumes at the offset following the last fragment successfully read,
+*  rather than restarting the read at offset 0.
 */
 Error_Info *
 multi_part_read_with_retry(
@@ -175,6 +320,8 @@ multi_part_read_with_retry(
       Byte             request_type,
       Byte             request_subtype, // VCP feature code for table read, ignore for capabilities
       DDC_Write_Read_Flags write_read_flags,
+      Multi_Part_Read_Stop_Func stop_func,
+      void *           stop_func_arg,
       Buffer**         buffer_loc)
 {
    bool debug = false;
@@ -203,11 +350,15 @@ multi_part_read_with_retry(
              "Start of while loop. try_ctr=%d, max_multi_part_read_tries=%d",
              tryctr, max_multi_part_read_tries);
 
+      if (tryctr > 0 && accumulator->len > 0)
+         DBGTRC_NOPREFIX(debug, TRACE_GROUP, "Resuming read at offset %d", accumulator->len);
       ddc_excp = try_multi_part_read(
               dh,
               request_type,
               request_subtype,
               write_read_flags,
+              stop_func,
+              stop_func_arg,
               accumulator);
       try_errors[tryctr] = ddc_excp;
       rc = (ddc_excp) ? ddc_excp->status_code : 0;
@@ -418,6 +569,7 @@ static inline void init_ddc_multi_part_io_func_name_table() {
 #define ADD_FUNC(_NAME) rtti_func_name_table_add(_NAME, #_NAME);
    ADD_FUNC(try_multi_part_read);
    ADD_FUNC(multi_part_read_with_retry);
+   ADD_FUNC(capabilities_segments_received);
 #undef ADD_FUNC
 }
 
@@ -25,12 +25,22 @@
 //temp:
 extern int multi_part_null_adjustment_millis;
 
+/** Signature of a function called after each fragment of a multi-part read
+ *  is received.  Returns true if no further fragments are required.
+ */
+typedef bool (*Multi_Part_Read_Stop_Func)(Buffer * accumulator, void * arg);
+
+bool
+capabilities_segments_received(Buffer * accumulator, void * arg);
+
 Error_Info *
 multi_part_read_with_retry(
    Display_Handle * dh,
    Byte             request_type,
    Byte             request_subtype,   // VCP feature code for table read, ignore for capabilities
    DDC_Write_Read_Flags write_read_flags,
+   Multi_Part_Read_Stop_Func stop_func,
+   void *           stop_func_arg,
    Buffer**         ppbuffer);
 
 Error_Info *
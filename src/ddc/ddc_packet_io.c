@@ -27,6 +27,7 @@
 
 #include "util/debug_util.h"
 #include "util/edid.h"
+#include "util/glib_util.h"
 #include "util/report_util.h"
 #include "util/string_util.h"
 #include "util/sysfs_util.h"
@@ -59,6 +60,7 @@
 
 #include "ddc/ddc_displays.h"
 #include "ddc/ddc_try_data.h"
+#include "ddc/ddc_vcp.h"
 
 #include "ddc/ddc_packet_io.h"
 
@@ -502,6 +504,7 @@ ddc_close_display(Display_Handle * dh) {
    g_hash_table_remove(open_displays, dh);
    g_mutex_unlock (&open_displays_mutex);
    remove_open_display_for_current_thread(dh);
+   ddc_invalidate_prepared_vcp_requests(dh);
 
    free_display_handle(dh);
    DBGTRC_RET_ERRINFO(debug, TRACE_GROUP, err, "dref=%s", dref_repr_t(dref));
@@ -670,6 +673,10 @@ DDCA_Status ddc_i2c_write_read_raw(
 }
 
 
+// Per-thread buffer for responses, avoids an allocation on every try
+#define WRITE_READ_BUFFER_SIZE  64
+static GPrivate write_read_buffer_key = G_PRIVATE_INIT(g_free);
+
 /** Writes a DDC request packet to a monitor and provides basic response parsing
  *  based whether the response type is continuous, non-continuous, or table.
  *
@@ -680,12 +687,12 @@ DDCA_Status ddc_i2c_write_read_raw(
  *  \param expected_subtype    expected subtype to check for
  *  \param response_packet_ptr_loc  where to write address of response packet received
  *
- *  \return pointer to #Error_Info struct if failure, NULL if success
+ *  \return status code
  *  \remark
  *  Issue: positive ADL codes, need to handle?
  */
-Error_Info *
-ddc_write_read(
+static DDCA_Status
+ddc_write_read_basic(
       Display_Handle * dh,
       DDC_Packet *     request_packet_ptr,
       bool             read_bytewise,
@@ -705,7 +712,10 @@ ddc_write_read(
    DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE,
          "Adding 1 to max_read_bytes to allow for initial double 0x63 quirk");
    max_read_bytes++;   //allow for quirk of double 0x6e at start
-   Byte * readbuf = calloc(1, max_read_bytes);
+   Byte * readbuf = (max_read_bytes <= WRITE_READ_BUFFER_SIZE)
+         ? get_thread_fixed_buffer(&write_read_buffer_key, WRITE_READ_BUFFER_SIZE)
+         : malloc(max_read_bytes);
+   memset(readbuf, 0, max_read_bytes);
    int    bytes_received = max_read_bytes;
    DDCA_Status    psc;
    *response_packet_ptr_loc = NULL;
@@ -748,11 +758,44 @@ ddc_write_read(
           *response_packet_ptr_loc = NULL;
        }
    }
-   free(readbuf);    // or does response_packet_ptr_loc point into here?
+   // response packet is a copy, does not point into readbuf
+   if (max_read_bytes > WRITE_READ_BUFFER_SIZE)
+      free(readbuf);
+
+   DBGTRC_RET_DDCRC(debug, TRACE_GROUP, psc, "*response_packet_ptr_loc=%p", *response_packet_ptr_loc);
+   return psc;
+}
+
 
-   Error_Info * excp = (psc < 0) ? ERRINFO_NEW(psc,NULL) : NULL;
-   DBGTRC_RET_ERRINFO_STRUCT(debug, TRACE_GROUP, excp, response_packet_ptr_loc, dbgrpt_packet);
-   return excp;
+/** Writes a DDC request packet to a monitor and provides basic response parsing
+ *  based whether the response type is continuous, non-continuous, or table.
+ *
+ *  \param dh                  display handle (for either I2C or ADL device)
+ *  \param request_packet_ptr  DDC packet to write
+ *  \param max_read_bytes      maximum number of bytes to read
+ *  \param expected_response_type expected response type to check for
+ *  \param expected_subtype    expected subtype to check for
+ *  \param response_packet_ptr_loc  where to write address of response packet received
+ *
+ *  \return pointer to #Error_Info struct if failure, NULL if success
+ *  \remark
+ *  Issue: positive ADL codes, need to handle?
+ */
+Error_Info *
+ddc_write_read(
+      Display_Handle * dh,
+      DDC_Packet *     request_packet_ptr,
+      bool             read_bytewise,
+      int              max_read_bytes,
+      Byte             expected_response_type,
+      Byte             expected_subtype,
+      DDC_Packet **    response_packet_ptr_loc
+     )
+{
+   DDCA_Status psc = ddc_write_read_basic(
+         dh, request_packet_ptr, read_bytewise, max_read_bytes,
+         expected_response_type, expected_subtype, response_packet_ptr_loc);
+   return (psc < 0) ? ERRINFO_NEW(psc,NULL) : NULL;
 }
 
 
@@ -804,7 +847,9 @@ ddc_write_read_with_retry(
    Error_Info * master_error = NULL;
    DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE,"ddcrc_null_response_max=%d, read_bytewise=%s",
                                         ddcrc_null_response_max, sbool(read_bytewise));
-   Error_Info * try_errors[MAX_MAX_TRIES] = {NULL};
+   // Failed tries are recorded as status codes.  Error_Info instances are
+   // only created if the operation ultimately fails.
+   DDCA_Status try_status[MAX_MAX_TRIES] = {0};
 
    TRACED_ASSERT(max_tries >= 1);
    for (tryctr=0, psc=-999, retryable=true;
@@ -817,7 +862,7 @@ ddc_write_read_with_retry(
          tryctr, max_tries, psc_name_code(psc), sbool(retryable),
          sbool(read_bytewise), pdd_get_adjusted_sleep_multiplier(pdd) );
 
-      Error_Info * cur_excp = ddc_write_read(
+      psc = ddc_write_read_basic(
                 dh,
                 request_packet_ptr,
                 read_bytewise,
@@ -826,14 +871,13 @@ ddc_write_read_with_retry(
                 expected_subtype,
                 response_packet_ptr_loc);
 
-      ASSERT_IFF(!cur_excp, *response_packet_ptr_loc);
+      ASSERT_IFF(psc == 0, *response_packet_ptr_loc);
       // TESTCASES:
       // if (tryctr < 2)
-      //    cur_excp = ERRINFO_NEW(DDCRC_NULL_RESPONSE, "dummy");
-      // cur_excp = errinfo_new(-EIO, "dummy");
+      //    psc = DDCRC_NULL_RESPONSE;
+      // psc = -EIO;
 
-      psc = (cur_excp) ? cur_excp->status_code : 0;
-      try_errors[tryctr] = cur_excp;
+      try_status[tryctr] = psc;
 
       if (psc == 0 && ddcrc_null_response_ct > 0) {
          DBGTRC_NOPREFIX(debug, TRACE_GROUP | DDCA_TRC_RETRY,
@@ -980,19 +1024,21 @@ ddc_write_read_with_retry(
    }
    pdd_record_final_by_dh(dh, psc, adjusted_tryctr);
 
-   Error_Info * errors_found[MAX_MAX_TRIES];
+   DDCA_Status status_found[MAX_MAX_TRIES];
    int errct = 0;
-   for (int ndx = 0; ndx < MAX_MAX_TRIES; ndx++) {
-      if (try_errors[ndx])
-         errors_found[errct++] = try_errors[ndx];
+   for (int ndx = 0; ndx < tryctr; ndx++) {
+      if (try_status[ndx] < 0)
+         status_found[errct++] = try_status[ndx];
+   }
+   if (IS_DBGTRC(debug, TRACE_GROUP | DDCA_TRC_RETRY)) {
+      char * s = errinfo_status_array_summary(status_found, errct);
+      DBGTRC_NOPREFIX(debug, TRACE_GROUP | DDCA_TRC_RETRY,
+                      "%s,%s after %d error(s): %s",
+                      dh_repr(dh),
+                      (psc == 0) ? "Succeeded" : "Failed",
+                      errct, s);
+      free(s);
    }
-   char * s = errinfo_array_summary(errors_found, errct);
-   DBGTRC_NOPREFIX(debug, TRACE_GROUP | DDCA_TRC_RETRY,
-                   "%s,%s after %d error(s): %s",
-                   dh_repr(dh),
-                   (psc == 0) ? "Succeeded" : "Failed",
-                   errct, s);
-   free(s);
 
    if (psc < 0) {
       // int last_try_index = tryctr-1;
@@ -1012,22 +1058,22 @@ ddc_write_read_with_retry(
          psc = DDCRC_ALL_RESPONSES_NULL;
       }
 
+      // materialize the causes only now that they will be returned
+      Error_Info * errors_found[MAX_MAX_TRIES];
+      for (int ndx = 0; ndx < errct; ndx++)
+         errors_found[ndx] = errinfo_new(status_found[ndx], "ddc_write_read", NULL);
       master_error = errinfo_new_with_causes(psc, errors_found, errct, __func__, NULL);
 
-      if (psc != try_errors[tryctr-1]->status_code)
+      if (psc != try_status[tryctr-1])
          COUNT_STATUS_CODE(psc);     // new status code, count it
    }
-   else {
-      for (int ndx = 0; ndx < tryctr-1; ndx++) {
-         BASE_ERRINFO_FREE_WITH_REPORT(try_errors[ndx], IS_DBGTRC(debug, TRACE_GROUP));
-      }
-   }
 
    try_data_record_tries2(dh, WRITE_READ_TRIES_OP, psc, tryctr);
 
 bye:
    DBGTRC_DONE(debug, TRACE_GROUP, "Total Tries (tryctr): %d. *response_packet_pointer_loc=%p,  Returning: %s",
-                                   tryctr, *response_packet_ptr_loc, errinfo_summary(master_error));
+         tryctr, *response_packet_ptr_loc,
+         (IS_DBGTRC(debug, TRACE_GROUP)) ? errinfo_summary(master_error) : "");
    ASSERT_IFF(!master_error, *response_packet_ptr_loc);
    return master_error;
 }
@@ -1129,7 +1175,7 @@ ddc_write_only_with_retry(
    DDCA_Status        psc;
    int                tryctr;
    bool               retryable;
-   Error_Info *       try_errors[MAX_MAX_TRIES];
+   DDCA_Status        try_status[MAX_MAX_TRIES];
 
    int max_tries = try_data_get_maxtries2(WRITE_ONLY_TRIES_OP);
    TRACED_ASSERT(max_tries > 0);
@@ -1141,9 +1187,8 @@ ddc_write_only_with_retry(
              "Start of try loop, tryctr=%d, max_tries=%d, rc=%d, retryable=%d",
              tryctr, max_tries, psc, retryable );
 
-      Error_Info * cur_excp = ddc_write_only(dh, request_packet_ptr);
-      psc = (cur_excp) ? cur_excp->status_code : 0;
-      try_errors[tryctr] = cur_excp;
+      psc = ddc_i2c_write_only(dh, request_packet_ptr);
+      try_status[tryctr] = psc;
       if (psc == -EBUSY)
          retryable = false;
    }
@@ -1162,25 +1207,26 @@ ddc_write_only_with_retry(
       DBGTRC_NOPREFIX(debug, TRACE_GROUP, "After try loop. tryctr=%d, retryable=%s",
                                            tryctr, sbool(retryable));
 
+      // Error_Info instances are only created for a failed operation
       if (retryable) {
          psc = DDCRC_RETRIES;
+         Error_Info * try_errors[MAX_MAX_TRIES];
+         for (int ndx = 0; ndx < tryctr; ndx++)
+            try_errors[ndx] = errinfo_new(try_status[ndx], "ddc_write_only", NULL);
          ddc_excp = errinfo_new_with_causes(psc, try_errors, tryctr, __func__, NULL);
-         if (psc != try_errors[tryctr-1]->status_code)
+         if (psc != try_status[tryctr-1])
             COUNT_STATUS_CODE(psc);     // new status code, count it
       }
       else {
          assert (tryctr == 1);
-         ddc_excp = try_errors[0];
+         ddc_excp = errinfo_new(try_status[0], "ddc_write_only", NULL);
       }
    }
-   else {
-      // 2 possibilities:
-      //   succeeded after retries, there will be some errors (tryctr > 1)
-      //   no errors (tryctr == 1)
-      // int last_bad_try_index = tryctr-2;
-      for (int ndx = 0; ndx < tryctr-1; ndx++) {
-         BASE_ERRINFO_FREE_WITH_REPORT(try_errors[ndx], IS_DBGTRC(debug, TRACE_GROUP) );
-      }
+   else if (tryctr > 1 && IS_DBGTRC(debug, TRACE_GROUP)) {
+      // succeeded after retries
+      char * s = errinfo_status_array_summary(try_status, tryctr-1);
+      DBGTRC_NOPREFIX(debug, TRACE_GROUP, "Succeeded after %d error(s): %s", tryctr-1, s);
+      free(s);
    }
    try_data_record_tries2(dh, WRITE_ONLY_TRIES_OP, psc, tryctr);
 
@@ -1196,6 +1242,7 @@ init_ddc_packet_io_func_name_table() {
    RTTI_ADD_FUNC(ddc_i2c_write_read_raw);
    RTTI_ADD_FUNC(ddc_i2c_write_only);
 // RTTI_ADD_FUNC(ddc_write_read_raw);
+   RTTI_ADD_FUNC(ddc_write_read_basic);
    RTTI_ADD_FUNC(ddc_write_read);
    RTTI_ADD_FUNC(ddc_write_read_with_retry);
    RTTI_ADD_FUNC(ddc_write_only);
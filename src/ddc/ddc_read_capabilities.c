@@ -29,6 +29,7 @@
 #include "usb/usb_displays.h"
 #endif
 
+#include "vcp/parse_capabilities.h"
 #include "vcp/persistent_capabilities.h"
 
 #include "ddc/ddc_multi_part_io.h"
@@ -46,12 +47,15 @@ static DDCA_Trace_Group TRACE_GROUP = DDCA_TRC_DDC;
  *  free this struct.
  *
  *  @param dh                       display handle
+ *  @param segment_names            if non-NULL, null terminated array of segment names,
+ *                                  reading stops once these segments are received
  *  @param capabilities_buffer_loc  address at which to return pointer to allocated Buffer
  *  @return                         pointer to #Error_Info struct, NULL if no error
  */
 static Error_Info *
 get_capabilities_into_buffer(
       Display_Handle * dh,
+      char **          segment_names,
       Buffer**         capabilities_buffer_loc)
 {
    bool debug = false;
@@ -65,6 +69,8 @@ get_capabilities_into_buffer(
                DDC_PACKET_TYPE_CAPABILITIES_REQUEST,
                0x00,                                 // no subtype for capabilities
                Write_Read_Flag_Capabilities,         // special all zero response handling
+               (segment_names) ? capabilities_segments_received : NULL,
+               segment_names,
                capabilities_buffer_loc);
    Buffer * cap_buffer = *capabilities_buffer_loc;
    ASSERT_IFF(cap_buffer, !ddc_excp);
@@ -143,7 +149,7 @@ ddc_get_capabilities_string(
 
          if (!dh->dref->capabilities_string) {
             Buffer * pcaps_buffer;
-            ddc_excp = get_capabilities_into_buffer(dh, &pcaps_buffer);
+            ddc_excp = get_capabilities_into_buffer(dh, NULL, &pcaps_buffer);
             if (!ddc_excp) {
                dh->dref->capabilities_string = g_strdup((char *) pcaps_buffer->bytes);
                buffer_free(pcaps_buffer,__func__);
@@ -160,6 +166,196 @@ ddc_get_capabilities_string(
 }
 
 
+/** Makes a capabilities string whose read was stopped early parsable,
+ *  by discarding any bytes following the last complete top level segment
+ *  and closing the outer parenthesis.
+ *
+ *  Strings that do not start with "(" or are already complete are copied unchanged.
+ *
+ *  @param  caps  capabilities string
+ *  @return newly allocated string
+ */
+static char *
+close_partial_capabilities_string(const char * caps) {
+   if (caps[0] != '(')
+      return g_strdup(caps);
+   int depth = 0;
+   int last_segment_end = 1;     // position following last complete segment
+   for (int pos = 0; caps[pos]; pos++) {
+      if (caps[pos] == '(') {
+         depth++;
+      }
+      else if (caps[pos] == ')') {
+         depth--;
+         if (depth == 0)
+            return g_strdup(caps);       // complete
+         if (depth == 1)
+            last_segment_end = pos+1;
+      }
+   }
+   return g_strdup_printf("%.*s)", last_segment_end, caps);
+}
+
+
+/** Reads the initial portion of a display's capabilities string that
+ *  contains the specified segments, e.g. "vcp".  Fragments following
+ *  the last needed segment are not read, saving the DDC round trip and
+ *  post-fragment sleep for each.
+ *
+ *  If the complete capabilities string is already known, from the Display_Ref
+ *  or the capabilities cache, a copy of it is returned without performing
+ *  any DDC communication.
+ *
+ *  Because the returned string may be incomplete, it is neither saved in
+ *  the Display_Ref nor in the capabilities cache.  An incomplete string
+ *  is truncated after its last complete segment and its outer parenthesis
+ *  closed, so that it can be parsed.
+ *
+ *  @param  dh             display handle
+ *  @param  segment_names  null terminated array of segment names
+ *  @param  caps_loc       where to return newly allocated, possibly partial,
+ *                         capabilities string.  Caller must free.
+ *  @return pointer to #Error_Info struct, NULL if no error
+ */
+Error_Info *
+ddc_get_capabilities_segments(
+      Display_Handle * dh,
+      char **          segment_names,
+      char**           caps_loc)
+{
+   bool debug = false;
+   assert(dh);
+   assert(dh->dref);
+   assert(segment_names);
+   DBGTRC_STARTING(debug, TRACE_GROUP, "dh=%s, segment_names[0]=%s", dh_repr(dh), segment_names[0]);
+
+   Error_Info * ddc_excp = NULL;
+   *caps_loc = NULL;
+   if (dh->dref->capabilities_string || dh->dref->io_path.io_mode == DDCA_IO_USB) {
+      char * caps = NULL;
+      ddc_excp = ddc_get_capabilities_string(dh, &caps);
+      if (!ddc_excp)
+         *caps_loc = g_strdup(caps);
+   }
+   else {
+      *caps_loc = g_strdup(get_persistent_capabilities(dh->dref->mmid));
+      if (!*caps_loc) {
+         Buffer * pcaps_buffer;
+         ddc_excp = get_capabilities_into_buffer(dh, segment_names, &pcaps_buffer);
+         if (!ddc_excp) {
+            *caps_loc = close_partial_capabilities_string((char *) pcaps_buffer->bytes);
+            buffer_free(pcaps_buffer,__func__);
+         }
+      }
+   }
+
+   ASSERT_IFF(*caps_loc, !ddc_excp);
+   DBGTRC_RET_ERRINFO(debug, TRACE_GROUP, ddc_excp, "*caps_loc -> |%s|", *caps_loc);
+   return ddc_excp;
+}
+
+
+static GMutex capabilities_feature_ids_mutex;   // guards Display_Ref capabilities_feature_ids
+
+
+// Returns the ids of the VCP features listed in a capabilities string.
+static Bit_Set_256
+parse_capabilities_feature_ids(char * caps) {
+   Parsed_Capabilities * pcaps = parse_capabilities_string(caps);
+   Bit_Set_256 ids = get_parsed_capabilities_feature_ids(pcaps, /*readable_only=*/false);
+   free_parsed_capabilities(pcaps);
+   return ids;
+}
+
+
+/** Gets the ids of the VCP features listed in a display's capabilities
+ *  string, if they can be determined without DDC communication.
+ *
+ *  The ids are obtained from those saved in the Display_Ref by a prior call
+ *  to #ddc_get_capabilities_feature_ids(), from the complete capabilities
+ *  string in the Display_Ref, or from the capabilities cache.
+ *
+ *  @param  dref     display reference
+ *  @param  ids_loc  where to return the feature ids
+ *  @return true if the ids are known, false if not
+ */
+bool
+ddc_get_known_capabilities_feature_ids(
+      Display_Ref *  dref,
+      Bit_Set_256 *  ids_loc)
+{
+   bool debug = false;
+   assert(dref);
+   DBGTRC_STARTING(debug, TRACE_GROUP, "dref=%s", dref_repr_t(dref));
+
+   *ids_loc = EMPTY_BIT_SET_256;
+   g_mutex_lock(&capabilities_feature_ids_mutex);
+   bool found = dref->capabilities_feature_ids_set;
+   if (found) {
+      *ids_loc = dref->capabilities_feature_ids;
+   }
+   else {
+      char * caps = g_strdup(dref->capabilities_string);
+      if (!caps && dref->io_path.io_mode != DDCA_IO_USB && dref->mmid)
+         caps = g_strdup(get_persistent_capabilities(dref->mmid));
+      if (caps) {
+         *ids_loc = parse_capabilities_feature_ids(caps);
+         dref->capabilities_feature_ids = *ids_loc;
+         dref->capabilities_feature_ids_set = true;
+         found = true;
+         free(caps);
+      }
+   }
+   g_mutex_unlock(&capabilities_feature_ids_mutex);
+
+   DBGTRC_RET_BOOL(debug, TRACE_GROUP, found, "*ids_loc = %s",
+                                    bs256_to_string_t(*ids_loc, "x", ", "));
+   return found;
+}
+
+
+/** Gets the ids of the VCP features listed in a display's capabilities string.
+ *
+ *  Unless the ids are already known, only the portion of the capabilities
+ *  string through the "vcp" segment is read.  The ids are saved in the
+ *  Display_Ref, so that subsequent calls for the same display perform no
+ *  DDC communication.
+ *
+ *  @param  dh       display handle
+ *  @param  ids_loc  where to return the feature ids
+ *  @return pointer to #Error_Info struct, NULL if no error
+ */
+Error_Info *
+ddc_get_capabilities_feature_ids(
+      Display_Handle * dh,
+      Bit_Set_256 *    ids_loc)
+{
+   bool debug = false;
+   assert(dh);
+   assert(dh->dref);
+   DBGTRC_STARTING(debug, TRACE_GROUP, "dh=%s", dh_repr(dh));
+
+   Error_Info * ddc_excp = NULL;
+   if (!ddc_get_known_capabilities_feature_ids(dh->dref, ids_loc)) {
+      char * segment_names[] = {"vcp", NULL};
+      char * caps = NULL;
+      ddc_excp = ddc_get_capabilities_segments(dh, segment_names, &caps);
+      if (!ddc_excp) {
+         *ids_loc = parse_capabilities_feature_ids(caps);
+         free(caps);
+         g_mutex_lock(&capabilities_feature_ids_mutex);
+         dh->dref->capabilities_feature_ids = *ids_loc;
+         dh->dref->capabilities_feature_ids_set = true;
+         g_mutex_unlock(&capabilities_feature_ids_mutex);
+      }
+   }
+
+   DBGTRC_RET_ERRINFO(debug, TRACE_GROUP, ddc_excp, "*ids_loc = %s",
+                                    bs256_to_string_t(*ids_loc, "x", ", "));
+   return ddc_excp;
+}
+
+
 #ifdef UNUSED
 Error_Info *
 get_capabilities_string_by_dref(Display_Ref * dref, char **pcaps) {
@@ -195,6 +391,9 @@ get_capabilities_string_by_dref(Display_Ref * dref, char **pcaps) {
 
 void init_ddc_read_capabilities() {
    RTTI_ADD_FUNC(ddc_get_capabilities_string);
+   RTTI_ADD_FUNC(ddc_get_capabilities_segments);
+   RTTI_ADD_FUNC(ddc_get_capabilities_feature_ids);
+   RTTI_ADD_FUNC(ddc_get_known_capabilities_feature_ids);
    RTTI_ADD_FUNC(get_capabilities_into_buffer);
 }
 
@@ -8,6 +8,7 @@
 #define DDC_READ_CAPABILITIES_H_
 
 /** \cond */
+#include "util/data_structures.h"
 #include "util/error_info.h"
 /** \endcond */
 
@@ -20,6 +21,22 @@ ddc_get_capabilities_string(
       Display_Handle * dh,
       char**           caps_loc);
 
+Error_Info *
+ddc_get_capabilities_segments(
+      Display_Handle * dh,
+      char **          segment_names,
+      char**           caps_loc);
+
+bool
+ddc_get_known_capabilities_feature_ids(
+      Display_Ref *    dref,
+      Bit_Set_256 *    ids_loc);
+
+Error_Info *
+ddc_get_capabilities_feature_ids(
+      Display_Handle * dh,
+      Bit_Set_256 *    ids_loc);
+
 void init_ddc_read_capabilities();
 
 #endif /* DDC_READ_CAPABILITIES_H_ */
@@ -15,6 +15,7 @@
 /** \endcond */
 
 #include "base/base_services.h"
+#include "base/detection_timing.h"
 #include "base/display_lock.h"
 #include "base/display_retry_data.h"
 #include "base/dsa2.h"
@@ -24,6 +25,7 @@
 #include "base/rtti.h"
 #include "base/sleep.h"
 #include "base/tuned_sleep.h"
+#include "base/worker_pool.h"
 
 #include "vcp/parse_capabilities.h"
 #include "vcp/persistent_capabilities.h"
@@ -144,6 +146,8 @@ void ddc_report_stats_main(DDCA_Stats_Type  stats,
       rpt_nl();
       report_elapsed_stats(depth);
       rpt_nl();
+      report_worker_pool_stats(depth);
+      rpt_nl();
    }
 
    if (stats & (DDCA_STATS_ELAPSED)) {
@@ -151,6 +155,11 @@ void ddc_report_stats_main(DDCA_Stats_Type  stats,
       rpt_nl();
    }
 
+   if (stats & DDCA_STATS_DETECTION) {
+      report_detection_timings(depth);
+      rpt_nl();
+   }
+
    if (show_per_display_stats) {
       rpt_label(depth, "PER-DISPLAY EXECUTION STATISTICS");
       rpt_nl();
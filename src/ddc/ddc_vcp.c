@@ -26,9 +26,11 @@
 #include "base/ddc_errno.h"
 #include "base/ddc_packets.h"
 #include "base/displays.h"
+#include "base/feature_value_cache.h"
 #include "base/parms.h"
 #include "base/rtti.h"
 #include "base/status_code_mgt.h"
+#include "base/tuned_sleep.h"
 
 #include "i2c/i2c_bus_core.h"
 
@@ -181,10 +183,13 @@ mock_get_nontable_vcp_value(
 // Get VCP values
 //
 
-/** Gets the value for a non-table feature.
+/** Gets the value for a non-table feature using an already constructed
+ *  Get VCP Feature request packet.
  *
  *  @param  dh                   handle for open display
  *  @param  feature_code         VCP feature code
+ *  @param  request_packet_ptr   Get VCP Feature request packet for **feature_code**,
+ *                               not modified
  *  @param  parsed_response_loc  where to return parsed response
  *  @return NULL if success, pointer to #Error_Info if failure
  *
@@ -192,10 +197,11 @@ mock_get_nontable_vcp_value(
  *
  * The value pointed to by parsed_response_loc is non-null iff the returned value is null.
  */
-Error_Info *
-ddc_get_nontable_vcp_value(
+static Error_Info *
+ddc_get_nontable_vcp_value_using_packet(
        Display_Handle *               dh,
        DDCA_Vcp_Feature_Code          feature_code,
+       DDC_Packet *                   request_packet_ptr,
        Parsed_Nontable_Vcp_Response** parsed_response_loc)
 {
    bool debug = false;
@@ -217,9 +223,6 @@ ddc_get_nontable_vcp_value(
    }
 
    DDC_Packet * response_packet_ptr = NULL;
-   DDC_Packet * request_packet_ptr = create_ddc_getvcp_request_packet(
-                                  feature_code, "ddc_get_nontable_vcp_value:request packet");
-   // dump_packet(request_packet_ptr);
 
    Byte expected_response_type = DDC_PACKET_TYPE_QUERY_VCP_RESPONSE;
    Byte expected_subtype = feature_code;
@@ -298,7 +301,6 @@ ddc_get_nontable_vcp_value(
       }
    }
 
-   free_ddc_packet(request_packet_ptr);
    if (response_packet_ptr)
       free_ddc_packet(response_packet_ptr);
 
@@ -312,6 +314,9 @@ ddc_get_nontable_vcp_value(
                       parsed_response->sh, parsed_response->sl,
                       (parsed_response->mh<<8) | parsed_response->ml,
                       (parsed_response->sh<<8) | parsed_response->sl);
+      // x02 = 0x02: feature values have been changed using the display's controls
+      if (feature_code == 0x02 && parsed_response->sl == 0x02)
+         fvc_invalidate(dh->dref, false);
    }
    *parsed_response_loc = parsed_response;
 
@@ -321,6 +326,351 @@ ddc_get_nontable_vcp_value(
 }
 
 
+/** Gets the value for a non-table feature.
+ *
+ *  @param  dh                   handle for open display
+ *  @param  feature_code         VCP feature code
+ *  @param  parsed_response_loc  where to return parsed response
+ *  @return NULL if success, pointer to #Error_Info if failure
+ *
+ * It is the responsibility of the caller to free the parsed response.
+ *
+ * The value pointed to by parsed_response_loc is non-null iff the returned value is null.
+ */
+Error_Info *
+ddc_get_nontable_vcp_value(
+       Display_Handle *               dh,
+       DDCA_Vcp_Feature_Code          feature_code,
+       Parsed_Nontable_Vcp_Response** parsed_response_loc)
+{
+   DDC_Packet * request_packet_ptr = create_ddc_getvcp_request_packet(
+                                  feature_code, "ddc_get_nontable_vcp_value:request packet");
+   // dump_packet(request_packet_ptr);
+   Error_Info * excp = ddc_get_nontable_vcp_value_using_packet(
+                          dh, feature_code, request_packet_ptr, parsed_response_loc);
+   free_ddc_packet(request_packet_ptr);
+   return excp;
+}
+
+
+//
+// Prepared requests
+//
+
+// Live prepared requests.  Guards against executing a request whose display
+// handle has been closed, or a request that has already been freed.
+static GHashTable * prepared_requests = NULL;   // set of Prepared_Vcp_Request *
+static GMutex       prepared_requests_mutex;
+
+/** Prepares a request to repeatedly read a non-table feature.
+ *
+ *  The Get VCP Feature request packet, including its checksum, is built
+ *  once and retained.
+ *
+ *  @param  dh            handle for open display
+ *  @param  feature_code  VCP feature code
+ *  @return newly allocated #Prepared_Vcp_Request
+ */
+Prepared_Vcp_Request *
+ddc_prepare_nontable_vcp_request(
+      Display_Handle *      dh,
+      DDCA_Vcp_Feature_Code feature_code)
+{
+   Prepared_Vcp_Request * preq = calloc(1, sizeof(Prepared_Vcp_Request));
+   memcpy(preq->marker, PREPARED_VCP_REQUEST_MARKER, 4);
+   preq->dh = dh;
+   preq->feature_code = feature_code;
+   preq->request_packet = create_ddc_getvcp_request_packet(
+                             feature_code, "ddc_prepare_nontable_vcp_request:request packet");
+   g_mutex_lock(&prepared_requests_mutex);
+   if (!prepared_requests)
+      prepared_requests = g_hash_table_new(g_direct_hash, NULL);
+   g_hash_table_add(prepared_requests, preq);
+   g_mutex_unlock(&prepared_requests_mutex);
+   return preq;
+}
+
+
+/** Returns the display handle of a prepared request.
+ *
+ *  The pointer passed is not dereferenced unless it is a live request,
+ *  so this function can be used to validate a pointer received from a client.
+ *
+ *  @param  preq  pointer to check
+ *  @return display handle,
+ *          NULL if **preq** is not a live #Prepared_Vcp_Request or its display
+ *          has been closed
+ */
+Display_Handle *
+ddc_get_prepared_vcp_request_dh(Prepared_Vcp_Request * preq) {
+   Display_Handle * dh = NULL;
+   g_mutex_lock(&prepared_requests_mutex);
+   if (prepared_requests && g_hash_table_contains(prepared_requests, preq)) {
+      assert(memcmp(preq->marker, PREPARED_VCP_REQUEST_MARKER, 4) == 0);
+      dh = preq->dh;
+   }
+   g_mutex_unlock(&prepared_requests_mutex);
+   return dh;
+}
+
+
+/** Reports whether a pointer is a live #Prepared_Vcp_Request.
+ *
+ *  @param  preq  pointer to check
+ *  @return true/false
+ */
+bool
+ddc_is_prepared_vcp_request(Prepared_Vcp_Request * preq) {
+   g_mutex_lock(&prepared_requests_mutex);
+   bool result = prepared_requests && g_hash_table_contains(prepared_requests, preq);
+   g_mutex_unlock(&prepared_requests_mutex);
+   return result;
+}
+
+
+/** Detaches all prepared requests from a display handle that is being closed.
+ *  The requests remain allocated until freed by the client, but can no
+ *  longer be executed.
+ *
+ *  @param  dh  display handle
+ */
+void
+ddc_invalidate_prepared_vcp_requests(Display_Handle * dh) {
+   bool debug = false;
+   int invalidated_ct = 0;
+   g_mutex_lock(&prepared_requests_mutex);
+   if (prepared_requests) {
+      GHashTableIter iter;
+      gpointer key;
+      g_hash_table_iter_init(&iter, prepared_requests);
+      while (g_hash_table_iter_next(&iter, &key, NULL)) {
+         Prepared_Vcp_Request * preq = key;
+         if (preq->dh == dh) {
+            preq->dh = NULL;
+            invalidated_ct++;
+         }
+      }
+   }
+   g_mutex_unlock(&prepared_requests_mutex);
+   DBGTRC_EXECUTED(debug, TRACE_GROUP, "dh=%p, invalidated %d request(s)", dh, invalidated_ct);
+}
+
+
+/** Executes a prepared request to read a non-table feature.
+ *
+ *  The value is always read from the display, not from the feature value cache.
+ *
+ *  @param  preq                 prepared request
+ *  @param  parsed_response_loc  where to return parsed response
+ *  @return NULL if success, pointer to #Error_Info if failure
+ */
+Error_Info *
+ddc_execute_prepared_nontable_vcp_request(
+      Prepared_Vcp_Request *         preq,
+      Parsed_Nontable_Vcp_Response** parsed_response_loc)
+{
+   assert(memcmp(preq->marker, PREPARED_VCP_REQUEST_MARKER, 4) == 0);
+   assert(preq->dh);
+   return ddc_get_nontable_vcp_value_using_packet(
+             preq->dh, preq->feature_code, preq->request_packet, parsed_response_loc);
+}
+
+
+/** Frees a #Prepared_Vcp_Request.
+ *
+ *  @param  preq  pointer to instance, may be NULL
+ */
+void
+ddc_free_prepared_vcp_request(Prepared_Vcp_Request * preq) {
+   if (preq) {
+      assert(memcmp(preq->marker, PREPARED_VCP_REQUEST_MARKER, 4) == 0);
+      g_mutex_lock(&prepared_requests_mutex);
+      g_hash_table_remove(prepared_requests, preq);
+      g_mutex_unlock(&prepared_requests_mutex);
+      free_ddc_packet(preq->request_packet);
+      preq->marker[3] = 'x';
+      free(preq);
+   }
+}
+
+
+/** Returns the time to live for a value of a non-table feature in the
+ *  feature value cache.
+ *
+ *  If the client has not set a value for the feature, the value depends on
+ *  the feature's class.  Read-only features are assumed to be static and
+ *  are cached for the life of the display, except for those known to
+ *  change.  Other features use the default time to live.
+ *
+ *  @param  dh            display handle
+ *  @param  feature_code  VCP feature code
+ *  @return time to live in milliseconds, #DDCA_CACHE_TTL_FOREVER,
+ *          or 0 if the value is not to be cached
+ */
+static int
+feature_value_cache_ttl(Display_Handle * dh, Byte feature_code) {
+   bool debug = false;
+   int ttl = fvc_get_ttl_override(feature_code);
+   if (ttl == DDCA_CACHE_TTL_DEFAULT) {
+      // features whose values change without being written
+      Byte uncacheable_features[] = {
+            0x02,        // new control value
+            0x03,        // soft controls
+            0x52,        // active control, a FIFO for MCCS 2.2 and later
+            0xaa,        // screen orientation
+            0xac,        // horizontal frequency
+            0xae,        // vertical frequency
+            0xb7,        // monitor status
+            0xc0,        // display usage time
+      };
+      ttl = feature_value_cache_default_ttl_millis;
+      for (int ndx = 0; ndx < ARRAY_SIZE(uncacheable_features); ndx++) {
+         if (uncacheable_features[ndx] == feature_code) {
+            ttl = 0;
+            break;
+         }
+      }
+      if (ttl != 0) {
+         const Display_Feature_Metadata * dfm = dyn_get_feature_metadata_by_dh_const(feature_code, dh);
+         if (dfm && (dfm->version_feature_flags & DDCA_RO))
+            ttl = DDCA_CACHE_TTL_FOREVER;
+      }
+   }
+   DBGTRC_EXECUTED(debug, TRACE_GROUP, "feature_code=0x%02x, returning %d", feature_code, ttl);
+   return ttl;
+}
+
+
+/** Gets the value for a non-table feature, using the feature value cache
+ *  if it is enabled.
+ *
+ *  @param  dh                  handle for open display
+ *  @param  feature_code        VCP feature code
+ *  @param  force_read          if true, always read the value from the display
+ *  @param  parsed_response_loc where to return pointer to newly allocated
+ *                              #Parsed_Nontable_Vcp_Response
+ *  @return NULL if success, pointer to #Error_Info if failure
+ */
+Error_Info *
+ddc_get_nontable_vcp_value_cached(
+      Display_Handle *               dh,
+      Byte                           feature_code,
+      bool                           force_read,
+      Parsed_Nontable_Vcp_Response** parsed_response_loc)
+{
+   bool debug = false;
+   DBGTRC_STARTING(debug, TRACE_GROUP, "dh=%s, feature_code=0x%02x, force_read=%s",
+                                       dh_repr(dh), feature_code, sbool(force_read));
+
+   Error_Info * excp = NULL;
+   DDCA_Non_Table_Vcp_Value cached;
+   if (feature_value_cache_enabled && !force_read &&
+       fvc_lookup(dh->dref, feature_code, &cached))
+   {
+      Parsed_Nontable_Vcp_Response * parsed_response = calloc(1, sizeof(Parsed_Nontable_Vcp_Response));
+      parsed_response->vcp_code = feature_code;
+      parsed_response->valid_response = true;
+      parsed_response->supported_opcode = true;
+      parsed_response->mh = cached.mh;
+      parsed_response->ml = cached.ml;
+      parsed_response->sh = cached.sh;
+      parsed_response->sl = cached.sl;
+      *parsed_response_loc = parsed_response;
+      DBGTRC_NOPREFIX(debug, TRACE_GROUP, "Using cached value");
+   }
+   else {
+      excp = ddc_get_nontable_vcp_value(dh, feature_code, parsed_response_loc);
+      if (!excp && feature_value_cache_enabled) {
+         Parsed_Nontable_Vcp_Response * parsed_response = *parsed_response_loc;
+         DDCA_Non_Table_Vcp_Value value = {
+               .mh = parsed_response->mh,
+               .ml = parsed_response->ml,
+               .sh = parsed_response->sh,
+               .sl = parsed_response->sl };
+         fvc_save(dh->dref, feature_code, &value, feature_value_cache_ttl(dh, feature_code));
+      }
+   }
+
+   DBGTRC_RET_ERRINFO2(debug, TRACE_GROUP, excp, *parsed_response_loc, "");
+   return excp;
+}
+
+
+/** Tests whether a status code indicates that communication with a display has
+ *  failed as a whole, rather than for a particular feature, so that there is no
+ *  point in continuing a batch operation.
+ */
+static bool is_display_level_error(DDCA_Status psc) {
+   return psc == DDCRC_DISCONNECTED || psc == DDCRC_DPMS_ASLEEP ||
+          psc == -ENODEV || psc == -ENXIO;
+}
+
+
+/** Reads the values of multiple non-table features in a single pass.
+ *
+ *  Sleeps between DDC operations are deferred for the duration of the batch,
+ *  so a sleep required after one operation overlaps the host side processing
+ *  of the next one, and the sleep following the final read does not delay
+ *  the return.
+ *
+ *  Values are taken from the feature value cache if it is enabled.
+ *
+ *  A failure reading a feature is recorded in its entry and the batch continues,
+ *  unless the failure indicates that the display itself cannot be communicated
+ *  with.  In that case the remaining entries are given the same status.
+ *
+ *  @param  dh         handle for open display
+ *  @param  entries    array of entries, with feature_code set for each
+ *  @param  entry_ct   number of entries
+ *  @return NULL if the batch was processed, even if some features could not be
+ *          read, pointer to #Error_Info if the batch was abandoned
+ */
+Error_Info *
+ddc_get_multiple_nontable_vcp_values(
+      Display_Handle *        dh,
+      DDCA_Vcp_Batch_Entry *  entries,
+      int                     entry_ct)
+{
+   bool debug = false;
+   DBGTRC_STARTING(debug, TRACE_GROUP, "dh=%s, entry_ct=%d", dh_repr(dh), entry_ct);
+
+   Error_Info * batch_err = NULL;
+   bool old_deferred = enable_thread_deferred_sleep(true);
+   int ok_ct = 0;
+   for (int ndx = 0; ndx < entry_ct; ndx++) {
+      DDCA_Vcp_Batch_Entry * entry = &entries[ndx];
+      memset(&entry->value, 0, sizeof(entry->value));
+      if (batch_err) {
+         entry->status = batch_err->status_code;
+         continue;
+      }
+      Parsed_Nontable_Vcp_Response * parsed_response = NULL;
+      Error_Info * erec = ddc_get_nontable_vcp_value_cached(
+            dh, entry->feature_code, /*force_read=*/ false, &parsed_response);
+      if (erec) {
+         entry->status = erec->status_code;
+         if (is_display_level_error(erec->status_code))
+            batch_err = erec;
+         else
+            ERRINFO_FREE_WITH_REPORT(erec, IS_DBGTRC(debug, TRACE_GROUP));
+      }
+      else {
+         entry->status = DDCRC_OK;
+         entry->value.mh = parsed_response->mh;
+         entry->value.ml = parsed_response->ml;
+         entry->value.sh = parsed_response->sh;
+         entry->value.sl = parsed_response->sl;
+         free(parsed_response);
+         ok_ct++;
+      }
+   }
+   enable_thread_deferred_sleep(old_deferred);
+
+   DBGTRC_RET_ERRINFO(debug, TRACE_GROUP, batch_err, "%d of %d features read", ok_ct, entry_ct);
+   return batch_err;
+}
+
+
 /** Gets the value of a table feature in a newly allocated Buffer struct.
  *  It is the responsibility of the caller to free the Buffer.
  *
@@ -347,6 +697,8 @@ ddc_get_table_vcp_value(
             DDC_PACKET_TYPE_TABLE_READ_REQUEST,
             feature_code,
             Write_Read_Flag_All_Zero_Response_Ok | Write_Read_Flag_Table_Read,
+            NULL,              // stop_func
+            NULL,              // stop_func_arg
             &paccumulator);
    if (debug || ddc_excp) {
       DBGTRC_NOPREFIX(debug, TRACE_GROUP,
@@ -555,13 +907,10 @@ is_rereadable_feature(
    }
 
    if (result) {
-      Display_Feature_Metadata * dfm =
-            dyn_get_feature_metadata_by_dh(opcode, dh, /*check_udf=*/ true, /*with_default*/false);
+      const Display_Feature_Metadata * dfm = dyn_get_feature_metadata_by_dh_const(opcode, dh);
       // if not found, assume readable  ??
-      if (dfm) {
+      if (dfm)
          result = dfm->version_feature_flags & DDCA_READABLE;
-         dfm_free(dfm);
-      }
    }
 
    DBGTRC_RET_BOOL(debug, TRACE_GROUP, result, "");
@@ -651,6 +1000,11 @@ ddc_set_nontable_vcp_value(
           "Writing feature 0x%02x , new value = %d, dh=%s",
           feature_code, new_value, dh_repr(dh) );
 
+   // A write can change the values of other features, e.g. color preset and RGB gains.
+   // Writing x02 (New Control Value) only resets the change indicator.
+   if (feature_code != 0x02)
+      fvc_invalidate(dh->dref, false);
+
    Public_Status_Code psc = 0;
    Error_Info * ddc_excp = NULL;
    if (dh->dref->io_path.io_mode == DDCA_IO_USB) {
@@ -700,6 +1054,8 @@ set_table_vcp_value(
    DBGTRC_STARTING(debug, TRACE_GROUP, "Writing feature 0x%02x , bytect = %d",
                                        feature_code, bytect);
 
+   fvc_invalidate(dh->dref, false);
+
    Public_Status_Code psc = 0;
    Error_Info * ddc_excp = NULL;
    if (dh->dref->io_path.io_mode == DDCA_IO_USB) {
@@ -879,11 +1235,115 @@ ddc_set_verified_vcp_value_with_retry(
 }
 
 
+/** Sets the values of multiple non-table features, then verifies them in a
+ *  single pass.
+ *
+ *  The features are written in array order, back to back.  Sleeps between
+ *  DDC operations are deferred for the duration of the batch, so only the
+ *  mandatory gap between operations is observed.  If setvcp verification is
+ *  enabled, once all writes have been performed each feature that was
+ *  successfully written and can be meaningfully reread is read, and its
+ *  status is set to DDCRC_VERIFY if the value read does not match the
+ *  value written.  As with #ddc_set_vcp_value(), only the SL byte is compared.
+ *
+ *  A failure writing a feature is recorded in its entry and the batch continues,
+ *  unless the failure indicates that the display itself cannot be communicated
+ *  with.  In that case the remaining entries are given the same status.
+ *
+ *  @param  dh         handle for open display
+ *  @param  entries    array of entries, with feature_code and value set for each
+ *  @param  entry_ct   number of entries
+ *  @return NULL if the batch was processed, even if some features were not
+ *          successfully set, pointer to #Error_Info if the batch was abandoned
+ */
+Error_Info *
+ddc_set_multiple_nontable_vcp_values(
+      Display_Handle *        dh,
+      DDCA_Vcp_Batch_Entry *  entries,
+      int                     entry_ct)
+{
+   bool debug = false;
+   bool verify = ddc_get_verify_setvcp();
+   DBGTRC_STARTING(debug, TRACE_GROUP, "dh=%s, entry_ct=%d, verify=%s",
+                                       dh_repr(dh), entry_ct, sbool(verify));
+
+   Error_Info * batch_err = NULL;
+   bool old_deferred = enable_thread_deferred_sleep(true);
+
+   for (int ndx = 0; ndx < entry_ct; ndx++) {
+      DDCA_Vcp_Batch_Entry * entry = &entries[ndx];
+      if (batch_err) {
+         entry->status = batch_err->status_code;
+         continue;
+      }
+      int new_value = entry->value.sh << 8 | entry->value.sl;
+      Error_Info * erec = ddc_set_nontable_vcp_value(dh, entry->feature_code, new_value);
+      entry->status = (erec) ? erec->status_code : DDCRC_OK;
+      if (erec) {
+         if (is_display_level_error(erec->status_code))
+            batch_err = erec;
+         else
+            ERRINFO_FREE_WITH_REPORT(erec, IS_DBGTRC(debug, TRACE_GROUP));
+      }
+   }
+
+   int verify_ct = 0;
+   int verify_failure_ct = 0;
+   if (verify && !batch_err) {
+      for (int ndx = 0; ndx < entry_ct; ndx++) {
+         DDCA_Vcp_Batch_Entry * entry = &entries[ndx];
+         if (batch_err) {
+            if (entry->status == DDCRC_OK)
+               entry->status = batch_err->status_code;
+            continue;
+         }
+         if (entry->status != DDCRC_OK                           ||
+             !is_rereadable_feature(dh, entry->feature_code)     ||
+             is_unreadable_sl_value(entry->feature_code, entry->value.sl) )
+            continue;
+
+         verify_ct++;
+         Parsed_Nontable_Vcp_Response * parsed_response = NULL;
+         Error_Info * erec = ddc_get_nontable_vcp_value(dh, entry->feature_code, &parsed_response);
+         if (erec) {
+            DBGTRC_NOPREFIX(debug, TRACE_GROUP, "Read after write of feature 0x%02x failed: %s",
+                                     entry->feature_code, psc_desc(erec->status_code));
+            entry->status = erec->status_code;
+            if (is_display_level_error(erec->status_code))
+               batch_err = erec;
+            else
+               ERRINFO_FREE_WITH_REPORT(erec, IS_DBGTRC(debug, TRACE_GROUP));
+         }
+         else {
+            if (parsed_response->sl != entry->value.sl) {
+               DBGTRC_NOPREFIX(debug, TRACE_GROUP,
+                     "Feature 0x%02x: value set 0x%02x, current value 0x%02x",
+                     entry->feature_code, entry->value.sl, parsed_response->sl);
+               entry->status = DDCRC_VERIFY;
+               verify_failure_ct++;
+            }
+            free(parsed_response);
+         }
+      }
+   }
+   enable_thread_deferred_sleep(old_deferred);
+
+   DBGTRC_RET_ERRINFO(debug, TRACE_GROUP, batch_err, "verified %d features, %d failures",
+                                                     verify_ct, verify_failure_ct);
+   return batch_err;
+}
+
+
 void init_ddc_vcp() {
    RTTI_ADD_FUNC(ddc_get_nontable_vcp_value);
+   RTTI_ADD_FUNC(ddc_get_nontable_vcp_value_using_packet);
+   RTTI_ADD_FUNC(ddc_get_nontable_vcp_value_cached);
+   RTTI_ADD_FUNC(ddc_invalidate_prepared_vcp_requests);
+   RTTI_ADD_FUNC(ddc_get_multiple_nontable_vcp_values);
    RTTI_ADD_FUNC(ddc_get_table_vcp_value);
    RTTI_ADD_FUNC(ddc_get_vcp_value);
    RTTI_ADD_FUNC(ddc_set_nontable_vcp_value);
+   RTTI_ADD_FUNC(ddc_set_multiple_nontable_vcp_values);
    RTTI_ADD_FUNC(ddc_set_vcp_value);
    RTTI_ADD_FUNC(ddc_set_verified_vcp_value_with_retry);
    RTTI_ADD_FUNC(is_rereadable_feature);
@@ -41,6 +41,12 @@ ddc_set_nontable_vcp_value(
       Byte                      feature_code,
       int                       new_value);
 
+Error_Info *
+ddc_set_multiple_nontable_vcp_values(
+      Display_Handle *          dh,
+      DDCA_Vcp_Batch_Entry *    entries,
+      int                       entry_ct);
+
 Error_Info *
 ddc_set_vcp_value(
       Display_Handle *          dh,
@@ -65,6 +71,54 @@ ddc_get_nontable_vcp_value(
       Byte                      feature_code,
       Parsed_Nontable_Vcp_Response** parsed_response_loc);
 
+Error_Info *
+ddc_get_nontable_vcp_value_cached(
+      Display_Handle *          dh,
+      Byte                      feature_code,
+      bool                      force_read,
+      Parsed_Nontable_Vcp_Response** parsed_response_loc);
+
+#define PREPARED_VCP_REQUEST_MARKER "PVRQ"
+/** Request to read a non-table feature, built once for repeated execution */
+typedef struct {
+   char                     marker[4];
+   Display_Handle *         dh;                // NULL once the display is closed
+   DDCA_Vcp_Feature_Code    feature_code;
+   DDC_Packet *             request_packet;    // includes checksum
+} Prepared_Vcp_Request;
+
+Prepared_Vcp_Request *
+ddc_prepare_nontable_vcp_request(
+      Display_Handle *          dh,
+      DDCA_Vcp_Feature_Code     feature_code);
+
+Error_Info *
+ddc_execute_prepared_nontable_vcp_request(
+      Prepared_Vcp_Request *    preq,
+      Parsed_Nontable_Vcp_Response** parsed_response_loc);
+
+void
+ddc_free_prepared_vcp_request(
+      Prepared_Vcp_Request *    preq);
+
+Display_Handle *
+ddc_get_prepared_vcp_request_dh(
+      Prepared_Vcp_Request *    preq);
+
+bool
+ddc_is_prepared_vcp_request(
+      Prepared_Vcp_Request *    preq);
+
+void
+ddc_invalidate_prepared_vcp_requests(
+      Display_Handle *          dh);
+
+Error_Info *
+ddc_get_multiple_nontable_vcp_values(
+      Display_Handle *          dh,
+      DDCA_Vcp_Batch_Entry *    entries,
+      int                       entry_ct);
+
 Error_Info *
 ddc_get_vcp_value(
        Display_Handle *         dh,
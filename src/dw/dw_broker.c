@@ -0,0 +1,720 @@
+/** @file dw_broker.c
+ *
+ *  Shares display change detection among the libddcutil processes of a user.
+ *
+ *  When broker mode is enabled, the first process to start watching binds a
+ *  Unix socket in the abstract namespace and becomes the broker.  It watches
+ *  for display changes as usual, and publishes each connection related
+ *  event to the processes that subsequently start watching.  These
+ *  subscribers do not run their own watch, stabilization, or recheck
+ *  threads, and perform no I2C I/O for the events received.  Each event
+ *  carries the results of the broker's own probing of the display: EDID,
+ *  bus information, DDC communication flags, and VCP version.  A subscriber
+ *  builds or updates its display reference for the bus from these, and
+ *  emits the event to its own clients.
+ *
+ *  On connecting, the broker tells the subscriber which event classes it
+ *  watches.  A process requesting classes the broker does not watch
+ *  watches independently instead.
+ *
+ *  If the broker process terminates or stops watching, the connection is
+ *  closed.  One subscriber then succeeds in binding the socket, becomes the
+ *  broker, and starts its own watch threads.  The others connect to it.
+ *
+ *  A single thread per process services the socket, in whichever role.
+ *  Peers are required to have the same user id.
+ */
+
+// Copyright (C) 2025 Sanford Rockowitz <rockowitz@minsoft.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "config.h"
+
+/** \cond */
+#include <assert.h>
+#include <errno.h>
+#include <glib-2.0/glib.h>
+#include <poll.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "public/ddcutil_types.h"
+
+#include "util/data_structures.h"
+#include "util/edid.h"
+#include "util/linux_util.h"
+#include "util/string_util.h"
+/** \endcond */
+
+#include "base/core.h"
+#include "base/displays.h"
+#include "base/i2c_bus_base.h"
+#include "base/parms.h"
+#include "base/rtti.h"
+#include "base/sleep.h"
+
+#include "ddc/ddc_displays.h"
+
+#include "dw_common.h"
+#include "dw_dref.h"
+#include "dw_main.h"
+#include "dw_poll.h"     // for process_event_mutex
+#include "dw_status_events.h"
+
+#include "dw_broker.h"
+
+
+// Trace class for this file
+static DDCA_Trace_Group TRACE_GROUP = DDCA_TRC_CONN;
+
+bool watch_broker_enabled = DEFAULT_WATCH_BROKER_ENABLED;
+
+#define BROKER_MSG_VERSION         2
+#define BROKER_MAX_PENDING         8     // listen() backlog
+#define BROKER_CONNECT_TRIES       5
+#define BROKER_HELLO_TIMEOUT_MILLIS 2000
+
+// Display_Ref flags set by ddc_initial_checks_by_dref(), passed to subscribers
+#define BROKER_DREF_FLAGS (DREF_DDC_COMMUNICATION_CHECKED                 | \
+                           DREF_DDC_COMMUNICATION_WORKING                 | \
+                           DREF_UNSUPPORTED_CHECKED                       | \
+                           DREF_DDC_USES_NULL_RESPONSE_FOR_UNSUPPORTED    | \
+                           DREF_DDC_USES_MH_ML_SH_SL_ZERO_FOR_UNSUPPORTED | \
+                           DREF_DDC_USES_DDC_FLAG_FOR_UNSUPPORTED         | \
+                           DREF_DDC_DOES_NOT_INDICATE_UNSUPPORTED         | \
+                           DREF_DDC_BUSY                                  | \
+                           DREF_DDC_DISABLED                              | \
+                           DREF_DPMS_SUSPEND_STANDBY_OFF)
+
+/** First record sent by the broker to a new subscriber. */
+typedef struct {
+   uint32_t  version;
+   uint32_t  event_classes;      // DDCA_Display_Event_Class watched by the broker
+} Broker_Hello_Msg;
+
+/** Event record sent over the socket.  A #DDCA_Display_Status_Event cannot
+ *  be sent as is, since its display reference is meaningful only within the
+ *  sending process.  Displays are identified by I2C bus number.  The broker's
+ *  probe results are included so that subscribers need not repeat them.
+ */
+typedef struct {
+   uint32_t  version;
+   int32_t   event_type;         // DDCA_Display_Event_Type
+   int32_t   busno;
+   uint32_t  flags;              // DDCA_Display_Status_Event.flags
+   char      connector_name[32];
+   // probe results, valid if has_edid
+   uint8_t   has_edid;
+   uint8_t   edid[128];
+   char      edid_source[EDID_SOURCE_FIELD_SIZE];
+   uint8_t   vcp_version_major;
+   uint8_t   vcp_version_minor;
+   uint32_t  dref_flags;         // BROKER_DREF_FLAGS subset of Display_Ref.flags
+   uint32_t  bus_flags;          // I2C_Bus_Info.flags
+   int32_t   drm_connector_id;
+   int32_t   drm_connector_found_by;
+   char      driver[32];
+} Broker_Event_Msg;
+
+static GMutex      broker_mutex;              // protects the following
+static Broker_Role broker_role    = Broker_Role_None;
+static int         listen_fd      = -1;       // role broker
+static int         broker_conn_fd = -1;       // role subscriber, connection to broker
+static GArray *    subscriber_fds = NULL;     // role broker, connections to subscribers
+static int         broker_stop_fd = -1;       // eventfd, readable when thread is to exit
+static GThread *   broker_thread  = NULL;
+static DDCA_Display_Event_Class
+                   broker_event_classes = DDCA_EVENT_CLASS_NONE;  // requested by this process
+
+
+const char * broker_role_name(Broker_Role role) {
+   char * result = NULL;
+   switch(role) {
+   case Broker_Role_None:        result = "Broker_Role_None";       break;
+   case Broker_Role_Broker:      result = "Broker_Role_Broker";     break;
+   case Broker_Role_Subscriber:  result = "Broker_Role_Subscriber"; break;
+   }
+   return result;
+}
+
+
+Broker_Role dw_broker_role() {
+   g_mutex_lock(&broker_mutex);
+   Broker_Role role = broker_role;
+   g_mutex_unlock(&broker_mutex);
+   return role;
+}
+
+
+//
+// Socket setup
+//
+
+/** Sets the address of the broker socket.  The name is in the abstract
+ *  namespace, so it is released automatically when the broker process exits,
+ *  however it exits.
+ */
+static socklen_t
+broker_socket_address(struct sockaddr_un * addr) {
+   memset(addr, 0, sizeof(*addr));
+   addr->sun_family = AF_UNIX;
+   int namelen = g_snprintf(addr->sun_path+1, sizeof(addr->sun_path)-1,
+                            "ddcutil-watch-broker-%u", getuid());
+   return offsetof(struct sockaddr_un, sun_path) + 1 + namelen;
+}
+
+
+static bool
+peer_is_same_user(int fd) {
+   struct ucred cred;
+   socklen_t len = sizeof(cred);
+   if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) < 0)
+      return false;
+   return cred.uid == getuid();
+}
+
+
+/** Attempts to bind and listen on the broker socket.
+ *
+ *  @return socket, -1 if another process is the broker or an error occurred
+ */
+static int
+try_bind_broker_socket() {
+   bool debug = false;
+   int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+   if (fd < 0) {
+      SYSLOG2(DDCA_SYSLOG_ERROR, "socket() failed. errno=%s", linux_errno_desc(errno));
+   }
+   else {
+      struct sockaddr_un addr;
+      socklen_t addrlen = broker_socket_address(&addr);
+      if (bind(fd, (struct sockaddr *) &addr, addrlen) < 0 || listen(fd, BROKER_MAX_PENDING) < 0) {
+         if (errno != EADDRINUSE)
+            SYSLOG2(DDCA_SYSLOG_ERROR, "Error creating watch broker socket. errno=%s",
+                                       linux_errno_desc(errno));
+         close(fd);
+         fd = -1;
+      }
+   }
+   DBGTRC_EXECUTED(debug, TRACE_GROUP, "Returning %d", fd);
+   return fd;
+}
+
+
+/** Attempts to connect to the broker socket.
+ *
+ *  @return socket, -1 if no broker or an error occurred
+ */
+static int
+try_connect_broker_socket() {
+   bool debug = false;
+   int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+   if (fd >= 0) {
+      struct sockaddr_un addr;
+      socklen_t addrlen = broker_socket_address(&addr);
+      if (connect(fd, (struct sockaddr *) &addr, addrlen) < 0) {
+         close(fd);
+         fd = -1;
+      }
+      else if (!peer_is_same_user(fd)) {
+         SYSLOG2(DDCA_SYSLOG_ERROR, "Watch broker socket is owned by another user");
+         close(fd);
+         fd = -1;
+      }
+   }
+   DBGTRC_EXECUTED(debug, TRACE_GROUP, "Returning %d", fd);
+   return fd;
+}
+
+
+/** Waits for the hello record from the broker, and checks that the broker
+ *  watches all the event classes requested by this process.
+ *
+ *  @param  fd  connection to the broker
+ *  @return true if this process can subscribe, false if not
+ */
+static bool
+receive_broker_hello(int fd) {
+   bool debug = false;
+   bool ok = false;
+   Broker_Hello_Msg hello;
+   struct pollfd pfd = {.fd = fd, .events = POLLIN};
+   if (poll(&pfd, 1, BROKER_HELLO_TIMEOUT_MILLIS) > 0 &&
+       recv(fd, &hello, sizeof(hello), 0) == sizeof(hello))
+   {
+      if (hello.version != BROKER_MSG_VERSION) {
+         SYSLOG2(DDCA_SYSLOG_WARNING, "Watch broker uses message version %u, expected %d",
+                                      hello.version, BROKER_MSG_VERSION);
+      }
+      else if ((hello.event_classes & broker_event_classes) != broker_event_classes) {
+         SYSLOG2(DDCA_SYSLOG_NOTICE,
+               "Watch broker event classes 0x%02x do not include requested classes 0x%02x",
+               hello.event_classes, broker_event_classes);
+      }
+      else {
+         ok = true;
+      }
+   }
+   else {
+      SYSLOG2(DDCA_SYSLOG_WARNING, "No response from watch broker");
+   }
+   DBGTRC_EXECUTED(debug, TRACE_GROUP, "fd=%d, Returning %s", fd, SBOOL(ok));
+   return ok;
+}
+
+
+/** Becomes either the broker or a subscriber.  A process that loses the
+ *  race to bind may find that the winner is not yet listening, so the
+ *  sequence is retried.  If the broker does not watch all the event classes
+ *  requested by this process, neither role is established.
+ *  Called with broker_mutex held.
+ */
+static Broker_Role
+establish_role() {
+   bool debug = false;
+   Broker_Role role = Broker_Role_None;
+   for (int ctr = 0; ctr < BROKER_CONNECT_TRIES && role == Broker_Role_None; ctr++) {
+      if (ctr > 0)
+         SLEEP_MILLIS_WITH_STATS(50);
+      listen_fd = try_bind_broker_socket();
+      if (listen_fd >= 0) {
+         role = Broker_Role_Broker;
+      }
+      else {
+         broker_conn_fd = try_connect_broker_socket();
+         if (broker_conn_fd >= 0) {
+            if (!receive_broker_hello(broker_conn_fd)) {
+               close(broker_conn_fd);
+               broker_conn_fd = -1;
+               break;
+            }
+            role = Broker_Role_Subscriber;
+         }
+      }
+   }
+   broker_role = role;
+   DBGTRC_EXECUTED(debug, TRACE_GROUP, "Returning %s", broker_role_name(role));
+   return role;
+}
+
+
+//
+// Broker role
+//
+
+static void
+remove_subscriber(guint ndx) {
+   int fd = g_array_index(subscriber_fds, int, ndx);
+   close(fd);
+   g_array_remove_index_fast(subscriber_fds, ndx);
+   SYSLOG2(DDCA_SYSLOG_NOTICE, "Watch broker subscriber disconnected, %d remaining", subscriber_fds->len);
+}
+
+
+static void
+accept_subscriber() {
+   int fd = accept4(listen_fd, NULL, NULL, SOCK_CLOEXEC | SOCK_NONBLOCK);
+   if (fd < 0) {
+      if (errno != EAGAIN && errno != EWOULDBLOCK)
+         SYSLOG2(DDCA_SYSLOG_ERROR, "accept4() failed. errno=%s", linux_errno_desc(errno));
+   }
+   else if (!peer_is_same_user(fd)) {
+      SYSLOG2(DDCA_SYSLOG_WARNING, "Rejected watch broker connection from another user");
+      close(fd);
+   }
+   else {
+      Broker_Hello_Msg hello = {.version = BROKER_MSG_VERSION, .event_classes = broker_event_classes};
+      if (send(fd, &hello, sizeof(hello), MSG_NOSIGNAL | MSG_DONTWAIT) != sizeof(hello)) {
+         SYSLOG2(DDCA_SYSLOG_ERROR, "Error sending to watch broker subscriber. errno=%s",
+                                    linux_errno_desc(errno));
+         close(fd);
+      }
+      else {
+         g_array_append_val(subscriber_fds, fd);
+         SYSLOG2(DDCA_SYSLOG_NOTICE, "Watch broker subscriber connected, %d total", subscriber_fds->len);
+      }
+   }
+}
+
+
+/** Copies this process's probe results for a display into an event record.
+ *
+ *  @param  msg   event record
+ *  @param  dref  display reference, may be NULL
+ */
+static void
+set_probe_results(Broker_Event_Msg * msg, Display_Ref * dref) {
+   if (dref && dref->pedid && !(dref->flags & DREF_REMOVED)) {
+      msg->has_edid = 1;
+      memcpy(msg->edid, dref->pedid->bytes, sizeof(msg->edid));
+      g_snprintf(msg->edid_source, sizeof(msg->edid_source), "%s", dref->pedid->edid_source);
+      msg->vcp_version_major = dref->vcp_version_xdf.major;
+      msg->vcp_version_minor = dref->vcp_version_xdf.minor;
+      msg->dref_flags        = dref->flags & BROKER_DREF_FLAGS;
+      I2C_Bus_Info * businfo = dref->detail;
+      if (businfo && dref->io_path.io_mode == DDCA_IO_I2C) {
+         msg->bus_flags              = businfo->flags;
+         msg->drm_connector_id       = businfo->drm_connector_id;
+         msg->drm_connector_found_by = businfo->drm_connector_found_by;
+         g_snprintf(msg->driver, sizeof(msg->driver), "%s", (businfo->driver) ? businfo->driver : "");
+      }
+   }
+}
+
+
+/** Sends an event to all subscribers.  Called from the thread that emits
+ *  display status events.  Does nothing unless this process is the broker.
+ *
+ *  @param  evt  event
+ */
+void dw_broker_publish(DDCA_Display_Status_Event evt) {
+   bool debug = false;
+   if (evt.event_type == DDCA_EVENT_VCP_VALUE_CHANGED)    // per process, see dw_vcp_monitor.c
+      return;
+
+   g_mutex_lock(&broker_mutex);
+   if (broker_role == Broker_Role_Broker && subscriber_fds->len > 0) {
+      DBGTRC_STARTING(debug, TRACE_GROUP, "evt=%s, %d subscribers",
+                                          display_status_event_repr_t(evt), subscriber_fds->len);
+      Broker_Event_Msg msg;
+      memset(&msg, 0, sizeof(msg));
+      msg.version    = BROKER_MSG_VERSION;
+      msg.event_type = evt.event_type;
+      msg.busno      = (evt.io_path.io_mode == DDCA_IO_I2C) ? evt.io_path.path.i2c_busno : -1;
+      msg.flags      = evt.flags;
+      g_snprintf(msg.connector_name, sizeof(msg.connector_name), "%s", evt.connector_name);
+      set_probe_results(&msg, dref_from_published_ddca_dref(evt.dref));
+
+      for (int ndx = subscriber_fds->len-1; ndx >= 0; ndx--) {
+         int fd = g_array_index(subscriber_fds, int, ndx);
+         if (send(fd, &msg, sizeof(msg), MSG_NOSIGNAL | MSG_DONTWAIT) != sizeof(msg)) {
+            // A subscriber that has stopped reading is dropped rather than blocking the broker
+            SYSLOG2(DDCA_SYSLOG_WARNING, "Error sending to watch broker subscriber. errno=%s",
+                                         linux_errno_desc(errno));
+            remove_subscriber(ndx);
+         }
+      }
+      DBGTRC_DONE(debug, TRACE_GROUP, "");
+   }
+   g_mutex_unlock(&broker_mutex);
+}
+
+
+//
+// Subscriber role
+//
+
+/** Updates the bus information record for a newly connected display from
+ *  the broker's probe results, without any I2C I/O.
+ *
+ *  @param  msg  event record
+ *  @return bus information record, NULL if the record has no valid EDID
+ */
+static I2C_Bus_Info *
+businfo_from_broker_msg(Broker_Event_Msg * msg) {
+   Parsed_Edid * edid = (msg->has_edid) ? create_parsed_edid2(msg->edid, msg->edid_source) : NULL;
+   if (!edid)
+      return NULL;
+
+   bool new_info = false;
+   I2C_Bus_Info * businfo = i2c_get_bus_info(msg->busno, &new_info);
+   if (!new_info)
+      i2c_reset_bus_info(businfo);
+   businfo->edid  = edid;
+   businfo->flags = msg->bus_flags | I2C_BUS_PROBED;
+   if (!businfo->drm_connector_name || !streq(businfo->drm_connector_name, msg->connector_name))
+      businfo->drm_connector_name = g_strdup(msg->connector_name);
+   businfo->drm_connector_id       = msg->drm_connector_id;
+   businfo->drm_connector_found_by = msg->drm_connector_found_by;
+   if (!businfo->driver && strlen(msg->driver) > 0)
+      businfo->driver = g_strdup(msg->driver);
+   return businfo;
+}
+
+
+/** Applies an event received from the broker to this process's display
+ *  references, emitting the corresponding local event.  Display references
+ *  are built or updated from the broker's probe results, so no I2C I/O is
+ *  performed.  Events in classes not requested by this process are ignored.
+ */
+static void
+process_broker_event(Broker_Event_Msg * msg) {
+   bool debug = false;
+   DBGTRC_STARTING(debug, TRACE_GROUP, "event_type=%s, busno=%d, connector=%s",
+         dw_display_event_type_name(msg->event_type), msg->busno, msg->connector_name);
+
+   if (msg->busno < 0 || msg->busno > 255) {
+      DBGTRC_DONE(debug, TRACE_GROUP, "Ignoring event for non-I2C display");
+      return;
+   }
+
+   bool is_dpms_event = msg->event_type == DDCA_EVENT_DPMS_AWAKE ||
+                        msg->event_type == DDCA_EVENT_DPMS_ASLEEP;
+   DDCA_Display_Event_Class event_class =
+         (is_dpms_event) ? DDCA_EVENT_CLASS_DPMS : DDCA_EVENT_CLASS_DISPLAY_CONNECTION;
+   if (!(broker_event_classes & event_class)) {
+      DBGTRC_DONE(debug, TRACE_GROUP, "Ignoring event in unrequested class");
+      return;
+   }
+
+   DDCA_MCCS_Version_Spec vspec = {msg->vcp_version_major, msg->vcp_version_minor};
+   g_mutex_lock(&process_event_mutex);
+   Display_Ref * dref = GET_DREF_BY_BUSNO(msg->busno, /*ignore_invalid*/ true);
+   switch(msg->event_type) {
+   case DDCA_EVENT_DISPLAY_DISCONNECTED:
+      if (dref)
+         dw_hotplug_change_handler(bs256_insert(EMPTY_BIT_SET_256, msg->busno), EMPTY_BIT_SET_256,
+                                   NULL, NULL);
+      break;
+   case DDCA_EVENT_DISPLAY_CONNECTED:
+      if (!dref) {
+         I2C_Bus_Info * businfo = businfo_from_broker_msg(msg);
+         if (!businfo) {
+            SYSLOG2(DDCA_SYSLOG_ERROR, "Watch broker event for bus %d has no valid EDID", msg->busno);
+            break;
+         }
+         SYSLOG2(DDCA_SYSLOG_NOTICE, "Adding connected display with bus %d", msg->busno);
+         dref = dw_add_checked_display_by_businfo(businfo, msg->dref_flags, vspec);
+         add_published_dref_id_by_dref(dref);
+         dw_emit_or_queue_display_status_event(DDCA_EVENT_DISPLAY_CONNECTED,
+               businfo->drm_connector_name, dref, dref->io_path, NULL);
+      }
+      break;
+   case DDCA_EVENT_DDC_ENABLED:
+      if (dref && !(dref->flags & DREF_DDC_COMMUNICATION_WORKING)) {
+         dref->flags = (dref->flags & ~BROKER_DREF_FLAGS) | (msg->dref_flags & BROKER_DREF_FLAGS);
+         dref->vcp_version_xdf = vspec;
+         dref->dispno = ++dispno_max;
+         dw_emit_or_queue_display_status_event(DDCA_EVENT_DDC_ENABLED,
+               dref->drm_connector, dref, dref->io_path, NULL);
+      }
+      break;
+   case DDCA_EVENT_DPMS_AWAKE:
+   case DDCA_EVENT_DPMS_ASLEEP:
+      if (dref)
+         dw_emit_or_queue_display_status_event(msg->event_type,
+               dref->drm_connector, dref, dref->io_path, NULL);
+      break;
+   default:
+      break;
+   }
+   g_mutex_unlock(&process_event_mutex);
+
+   DBGTRC_DONE(debug, TRACE_GROUP, "");
+}
+
+
+/** Called when the connection to the broker is lost.  Either becomes the
+ *  broker, in which case this process starts its own watch threads, or
+ *  connects to the new broker.  If neither is possible, e.g. because the
+ *  new broker does not watch the event classes requested by this process,
+ *  this process starts its own watch threads without being the broker.
+ *
+ *  @return true if a role was established
+ */
+static bool
+replace_broker() {
+   bool debug = false;
+   DBGTRC_STARTING(debug, TRACE_GROUP, "");
+
+   g_mutex_lock(&broker_mutex);
+   close(broker_conn_fd);
+   broker_conn_fd = -1;
+   Broker_Role role = establish_role();
+   g_mutex_unlock(&broker_mutex);
+
+   if (role == Broker_Role_Broker) {
+      MSG_W_SYSLOG(DDCA_SYSLOG_NOTICE, "Watch broker exited, this process is now the watch broker");
+      dw_take_over_watching();
+   }
+   else if (role == Broker_Role_None) {
+      MSG_W_SYSLOG(DDCA_SYSLOG_WARNING, "Watch broker exited and no usable replacement, watching independently");
+      dw_take_over_watching();
+   }
+
+   DBGTRC_DONE(debug, TRACE_GROUP, "role=%s", broker_role_name(role));
+   return role != Broker_Role_None;
+}
+
+
+//
+// Broker thread
+//
+
+/** Function executed by the broker thread.
+ *  In the broker role accepts subscribers and notices their departure.
+ *  In the subscriber role receives events from the broker.
+ */
+static gpointer
+dw_broker_thread_func(gpointer data) {
+   bool debug = false;
+   DBGTRC_STARTING(debug, TRACE_GROUP, "role=%s", broker_role_name(broker_role));
+
+   GArray * pollfds = g_array_new(false, true, sizeof(struct pollfd));
+   bool terminate = false;
+   while (!terminate) {
+      g_array_set_size(pollfds, 0);
+      struct pollfd pfd = {.fd = broker_stop_fd, .events = POLLIN};
+      g_array_append_val(pollfds, pfd);
+
+      g_mutex_lock(&broker_mutex);
+      Broker_Role role = broker_role;
+      if (role == Broker_Role_Broker) {
+         pfd.fd = listen_fd;
+         g_array_append_val(pollfds, pfd);
+         for (guint ndx = 0; ndx < subscriber_fds->len; ndx++) {
+            pfd.fd = g_array_index(subscriber_fds, int, ndx);
+            g_array_append_val(pollfds, pfd);
+         }
+      }
+      else if (role == Broker_Role_Subscriber) {
+         pfd.fd = broker_conn_fd;
+         g_array_append_val(pollfds, pfd);
+      }
+      g_mutex_unlock(&broker_mutex);
+
+      int rc = poll((struct pollfd *) pollfds->data, pollfds->len, -1);
+      if (rc < 0) {
+         if (errno == EINTR)
+            continue;
+         SYSLOG2(DDCA_SYSLOG_ERROR, "poll() failed. errno=%s", linux_errno_desc(errno));
+         break;
+      }
+      struct pollfd * fds = (struct pollfd *) pollfds->data;
+      if (fds[0].revents) {
+         terminate = true;
+      }
+      else if (role == Broker_Role_Subscriber) {
+         if (fds[1].revents) {
+            Broker_Event_Msg msg;
+            ssize_t ct = recv(broker_conn_fd, &msg, sizeof(msg), 0);
+            if (ct == sizeof(msg) && msg.version == BROKER_MSG_VERSION)
+               process_broker_event(&msg);
+            else if (ct <= 0 && !(ct < 0 && errno == EINTR))
+               terminate = !replace_broker();
+         }
+      }
+      else if (role == Broker_Role_Broker) {
+         g_mutex_lock(&broker_mutex);
+         if (fds[1].revents)
+            accept_subscriber();
+         // subscribers never send, so readability means the connection was closed
+         for (guint pndx = 2; pndx < pollfds->len; pndx++) {
+            if (fds[pndx].revents) {
+               for (guint ndx = 0; ndx < subscriber_fds->len; ndx++) {
+                  if (g_array_index(subscriber_fds, int, ndx) == fds[pndx].fd) {
+                     remove_subscriber(ndx);
+                     break;
+                  }
+               }
+            }
+         }
+         g_mutex_unlock(&broker_mutex);
+      }
+      else {
+         terminate = true;
+      }
+   }
+   g_array_free(pollfds, true);
+
+   DBGTRC_DONE(debug, TRACE_GROUP, "");
+   return NULL;
+}
+
+
+/** Establishes this process as either the broker or a subscriber,
+ *  and starts the broker thread.
+ *
+ *  @param  event_classes  event classes requested by this process
+ *  @return role, #Broker_Role_None if neither could be established,
+ *          in which case the caller watches independently
+ */
+Broker_Role dw_broker_start(DDCA_Display_Event_Class event_classes) {
+   bool debug = false;
+   DBGTRC_STARTING(debug, TRACE_GROUP, "event_classes=0x%02x", event_classes);
+
+   g_mutex_lock(&broker_mutex);
+   assert(!broker_thread);
+   Broker_Role role = Broker_Role_None;
+   broker_event_classes = event_classes;
+   broker_stop_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+   if (broker_stop_fd < 0) {
+      SYSLOG2(DDCA_SYSLOG_ERROR, "eventfd() failed. errno=%s", linux_errno_desc(errno));
+   }
+   else {
+      role = establish_role();
+      if (role == Broker_Role_None) {
+         close(broker_stop_fd);
+         broker_stop_fd = -1;
+      }
+      else {
+         broker_thread = g_thread_new("watch_broker", dw_broker_thread_func, NULL);
+      }
+   }
+   g_mutex_unlock(&broker_mutex);
+
+   MSG_W_SYSLOG(DDCA_SYSLOG_NOTICE, "Watch broker role: %s", broker_role_name(role));
+   DBGTRC_DONE(debug, TRACE_GROUP, "Returning %s", broker_role_name(role));
+   return role;
+}
+
+
+/** Stops the broker thread and closes all broker connections.
+ *  Must not be called with the watch thread mutex held, since the broker
+ *  thread may be taking over watching.
+ */
+void dw_broker_stop() {
+   bool debug = false;
+   DBGTRC_STARTING(debug, TRACE_GROUP, "broker_thread=%p", broker_thread);
+
+   g_mutex_lock(&broker_mutex);
+   GThread * thread = broker_thread;
+   broker_thread = NULL;
+   if (thread) {
+      uint64_t one = 1;
+      if (write(broker_stop_fd, &one, sizeof(one)) != sizeof(one))
+         SYSLOG2(DDCA_SYSLOG_ERROR, "write() to broker stop eventfd failed. errno=%s",
+                                    linux_errno_desc(errno));
+   }
+   g_mutex_unlock(&broker_mutex);
+
+   if (thread)
+      g_thread_join(thread);
+
+   g_mutex_lock(&broker_mutex);
+   for (guint ndx = 0; ndx < subscriber_fds->len; ndx++)
+      close(g_array_index(subscriber_fds, int, ndx));
+   g_array_set_size(subscriber_fds, 0);
+   if (listen_fd >= 0)
+      close(listen_fd);
+   if (broker_conn_fd >= 0)
+      close(broker_conn_fd);
+   if (broker_stop_fd >= 0)
+      close(broker_stop_fd);
+   listen_fd = broker_conn_fd = broker_stop_fd = -1;
+   broker_role = Broker_Role_None;
+   g_mutex_unlock(&broker_mutex);
+
+   DBGTRC_DONE(debug, TRACE_GROUP, "");
+}
+
+
+void init_dw_broker() {
+   g_mutex_lock(&broker_mutex);
+   if (!subscriber_fds)
+      subscriber_fds = g_array_new(false, false, sizeof(int));
+   g_mutex_unlock(&broker_mutex);
+
+   RTTI_ADD_FUNC(dw_broker_start);
+   RTTI_ADD_FUNC(dw_broker_stop);
+   RTTI_ADD_FUNC(dw_broker_publish);
+   RTTI_ADD_FUNC(dw_broker_thread_func);
+   RTTI_ADD_FUNC(process_broker_event);
+   RTTI_ADD_FUNC(replace_broker);
+   RTTI_ADD_FUNC(receive_broker_hello);
+}
@@ -0,0 +1,33 @@
+/** @file dw_broker.h
+ *
+ *  Share display change detection among libddcutil processes
+ */
+
+// Copyright (C) 2025 Sanford Rockowitz <rockowitz@minsoft.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef DW_BROKER_H_
+#define DW_BROKER_H_
+
+/** \cond */
+#include <stdbool.h>
+
+#include "public/ddcutil_types.h"
+/** \endcond */
+
+typedef enum {
+   Broker_Role_None,          ///< broker mode not active
+   Broker_Role_Broker,        ///< this process watches and publishes events
+   Broker_Role_Subscriber     ///< this process receives events from the broker
+} Broker_Role;
+
+extern bool watch_broker_enabled;
+
+const char * broker_role_name(Broker_Role role);
+Broker_Role  dw_broker_start(DDCA_Display_Event_Class event_classes);
+void         dw_broker_stop();
+Broker_Role  dw_broker_role();
+void         dw_broker_publish(DDCA_Display_Status_Event evt);
+void         init_dw_broker();
+
+#endif /* DW_BROKER_H_ */
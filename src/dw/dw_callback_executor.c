@@ -0,0 +1,286 @@
+/** @file dw_callback_executor.c
+ *
+ *  Fixed-size pool of threads that invokes display status callbacks.
+ *
+ *  Each registered callback function is a separate client.  Events for a
+ *  client are queued in order, and a client is executed by at most one pool
+ *  thread at a time, so each client sees its events in the order they were
+ *  emitted.  Different clients are serviced concurrently.
+ *
+ *  The total number of queued events is bounded.  If the bound is reached,
+ *  the oldest event queued for the client is discarded.  An event that
+ *  cancels a still-queued event for the same display, e.g. a disconnect
+ *  following a connect, removes the queued event and is itself discarded.
+ */
+
+// Copyright (C) 2025 Sanford Rockowitz <rockowitz@minsoft.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/** \cond */
+#include <assert.h>
+#include <glib-2.0/glib.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+/** \endcond */
+
+#include "util/report_util.h"
+#include "util/timestamp.h"
+
+#include "base/core.h"
+#include "base/parms.h"
+#include "base/rtti.h"
+
+#include "dw_status_events.h"
+
+#include "dw_callback_executor.h"
+
+
+// Trace class for this file
+static DDCA_Trace_Group TRACE_GROUP = DDCA_TRC_CONN;
+
+int callback_executor_threads    = DEFAULT_CALLBACK_EXECUTOR_THREADS;
+int callback_executor_max_queued = DEFAULT_CALLBACK_EXECUTOR_MAX_QUEUED;
+
+/** Queued events for one callback function */
+typedef struct {
+   DDCA_Display_Status_Callback_Func func;
+   GQueue *    pending;    // of Callback_Queue_Entry *
+   bool        scheduled;  // on the ready queue or being executed
+} Callback_Client;
+
+static GMutex       executor_mutex;
+static GCond        executor_cond;
+static GHashTable * executor_clients = NULL;   // key: func, value: Callback_Client*
+static GQueue       executor_ready = G_QUEUE_INIT;   // Callback_Client* with pending events
+static GThread **   executor_threads = NULL;
+static int          executor_thread_ct = 0;
+static bool         executor_shutdown = false;
+static int          executor_queued_ct = 0;
+
+// Statistics, protected by executor_mutex
+static int          stats_submitted;
+static int          stats_dispatched;
+static int          stats_coalesced;
+static int          stats_dropped;
+static int          stats_max_queued;
+static uint64_t     stats_total_latency_nanos;
+static uint64_t     stats_max_latency_nanos;
+
+
+static void
+free_callback_client(gpointer data) {
+   Callback_Client * client = data;
+   g_queue_free_full(client->pending, free);
+   free(client);
+}
+
+
+/** Tests whether one event reverses another for the same display,
+ *  so that a client need see neither.
+ */
+static bool
+is_cancelling_event(DDCA_Display_Event_Type queued, DDCA_Display_Event_Type latest) {
+   return (queued == DDCA_EVENT_DISPLAY_CONNECTED && latest == DDCA_EVENT_DISPLAY_DISCONNECTED) ||
+          (queued == DDCA_EVENT_DPMS_ASLEEP       && latest == DDCA_EVENT_DPMS_AWAKE)          ||
+          (queued == DDCA_EVENT_DPMS_AWAKE        && latest == DDCA_EVENT_DPMS_ASLEEP);
+}
+
+
+/** Removes the most recent queued event for the same display as
+ *  #evt, if #evt cancels it.  Called with executor_mutex held.
+ *
+ *  @return true if a queued event was removed
+ */
+static bool
+coalesce_event(Callback_Client * client, DDCA_Display_Status_Event evt) {
+   if (!evt.dref)
+      return false;
+   for (GList * link = client->pending->tail; link; link = link->prev) {
+      Callback_Queue_Entry * cqe = link->data;
+      if (cqe->event.dref == evt.dref) {
+         if (!is_cancelling_event(cqe->event.event_type, evt.event_type))
+            return false;
+         free(cqe);
+         g_queue_delete_link(client->pending, link);
+         return true;
+      }
+   }
+   return false;
+}
+
+
+/** Function executed by each executor thread */
+static gpointer
+callback_executor_func(gpointer data) {
+   bool debug = false;
+   DBGTRC_STARTING(debug, TRACE_GROUP, "");
+
+   g_mutex_lock(&executor_mutex);
+   while (true) {
+      while (!executor_shutdown && g_queue_is_empty(&executor_ready))
+         g_cond_wait(&executor_cond, &executor_mutex);
+      if (executor_shutdown)
+         break;
+
+      Callback_Client * client = g_queue_pop_head(&executor_ready);
+      Callback_Queue_Entry * cqe = g_queue_pop_head(client->pending);
+      if (!cqe) {      // all of the client's queued events were coalesced away
+         client->scheduled = false;
+         continue;
+      }
+      executor_queued_ct--;
+      uint64_t latency = cur_monotonic_nanosec() - cqe->queued_nanos;
+      stats_total_latency_nanos += latency;
+      stats_max_latency_nanos = MAX(stats_max_latency_nanos, latency);
+      stats_dispatched++;
+      g_mutex_unlock(&executor_mutex);
+
+      dw_execute_callback_func(cqe);     // frees cqe
+
+      g_mutex_lock(&executor_mutex);
+      // only now may another thread take this client's next event
+      if (g_queue_is_empty(client->pending))
+         client->scheduled = false;
+      else
+         g_queue_push_tail(&executor_ready, client);
+   }
+   g_mutex_unlock(&executor_mutex);
+
+   DBGTRC_DONE(debug, TRACE_GROUP, "");
+   return NULL;
+}
+
+
+/** Queues a display status event for delivery to a callback function.
+ *
+ *  @param  func  callback function
+ *  @param  evt   event
+ */
+void
+dw_submit_display_status_callback(
+      DDCA_Display_Status_Callback_Func func,
+      DDCA_Display_Status_Event         evt)
+{
+   bool debug = false;
+   DBGTRC_STARTING(debug, TRACE_GROUP, "func=%p, evt=%s", func, display_status_event_repr_t(evt));
+
+   g_mutex_lock(&executor_mutex);
+   if (executor_shutdown) {
+      g_mutex_unlock(&executor_mutex);
+      DBGTRC_DONE(debug, TRACE_GROUP, "Executor terminated, event discarded");
+      return;
+   }
+   if (!executor_threads) {
+      executor_thread_ct = MAX(1, callback_executor_threads);
+      executor_threads = calloc(executor_thread_ct, sizeof(GThread*));
+      for (int ndx = 0; ndx < executor_thread_ct; ndx++)
+         executor_threads[ndx] = g_thread_new("display_status_callbacks", callback_executor_func, NULL);
+   }
+   stats_submitted++;
+
+   Callback_Client * client = g_hash_table_lookup(executor_clients, func);
+   if (!client) {
+      client = calloc(1, sizeof(Callback_Client));
+      client->func = func;
+      client->pending = g_queue_new();
+      g_hash_table_insert(executor_clients, func, client);
+   }
+
+   if (coalesce_event(client, evt)) {
+      executor_queued_ct--;
+      stats_coalesced += 2;
+      g_mutex_unlock(&executor_mutex);
+      DBGTRC_DONE(debug, TRACE_GROUP, "Event cancelled a queued event");
+      return;
+   }
+
+   if (executor_queued_ct >= callback_executor_max_queued && !g_queue_is_empty(client->pending)) {
+      Callback_Queue_Entry * oldest = g_queue_pop_head(client->pending);
+      SYSLOG2(DDCA_SYSLOG_WARNING, "Callback queue full, discarding %s",
+            display_status_event_repr_t(oldest->event));
+      free(oldest);
+      executor_queued_ct--;
+      stats_dropped++;
+   }
+
+   Callback_Queue_Entry * cqe = calloc(1, sizeof(Callback_Queue_Entry));
+   cqe->func = func;
+   cqe->event = evt;
+   cqe->queued_nanos = cur_monotonic_nanosec();
+   g_queue_push_tail(client->pending, cqe);
+   executor_queued_ct++;
+   stats_max_queued = MAX(stats_max_queued, executor_queued_ct);
+
+   if (!client->scheduled) {
+      client->scheduled = true;
+      g_queue_push_tail(&executor_ready, client);
+      g_cond_signal(&executor_cond);
+   }
+   int queued_ct = executor_queued_ct;
+   g_mutex_unlock(&executor_mutex);
+
+   DBGTRC_DONE(debug, TRACE_GROUP, "queue depth: %d", queued_ct);
+}
+
+
+void dw_report_callback_executor_stats(int depth) {
+   int d1 = depth+1;
+   g_mutex_lock(&executor_mutex);
+   rpt_label(depth, "Display status callback executor:");
+   rpt_vstring(d1, "Threads:                      %d", callback_executor_threads);
+   rpt_vstring(d1, "Events submitted:             %d", stats_submitted);
+   rpt_vstring(d1, "Events dispatched:            %d", stats_dispatched);
+   rpt_vstring(d1, "Events coalesced:             %d", stats_coalesced);
+   rpt_vstring(d1, "Events dropped (queue full):  %d", stats_dropped);
+   rpt_vstring(d1, "Current queue depth:          %d", executor_queued_ct);
+   rpt_vstring(d1, "Maximum queue depth:          %d", stats_max_queued);
+   if (stats_dispatched > 0) {
+      rpt_vstring(d1, "Average dispatch latency:     %.3f ms",
+            (stats_total_latency_nanos / (double) stats_dispatched) / 1000000.0);
+      rpt_vstring(d1, "Maximum dispatch latency:     %.3f ms",
+            stats_max_latency_nanos / 1000000.0);
+   }
+   g_mutex_unlock(&executor_mutex);
+}
+
+
+void init_dw_callback_executor() {
+   g_mutex_lock(&executor_mutex);
+   if (!executor_clients)
+      executor_clients = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, free_callback_client);
+   executor_shutdown = false;
+   g_mutex_unlock(&executor_mutex);
+
+   RTTI_ADD_FUNC(callback_executor_func);
+   RTTI_ADD_FUNC(dw_submit_display_status_callback);
+}
+
+
+/** Stops the executor threads.  Events not yet delivered are discarded. */
+void terminate_dw_callback_executor() {
+   bool debug = false;
+   DBGTRC_STARTING(debug, TRACE_GROUP, "executor_thread_ct=%d", executor_thread_ct);
+
+   g_mutex_lock(&executor_mutex);
+   executor_shutdown = true;
+   g_cond_broadcast(&executor_cond);
+   g_mutex_unlock(&executor_mutex);
+
+   for (int ndx = 0; ndx < executor_thread_ct; ndx++)
+      g_thread_join(executor_threads[ndx]);
+
+   g_mutex_lock(&executor_mutex);
+   free(executor_threads);
+   executor_threads = NULL;
+   executor_thread_ct = 0;
+   g_queue_clear(&executor_ready);
+   if (executor_clients) {
+      g_hash_table_destroy(executor_clients);
+      executor_clients = NULL;
+   }
+   executor_queued_ct = 0;
+   g_mutex_unlock(&executor_mutex);
+
+   DBGTRC_DONE(debug, TRACE_GROUP, "");
+}
@@ -0,0 +1,29 @@
+/** @file dw_callback_executor.h
+ *
+ *  Fixed-size pool of threads that invokes display status callbacks
+ */
+
+// Copyright (C) 2025 Sanford Rockowitz <rockowitz@minsoft.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef DW_CALLBACK_EXECUTOR_H_
+#define DW_CALLBACK_EXECUTOR_H_
+
+/** \cond */
+#include <glib-2.0/glib.h>
+#include <stdbool.h>
+
+#include "public/ddcutil_types.h"
+/** \endcond */
+
+extern int callback_executor_threads;
+extern int callback_executor_max_queued;
+
+void dw_submit_display_status_callback(
+        DDCA_Display_Status_Callback_Func func,
+        DDCA_Display_Status_Event         evt);
+void dw_report_callback_executor_stats(int depth);
+void init_dw_callback_executor();
+void terminate_dw_callback_executor();
+
+#endif /* DW_CALLBACK_EXECUTOR_H_ */
@@ -14,10 +14,15 @@
 #ifdef ENABLE_UDEV
 #include <libudev.h>
 #endif
+#include <limits.h>
 #include <stdbool.h>
 #include <stdlib.h>
+#include <poll.h>
 #include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/stat.h>
+#include <sys/timerfd.h>
 #include <unistd.h>
 
 #include "util/common_inlines.h"
@@ -34,6 +39,7 @@
 #include "util/report_util.h"
 #include "util/string_util.h"
 #include "util/sysfs_util.h"
+#include "util/timestamp.h"
 #include "util/traced_function_stack.h"
 #include "util/udev_util.h"
 
@@ -45,6 +51,7 @@
 #include "base/linux_errno.h"
 #include "base/rtti.h"
 #include "base/sleep.h"
+#include "base/worker_pool.h"
 /** \endcond */
 
 #include "sysfs/sysfs_base.h"
@@ -87,6 +94,8 @@ uint32_t dw_calc_watch_loop_millisec(DDC_Watch_Mode watch_mode) {
    case Watch_Mode_Udev:   final_answer = udev_watch_loop_millisec;   break;
    case Watch_Mode_Xevent: final_answer = xevent_watch_loop_millisec; break;
    case Watch_Mode_Poll:   final_answer = poll_watch_loop_millisec;   break;
+   // interval at which DPMS state is rechecked, connection changes are event driven
+   case Watch_Mode_Drm:    final_answer = udev_watch_loop_millisec;   break;
    case Watch_Mode_Dynamic:
         PROGRAM_LOGIC_ERROR("watch_mode == Watch_Mode_Dynamic");
    }
@@ -95,21 +104,128 @@ uint32_t dw_calc_watch_loop_millisec(DDC_Watch_Mode watch_mode) {
 }
 
 
-/** Performs a sleep in short segments so that it can be responsively terminated
- *  when dw_stop_watch_displays() is called. Each segment is no longer than
- *  200 milliseconds.
+//
+// Watch thread termination
+//
+
+static int    terminate_watch_fd = -1;      // eventfd, readable once termination requested
+static GMutex terminate_watch_fd_mutex;
+
+
+/** Returns the eventfd that becomes readable when watch thread termination
+ *  is requested, creating it if necessary.  Watch threads include it in
+ *  their poll or epoll sets, so that they can block indefinitely while
+ *  remaining responsive to #dw_request_terminate_watch().
+ *
+ *  @return file descriptor, -1 if it could not be created
+ */
+int dw_terminate_watch_fd() {
+   g_mutex_lock(&terminate_watch_fd_mutex);
+   if (terminate_watch_fd < 0) {
+      terminate_watch_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+      if (terminate_watch_fd < 0)
+         SYSLOG2(DDCA_SYSLOG_ERROR, "eventfd() failed. errno=%s", linux_errno_desc(errno));
+   }
+   int result = terminate_watch_fd;
+   g_mutex_unlock(&terminate_watch_fd_mutex);
+   return result;
+}
+
+
+/** Signals the watch threads to terminate. */
+void dw_request_terminate_watch() {
+   bool debug = false;
+   DBGTRC_STARTING(debug, TRACE_GROUP, "");
+
+   terminate_watch_thread = true;
+   int fd = dw_terminate_watch_fd();
+   if (fd >= 0) {
+      uint64_t one = 1;
+      if (write(fd, &one, sizeof(one)) != sizeof(one))
+         SYSLOG2(DDCA_SYSLOG_ERROR, "write() to termination eventfd failed. errno=%s",
+                                    linux_errno_desc(errno));
+   }
+
+   DBGTRC_DONE(debug, TRACE_GROUP, "");
+}
+
+
+/** Clears any prior termination request.  Called before the watch threads
+ *  are started.
+ */
+void dw_reset_terminate_watch() {
+   terminate_watch_thread = false;
+   int fd = dw_terminate_watch_fd();
+   if (fd >= 0) {
+      uint64_t ct;
+      while (read(fd, &ct, sizeof(ct)) > 0);   // fd is nonblocking
+   }
+}
+
+
+/** Adds a file descriptor to an epoll set, watching for input.
+ *
+ *  @param  epoll_fd  epoll instance
+ *  @param  fd        file descriptor to add
+ *  @return true if successful, false if not
+ */
+bool
+dw_epoll_add_input_fd(int epoll_fd, int fd) {
+   struct epoll_event ev = {.events = EPOLLIN, .data.fd = fd};
+   if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+      SYSLOG2(DDCA_SYSLOG_ERROR, "epoll_ctl() failed for fd %d. errno=%s", fd, linux_errno_desc(errno));
+      return false;
+   }
+   return true;
+}
+
+
+/** Arms a one-shot timerfd.
+ *
+ *  @param  timer_fd  timerfd
+ *  @param  millisec  milliseconds until expiration, 0 to disarm
+ */
+void
+dw_arm_timerfd(int timer_fd, int millisec) {
+   struct itimerspec spec = {
+         .it_interval = {0, 0},
+         .it_value    = {millisec / 1000, (millisec % 1000) * 1000000L}
+   };
+   timerfd_settime(timer_fd, 0, &spec, NULL);
+}
+
+
+/** Sleeps for the specified interval, returning early if
+ *  dw_stop_watch_displays() is called.
+ *
+ *  The sleep blocks on the termination eventfd, so unlike sleeping in
+ *  short segments it involves no intermediate wakeups.
  *
  *  @param  watch_loop_millisec  intended total milliseconds to sleep
  *  @return actual total milliseconds
  */
 uint32_t dw_split_sleep(int watch_loop_millisec) {
    assert(watch_loop_millisec > 0);
-   uint64_t max_sleep_microsec = watch_loop_millisec * (uint64_t)1000;
-   uint64_t sleep_step_microsec = MIN(200, max_sleep_microsec);     // .2 sec
-   uint64_t slept = 0;
-   for (; slept < max_sleep_microsec && !terminate_watch_thread; slept += sleep_step_microsec)
-      usleep(sleep_step_microsec);
-   return slept/1000;
+   uint64_t start_nanos = cur_realtime_nanosec();
+   int fd = dw_terminate_watch_fd();
+   if (fd < 0) {
+      // fall back to sleeping in segments of no more than 200 milliseconds
+      uint64_t max_sleep_microsec = watch_loop_millisec * (uint64_t)1000;
+      uint64_t sleep_step_microsec = MIN(200*1000, max_sleep_microsec);
+      for (uint64_t slept = 0; slept < max_sleep_microsec && !terminate_watch_thread; slept += sleep_step_microsec)
+         usleep(sleep_step_microsec);
+   }
+   else if (!terminate_watch_thread) {
+      struct pollfd pfd = {.fd = fd, .events = POLLIN};
+      int remaining_millisec = watch_loop_millisec;
+      while (remaining_millisec > 0) {
+         int rc = poll(&pfd, 1, remaining_millisec);
+         if (rc >= 0 || errno != EINTR)
+            break;
+         remaining_millisec = watch_loop_millisec - NANOS2MILLIS(cur_realtime_nanosec() - start_nanos);
+      }
+   }
+   return NANOS2MILLIS(cur_realtime_nanosec() - start_nanos);
 }
 
 
@@ -337,6 +453,17 @@ Bit_Set_256 ddc_i2c_check_bus_asleep(
 #endif
 
 
+/** Worker pool task that gets and checks the #I2C_Bus_Info for a bus.
+ *
+ *  @param  data  bus number, as a pointer
+ *  @return #I2C_Bus_Info for the bus
+ */
+STATIC void *
+threaded_get_and_check_bus_info(void * data) {
+   return i2c_get_and_check_bus_info(GPOINTER_TO_INT(data));
+}
+
+
 /** Updates persistent data structures for bus changes and
  *  either emits change events or queues them for later processing.
  *
@@ -405,14 +532,22 @@ bool dw_hotplug_change_handler(
    }
    bs256_iter_free(iter);
 
+   // Check the added buses in parallel, e.g. when a dock with several monitors is attached
+   Worker_Batch * batch = wp_new_batch("hotplug added buses");
    iter = bs256_iter_new(bs_buses_w_edid_added);
    while (true) {
       int busno = bs256_iter_next(iter);
       if (busno < 0)
          break;
+      wp_batch_add(batch, threaded_get_and_check_bus_info, GINT_TO_POINTER(busno));
+   }
+   bs256_iter_free(iter);
+   GPtrArray * added_businfos = wp_batch_wait(batch);
+
+   for (int ndx = 0; ndx < added_businfos->len; ndx++) {
+      I2C_Bus_Info * businfo = g_ptr_array_index(added_businfos, ndx);
+      int busno = businfo->busno;
       DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE, "Adding display ref for bus: %d", busno);
-       // need to protect ?
-      I2C_Bus_Info * businfo = i2c_get_and_check_bus_info(busno);
 
        char buf[100];
        g_snprintf(buf, 100, "Adding connected display with bus %d", busno);
@@ -437,7 +572,7 @@ bool dw_hotplug_change_handler(
           event_emitted = false;
       }
    }
-   bs256_iter_free(iter);
+   g_ptr_array_free(added_businfos, true);
 
    if (IS_DBGTRC(debug, DDCA_TRC_NONE)) {
       rpt_nl();
@@ -476,6 +611,7 @@ ddc_i2c_stabilized_buses(GPtrArray* prior, bool some_displays_disconnected) {
    // It has been observed that in some cases (Samsung U32H750) a disconnect is followed a
    // few seconds later by a connect. Wait a few seconds to avoid triggering events
    // in this case.
+   g_atomic_int_inc(&stabilization_ct);
    if (some_displays_disconnected) {
       if (initial_stabilization_millisec > 0) {
          char * s = g_strdup_printf(
@@ -511,6 +647,187 @@ ddc_i2c_stabilized_buses(GPtrArray* prior, bool some_displays_disconnected) {
 #endif
 
 
+//
+// Connector fingerprints
+//
+
+typedef struct {
+   bool     sysfs_checked;     // sysfs_usable and connector_name determined
+   bool     sysfs_usable;      // sysfs connector attributes reliably track the display
+   char *   connector_name;
+   bool     fingerprint_valid;
+   guint32  fingerprint;
+   bool     has_edid;          // result of the most recent full check
+} Bus_Fingerprint;
+
+static Bus_Fingerprint bus_fingerprints[256];
+static GMutex          bus_fingerprints_mutex;
+
+
+static guint32 fnv1a_update(guint32 hash, const Byte * bytes, int len) {
+   for (int ndx = 0; ndx < len; ndx++) {
+      hash ^= bytes[ndx];
+      hash *= 16777619u;
+   }
+   return hash;
+}
+
+
+/** Computes a fingerprint of the sysfs DRM connector attributes that change
+ *  when a display is connected or disconnected, i.e. the contents of the
+ *  status and edid attributes.  Reading these attributes involves no I2C
+ *  communication.  (Attribute modification times and sizes are not used,
+ *  since sysfs does not update them when the values change.)
+ *
+ *  @param  connector_name  e.g. card0-HDMI-A-1
+ *  @param  fingerprint_loc where to return fingerprint
+ *  @return true if the connector attributes could be read, false if not
+ */
+static bool
+connector_fingerprint(const char * connector_name, guint32 * fingerprint_loc) {
+   char path[PATH_MAX];
+   g_snprintf(path, sizeof(path), "%s/%s/status", sysfs_class_drm, connector_name);
+   GByteArray * status = read_binary_file(path, 100, true);
+   if (!status)
+      return false;
+   guint32 hash = fnv1a_update(2166136261u, status->data, status->len);
+   g_byte_array_free(status, true);
+
+   g_snprintf(path, sizeof(path), "%s/%s/edid", sysfs_class_drm, connector_name);
+   GByteArray * edid = read_binary_file(path, 2048, true);
+   if (edid) {
+      hash = fnv1a_update(hash, edid->data, edid->len);
+      g_byte_array_free(edid, true);
+   }
+   *fingerprint_loc = hash;
+   return true;
+}
+
+
+/** Determines which of the specified buses have an EDID, performing a full
+ *  check (#i2c_edid_exists(), which may read the EDID over I2C) only for
+ *  buses whose sysfs connector fingerprint has changed since the previous
+ *  call, or that cannot be fingerprinted.
+ *
+ *  A bus can be fingerprinted if it has a DRM connector and its driver
+ *  reliably maintains sysfs connector attributes.
+ *
+ *  @param  bs_attached_buses  buses to check
+ *  @return buses having an EDID
+ */
+Bit_Set_256
+dw_buses_w_edid_by_fingerprint(Bit_Set_256 bs_attached_buses) {
+   bool debug = false;
+   DBGTRC_STARTING(debug, TRACE_GROUP, "bs_attached_buses: %s", BS256_REPR(bs_attached_buses));
+
+   Bit_Set_256 bs_buses_w_edid = EMPTY_BIT_SET_256;
+   int full_check_ct = 0;
+
+   g_mutex_lock(&bus_fingerprints_mutex);
+   for (int busno = 0; busno < 256; busno++) {
+      Bus_Fingerprint * bf = &bus_fingerprints[busno];
+      if (!bs256_contains(bs_attached_buses, busno)) {
+         // bus removed, or never present
+         if (bf->sysfs_checked) {
+            free(bf->connector_name);
+            memset(bf, 0, sizeof(Bus_Fingerprint));
+         }
+         continue;
+      }
+
+      if (!bf->sysfs_checked) {
+         bf->sysfs_checked = true;
+         bf->sysfs_usable = is_sysfs_reliable_for_busno(busno);
+         if (bf->sysfs_usable) {
+            I2C_Bus_Info * businfo = (all_i2c_buses)
+                  ? i2c_find_bus_info_in_gptrarray_by_busno(all_i2c_buses, busno)
+                  : NULL;
+            bf->connector_name = (businfo && businfo->drm_connector_name)
+                  ? g_strdup(businfo->drm_connector_name)
+                  : get_sys_drm_connector_name_by_busno(busno);
+         }
+      }
+
+      bool unchanged = false;
+      if (bf->sysfs_usable && bf->connector_name) {
+         guint32 fingerprint;
+         if (connector_fingerprint(bf->connector_name, &fingerprint)) {
+            unchanged = bf->fingerprint_valid && fingerprint == bf->fingerprint;
+            bf->fingerprint = fingerprint;
+            bf->fingerprint_valid = true;
+         }
+         else {
+            bf->fingerprint_valid = false;
+         }
+      }
+
+      if (!unchanged) {
+         bf->has_edid = i2c_edid_exists(busno);
+         full_check_ct++;
+      }
+      if (bf->has_edid)
+         bs_buses_w_edid = bs256_insert(bs_buses_w_edid, busno);
+   }
+   g_mutex_unlock(&bus_fingerprints_mutex);
+
+   DBGTRC_DONE(debug, TRACE_GROUP, "full checks: %d, returning: %s",
+         full_check_ct, BS256_REPR(bs_buses_w_edid));
+   return bs_buses_w_edid;
+}
+
+
+/** Forgets all connector fingerprints, so that the next call to
+ *  #dw_buses_w_edid_by_fingerprint() performs a full check of every bus.
+ */
+void dw_reset_bus_fingerprints() {
+   g_mutex_lock(&bus_fingerprints_mutex);
+   for (int busno = 0; busno < 256; busno++) {
+      free(bus_fingerprints[busno].connector_name);
+      memset(&bus_fingerprints[busno], 0, sizeof(Bus_Fingerprint));
+   }
+   g_mutex_unlock(&bus_fingerprints_mutex);
+}
+
+
+//
+// Watch loop statistics
+//
+
+// Used to compare watch modes, and the effect of stabilization settings,
+// e.g. when connector changes are simulated using DDCUTIL_SYSFS_ROOT.
+static gint watch_wakeup_cts[Watch_Mode_Drm+1];
+static gint stabilization_ct;
+static gint stabilization_poll_ct;
+
+
+/** Counts a wakeup of a display watch thread, i.e. a return from sleep,
+ *  X11 event wait, or epoll_wait(), whether or not it finds a change.
+ *
+ *  @param  watch_mode  mode of the watch thread
+ */
+void dw_count_watch_wakeup(DDC_Watch_Mode watch_mode) {
+   assert(watch_mode >= 0 && watch_mode <= Watch_Mode_Drm);
+   g_atomic_int_inc(&watch_wakeup_cts[watch_mode]);
+}
+
+
+/** Reports display watch thread wakeups and stabilization checks.
+ *
+ *  @param  depth  logical indentation depth
+ */
+void dw_report_watch_stats(int depth) {
+   int d1 = depth+1;
+   rpt_label(depth, "Display watch statistics:");
+   for (DDC_Watch_Mode mode = Watch_Mode_Poll; mode <= Watch_Mode_Drm; mode++) {
+      int ct = g_atomic_int_get(&watch_wakeup_cts[mode]);
+      if (ct > 0)
+         rpt_vstring(d1, "Watch thread wakeups, mode %-7s  %d", watch_mode_name(mode), ct);
+   }
+   rpt_vstring(d1, "Stabilization checks:              %d", g_atomic_int_get(&stabilization_ct));
+   rpt_vstring(d1, "Stabilization polls:               %d", g_atomic_int_get(&stabilization_poll_ct));
+}
+
+
 Bit_Set_256
 dw_stabilized_buses_bs(Bit_Set_256 bs_prior, bool some_displays_disconnected) {
    bool debug = false;
@@ -522,6 +839,7 @@ dw_stabilized_buses_bs(Bit_Set_256 bs_prior, bool some_displays_disconnected) {
    // It has been observed that in some cases (Samsung U32H750) a disconnect is followed a
    // few seconds later by a connect. Wait a few seconds to avoid triggering events
    // in this case.
+   g_atomic_int_inc(&stabilization_ct);
    if (some_displays_disconnected) {
       if (initial_stabilization_millisec > 0) {
          char * s = g_strdup_printf(
@@ -539,7 +857,8 @@ dw_stabilized_buses_bs(Bit_Set_256 bs_prior, bool some_displays_disconnected) {
    while (!stable) {
       // DW_SLEEP_MILLIS(stabilization_poll_millisec, "Loop until stable"); // TMI
       SLEEP_MILLIS_WITH_STATS(stabilization_poll_millisec);
-      BS256 bs_latest = i2c_buses_w_edid_as_bitset();
+      g_atomic_int_inc(&stabilization_poll_ct);
+      BS256 bs_latest = dw_buses_w_edid_by_fingerprint(i2c_detect_attached_buses_as_bitset());
       if (bs256_eq(bs_latest, bs_prior))
             stable = true;
       bs_prior = bs_latest;
@@ -548,7 +867,7 @@ dw_stabilized_buses_bs(Bit_Set_256 bs_prior, bool some_displays_disconnected) {
    if (stablect > 1) {
       char buf[100];
       g_snprintf(buf, 100,
-            "Required %d extra %d millisecond calls to i2c_buses_w_edid_as_bitset()",
+            "Required %d extra %d millisecond calls to dw_buses_w_edid_by_fingerprint()",
             stablect+1, stabilization_poll_millisec);
       DBGTRC_NOPREFIX(debug, TRACE_GROUP, "%s", buf);
       SYSLOG2(DDCA_SYSLOG_NOTICE, "%s", buf);
@@ -601,10 +920,24 @@ void init_dw_common() {
 #ifdef WATCH_ASLEEP
    RTTI_ADD_FUNC(ddc_i2c_check_bus_asleep);
 #endif
+   RTTI_ADD_FUNC(dw_buses_w_edid_by_fingerprint);
    RTTI_ADD_FUNC(dw_stabilized_buses_bs);
    RTTI_ADD_FUNC(dw_emit_deferred_events);
    RTTI_ADD_FUNC(dw_hotplug_change_handler);
    RTTI_ADD_FUNC(record_active_callback_thread);
    RTTI_ADD_FUNC(remove_active_callback_thread);
    RTTI_ADD_FUNC(active_callback_thread_ct);
+   RTTI_ADD_FUNC(dw_request_terminate_watch);
+   RTTI_ADD_FUNC(dw_report_watch_stats);
+}
+
+
+void terminate_dw_common() {
+   dw_reset_bus_fingerprints();
+   g_mutex_lock(&terminate_watch_fd_mutex);
+   if (terminate_watch_fd >= 0) {
+      close(terminate_watch_fd);
+      terminate_watch_fd = -1;
+   }
+   g_mutex_unlock(&terminate_watch_fd_mutex);
 }
@@ -27,6 +27,11 @@ extern bool       terminate_watch_thread;
 extern bool       terminate_using_x11_event;
 
 uint32_t  dw_calc_watch_loop_millisec(DDC_Watch_Mode watch_mode);
+int       dw_terminate_watch_fd();
+void      dw_request_terminate_watch();
+void      dw_reset_terminate_watch();
+bool      dw_epoll_add_input_fd(int epoll_fd, int fd);
+void      dw_arm_timerfd(int timer_fd, int millisec);
 uint32_t  dw_split_sleep(int watch_loop_millisec);
 void      dw_terminate_if_invalid_thread_or_process(pid_t cur_pid, pid_t cur_tid);
 
@@ -81,6 +86,13 @@ typedef struct {
 bool bs256_pair_eq(Bit_Set_256_Pair pair1, Bit_Set_256_Pair pair2);
 #endif
 
+Bit_Set_256
+dw_buses_w_edid_by_fingerprint(Bit_Set_256 bs_attached_buses);
+void dw_reset_bus_fingerprints();
+
+void dw_count_watch_wakeup(DDC_Watch_Mode watch_mode);
+void dw_report_watch_stats(int depth);
+
 Bit_Set_256
 dw_stabilized_buses_bs(Bit_Set_256 bs_prior, bool some_displays_disconnected);
 
@@ -104,5 +116,6 @@ void remove_active_callback_thread(GThread* thread);
 int  active_callback_thread_ct();
 
 void init_dw_common();
+void terminate_dw_common();
 
 #endif /* DW_COMMON_H_ */
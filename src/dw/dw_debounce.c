@@ -0,0 +1,325 @@
+/** @file dw_debounce.c
+ *
+ *  Per-connector debouncing of display connection changes reported by udev.
+ *
+ *  When udev reports a DRM change for a connector, only that connector's
+ *  sysfs edid attribute is examined.  The observation starts (or restarts)
+ *  a quiet period for the connector.  Once no further change has been
+ *  observed for the duration of the quiet period, the edid attribute is
+ *  read one final time to confirm it, and if the connector's state differs
+ *  from the state last reported, a display connection event is emitted.
+ *
+ *  The quiet period is #stabilization_poll_millisec.  When the change
+ *  would be reported as a disconnection, it is at least
+ *  #initial_stabilization_millisec, since some monitors (e.g. Samsung
+ *  U32H750) follow a disconnect a few seconds later with a connect.
+ *
+ *  No thread sleeps.  The caller asks for the time until the next quiet
+ *  period expires, typically to arm a timerfd, and calls
+ *  #dw_debouncer_process_expired() when it does.
+ *
+ *  Events that cannot be attributed to a connector are debounced the same
+ *  way, using the set of all buses having an EDID as the observation.
+ */
+
+// Copyright (C) 2025 Sanford Rockowitz <rockowitz@minsoft.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "config.h"
+
+/** \cond */
+#include <assert.h>
+#include <glib-2.0/glib.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "util/data_structures.h"
+#include "util/file_util.h"
+#include "util/report_util.h"
+#include "util/string_util.h"
+#include "util/timestamp.h"
+/** \endcond */
+
+#include "base/core.h"
+#include "base/displays.h"
+#include "base/rtti.h"
+
+#include "sysfs/sysfs_base.h"
+
+#include "i2c/i2c_bus_core.h"
+
+#include "dw_common.h"
+#include "dw_recheck.h"
+
+#include "dw_debounce.h"
+
+// Trace class for this file
+static DDCA_Trace_Group TRACE_GROUP = DDCA_TRC_CONN;
+
+typedef struct {
+   char *      connector_name;
+   int         busno;
+   bool        observed_has_edid;    // most recent observation
+   uint64_t    deadline_nanos;       // end of quiet period, monotonic clock
+   int         observation_ct;
+} Connector_Debounce_Entry;
+
+
+#define DW_DEBOUNCER_MARKER "DWDB"
+struct Dw_Debouncer {
+   char        marker[4];
+   GPtrArray * entries;                // array of Connector_Debounce_Entry *
+   GArray *    events_queue;           // if non-NULL, events are queued rather than emitted
+   bool        rescan_pending;
+   Bit_Set_256 rescan_observed;
+   uint64_t    rescan_deadline_nanos;
+};
+
+
+static void free_connector_debounce_entry(void * data) {
+   Connector_Debounce_Entry * entry = data;
+   free(entry->connector_name);
+   free(entry);
+}
+
+
+/** Creates a new #Dw_Debouncer.
+ *
+ *  @param  events_queue  if non-NULL, events are placed on this queue
+ *                        rather than being emitted directly
+ *  @return newly allocated #Dw_Debouncer
+ */
+Dw_Debouncer * dw_new_debouncer(GArray * events_queue) {
+   Dw_Debouncer * deb = calloc(1, sizeof(Dw_Debouncer));
+   memcpy(deb->marker, DW_DEBOUNCER_MARKER, 4);
+   deb->entries = g_ptr_array_new_with_free_func(free_connector_debounce_entry);
+   deb->events_queue = events_queue;
+   return deb;
+}
+
+
+void dw_free_debouncer(Dw_Debouncer * deb) {
+   if (deb) {
+      assert(memcmp(deb->marker, DW_DEBOUNCER_MARKER, 4) == 0);
+      g_ptr_array_free(deb->entries, true);
+      deb->marker[3] = 'x';
+      free(deb);
+   }
+}
+
+
+/** Calculates the quiet period that must elapse before a change is reported.
+ *
+ *  @param  disconnecting  true if the change would be reported as a disconnection
+ *  @return quiet period in nanoseconds
+ */
+static uint64_t quiet_period_nanos(bool disconnecting) {
+   int millis = stabilization_poll_millisec;
+   if (disconnecting)
+      millis = MAX(millis, initial_stabilization_millisec);
+   return MILLIS2NANOS(millis);
+}
+
+
+/** Reads a connector's sysfs edid attribute.
+ *
+ *  @param  connector_name  e.g. card0-DP-1
+ *  @return true if the attribute has a value, false if not
+ */
+static bool connector_has_edid(const char * connector_name) {
+   char * s = g_strdup_printf("%s/%s/edid", sysfs_class_drm, connector_name);
+   GByteArray* bytes = read_binary_file(s, 2048, true);
+   bool has_edid = (bytes && bytes->len > 0);
+   if (bytes)
+      g_byte_array_free(bytes, true);
+   free(s);
+   return has_edid;
+}
+
+
+static Connector_Debounce_Entry *
+find_entry(Dw_Debouncer * deb, const char * connector_name) {
+   for (int ndx = 0; ndx < deb->entries->len; ndx++) {
+      Connector_Debounce_Entry * entry = g_ptr_array_index(deb->entries, ndx);
+      if (streq(entry->connector_name, connector_name))
+         return entry;
+   }
+   return NULL;
+}
+
+
+/** Records a udev change event for a DRM connector.
+ *
+ *  The connector's edid attribute is read and its quiet period is restarted.
+ *  Connectors without an associated I2C bus, e.g. MST hub connectors
+ *  without an attached monitor, are ignored.
+ *
+ *  @param  deb              debouncer
+ *  @param  connector_name   name of sysfs DRM connector
+ *  @param  bs_buses_w_edid  buses currently reported as having an EDID
+ */
+void dw_debounce_connector_event(
+      Dw_Debouncer * deb,
+      char *         connector_name,
+      Bit_Set_256    bs_buses_w_edid)
+{
+   bool debug = false;
+   assert(deb && memcmp(deb->marker, DW_DEBOUNCER_MARKER, 4) == 0);
+   DBGTRC_STARTING(debug, TRACE_GROUP, "connector_name=%s", connector_name);
+
+   int busno = search_all_businfo_records_by_connector_name(connector_name);
+   // busno -1 possible for added hub devices, only the one w attached monitor will have busno
+   if (busno >= 0) {
+      bool has_edid = connector_has_edid(connector_name);
+      Connector_Debounce_Entry * entry = find_entry(deb, connector_name);
+      if (!entry) {
+         entry = calloc(1, sizeof(Connector_Debounce_Entry));
+         entry->connector_name = g_strdup(connector_name);
+         entry->busno = busno;
+         g_ptr_array_add(deb->entries, entry);
+      }
+      entry->observed_has_edid = has_edid;
+      entry->observation_ct++;
+      bool disconnecting = !has_edid && bs256_contains(bs_buses_w_edid, busno);
+      entry->deadline_nanos = cur_monotonic_nanosec() + quiet_period_nanos(disconnecting);
+      DBGTRC_NOPREFIX(debug, TRACE_GROUP,
+            "busno=%d, has_edid=%s, observation_ct=%d, disconnecting=%s",
+            busno, SBOOL(has_edid), entry->observation_ct, SBOOL(disconnecting));
+   }
+
+   DBGTRC_DONE(debug, TRACE_GROUP, "busno=%d", busno);
+}
+
+
+/** Records a udev change event that cannot be attributed to a connector.
+ *  The set of all buses having an EDID is examined, and its quiet period
+ *  is restarted.
+ *
+ *  @param  deb              debouncer
+ *  @param  bs_buses_w_edid  buses currently reported as having an EDID
+ */
+void dw_debounce_rescan_event(
+      Dw_Debouncer * deb,
+      Bit_Set_256    bs_buses_w_edid)
+{
+   bool debug = false;
+   assert(deb && memcmp(deb->marker, DW_DEBOUNCER_MARKER, 4) == 0);
+   DBGTRC_STARTING(debug, TRACE_GROUP, "");
+
+   deb->rescan_observed = i2c_buses_w_edid_as_bitset();
+   bool disconnecting = bs256_count(bs256_and_not(bs_buses_w_edid, deb->rescan_observed)) > 0;
+   deb->rescan_deadline_nanos = cur_monotonic_nanosec() + quiet_period_nanos(disconnecting);
+   deb->rescan_pending = true;
+
+   DBGTRC_DONE(debug, TRACE_GROUP, "rescan_observed: %s", BS256_REPR(deb->rescan_observed));
+}
+
+
+/** Returns the time until the earliest quiet period expires.
+ *
+ *  @param  deb  debouncer
+ *  @return milliseconds, at least 1, -1 if nothing is pending
+ */
+int dw_debouncer_next_timeout_millisec(Dw_Debouncer * deb) {
+   assert(deb && memcmp(deb->marker, DW_DEBOUNCER_MARKER, 4) == 0);
+   uint64_t earliest = UINT64_MAX;
+   for (int ndx = 0; ndx < deb->entries->len; ndx++) {
+      Connector_Debounce_Entry * entry = g_ptr_array_index(deb->entries, ndx);
+      earliest = MIN(earliest, entry->deadline_nanos);
+   }
+   if (deb->rescan_pending)
+      earliest = MIN(earliest, deb->rescan_deadline_nanos);
+   if (earliest == UINT64_MAX)
+      return -1;
+   uint64_t now = cur_monotonic_nanosec();
+   if (earliest <= now)
+      return 1;
+   return MAX(1, (earliest - now) / (1000*1000));
+}
+
+
+/** Settles the connectors whose quiet periods have expired, and emits or
+ *  queues events for those whose state changed.
+ *
+ *  For each expired connector the edid attribute is read once more.  If it
+ *  no longer matches the prior observation, the connector is still changing
+ *  and a new quiet period begins.
+ *
+ *  @param  deb              debouncer
+ *  @param  bs_buses_w_edid  buses currently reported as having an EDID
+ *  @return updated set of buses having an EDID
+ */
+Bit_Set_256 dw_debouncer_process_expired(
+      Dw_Debouncer * deb,
+      Bit_Set_256    bs_buses_w_edid)
+{
+   bool debug = false;
+   assert(deb && memcmp(deb->marker, DW_DEBOUNCER_MARKER, 4) == 0);
+   DBGTRC_STARTING(debug, TRACE_GROUP, "bs_buses_w_edid: %s", BS256_REPR(bs_buses_w_edid));
+
+   uint64_t now = cur_monotonic_nanosec();
+   Bit_Set_256 bs_removed = EMPTY_BIT_SET_256;
+   Bit_Set_256 bs_added   = EMPTY_BIT_SET_256;
+
+   for (int ndx = deb->entries->len-1; ndx >= 0; ndx--) {
+      Connector_Debounce_Entry * entry = g_ptr_array_index(deb->entries, ndx);
+      if (entry->deadline_nanos > now)
+         continue;
+      bool has_edid = connector_has_edid(entry->connector_name);
+      bool reported = bs256_contains(bs_buses_w_edid, entry->busno);
+      if (has_edid != entry->observed_has_edid) {
+         DBGTRC_NOPREFIX(debug, TRACE_GROUP, "%s still changing", entry->connector_name);
+         entry->observed_has_edid = has_edid;
+         entry->observation_ct++;
+         entry->deadline_nanos = now + quiet_period_nanos(!has_edid && reported);
+         continue;
+      }
+      if (entry->observation_ct > 1) {
+         SYSLOG2(DDCA_SYSLOG_NOTICE, "Connector %s required %d observations to stabilize",
+               entry->connector_name, entry->observation_ct);
+      }
+      if (has_edid && !reported)
+         bs_added = bs256_insert(bs_added, entry->busno);
+      else if (!has_edid && reported)
+         bs_removed = bs256_insert(bs_removed, entry->busno);
+      g_ptr_array_remove_index_fast(deb->entries, ndx);
+   }
+
+   if (deb->rescan_pending && deb->rescan_deadline_nanos <= now) {
+      Bit_Set_256 bs_latest = i2c_buses_w_edid_as_bitset();
+      if (!bs256_eq(bs_latest, deb->rescan_observed)) {
+         DBGTRC_NOPREFIX(debug, TRACE_GROUP, "Buses with EDID still changing");
+         deb->rescan_observed = bs_latest;
+         bool disconnecting = bs256_count(bs256_and_not(bs_buses_w_edid, bs_latest)) > 0;
+         deb->rescan_deadline_nanos = now + quiet_period_nanos(disconnecting);
+      }
+      else {
+         bs_removed = bs256_or(bs_removed, bs256_and_not(bs_buses_w_edid, bs_latest));
+         bs_added   = bs256_or(bs_added,   bs256_and_not(bs_latest, bs_buses_w_edid));
+         deb->rescan_pending = false;
+      }
+   }
+
+   if (bs256_count(bs_removed) > 0 || bs256_count(bs_added) > 0) {
+      DBGTRC_NOPREFIX(debug, TRACE_GROUP, "bs_removed: %s", BS256_REPR(bs_removed));
+      DBGTRC_NOPREFIX(debug, TRACE_GROUP, "bs_added:   %s", BS256_REPR(bs_added));
+      bs_buses_w_edid = bs256_or(bs256_and_not(bs_buses_w_edid, bs_removed), bs_added);
+      GPtrArray * drefs_to_recheck = g_ptr_array_new();
+      dw_hotplug_change_handler(bs_removed, bs_added, deb->events_queue, drefs_to_recheck);
+      // displays whose DDC communication is not yet working, e.g. still waking up
+      for (int ndx = 0; ndx < drefs_to_recheck->len; ndx++)
+         dw_put_recheck_queue(g_ptr_array_index(drefs_to_recheck, ndx));
+      g_ptr_array_free(drefs_to_recheck, true);
+   }
+
+   DBGTRC_DONE(debug, TRACE_GROUP, "Returning: %s", BS256_REPR(bs_buses_w_edid));
+   return bs_buses_w_edid;
+}
+
+
+void init_dw_debounce() {
+   RTTI_ADD_FUNC(dw_debounce_connector_event);
+   RTTI_ADD_FUNC(dw_debounce_rescan_event);
+   RTTI_ADD_FUNC(dw_debouncer_process_expired);
+}
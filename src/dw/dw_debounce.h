@@ -0,0 +1,36 @@
+/** @file dw_debounce.h
+ *
+ *  Per-connector debouncing of display connection changes reported by udev
+ */
+
+// Copyright (C) 2025 Sanford Rockowitz <rockowitz@minsoft.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef DW_DEBOUNCE_H_
+#define DW_DEBOUNCE_H_
+
+/** \cond */
+#include <glib-2.0/glib.h>
+#include <stdbool.h>
+
+#include "util/data_structures.h"
+/** \endcond */
+
+typedef struct Dw_Debouncer Dw_Debouncer;
+
+Dw_Debouncer * dw_new_debouncer(GArray * events_queue);
+void           dw_free_debouncer(Dw_Debouncer * deb);
+void           dw_debounce_connector_event(
+                  Dw_Debouncer * deb,
+                  char *         connector_name,
+                  Bit_Set_256    bs_buses_w_edid);
+void           dw_debounce_rescan_event(
+                  Dw_Debouncer * deb,
+                  Bit_Set_256    bs_buses_w_edid);
+int            dw_debouncer_next_timeout_millisec(Dw_Debouncer * deb);
+Bit_Set_256    dw_debouncer_process_expired(
+                  Dw_Debouncer * deb,
+                  Bit_Set_256    bs_buses_w_edid);
+void           init_dw_debounce();
+
+#endif /* DW_DEBOUNCE_H_ */
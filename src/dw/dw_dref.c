@@ -77,6 +77,34 @@ void dw_mark_display_ref_removed(Display_Ref* dref) {
 }
 
 
+/** Creates a #Display_Ref for the display on a bus, before any DDC checks
+ *  have been performed.
+ *
+ *  @param businfo  I2C_Bus_Info record for the bus, must have an EDID
+ *  @return         new Display_Ref
+ */
+static Display_Ref *
+new_dref_by_businfo(I2C_Bus_Info * businfo) {
+   assert(businfo->edid);
+   Display_Ref * dref = create_bus_display_ref(businfo->busno);
+   // dref->dispno = DISPNO_INVALID;   // -1, guilty until proven innocent
+   // dref->dispno = ++dispno_max;   // dispno not used in libddcutil except to indicate invalid
+   dref->pedid = copy_parsed_edid(businfo->edid);
+   dref->mmid  = mmk_new(
+                    dref->pedid->mfg_id,
+                    dref->pedid->model_name,
+                    dref->pedid->product_code);
+
+   // drec->detail.bus_detail = businfo;
+   dref->detail = businfo;
+   dref->flags |= DREF_DDC_IS_MONITOR_CHECKED;
+   dref->flags |= DREF_DDC_IS_MONITOR;
+   dref->drm_connector = g_strdup(businfo->drm_connector_name);
+   dref->drm_connector_id = businfo->drm_connector_id;
+   return dref;
+}
+
+
 /** If a display is present on a specified bus, adds a Display_Ref
  *  for that display.
  *
@@ -109,21 +137,7 @@ Display_Ref * dw_add_display_by_businfo(I2C_Bus_Info * businfo) {
       DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE, "No display detected on bus %d", businfo->busno);
    }
    else {
-      dref = create_bus_display_ref(businfo->busno);
-      // dref->dispno = DISPNO_INVALID;   // -1, guilty until proven innocent
-      // dref->dispno = ++dispno_max;   // dispno not used in libddcutil except to indicate invalid
-      dref->pedid = copy_parsed_edid(businfo->edid);
-      dref->mmid  = mmk_new(
-                       dref->pedid->mfg_id,
-                       dref->pedid->model_name,
-                       dref->pedid->product_code);
-
-      // drec->detail.bus_detail = businfo;
-      dref->detail = businfo;
-      dref->flags |= DREF_DDC_IS_MONITOR_CHECKED;
-      dref->flags |= DREF_DDC_IS_MONITOR;
-      dref->drm_connector = g_strdup(businfo->drm_connector_name);
-      dref->drm_connector_id = businfo->drm_connector_id;
+      dref = new_dref_by_businfo(businfo);
 
       DDCA_Status rc = dref_lock(dref);
       if (rc != 0) {
@@ -170,6 +184,40 @@ Display_Ref * dw_add_display_by_businfo(I2C_Bus_Info * businfo) {
 }
 
 
+/** Adds a Display_Ref for the display on a bus using the results of DDC
+ *  checks already performed by another process, i.e. the watch broker.
+ *  No I2C I/O is performed.
+ *
+ *  @param businfo      I2C_Bus_Info record for the bus, must have an EDID
+ *  @param ddc_flags    DREF_DDC_* and DREF_UNSUPPORTED_* flags set by the checks
+ *  @param vcp_version  VCP version reported by the display
+ *  @return             new Display_Ref
+ */
+Display_Ref *
+dw_add_checked_display_by_businfo(
+      I2C_Bus_Info *          businfo,
+      Dref_Flags              ddc_flags,
+      DDCA_MCCS_Version_Spec  vcp_version)
+{
+   bool debug = false;
+   assert(businfo);
+   DBGTRC_STARTING(debug, DDCA_TRC_CONN, "busno=%d, ddc_flags=%s, vcp_version=%d.%d",
+         businfo->busno, interpret_dref_flags_t(ddc_flags), vcp_version.major, vcp_version.minor);
+
+   Display_Ref * dref = new_dref_by_businfo(businfo);
+   dref->flags |= ddc_flags;
+   dref->vcp_version_xdf = vcp_version;
+   if (!(dref->flags & DREF_DDC_COMMUNICATION_WORKING))
+      dref->dispno = DISPNO_INVALID;
+   else
+      dref->dispno = ++dispno_max;
+   dw_add_display_ref(dref);
+
+   DBGTRC_DONE(debug, DDCA_TRC_CONN, "Returning dref %s", dref_reprx_t(dref));
+   return dref;
+}
+
+
 /** Given a #I2C_Bus_Info instance, checks if there is a currently active #Display_Ref
  *  for that bus (i.e. one with the DREF_REMOVED flag not set).
  *  If found, sets the DREF_REMOVED flag.
@@ -233,6 +281,7 @@ dw_recheck_dref(Display_Ref * dref) {
 
 
 void init_dw_dref()  {
+   RTTI_ADD_FUNC(dw_add_checked_display_by_businfo);
    RTTI_ADD_FUNC(dw_add_display_by_businfo);
    RTTI_ADD_FUNC(dw_add_display_ref);
    RTTI_ADD_FUNC(dw_mark_display_ref_removed);
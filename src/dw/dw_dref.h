@@ -19,6 +19,8 @@
 void         dw_add_display_ref(Display_Ref * dref);
 void         dw_mark_display_ref_removed(Display_Ref* dref);
 Display_Ref* dw_add_display_by_businfo(I2C_Bus_Info * businfo);
+Display_Ref* dw_add_checked_display_by_businfo(
+                I2C_Bus_Info * businfo, Dref_Flags ddc_flags, DDCA_MCCS_Version_Spec vcp_version);
 Display_Ref* dw_remove_display_by_businfo(I2C_Bus_Info * businfo);
 Error_Info*  dw_recheck_dref(Display_Ref * dref);
 
@@ -0,0 +1,449 @@
+/** @file dw_drm.c
+ *
+ *  Watch for display connection and DPMS changes using DRM uevents,
+ *  reading connector properties with libdrm.
+ *
+ *  The kernel emits a "change" uevent on the drm subsystem when a connector's
+ *  status changes, normally with property CONNECTOR identifying the connector.
+ *  Only that connector is then queried, using a DRM device file descriptor
+ *  that is kept open for the life of the watch thread.  Reading the kernel's
+ *  current connector state involves no I2C traffic.
+ *
+ *  The kernel does not emit uevents for DPMS changes, so if DPMS events are
+ *  requested the DPMS property of connected connectors is reread on the watch
+ *  loop interval, also using the cached file descriptor.
+ */
+
+// Copyright (C) 2025 Sanford Rockowitz <rockowitz@minsoft.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "config.h"
+#include "public/ddcutil_types.h"
+
+/** \cond */
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <glib-2.0/glib.h>
+#include <inttypes.h>
+#include <libudev.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <xf86drm.h>
+#include <xf86drmMode.h>
+
+#include "util/coredefs.h"
+#include "util/data_structures.h"
+#include "util/debug_util.h"
+#include "util/libdrm_aux_util.h"
+#include "util/linux_util.h"
+#include "util/report_util.h"
+#include "util/string_util.h"
+#include "util/traced_function_stack.h"
+
+#include "base/core.h"
+#include "base/displays.h"
+#include "base/drm_connector_state.h"
+#include "base/i2c_bus_base.h"
+#include "base/linux_errno.h"
+#include "base/rtti.h"
+/** \endcond */
+
+#include "sysfs/sysfs_base.h"
+
+#include "i2c/i2c_bus_core.h"
+
+#include "dw_common.h"
+#include "dw_debounce.h"
+#include "dw_status_events.h"
+#include "dw_udev.h"
+
+#include "dw/dw_drm.h"
+
+
+// Trace class for this file
+static DDCA_Trace_Group TRACE_GROUP = DDCA_TRC_CONN;
+
+#define DW_DRM_MAX_CARDS 16
+
+#define DW_DRM_CONNECTOR_KEY(_cardno, _connector_id) \
+   GINT_TO_POINTER( ((_cardno) << 16) | (_connector_id) )
+
+/** Last observed state of a DRM connector */
+typedef struct {
+   int               cardno;
+   int               connector_id;
+   drmModeConnection connection;
+   uint64_t          dpms;
+} Dw_Drm_Connector;
+
+
+/** State of the DRM watch loop that persists across events */
+typedef struct {
+   int            card_fds[DW_DRM_MAX_CARDS];   // cached DRM device fds, -1 if not open
+   GHashTable *   connectors;      // key DW_DRM_CONNECTOR_KEY(), value Dw_Drm_Connector *
+   Bit_Set_256    bs_cur_buses_w_edid;
+   Dw_Debouncer * debouncer;
+   bool           watch_connections;
+   bool           watch_dpms;
+} Drm_Watch_State;
+
+
+static inline bool
+dw_drm_dpms_asleep(uint64_t dpms) {
+   return dpms != DRM_MODE_DPMS_ON;
+}
+
+
+/** Returns the cached file descriptor for a DRM card, opening
+ *  the device if it is not already open.
+ *
+ *  @param  state   watch loop state
+ *  @param  cardno  DRM card number
+ *  @return file descriptor, -1 if unavailable
+ */
+static int
+dw_drm_card_fd(Drm_Watch_State * state, int cardno) {
+   if (cardno < 0 || cardno >= DW_DRM_MAX_CARDS)
+      return -1;
+   if (state->card_fds[cardno] < 0) {
+      char devname[40];
+      g_snprintf(devname, sizeof(devname), "/dev/dri/card%d", cardno);
+      // Only connector queries are performed, so read access suffices.
+      // The kernel makes the first opener of a primary node DRM master
+      // regardless of access mode.  If ddcutil wins that race (e.g. it
+      // starts before the compositor) it would block the compositor from
+      // modesetting, so drop master immediately.  drmDropMaster() fails
+      // harmlessly if this fd is not master.
+      int fd = open(devname, O_RDONLY | O_CLOEXEC);
+      if (fd < 0)
+         SYSLOG2(DDCA_SYSLOG_ERROR, "Error opening %s. errno=%s", devname, linux_errno_desc(errno));
+      else
+         drmDropMaster(fd);
+      state->card_fds[cardno] = fd;
+   }
+   return state->card_fds[cardno];
+}
+
+
+/** Emits a DPMS event for the display on a connector.
+ *
+ *  @param  connector_id  DRM connector id
+ *  @param  asleep        true if the display went to sleep, false if it woke
+ */
+static void
+dw_drm_emit_dpms_event(int connector_id, bool asleep) {
+   bool debug = false;
+   char * cname = get_sys_drm_connector_name_by_connector_id(connector_id);
+   Display_Ref * dref = (cname) ? GET_DREF_BY_CONNECTOR(cname, /*ignore_invalid*/ true) : NULL;
+   DBGTRC_EXECUTED(debug, TRACE_GROUP, "connector_id=%d, cname=%s, asleep=%s, dref=%s",
+         connector_id, cname, sbool(asleep), dref_repr_t(dref));
+   if (dref) {
+      DDCA_Display_Event_Type event_type = (asleep) ? DDCA_EVENT_DPMS_ASLEEP : DDCA_EVENT_DPMS_AWAKE;
+      dw_emit_or_queue_display_status_event(event_type, dref->drm_connector, dref, dref->io_path, NULL);
+   }
+   free(cname);
+}
+
+
+/** Reads the current state of a single connector and reports
+ *  any change from its last observed state.
+ *
+ *  A change in connection status is passed to the debouncer.
+ *  A change in DPMS state of a connected display is reported immediately.
+ *
+ *  @param  state         watch loop state
+ *  @param  cardno        DRM card number
+ *  @param  connector_id  DRM connector id
+ *  @param  report        if false, only record the connector's state
+ */
+static void
+dw_drm_check_connector(Drm_Watch_State * state, int cardno, int connector_id, bool report) {
+   bool debug = false;
+   DBGTRC_STARTING(debug, TRACE_GROUP, "cardno=%d, connector_id=%d, report=%s",
+         cardno, connector_id, sbool(report));
+
+   int fd = dw_drm_card_fd(state, cardno);
+   Drm_Connector_State * cstate = (fd >= 0) ? get_drm_connector_state_by_fd(fd, cardno, connector_id) : NULL;
+   if (!cstate) {
+      DBGTRC_DONE(debug, TRACE_GROUP, "Connector state unavailable");
+      return;
+   }
+
+   Dw_Drm_Connector * prior = g_hash_table_lookup(state->connectors,
+                                                  DW_DRM_CONNECTOR_KEY(cardno, connector_id));
+   if (!prior) {
+      prior = calloc(1, sizeof(Dw_Drm_Connector));
+      prior->cardno = cardno;
+      prior->connector_id = connector_id;
+      prior->connection = DRM_MODE_DISCONNECTED;
+      prior->dpms = DRM_MODE_DPMS_ON;
+      g_hash_table_insert(state->connectors, DW_DRM_CONNECTOR_KEY(cardno, connector_id), prior);
+   }
+   bool connection_changed = cstate->connection != prior->connection;
+   bool dpms_changed = dw_drm_dpms_asleep(cstate->dpms) != dw_drm_dpms_asleep(prior->dpms);
+   DBGTRC_NOPREFIX(debug, TRACE_GROUP, "connection: %d -> %d, dpms: %"PRIu64" -> %"PRIu64,
+         prior->connection, cstate->connection, prior->dpms, cstate->dpms);
+
+   if (report) {
+      if (connection_changed && state->watch_connections) {
+         char * cname = get_sys_drm_connector_name_by_connector_id(connector_id);
+         if (cname)
+            dw_debounce_connector_event(state->debouncer, cname, state->bs_cur_buses_w_edid);
+         else
+            dw_debounce_rescan_event(state->debouncer, state->bs_cur_buses_w_edid);
+         free(cname);
+      }
+      else if (dpms_changed && state->watch_dpms && cstate->connection == DRM_MODE_CONNECTED) {
+         dw_drm_emit_dpms_event(connector_id, dw_drm_dpms_asleep(cstate->dpms));
+      }
+   }
+   prior->connection = cstate->connection;
+   prior->dpms = cstate->dpms;
+   free_drm_connector_state(cstate);
+
+   DBGTRC_DONE(debug, TRACE_GROUP, "connection_changed=%s, dpms_changed=%s",
+         sbool(connection_changed), sbool(dpms_changed));
+}
+
+
+/** Checks every connector of a card.  Used when a uevent does not identify
+ *  the connector, or when connectors are added or removed, e.g. by an MST hub.
+ *
+ *  @param  state   watch loop state
+ *  @param  cardno  DRM card number
+ *  @param  report  if false, only record the state of the card's connectors
+ */
+static void
+dw_drm_scan_card(Drm_Watch_State * state, int cardno, bool report) {
+   bool debug = false;
+   DBGTRC_STARTING(debug, TRACE_GROUP, "cardno=%d, report=%s", cardno, sbool(report));
+
+   int fd = dw_drm_card_fd(state, cardno);
+   drmModeResPtr res = (fd >= 0) ? drmModeGetResources(fd) : NULL;
+   if (!res) {
+      DBGTRC_DONE(debug, TRACE_GROUP, "DRM resources unavailable for card %d", cardno);
+      return;
+   }
+
+   GHashTable * seen = g_hash_table_new(g_direct_hash, g_direct_equal);
+   for (int ndx = 0; ndx < res->count_connectors; ndx++) {
+      dw_drm_check_connector(state, cardno, res->connectors[ndx], report);
+      g_hash_table_add(seen, DW_DRM_CONNECTOR_KEY(cardno, res->connectors[ndx]));
+   }
+   drmModeFreeResources(res);
+
+   // Forget connectors that no longer exist
+   bool connected_connector_removed = false;
+   GHashTableIter iter;
+   gpointer key;
+   gpointer value;
+   g_hash_table_iter_init(&iter, state->connectors);
+   while (g_hash_table_iter_next(&iter, &key, &value)) {
+      Dw_Drm_Connector * conn = value;
+      if (conn->cardno == cardno && !g_hash_table_contains(seen, key)) {
+         if (conn->connection == DRM_MODE_CONNECTED)
+            connected_connector_removed = true;
+         g_hash_table_iter_remove(&iter);
+      }
+   }
+   g_hash_table_destroy(seen);
+   if (connected_connector_removed && report && state->watch_connections)
+      dw_debounce_rescan_event(state->debouncer, state->bs_cur_buses_w_edid);
+
+   DBGTRC_DONE(debug, TRACE_GROUP, "connected_connector_removed=%s", sbool(connected_connector_removed));
+}
+
+
+/** Rereads the DPMS state of all connected connectors. */
+static void
+dw_drm_check_dpms(Drm_Watch_State * state) {
+   GHashTableIter iter;
+   gpointer value;
+   g_hash_table_iter_init(&iter, state->connectors);
+   while (g_hash_table_iter_next(&iter, NULL, &value)) {
+      Dw_Drm_Connector * conn = value;
+      if (conn->connection == DRM_MODE_CONNECTED)
+         dw_drm_check_connector(state, conn->cardno, conn->connector_id, /*report*/ true);
+   }
+}
+
+
+/** Processes a single drm subsystem udev event.
+ *
+ *  @param  dev    udev device describing the event
+ *  @param  state  watch loop state, updated
+ */
+static void
+dw_drm_process_udev_event(struct udev_device * dev, Drm_Watch_State * state) {
+   bool debug = false;
+   const char * action    = udev_device_get_property_value(dev, "ACTION");
+   const char * connector = udev_device_get_property_value(dev, "CONNECTOR");
+   const char * sysname   = udev_device_get_sysname(dev);     // e.g. card0, card0-DP-1
+   DBGTRC_STARTING(debug || report_udev_events, TRACE_GROUP, "action=%s, connector=%s, sysname=%s",
+         action, connector, sysname);
+
+   int cardno = -1;
+   int connector_id = -1;
+   if (!sysname || sscanf(sysname, "card%d", &cardno) != 1) {
+      DBGTRC_NOPREFIX(debug, TRACE_GROUP, "Ignoring event for %s", sysname);
+   }
+   else if (action && streq(action, "change") && connector && str_to_int(connector, &connector_id, 10)) {
+      dw_drm_check_connector(state, cardno, connector_id, /*report*/ true);
+   }
+   else {
+      dw_drm_scan_card(state, cardno, /*report*/ true);
+   }
+
+   DBGTRC_DONE(debug, TRACE_GROUP, "");
+}
+
+
+/** Main loop watching for display changes using DRM uevents. Runs as thread.
+ *
+ *  The thread blocks in epoll_wait() on the udev monitor, the termination
+ *  eventfd, the debounce timerfd, and if DPMS events are requested a
+ *  periodic timerfd for rechecking DPMS state.
+ *
+ *  @param data   #Watch_Displays_Data passed from creator thread
+ */
+gpointer dw_watch_displays_drm(gpointer data) {
+   bool debug = false;
+
+   Watch_Displays_Data * wdd = data;
+   assert(wdd && memcmp(wdd->marker, WATCH_DISPLAYS_DATA_MARKER, 4) == 0 );
+   DBGTRC_STARTING(debug, TRACE_GROUP,
+         "Caller process id: %d, caller thread id: %d, event_classes=0x%02x, watch_loop_millisec=%d",
+         wdd->main_process_id, wdd->main_thread_id, wdd->event_classes, wdd->watch_loop_millisec);
+
+   Drm_Watch_State state = {0};
+   for (int ndx = 0; ndx < DW_DRM_MAX_CARDS; ndx++)
+      state.card_fds[ndx] = -1;
+   state.connectors = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, free);
+   state.watch_connections = wdd->event_classes & DDCA_EVENT_CLASS_DISPLAY_CONNECTION;
+   state.watch_dpms = wdd->event_classes & DDCA_EVENT_CLASS_DPMS;
+   state.bs_cur_buses_w_edid =
+         buses_bitset_from_businfo_array(all_i2c_buses, /*only_connected=*/ true);
+   state.debouncer = dw_new_debouncer(NULL);
+
+   pid_t cur_pid = getpid();
+   pid_t cur_tid = get_thread_id();
+
+   struct udev* udev = udev_new();
+   struct udev_monitor* mon = udev_monitor_new_from_netlink(udev, "udev");
+   udev_monitor_filter_add_match_subsystem_devtype(mon, "drm", NULL);
+   udev_monitor_enable_receiving(mon);
+   int udev_fd = udev_monitor_get_fd(mon);    // nonblocking
+
+   // Record the initial state of all connectors, opening the DRM devices
+   GPtrArray * devnames = get_dri_device_names_using_filesys();
+   for (int ndx = 0; ndx < devnames->len; ndx++) {
+      int cardno = extract_cardno(g_ptr_array_index(devnames, ndx));
+      if (cardno >= 0)
+         dw_drm_scan_card(&state, cardno, /*report*/ false);
+   }
+   g_ptr_array_free(devnames, true);
+   DBGTRC_NOPREFIX(debug, TRACE_GROUP, "Watching %d DRM connectors", g_hash_table_size(state.connectors));
+
+   int terminate_fd = dw_terminate_watch_fd();
+   int debounce_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+   int dpms_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+   int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+   bool ok = terminate_fd >= 0 && debounce_fd >= 0 && dpms_fd >= 0 && epoll_fd >= 0;
+   if (!ok) {
+      SYSLOG2(DDCA_SYSLOG_ERROR, "Unable to create file descriptors for DRM watch loop");
+   }
+   else {
+      ok = dw_epoll_add_input_fd(epoll_fd, terminate_fd) &&
+           dw_epoll_add_input_fd(epoll_fd, debounce_fd)  &&
+           dw_epoll_add_input_fd(epoll_fd, udev_fd);
+      if (ok && state.watch_dpms) {
+         ok = dw_epoll_add_input_fd(epoll_fd, dpms_fd);
+         int millisec = wdd->watch_loop_millisec;
+         struct itimerspec spec = {
+               .it_interval = {millisec / 1000, (millisec % 1000) * 1000000L},
+               .it_value    = {millisec / 1000, (millisec % 1000) * 1000000L}
+         };
+         timerfd_settime(dpms_fd, 0, &spec, NULL);
+      }
+   }
+
+   bool terminate = !ok;
+   while (!terminate) {
+      struct epoll_event events[4];
+      int ct = epoll_wait(epoll_fd, events, 4, -1);
+      if (ct < 0) {
+         if (errno == EINTR)
+            continue;
+         SYSLOG2(DDCA_SYSLOG_ERROR, "epoll_wait() failed. errno=%s", linux_errno_desc(errno));
+         break;
+      }
+      dw_count_watch_wakeup(wdd->watch_mode);
+
+      for (int ndx = 0; ndx < ct; ndx++) {
+         int fd = events[ndx].data.fd;
+         if (fd == terminate_fd) {
+            terminate = true;
+         }
+         else if (fd == debounce_fd) {
+            uint64_t expirations;
+            if (read(debounce_fd, &expirations, sizeof(expirations)) > 0) {
+               state.bs_cur_buses_w_edid = dw_debouncer_process_expired(
+                                              state.debouncer, state.bs_cur_buses_w_edid);
+            }
+         }
+         else if (fd == dpms_fd) {
+            uint64_t expirations;
+            if (read(dpms_fd, &expirations, sizeof(expirations)) > 0)
+               dw_drm_check_dpms(&state);
+         }
+         else if (fd == udev_fd) {
+            struct udev_device * dev = NULL;
+            while (!terminate_watch_thread && (dev = udev_monitor_receive_device(mon))) {
+               dw_drm_process_udev_event(dev, &state);
+               udev_device_unref(dev);
+            }
+         }
+      }
+      if (terminate || terminate_watch_thread)
+         break;
+
+      dw_terminate_if_invalid_thread_or_process(cur_pid, cur_tid);
+
+      // Wake when the earliest connector quiet period ends, if any
+      dw_arm_timerfd(debounce_fd, MAX(0, dw_debouncer_next_timeout_millisec(state.debouncer)));
+   }
+
+   DBGTRC_DONE(debug, TRACE_GROUP, "Terminating thread");
+   if (epoll_fd >= 0)
+      close(epoll_fd);
+   if (debounce_fd >= 0)
+      close(debounce_fd);
+   if (dpms_fd >= 0)
+      close(dpms_fd);
+   for (int ndx = 0; ndx < DW_DRM_MAX_CARDS; ndx++) {
+      if (state.card_fds[ndx] >= 0)
+         close(state.card_fds[ndx]);
+   }
+   g_hash_table_destroy(state.connectors);
+   dw_free_debouncer(state.debouncer);
+   dw_free_watch_displays_data(wdd);
+   udev_monitor_unref(mon);
+   udev_unref(udev);
+   free_current_traced_function_stack();
+   return NULL;
+}
+
+
+void init_dw_drm() {
+   RTTI_ADD_FUNC(dw_drm_check_connector);
+   RTTI_ADD_FUNC(dw_drm_scan_card);
+   RTTI_ADD_FUNC(dw_drm_emit_dpms_event);
+   RTTI_ADD_FUNC(dw_drm_process_udev_event);
+   RTTI_ADD_FUNC(dw_watch_displays_drm);
+}
@@ -0,0 +1,23 @@
+/** @file dw_drm.h
+ *
+ *  Watch for display connection and DPMS changes using DRM uevents,
+ *  reading connector properties with libdrm
+ */
+
+// Copyright (C) 2025 Sanford Rockowitz <rockowitz@minsoft.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef DW_DRM_H_
+#define DW_DRM_H_
+
+/** \cond */
+#include <glib-2.0/glib.h>
+#include <stdbool.h>
+
+#include "public/ddcutil_types.h"
+/** \endcond */
+
+gpointer    dw_watch_displays_drm(gpointer data);
+void        init_dw_drm();
+
+#endif /* DW_DRM_H_ */
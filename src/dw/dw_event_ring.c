@@ -0,0 +1,216 @@
+/** @file dw_event_ring.c
+ *
+ *  Delivers display status events through a pollable file descriptor,
+ *  as an alternative to registered callbacks.
+ *
+ *  Events are placed in a fixed-size ring buffer and an eventfd is
+ *  signalled.  The client polls the eventfd from its own event loop, and
+ *  when it is readable repeatedly calls #dw_get_next_event() until no event
+ *  remains.  No library thread runs client code.
+ *
+ *  There is a single consumer.  Producers are serialized by a mutex, so the
+ *  ring is single producer/single consumer and the consumer side takes no
+ *  lock.  If the ring is full the newest event is discarded.
+ */
+
+// Copyright (C) 2025 Sanford Rockowitz <rockowitz@minsoft.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/** \cond */
+#include <assert.h>
+#include <errno.h>
+#include <glib-2.0/glib.h>
+#include <inttypes.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+/** \endcond */
+
+#include "public/ddcutil_status_codes.h"
+
+#include "util/linux_util.h"
+
+#include "base/core.h"
+#include "base/rtti.h"
+
+#include "dw_status_events.h"
+
+#include "dw_event_ring.h"
+
+
+// Trace class for this file
+static DDCA_Trace_Group TRACE_GROUP = DDCA_TRC_CONN;
+
+static_assert((EVENT_RING_CAPACITY & (EVENT_RING_CAPACITY-1)) == 0,
+              "EVENT_RING_CAPACITY must be a power of 2");
+
+static DDCA_Display_Status_Event event_ring[EVENT_RING_CAPACITY];
+static guint  ring_head = 0;       // count of events written, updated only by producer
+static guint  ring_tail = 0;       // count of events read, updated only by consumer
+static gint   event_fd  = -1;      // eventfd signalled when an event is added
+static GMutex producer_mutex;      // serializes producers, and open/close
+static int    dropped_ct = 0;      // protected by producer_mutex
+
+
+/** Creates the eventfd through which display status events are signalled,
+ *  or returns the existing one.
+ *
+ *  @param  fd_loc  where to return the file descriptor
+ *  @retval DDCRC_OK
+ *  @retval DDCRC_ARG  fd_loc is NULL
+ *  @retval -errno     eventfd() failed
+ */
+DDCA_Status dw_open_event_fd(int * fd_loc) {
+   bool debug = false;
+   DBGTRC_STARTING(debug, TRACE_GROUP, "fd_loc=%p", fd_loc);
+
+   DDCA_Status ddcrc = DDCRC_OK;
+   if (!fd_loc) {
+      ddcrc = DDCRC_ARG;
+   }
+   else {
+      g_mutex_lock(&producer_mutex);
+      if (event_fd < 0) {
+         int fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+         if (fd < 0) {
+            ddcrc = -errno;
+            SYSLOG2(DDCA_SYSLOG_ERROR, "eventfd() failed. errno=%s", linux_errno_desc(errno));
+         }
+         else {
+            g_atomic_int_set(&ring_tail, g_atomic_int_get(&ring_head));
+            dropped_ct = 0;
+            g_atomic_int_set(&event_fd, fd);
+         }
+      }
+      *fd_loc = event_fd;
+      g_mutex_unlock(&producer_mutex);
+   }
+
+   DBGTRC_RET_DDCRC(debug, TRACE_GROUP, ddcrc, "*fd_loc=%d", (fd_loc) ? *fd_loc : -1);
+   return ddcrc;
+}
+
+
+/** Closes the eventfd and discards any undelivered events.
+ *
+ *  @retval DDCRC_OK
+ *  @retval DDCRC_INVALID_OPERATION  eventfd not open
+ */
+DDCA_Status dw_close_event_fd() {
+   bool debug = false;
+   DBGTRC_STARTING(debug, TRACE_GROUP, "event_fd=%d", event_fd);
+
+   DDCA_Status ddcrc = DDCRC_OK;
+   g_mutex_lock(&producer_mutex);
+   if (event_fd < 0) {
+      ddcrc = DDCRC_INVALID_OPERATION;
+   }
+   else {
+      close(event_fd);
+      g_atomic_int_set(&event_fd, -1);
+      g_atomic_int_set(&ring_tail, g_atomic_int_get(&ring_head));
+      if (dropped_ct > 0)
+         SYSLOG2(DDCA_SYSLOG_NOTICE, "%d display status event(s) discarded because event ring was full",
+                                     dropped_ct);
+   }
+   g_mutex_unlock(&producer_mutex);
+
+   DBGTRC_RET_DDCRC(debug, TRACE_GROUP, ddcrc, "");
+   return ddcrc;
+}
+
+
+/** Adds an event to the ring buffer and signals the eventfd.
+ *  Does nothing if the eventfd has not been opened.
+ *
+ *  @param  evt  event to add
+ */
+void dw_put_event_ring(DDCA_Display_Status_Event evt) {
+   bool debug = false;
+   if (g_atomic_int_get(&event_fd) < 0)
+      return;
+   DBGTRC_STARTING(debug, TRACE_GROUP, "evt=%s", display_status_event_repr_t(evt));
+
+   g_mutex_lock(&producer_mutex);
+   bool added = false;
+   if (event_fd >= 0) {
+      guint head = ring_head;
+      if (head - g_atomic_int_get(&ring_tail) >= EVENT_RING_CAPACITY) {
+         dropped_ct++;
+         SYSLOG2(DDCA_SYSLOG_WARNING, "Display status event ring full, discarding %s",
+                                      display_status_event_repr_t(evt));
+      }
+      else {
+         event_ring[head & (EVENT_RING_CAPACITY-1)] = evt;
+         g_atomic_int_set(&ring_head, head+1);     // publishes the slot
+         uint64_t one = 1;
+         if (write(event_fd, &one, sizeof(one)) != sizeof(one))
+            SYSLOG2(DDCA_SYSLOG_ERROR, "write() to display status eventfd failed. errno=%s",
+                                       linux_errno_desc(errno));
+         added = true;
+      }
+   }
+   g_mutex_unlock(&producer_mutex);
+
+   DBGTRC_DONE(debug, TRACE_GROUP, "added=%s", sbool(added));
+}
+
+
+/** Removes the oldest event from the ring buffer.  Does not block.
+ *
+ *  When the ring is found empty the eventfd is reset, so it becomes
+ *  readable again only when a further event is added.  The caller should
+ *  therefore keep calling this function until it returns #DDCRC_NOT_FOUND.
+ *
+ *  @param  evt_loc  where to return the event
+ *  @retval DDCRC_OK
+ *  @retval DDCRC_NOT_FOUND          no event available
+ *  @retval DDCRC_INVALID_OPERATION  eventfd not open
+ *  @retval DDCRC_ARG                evt_loc is NULL
+ */
+DDCA_Status dw_get_next_event(DDCA_Display_Status_Event * evt_loc) {
+   bool debug = false;
+   DBGTRC_STARTING(debug, TRACE_GROUP, "evt_loc=%p", evt_loc);
+
+   DDCA_Status ddcrc = DDCRC_OK;
+   int fd = g_atomic_int_get(&event_fd);
+   if (!evt_loc) {
+      ddcrc = DDCRC_ARG;
+   }
+   else if (fd < 0) {
+      ddcrc = DDCRC_INVALID_OPERATION;
+   }
+   else {
+      guint tail = g_atomic_int_get(&ring_tail);
+      if (g_atomic_int_get(&ring_head) == tail) {
+         // Drain the eventfd, then look again.  A producer that adds an
+         // event after the recheck also writes the eventfd after it.
+         uint64_t ct;
+         while (read(fd, &ct, sizeof(ct)) > 0);    // fd is nonblocking
+         if (g_atomic_int_get(&ring_head) == tail)
+            ddcrc = DDCRC_NOT_FOUND;
+      }
+      if (ddcrc == DDCRC_OK) {
+         *evt_loc = event_ring[tail & (EVENT_RING_CAPACITY-1)];
+         g_atomic_int_set(&ring_tail, tail+1);     // releases the slot
+      }
+   }
+
+   DBGTRC_RET_DDCRC(debug, TRACE_GROUP, ddcrc, "%s",
+         (ddcrc == DDCRC_OK) ? display_status_event_repr_t(*evt_loc) : "");
+   return ddcrc;
+}
+
+
+void init_dw_event_ring() {
+   RTTI_ADD_FUNC(dw_open_event_fd);
+   RTTI_ADD_FUNC(dw_close_event_fd);
+   RTTI_ADD_FUNC(dw_put_event_ring);
+   RTTI_ADD_FUNC(dw_get_next_event);
+}
+
+
+void terminate_dw_event_ring() {
+   if (g_atomic_int_get(&event_fd) >= 0)
+      dw_close_event_fd();
+}
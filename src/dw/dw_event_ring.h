@@ -0,0 +1,27 @@
+/** @file dw_event_ring.h
+ *
+ *  Delivers display status events through a pollable file descriptor
+ */
+
+// Copyright (C) 2025 Sanford Rockowitz <rockowitz@minsoft.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef DW_EVENT_RING_H_
+#define DW_EVENT_RING_H_
+
+/** \cond */
+#include <stdbool.h>
+
+#include "public/ddcutil_types.h"
+/** \endcond */
+
+#define EVENT_RING_CAPACITY 64     // must be a power of 2
+
+DDCA_Status dw_open_event_fd(int * fd_loc);
+DDCA_Status dw_get_next_event(DDCA_Display_Status_Event * evt_loc);
+DDCA_Status dw_close_event_fd();
+void        dw_put_event_ring(DDCA_Display_Status_Event evt);
+void        init_dw_event_ring();
+void        terminate_dw_event_ring();
+
+#endif /* DW_EVENT_RING_H_ */
@@ -41,8 +41,12 @@
 #include "ddc/ddc_displays.h"
 #include "ddc/ddc_display_ref_reports.h"
 
+#include "dw_broker.h"
 #include "dw_status_events.h"
 #include "dw_common.h"
+#ifdef USE_LIBDRM
+#include "dw_drm.h"
+#endif
 #include "dw_udev.h"
 #include "dw_recheck.h"
 #include "dw_poll.h"
@@ -65,6 +69,7 @@ static GThread * recheck_thread = NULL;
 static GMutex    watch_thread_mutex;
 static DDCA_Display_Event_Class active_watch_displays_classes = DDCA_EVENT_CLASS_NONE;
 static Watch_Displays_Data * global_wdd;     // needed to pass to dw_stop_watch_displays()
+static bool      broker_subscribed = false;  // receiving events from the watch broker, no watch thread
 
 
 // ***
@@ -95,6 +100,10 @@ resolve_watch_mode(DDC_Watch_Mode initial_mode,  XEvent_Data ** xev_data_loc) {
    if (initial_mode == Watch_Mode_Udev)
       initial_mode = Watch_Mode_Poll;
 #endif
+#ifndef USE_LIBDRM
+   if (initial_mode == Watch_Mode_Drm)
+      initial_mode = Watch_Mode_Poll;
+#endif
 
    if (initial_mode == Watch_Mode_Dynamic) {
       resolved_watch_mode = Watch_Mode_Poll;    // always works, may be slow
@@ -156,7 +165,100 @@ resolve_watch_mode(DDC_Watch_Mode initial_mode,  XEvent_Data ** xev_data_loc) {
 #endif
 
 
+/** Starts the watch and recheck threads.
+ *  Called with watch_thread_mutex held.
+ *
+ *  @param  event_classes  types of events to watch for
+ */
+STATIC void
+start_watch_threads(DDCA_Display_Event_Class event_classes) {
+   bool debug = false;
+   DBGTRC_STARTING(debug, TRACE_GROUP, "event_classes=0x%02x", event_classes);
+
+#ifdef USE_X11
+   XEvent_Data * xev_data = NULL;
+   DDC_Watch_Mode resolved_watch_mode = resolve_watch_mode(watch_displays_mode, &xev_data);
+   ASSERT_IFF(resolved_watch_mode == Watch_Mode_Xevent, xev_data);
+#elif defined(USE_LIBDRM)
+   DDC_Watch_Mode resolved_watch_mode =
+         (watch_displays_mode == Watch_Mode_Drm) ? Watch_Mode_Drm : Watch_Mode_Poll;
+#else
+   DDC_Watch_Mode resolved_watch_mode = Watch_Mode_Poll;
+#endif
+
+   int calculated_watch_loop_millisec = dw_calc_watch_loop_millisec(resolved_watch_mode);
+   // DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE, "calc_watch_loop_millisec() returned %d", calculated_watch_loop_millisec);
+   MSG_W_SYSLOG(DDCA_SYSLOG_NOTICE,
+         "Watching for display connection changes, resolved watch mode = %s, poll loop interval = %d millisec",
+         watch_mode_name(resolved_watch_mode), calculated_watch_loop_millisec);
+   MSG_W_SYSLOG(DDCA_SYSLOG_NOTICE,
+         "                                         extra_stabilization_millisec: %d,  stabilization_poll_millisec: %d",
+         initial_stabilization_millisec, stabilization_poll_millisec);
+   DBGTRC_NOPREFIX(debug, TRACE_GROUP, "use_sysfs_connector_id: %s", SBOOL(use_sysfs_connector_id));    // watch udev only
+
+   dw_reset_terminate_watch();
+   dw_reset_bus_fingerprints();    // connections may have changed while not watching
+
+   // Start recheck thread
+   Recheck_Displays_Data * rdd = calloc(1, sizeof(Recheck_Displays_Data));
+   memcpy(rdd->marker, RECHECK_DISPLAYS_DATA_MARKER,4);
+   recheck_thread = g_thread_new("display_recheck_thread",             // optional thread name
+                                 dw_recheck_displays_func,
+                                 rdd);
+   DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE, "Started recheck_thread = %p", recheck_thread);
+   SYSLOG2(DDCA_SYSLOG_NOTICE, "libddcutil recheck thread %p started", recheck_thread);
+
+   // Start watch thread
+   Watch_Displays_Data * wdd = calloc(1, sizeof(Watch_Displays_Data));
+   memcpy(wdd->marker, WATCH_DISPLAYS_DATA_MARKER, 4);
+   wdd->main_process_id = pid();
+   wdd->main_thread_id = tid();    // alt = syscall(SYS_gettid);
+   // event_classes &= ~DDCA_EVENT_CLASS_DPMS;     // *** TEMP ***
+   wdd->event_classes = event_classes;
+   wdd->watch_mode = resolved_watch_mode;
+   wdd->watch_loop_millisec = calculated_watch_loop_millisec;
+#ifdef USE_X11
+   if (xev_data)
+      wdd->evdata = xev_data;
+#endif
+   global_wdd = wdd;   // so that it's available to ddc_stop_watch_displays()
+
+#ifdef CALLBACK_DISPLAYS_THREAD
+   DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE, "Calling g_thread_new()...");
+   Callback_Displays_Data * cdd = dw_new_callback_displays_data();
+   callback_thread = g_thread_new(
+                    "callback_displays_thread",             // optional thread name
+                    dw_callback_displays_func,
+                    cdd);
+   DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE, "Started callback_thread = %p", callback_thread);
+   SYSLOG2(DDCA_SYSLOG_NOTICE, "libddcutil callback thread %p started", callback_thread);
+#endif
+
+   GThreadFunc watch_thread_func =
+         (resolved_watch_mode == Watch_Mode_Poll || resolved_watch_mode == Watch_Mode_Xevent)
+              ? dw_watch_display_connections
+              : dw_watch_displays_udev;
+#ifdef USE_LIBDRM
+   if (resolved_watch_mode == Watch_Mode_Drm)
+      watch_thread_func = dw_watch_displays_drm;
+#endif
+
+   DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE, "Calling g_thread_new()...");
+   watch_thread = g_thread_new(
+                    "watch_displays",             // optional thread name
+                    watch_thread_func,
+                    wdd);
+   DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE, "Started watch_thread = %p", watch_thread);
+   SYSLOG2(DDCA_SYSLOG_NOTICE, "libddcutil watch thread %p started", watch_thread);
+
+   DBGTRC_DONE(debug, TRACE_GROUP, "watch_thread=%p", watch_thread);
+}
+
+
 /** Starts thread that watches for changes in display connection status.
+ *
+ *  If watch broker mode is enabled and another process is already watching,
+ *  no threads are started.  Events are instead received from that process.
  *
  *  @param  event_classes  types of events to watch for
  *  @return  Error_Info struct if error, possible status codes:
@@ -171,9 +273,6 @@ dw_start_watch_displays(DDCA_Display_Event_Class event_classes) {
         watch_mode_name(watch_displays_mode), watch_thread, event_classes, SBOOL(all_video_adapters_implement_drm));
    DBGTRC_NOPREFIX(debug, TRACE_GROUP, "thread_id = %d, traced_function_stack=%p", TID(), traced_function_stack);
    Error_Info * err = NULL;
-#ifdef USE_X11
-   XEvent_Data * xev_data = NULL;
-#endif
 
    if (!all_video_adapters_implement_drm) {
       err = ERRINFO_NEW(DDCRC_INVALID_OPERATION, "Requires DRM video drivers");
@@ -185,81 +284,24 @@ dw_start_watch_displays(DDCA_Display_Event_Class event_classes) {
       goto bye;
    }
 
-#ifdef USE_X11
-   DDC_Watch_Mode resolved_watch_mode = resolve_watch_mode(watch_displays_mode, &xev_data);
-   ASSERT_IFF(resolved_watch_mode == Watch_Mode_Xevent, xev_data);
-#else
-   DDC_Watch_Mode resolved_watch_mode = Watch_Mode_Poll;
-#endif
-
-   int calculated_watch_loop_millisec = dw_calc_watch_loop_millisec(resolved_watch_mode);
-   // DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE, "calc_watch_loop_millisec() returned %d", calculated_watch_loop_millisec);
-   MSG_W_SYSLOG(DDCA_SYSLOG_NOTICE,
-         "Watching for display connection changes, resolved watch mode = %s, poll loop interval = %d millisec",
-         watch_mode_name(resolved_watch_mode), calculated_watch_loop_millisec);
-   MSG_W_SYSLOG(DDCA_SYSLOG_NOTICE,
-         "                                         extra_stabilization_millisec: %d,  stabilization_poll_millisec: %d",
-         initial_stabilization_millisec, stabilization_poll_millisec);
-   DBGTRC_NOPREFIX(debug, TRACE_GROUP, "use_sysfs_connector_id: %s", SBOOL(use_sysfs_connector_id));    // watch udev only
-
    g_mutex_lock(&watch_thread_mutex);
    if (!(event_classes & (DDCA_EVENT_CLASS_DPMS|DDCA_EVENT_CLASS_DISPLAY_CONNECTION))) {
       err = ERRINFO_NEW(DDCRC_ARG, "Invalid event classes");
    }
-   else if (watch_thread) {
+   else if (watch_thread || broker_subscribed) {
       err = ERRINFO_NEW(DDCRC_INVALID_OPERATION, "Watch thread already running");
    }
    else {
-      terminate_watch_thread = false;
-
-      // Start recheck thread
-      Recheck_Displays_Data * rdd = calloc(1, sizeof(Recheck_Displays_Data));
-      memcpy(rdd->marker, RECHECK_DISPLAYS_DATA_MARKER,4);
-      recheck_thread = g_thread_new("display_recheck_thread",             // optional thread name
-                                    dw_recheck_displays_func,
-                                    rdd);
-      DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE, "Started recheck_thread = %p", recheck_thread);
-      SYSLOG2(DDCA_SYSLOG_NOTICE, "libddcutil recheck thread %p started", recheck_thread);
-
-      // Start watch thread
-      Watch_Displays_Data * wdd = calloc(1, sizeof(Watch_Displays_Data));
-      memcpy(wdd->marker, WATCH_DISPLAYS_DATA_MARKER, 4);
-      wdd->main_process_id = pid();
-      wdd->main_thread_id = tid();    // alt = syscall(SYS_gettid);
-      // event_classes &= ~DDCA_EVENT_CLASS_DPMS;     // *** TEMP ***
-      wdd->event_classes = event_classes;
-      wdd->watch_mode = resolved_watch_mode;
-      wdd->watch_loop_millisec = calculated_watch_loop_millisec;
-#ifdef USE_X11
-      if (xev_data)
-         wdd->evdata = xev_data;
-#endif
-      global_wdd = wdd;   // so that it's available to ddc_stop_watch_displays() 
-
-#ifdef CALLBACK_DISPLAYS_THREAD
-      DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE, "Calling g_thread_new()...");
-      Callback_Displays_Data * cdd = dw_new_callback_displays_data();
-      callback_thread = g_thread_new(
-                       "callback_displays_thread",             // optional thread name
-                       dw_callback_displays_func,
-                       cdd);
-      DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE, "Started callback_thread = %p", callback_thread);
-      SYSLOG2(DDCA_SYSLOG_NOTICE, "libddcutil callback thread %p started", callback_thread);
-#endif
-
-      GThreadFunc watch_thread_func =
-            (resolved_watch_mode == Watch_Mode_Poll || resolved_watch_mode == Watch_Mode_Xevent)
-                 ? dw_watch_display_connections
-                 : dw_watch_displays_udev;
-
-      DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE, "Calling g_thread_new()...");
-      watch_thread = g_thread_new(
-                       "watch_displays",             // optional thread name
-                       watch_thread_func,
-                       wdd);
+      Broker_Role role = (watch_broker_enabled) ? dw_broker_start(event_classes) : Broker_Role_None;
+      if (role == Broker_Role_Subscriber) {
+         broker_subscribed = true;
+         MSG_W_SYSLOG(DDCA_SYSLOG_NOTICE,
+               "Receiving display connection changes from the watch broker process");
+      }
+      else {
+         start_watch_threads(event_classes);
+      }
       active_watch_displays_classes = event_classes;
-      DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE, "Started watch_thread = %p", watch_thread);
-      SYSLOG2(DDCA_SYSLOG_NOTICE, "libddcutil watch thread %p started", watch_thread);
    }
    g_mutex_unlock(&watch_thread_mutex);
 
@@ -269,6 +311,25 @@ bye:
 }
 
 
+/** Called by the broker thread when the watch broker process has gone
+ *  away and this process has become the broker, or cannot subscribe to
+ *  the replacement broker.  Starts this process's own watch threads.
+ */
+void dw_take_over_watching() {
+   bool debug = false;
+   DBGTRC_STARTING(debug, TRACE_GROUP, "broker_subscribed=%s", sbool(broker_subscribed));
+
+   g_mutex_lock(&watch_thread_mutex);
+   if (broker_subscribed && !watch_thread) {
+      broker_subscribed = false;
+      start_watch_threads(active_watch_displays_classes);
+   }
+   g_mutex_unlock(&watch_thread_mutex);
+
+   DBGTRC_DONE(debug, TRACE_GROUP, "watch_thread=%p", watch_thread);
+}
+
+
 /** Halts threads that watch for changes in display connection status.
  *
  *  @param   wait                if true, does not return until the watch thread exits,
@@ -289,9 +350,18 @@ dw_stop_watch_displays(bool wait, DDCA_Display_Event_Class* enabled_classes_loc)
    if (enabled_classes_loc)
       *enabled_classes_loc = DDCA_EVENT_CLASS_NONE;
 
+   // Not under watch_thread_mutex, since the broker thread may be taking over watching
+   dw_broker_stop();
+
    g_mutex_lock(&watch_thread_mutex);
 
-   if (watch_thread) {
+   if (broker_subscribed) {
+      broker_subscribed = false;
+      if (enabled_classes_loc)
+         *enabled_classes_loc = active_watch_displays_classes;
+      SYSLOG2(DDCA_SYSLOG_NOTICE, "Unsubscribed from watch broker.");
+   }
+   else if (watch_thread) {
       DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE, "resolved_watch_mode = %s",
                                             watch_mode_name(global_wdd->watch_mode));
 #ifdef USE_X11
@@ -301,15 +371,16 @@ dw_stop_watch_displays(bool wait, DDCA_Display_Event_Class* enabled_classes_loc)
             SLEEP_MILLIS_WITH_SYSLOG(2*1000, "After ddc_send_x11_termination_message()");
          }
          else {
-            terminate_watch_thread = true;
+            dw_request_terminate_watch();
          }
       }
       else {
-         terminate_watch_thread = true;  // signal watch thread to terminate
+         dw_request_terminate_watch();  // signal watch thread to terminate
       }
 #else
-      terminate_watch_thread = true;
+      dw_request_terminate_watch();
 #endif
+      dw_wake_recheck_thread();     // recheck thread may be blocked waiting for work
 
       // DBGTRC_NOPREFIX(debug, TRACE_GROUP, "Waiting %d millisec for watch thread to terminate...", 4000);
       // usleep(4000*1000);  // greater than the sleep in watch_displays_using_poll()
@@ -339,7 +410,7 @@ dw_stop_watch_displays(bool wait, DDCA_Display_Event_Class* enabled_classes_loc)
 
 
 bool dw_is_watch_displays_executing() {
-   return watch_thread;
+   return watch_thread || broker_subscribed;
 }
 
 
@@ -357,7 +428,7 @@ dw_get_active_watch_classes(DDCA_Display_Event_Class * classes_loc) {
    DDCA_Status ddcrc = DDCRC_INVALID_OPERATION;
    *classes_loc = DDCA_EVENT_CLASS_NONE;
    g_mutex_lock(&watch_thread_mutex);
-   if (watch_thread) {
+   if (watch_thread || broker_subscribed) {
       *classes_loc = active_watch_displays_classes;
       ddcrc = DDCRC_OK;
    }
@@ -404,6 +475,7 @@ dw_redetect_displays() {
    g_mutex_lock(&all_display_refs_mutex);
    all_display_refs = ddc_detect_all_displays(&display_open_errors);
    g_mutex_unlock(&all_display_refs_mutex);
+   ddc_mark_display_set_changed();
    if (debug) {
       ddc_dbgrpt_drefs("all_displays:", all_display_refs, 1);
    }
@@ -450,7 +522,9 @@ DDCA_Status dw_set_display_watch_settings(DDCA_DW_Settings * settings) {
 
 
 void init_dw_main() {
+   RTTI_ADD_FUNC(start_watch_threads);
    RTTI_ADD_FUNC(dw_start_watch_displays);
+   RTTI_ADD_FUNC(dw_take_over_watching);
    RTTI_ADD_FUNC(dw_stop_watch_displays);
    RTTI_ADD_FUNC(dw_get_active_watch_classes);
 #ifdef USE_X11
@@ -19,6 +19,7 @@ extern bool            enable_watch_displays;
 
 Error_Info * dw_start_watch_displays(DDCA_Display_Event_Class event_classes);
 DDCA_Status  dw_stop_watch_displays(bool wait, DDCA_Display_Event_Class* enabled_classes);
+void         dw_take_over_watching();
 DDCA_Status  dw_get_active_watch_classes(DDCA_Display_Event_Class * classes_loc);
 void         dw_redetect_displays();
 bool         dw_is_watch_displays_executing();
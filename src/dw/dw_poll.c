@@ -96,7 +96,8 @@ STATIC void process_screen_change_event(
    BS256 bs_old_buses_w_edid   = *p_bs_buses_w_edid;
 
    Bit_Set_256 bs_new_attached_buses = i2c_detect_attached_buses_as_bitset();
-   Bit_Set_256 bs_new_buses_w_edid   = i2c_filter_buses_w_edid_as_bitset(bs_new_attached_buses);
+   // full EDID checks only for buses whose sysfs connector state changed
+   Bit_Set_256 bs_new_buses_w_edid   = dw_buses_w_edid_by_fingerprint(bs_new_attached_buses);
 
    Bit_Set_256 bs_added_buses_w_edid     = bs256_and_not(bs_new_buses_w_edid, bs_old_buses_w_edid);
    Bit_Set_256 bs_removed_buses_w_edid   = bs256_and_not(bs_old_buses_w_edid, bs_new_buses_w_edid);
@@ -279,6 +280,7 @@ gpointer dw_watch_display_connections(gpointer data) {
       if (terminate_watch_thread)
          continue;
       dw_terminate_if_invalid_thread_or_process(cur_pid, cur_tid);
+      dw_count_watch_wakeup(wdd->watch_mode);
 
 #ifdef USE_X11
       if (wdd->watch_mode == Watch_Mode_Xevent) {
@@ -4,7 +4,7 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 
 #include <glib-2.0/glib.h>
-
+#include <inttypes.h>
 
 #include "public/ddcutil_types.h"
 
@@ -13,8 +13,10 @@
 
 #include "base/core.h"
 #include "base/displays.h"
+#include "base/parms.h"
 #include "base/rtti.h"
 #include "base/sleep.h"
+#include "base/worker_pool.h"
 
 #include "ddc/ddc_displays.h"
 
@@ -57,10 +59,17 @@ emit_recheck_debug_msg(
 }
 
 
+/** Interval between successive rechecks of a display ref */
+#define RECHECK_INTERVAL_MILLIS 200
+/** Rechecking of a display ref ceases after this many milliseconds */
+#define RECHECK_MAX_MILLIS     3000
+
+
 typedef struct {
    Display_Ref*  dref;
-   uint64_t      initial_ts_nanos;
-   int           sleepctr;
+   uint64_t      initial_ts_nanos;   // monotonic
+   uint64_t      due_nanos;          // monotonic time of next recheck
+   int           sleepctr;           // number of rechecks performed
 } Recheck_Queue_Entry;
 
 
@@ -69,13 +78,19 @@ void dw_free_recheck_queue_entry(Recheck_Queue_Entry * entry) {
 }
 
 GAsyncQueue *  recheck_queue = NULL;
-GMutex *  recheck_queue_mutex = NULL;
 
+// Pushed onto the recheck queue to wake the recheck thread for termination
+static Recheck_Queue_Entry recheck_wakeup_entry;
+
+
+#ifdef OLD
+GMutex *  recheck_queue_mutex = NULL;
 
 GAsyncQueue * init_recheck_queue() {
    recheck_queue = g_async_queue_new();
    return recheck_queue;
 }
+#endif
 
 
 void dw_put_recheck_queue(Display_Ref* dref) {
@@ -84,17 +99,126 @@ void dw_put_recheck_queue(Display_Ref* dref) {
 
    Recheck_Queue_Entry * entry = calloc(1, sizeof(Recheck_Queue_Entry));
    entry->dref = dref;
-   entry->initial_ts_nanos = cur_realtime_nanosec();
+   entry->initial_ts_nanos = cur_monotonic_nanosec();
+   entry->due_nanos = entry->initial_ts_nanos + MILLIS2NANOS(RECHECK_INTERVAL_MILLIS);
    entry->sleepctr = 0;
 
-   // g_mutex_lock(recheck_queue_mutex);
    g_async_queue_push(recheck_queue, entry);
-   // g_mutex_unlock(recheck_queue_mutex);
 
    DBGTRC_DONE(debug, DDCA_TRC_CONN, "");
 }
 
 
+/** Wakes the recheck thread if it is blocked waiting for work, so that
+ *  it notices a termination request.
+ */
+void dw_wake_recheck_thread() {
+   g_async_queue_push(recheck_queue, &recheck_wakeup_entry);
+}
+
+
+//
+// Min-heap of Recheck_Queue_Entry, ordered by due time
+//
+
+static inline bool
+recheck_heap_less(GPtrArray * heap, guint ndx1, guint ndx2) {
+   Recheck_Queue_Entry * e1 = g_ptr_array_index(heap, ndx1);
+   Recheck_Queue_Entry * e2 = g_ptr_array_index(heap, ndx2);
+   return e1->due_nanos < e2->due_nanos;
+}
+
+
+static inline void
+recheck_heap_swap(GPtrArray * heap, guint ndx1, guint ndx2) {
+   gpointer temp = heap->pdata[ndx1];
+   heap->pdata[ndx1] = heap->pdata[ndx2];
+   heap->pdata[ndx2] = temp;
+}
+
+
+static void
+recheck_heap_push(GPtrArray * heap, Recheck_Queue_Entry * rqe) {
+   g_ptr_array_add(heap, rqe);
+   guint ndx = heap->len - 1;
+   while (ndx > 0) {
+      guint parent = (ndx - 1) / 2;
+      if (!recheck_heap_less(heap, ndx, parent))
+         break;
+      recheck_heap_swap(heap, ndx, parent);
+      ndx = parent;
+   }
+}
+
+
+static Recheck_Queue_Entry *
+recheck_heap_peek(GPtrArray * heap) {
+   return (heap->len > 0) ? g_ptr_array_index(heap, 0) : NULL;
+}
+
+
+static Recheck_Queue_Entry *
+recheck_heap_pop(GPtrArray * heap) {
+   if (heap->len == 0)
+      return NULL;
+   Recheck_Queue_Entry * result = g_ptr_array_index(heap, 0);
+   recheck_heap_swap(heap, 0, heap->len - 1);
+   g_ptr_array_set_size(heap, heap->len - 1);
+   guint ndx = 0;
+   while (true) {
+      guint smallest = ndx;
+      guint left  = 2*ndx + 1;
+      guint right = 2*ndx + 2;
+      if (left < heap->len && recheck_heap_less(heap, left, smallest))
+         smallest = left;
+      if (right < heap->len && recheck_heap_less(heap, right, smallest))
+         smallest = right;
+      if (smallest == ndx)
+         break;
+      recheck_heap_swap(heap, ndx, smallest);
+      ndx = smallest;
+   }
+   return result;
+}
+
+
+/** Waits until either a new recheck request arrives or the earliest
+ *  scheduled recheck is due, then moves all newly queued requests
+ *  to the heap.  Blocks indefinitely if nothing is scheduled.
+ */
+static void
+wait_for_recheck_work(GPtrArray * heap) {
+   Recheck_Queue_Entry * next = recheck_heap_peek(heap);
+   Recheck_Queue_Entry * rqe  = NULL;
+   if (!next) {
+      rqe = g_async_queue_pop(recheck_queue);
+   }
+   else {
+      uint64_t now = cur_monotonic_nanosec();
+      if (next->due_nanos > now)
+         rqe = g_async_queue_timeout_pop(recheck_queue, NANOS2MICROS(next->due_nanos - now));
+      else
+         rqe = g_async_queue_try_pop(recheck_queue);
+   }
+   while (rqe) {
+      if (rqe != &recheck_wakeup_entry)
+         recheck_heap_push(heap, rqe);
+      rqe = g_async_queue_try_pop(recheck_queue);
+   }
+}
+
+
+/** Worker pool task that rechecks a single display ref.
+ *
+ *  @param  data  #Display_Ref
+ *  @return #Error_Info returned by #dw_recheck_dref(), NULL if ok
+ */
+STATIC void *
+threaded_recheck_dref(void * data) {
+   return dw_recheck_dref((Display_Ref *) data);
+}
+
+
 #ifdef NO
 typedef struct {
    GArray *    deferred_event_queue;
@@ -109,139 +233,134 @@ typedef struct {
  *
  *  @param   data  pointer to a #Recheck_Displays_Data struct
  *
- *  At increasing time intervals, each display ref is checked to see if DDC
- *  communication is working.  If so, a #DDC_Display_Status event of type
- *  #DDCA_EVENT_DDC_ENABLED is emitted, and the display ref is removed from
- *  from the array.
- *
- *  The time intervals are calculated as follows. The intervals are numbered
- *  from 0. The base interval is global variable #retry_thread_sleep_factor_millis.
- *  An adjustment factor is calculated as 2**i, where i is the interval number,
- *  i.e. 1, 2, 4, 8 etc.
+ *  Each display ref is rechecked every #RECHECK_INTERVAL_MILLIS milliseconds,
+ *  measured from its own prior check, until DDC communication works, the
+ *  display is disconnected, or #RECHECK_MAX_MILLIS have elapsed since the
+ *  display ref was queued.  If communication works, a #DDC_Display_Status
+ *  event of type #DDCA_EVENT_DDC_ENABLED is emitted.
  *
- *  The thread terminates when either all display refs have been removed from
- *  the array because communication has succeeded, or because the maximum of
- *  sleep intervals have occurred, i.e. until a total of
- *  (1+2+4+8)*retry_thread_sleep_factor_millis milliseconds have been slept.
+ *  Pending rechecks are kept in a min-heap ordered by due time.  The thread
+ *  blocks on the recheck queue until a new request arrives or the earliest
+ *  recheck is due, so it consumes no CPU while there is nothing to do.  All
+ *  display refs that are due at the same time are rechecked in parallel
+ *  using the worker pool.
  *
- *  On termination the **displays to recheck** array is freed.  Note that the
- *  display references themselves are not; display references are persistent.
+ *  Note that the display references themselves are not freed; display
+ *  references are persistent.
  */
 gpointer dw_recheck_displays_func(gpointer data) {
    bool debug = false;
    DBGTRC_STARTING(debug, TRACE_GROUP, "data=%p", data);
    Recheck_Displays_Data*  rdd = (Recheck_Displays_Data *) data;
-   init_recheck_queue();
-   // recheck_thread_active = true;
-
-   // GPtrArray * displays_to_recheck = g_ptr_array_new();
-#ifdef DEBUG
-   for (int ndx = 0; ndx < displays_to_recheck->len; ndx++) {
-      Display_Ref * dref = g_ptr_array_index(displays_to_recheck, ndx);
-      DBGMSG("dref=%s", dref_reprx_t(dref));
-   }
-#endif
-
-   GQueue * to_check_again = g_queue_new();
 
-   int sleep_interval_millis = 200;    // temp
-   int max_sleep_time_millis = 3000;
-   int pop_interval_millis   = 100;
+   GPtrArray * heap = g_ptr_array_new();    // min-heap of Recheck_Queue_Entry
 
    while (!terminate_watch_thread) {
-      SLEEP_MILLIS_WITH_SYSLOG(sleep_interval_millis, "Recheck interval");   // move to end of loop
-      uint64_t cur_time_nanos = cur_realtime_nanosec();
-
-      Recheck_Queue_Entry* rqe = NULL;
-      while (!rqe && !terminate_watch_thread) {
-         while (g_queue_get_length(to_check_again) > 0) {
-            rqe = g_queue_pop_head(to_check_again);
-            g_async_queue_push_front(recheck_queue, rqe);
-         }
-         uint64_t pop_interval_micros = MILLIS2MICROS(pop_interval_millis);
-         rqe = g_async_queue_timeout_pop(recheck_queue, pop_interval_micros);
-         if (terminate_watch_thread) {
-            continue;
-         }
-      }
+      wait_for_recheck_work(heap);
       if (terminate_watch_thread) {
          DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE, "terminating recheck thread execution");
          break;
       }
 
-      if (cur_time_nanos > rqe->initial_ts_nanos + MILLIS2NANOS(max_sleep_time_millis)) {
-         emit_recheck_debug_msg(debug, DDCA_SYSLOG_NOTICE,
-               "ddc did not become enabled for %s after %d milliseconds",
-                dref_reprx_t(rqe->dref), max_sleep_time_millis);
-         dw_free_recheck_queue_entry(rqe);
+      // Collect all entries that are due, so that displays on different buses
+      // are rechecked in parallel using the worker pool
+      uint64_t cur_time_nanos = cur_monotonic_nanosec();
+      GPtrArray * entries = g_ptr_array_new();
+      while (recheck_heap_peek(heap) && recheck_heap_peek(heap)->due_nanos <= cur_time_nanos)
+         g_ptr_array_add(entries, recheck_heap_pop(heap));
+      if (entries->len == 0) {
+         g_ptr_array_free(entries, true);
          continue;
       }
 
-      Display_Ref * dref = rqe->dref;
-      // DBGMSG("   rechecking %s", dref_repr_t(dref));
-      Error_Info * err = dw_recheck_dref(dref);    // <===
-      DBGTRC_NOPREFIX(false, DDCA_TRC_NONE, "after dw_recheck_dref(), dref->flags=%s",
-            interpret_dref_flags_t(dref->flags));
-      // dbgrpt_display_ref(dref,false,2);
-      if (!err) {
-         emit_recheck_debug_msg(debug, DDCA_SYSLOG_NOTICE,
-             "ddc became enabled for %s after %ld milliseconds",
-              dref_reprx_t(dref), NANOS2MILLIS(cur_realtime_nanosec() - rqe->initial_ts_nanos));
-         dref->dispno = ++dispno_max;
-
-         DBGTRC_NOPREFIX(false, DDCA_TRC_NONE, "locking process_event_mutex");
-         g_mutex_lock(&process_event_mutex);
-         dw_emit_or_queue_display_status_event(
-               DDCA_EVENT_DDC_ENABLED,
-               dref->drm_connector,
-               dref,
-               dref->io_path,
-               NULL);    //  deferred_event_queue);
-         g_mutex_unlock(&process_event_mutex);
-         DBGTRC_NOPREFIX(false, DDCA_TRC_NONE, "unlocked process_event_mutex");
-         dw_free_recheck_queue_entry(rqe);
+      Worker_Batch * batch = wp_new_batch("recheck displays");
+      for (int ndx = 0; ndx < entries->len; ndx++) {
+         Recheck_Queue_Entry * rqe = g_ptr_array_index(entries, ndx);
+         wp_batch_add(batch, threaded_recheck_dref, rqe->dref);
       }
-      else {
-         if (err->status_code == DDCRC_DISCONNECTED) {
+      GPtrArray * errors = wp_batch_wait(batch);
+
+      uint64_t done_nanos = cur_monotonic_nanosec();
+      for (int ndx = 0; ndx < entries->len; ndx++) {
+         Recheck_Queue_Entry * rqe = g_ptr_array_index(entries, ndx);
+         Display_Ref * dref = rqe->dref;
+         Error_Info * err = g_ptr_array_index(errors, ndx);
+         rqe->sleepctr++;
+         uint64_t elapsed_millis = NANOS2MILLIS(done_nanos - rqe->initial_ts_nanos);
+         DBGTRC_NOPREFIX(false, DDCA_TRC_NONE, "after dw_recheck_dref(), dref->flags=%s",
+               interpret_dref_flags_t(dref->flags));
+         if (!err) {
             emit_recheck_debug_msg(debug, DDCA_SYSLOG_NOTICE,
-                "Display %s no longer detected after %"PRIu64" milliseconds",
-                dref_reprx_t(dref),
-                NANOS2MILLIS(cur_time_nanos - rqe->initial_ts_nanos));
-
-            dref->dispno = DISPNO_REMOVED;
-             dw_emit_or_queue_display_status_event(
-                   DDCA_EVENT_DISPLAY_DISCONNECTED,
-                   dref->drm_connector,
-                   dref,
-                   dref->io_path,
-                   NULL);   //                    rdd->deferred_event_queue);
-             dw_free_recheck_queue_entry(rqe);
+                "ddc became enabled for %s after %"PRIu64" milliseconds",
+                 dref_reprx_t(dref), elapsed_millis);
+            dref->dispno = ++dispno_max;
+
+            DBGTRC_NOPREFIX(false, DDCA_TRC_NONE, "locking process_event_mutex");
+            g_mutex_lock(&process_event_mutex);
+            dw_emit_or_queue_display_status_event(
+                  DDCA_EVENT_DDC_ENABLED,
+                  dref->drm_connector,
+                  dref,
+                  dref->io_path,
+                  NULL);    //  deferred_event_queue);
+            g_mutex_unlock(&process_event_mutex);
+            DBGTRC_NOPREFIX(false, DDCA_TRC_NONE, "unlocked process_event_mutex");
+            dw_free_recheck_queue_entry(rqe);
          }
          else {
-            DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE,
-                   "ddc still not enabled for %s after %d milliseconds, retrying ...",
-                   dref_reprx_t(rqe->dref), sleep_interval_millis);
-            g_queue_push_head(to_check_again, rqe);
+            if (err->status_code == DDCRC_DISCONNECTED) {
+               emit_recheck_debug_msg(debug, DDCA_SYSLOG_NOTICE,
+                   "Display %s no longer detected after %"PRIu64" milliseconds",
+                   dref_reprx_t(dref), elapsed_millis);
+
+               dref->dispno = DISPNO_REMOVED;
+                dw_emit_or_queue_display_status_event(
+                      DDCA_EVENT_DISPLAY_DISCONNECTED,
+                      dref->drm_connector,
+                      dref,
+                      dref->io_path,
+                      NULL);   //                    rdd->deferred_event_queue);
+                dw_free_recheck_queue_entry(rqe);
+            }
+            else if (elapsed_millis + RECHECK_INTERVAL_MILLIS > RECHECK_MAX_MILLIS) {
+               emit_recheck_debug_msg(debug, DDCA_SYSLOG_NOTICE,
+                     "ddc did not become enabled for %s after %"PRIu64" milliseconds, %d checks",
+                      dref_reprx_t(dref), elapsed_millis, rqe->sleepctr);
+               dw_free_recheck_queue_entry(rqe);
+            }
+            else {
+               DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE,
+                      "ddc still not enabled for %s after %"PRIu64" milliseconds, retrying ...",
+                      dref_reprx_t(rqe->dref), elapsed_millis);
+               rqe->due_nanos = done_nanos + MILLIS2NANOS(RECHECK_INTERVAL_MILLIS);
+               recheck_heap_push(heap, rqe);
+            }
+            ERRINFO_FREE_WITH_REPORT(err, IS_DBGTRC(debug, DDCA_TRC_NONE) ||  is_report_ddc_errors_enabled() );
          }
-         ERRINFO_FREE_WITH_REPORT(err, IS_DBGTRC(debug, DDCA_TRC_NONE) ||  is_report_ddc_errors_enabled() );
       }
+      g_ptr_array_free(errors, true);
+      g_ptr_array_free(entries, true);
    }
 
    if (terminate_watch_thread) {
       char * s = "recheck thread terminating because watch thread terminated";
       DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE, "%s", s);
       SYSLOG2(DDCA_SYSLOG_NOTICE, "%s", s);
+   }
 
-      // free what's left on the queue
-      while (true) {
-         Recheck_Queue_Entry * rqe = g_async_queue_timeout_pop(recheck_queue, 0);
-         if (!rqe)
-            break;
-         emit_recheck_debug_msg(debug, DDCA_SYSLOG_ERROR,
-               "Flushing request queue entry for %s ",
-                  dref_reprx_t(rqe->dref));
-      }
+   // free what's left on the queue and in the heap
+   Recheck_Queue_Entry * rqe = NULL;
+   while ( (rqe = g_async_queue_try_pop(recheck_queue)) ) {
+      if (rqe != &recheck_wakeup_entry)
+         recheck_heap_push(heap, rqe);
+   }
+   while ( (rqe = recheck_heap_pop(heap)) ) {
+      emit_recheck_debug_msg(debug, DDCA_SYSLOG_ERROR,
+            "Flushing request queue entry for %s ",
+               dref_reprx_t(rqe->dref));
+      dw_free_recheck_queue_entry(rqe);
    }
+   g_ptr_array_free(heap, true);
 
    free(rdd);
    DBGTRC_DONE(debug, TRACE_GROUP, "terminating recheck thread");
@@ -253,6 +372,8 @@ gpointer dw_recheck_displays_func(gpointer data) {
 
 
 void init_dw_recheck() {
+   if (!recheck_queue)
+      recheck_queue = g_async_queue_new();
    RTTI_ADD_FUNC(dw_recheck_displays_func);
 }
 
@@ -9,6 +9,7 @@
 #include <glib-2.0/glib.h>
 
 void     dw_put_recheck_queue(Display_Ref* dref);
+void     dw_wake_recheck_thread();
 gpointer dw_recheck_displays_func(gpointer data);
 
 void     init_dw_recheck();
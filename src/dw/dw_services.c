@@ -8,13 +8,21 @@
 
 #include "config.h"
 
+#include "dw/dw_broker.h"
+#include "dw/dw_callback_executor.h"
 #include "dw/dw_common.h"
+#include "dw/dw_debounce.h"
 #include "dw/dw_dref.h"
+#include "dw/dw_event_ring.h"
+#ifdef USE_LIBDRM
+#include "dw/dw_drm.h"
+#endif
 #include "dw/dw_main.h"
 #include "dw/dw_poll.h"
 #include "dw/dw_recheck.h"
 #include "dw/dw_status_events.h"
 #include "dw/dw_udev.h"
+#include "dw/dw_vcp_monitor.h"
 #ifdef USE_X11
 #include "dw/dw_xevent.h"
 #endif
@@ -27,13 +35,21 @@ void init_dw_services() {
    bool debug = false;
    DBGMSF(debug, "Starting");
 
+   init_dw_broker();
+   init_dw_callback_executor();
    init_dw_common();
+   init_dw_debounce();
    init_dw_dref();
+   init_dw_event_ring();
+#ifdef USE_LIBDRM
+   init_dw_drm();
+#endif
    init_dw_main();
    init_dw_poll();
    init_dw_recheck();
    init_dw_status_events();
    init_dw_udev();
+   init_dw_vcp_monitor();
 #ifdef USE_X11
    init_dw_xevent();
 #endif
@@ -47,5 +63,10 @@ void terminate_dw_services() {
    bool debug = false;
    DBGTRC_STARTING(debug, DDCA_TRC_CONN, "");
 
+   terminate_dw_vcp_monitor();
+   terminate_dw_callback_executor();
+   terminate_dw_event_ring();
+   terminate_dw_common();
+
    DBGTRC_DONE(debug, DDCA_TRC_CONN, "");
 }
@@ -23,9 +23,15 @@
 #include "sysfs/sysfs_sys_drm_connector.h"
 
 #include "ddc/ddc_display_ref_reports.h"
+#include "ddc/ddc_displays.h"
 #include "ddc/ddc_packet_io.h"
 
+#ifdef ENABLE_UDEV
+#include "dw_broker.h"
+#endif
+#include "dw_callback_executor.h"
 #include "dw_common.h"
+#include "dw_event_ring.h"
 
 #include "dw_status_events.h"
 
@@ -148,9 +154,10 @@ free_callback_queue_entry(Callback_Queue_Entry* q) {
 }
 
 
-/** Function that runs in a thread to invoke a single user callback function
+/** Invokes a single user callback function.  Executes in a
+ *  callback executor thread.
  *
- *  @param  data  Callback_Displays_Data struct
+ *  @param  data  #Callback_Queue_Entry, freed on completion
  *  @return NULL
  */
 gpointer dw_execute_callback_func(gpointer data) {
@@ -186,7 +193,7 @@ gpointer dw_execute_callback_func(gpointer data) {
    DBGTRC_DONE(debug, TRACE_GROUP, "%s", buf);
    SYSLOG2(DDCA_SYSLOG_NOTICE, "%s", buf);
    free(buf);
-   return NULL;   // terminates thread
+   return NULL;
 }
 
 
@@ -269,13 +276,24 @@ const char * dw_display_event_type_name(DDCA_Display_Event_Type event_type) {
    case DDCA_EVENT_DPMS_AWAKE:           result = "DDCA_EVENT_DPMS_AWAKE";           break;
    case DDCA_EVENT_DPMS_ASLEEP:          result = "DDCA_EVENT_DPMS_ASLEEP";          break;
    case DDCA_EVENT_DDC_ENABLED:          result = "DDCA_EVENT_DDC_ENABLED";          break;
-   case DDCA_EVENT_UNUSED2:              result = "DDCA_EVENT_UNUSED2";              break;
+   case DDCA_EVENT_VCP_VALUE_CHANGED:    result = "DDCA_EVENT_VCP_VALUE_CHANGED";    break;
    }
    return result;
 }
 
 
 char * display_status_event_repr(DDCA_Display_Status_Event evt) {
+   if (evt.event_type == DDCA_EVENT_VCP_VALUE_CHANGED) {
+      return g_strdup_printf(
+         "DDCA_Display_Status_Event[%s:  %s, %s, dref: %s, io_path:/dev/i2c-%d, feature: 0x%02x, value: 0x%04x]",
+         formatted_time_t(evt.timestamp_nanos),
+         dw_display_event_type_name(evt.event_type),
+                                     evt.connector_name,
+                                     ddci_dref_repr_t(evt.dref),
+                                     evt.io_path.path.i2c_busno,
+                                     evt.vcp_feature_code,
+                                     evt.vcp_value);
+   }
    char * s = g_strdup_printf(
       "DDCA_Display_Status_Event[%s:  %s, %s, dref: %s, io_path:/dev/i2c-%d, ddc working: %s]",
       formatted_time_t(evt.timestamp_nanos),   // will this clobber a wrapping DBGTRC?
@@ -346,6 +364,8 @@ void dw_emit_display_status_record(
    bool debug = false;
    DBGTRC_STARTING(debug, TRACE_GROUP, "evt=%s", display_status_event_repr_t(evt));
    SYSLOG2(DDCA_SYSLOG_NOTICE, "Emitting %s",  display_status_event_repr_t(evt));
+   if (evt.event_type != DDCA_EVENT_VCP_VALUE_CHANGED)
+      ddc_mark_display_set_changed();
 
    // DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE, "evet->dref -> ", dref_reprx_t(evt->dref));
    Display_Ref * dref0 = dref_from_published_ddca_dref(evt.dref);
@@ -387,6 +407,16 @@ void dw_emit_display_status_record(
 #endif
 
    int callback_ct = (display_detection_callbacks) ? display_detection_callbacks->len : 0;
+   for (int ndx = 0; ndx < callback_ct; ndx++)
+      dw_submit_display_status_callback(g_ptr_array_index(display_detection_callbacks, ndx), evt);
+   dw_put_event_ring(evt);
+#ifdef ENABLE_UDEV
+   dw_broker_publish(evt);
+#endif
+
+   DBGTRC_DONE(debug, TRACE_GROUP, "Submitted %d event callback(s)", callback_ct);
+
+#ifdef OLD
    if (callback_ct > 0) {
       DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE, "Starting %d callback threads", display_detection_callbacks->len);
       SYSLOG2(DDCA_SYSLOG_NOTICE, "Starting %d callback threads", display_detection_callbacks->len);
@@ -408,6 +438,7 @@ void dw_emit_display_status_record(
 
    SYSLOG2(DDCA_SYSLOG_NOTICE, "Started %d event callback thread(s)", callback_ct);
    DBGTRC_DONE(debug, TRACE_GROUP, "Started %d event callback thread(s)", callback_ct);
+#endif
 }
 
 
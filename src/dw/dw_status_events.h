@@ -16,6 +16,7 @@
 typedef struct {
    DDCA_Display_Status_Callback_Func func;
    DDCA_Display_Status_Event         event;
+   uint64_t                          queued_nanos;   // monotonic
 } Callback_Queue_Entry;
 
 gpointer dw_execute_callback_func(gpointer data);
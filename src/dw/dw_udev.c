@@ -20,7 +20,9 @@
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/epoll.h>
 #include <sys/stat.h>
+#include <sys/timerfd.h>
 #include <unistd.h>
 
 #include "util/coredefs.h"
@@ -59,6 +61,7 @@
 #include "ddc/ddc_vcp.h"
 
 #include "dw_common.h"
+#include "dw_debounce.h"
 #include "dw_status_events.h"
 
 #include "dw/dw_udev.h"
@@ -117,6 +120,8 @@ void dbgrpt_udev_device(struct udev_device * dev, bool verbose, int depth) {
 // Variant using udev 
 //
 
+#ifdef OLD
+// Replaced by per-connector debouncing in dw_debounce.c
 
 /** Repeatedly reads the edid attibute from the sysfs drm connector dir
  *  whose name has the specfied value.  The value is repeatedly read
@@ -155,7 +160,7 @@ dw_i2c_stabilized_single_bus_by_connector_name(char * drm_connector_name, bool p
       // usleep(1000*stabilization_poll_millisec);
       SLEEP_MILLIS_WITH_SYSLOG(stabilization_poll_millisec, "Stabilization loop");
 
-      char * s = g_strdup_printf("/sys/class/drm/%s/edid", drm_connector_name);
+      char * s = g_strdup_printf("%s/%s/edid", sysfs_class_drm, drm_connector_name);
       // DBGF(debug, "reading: %s", s);
       GByteArray* bytes = read_binary_file(s, 2048, true);
       // DBGF(debug, "bytes read: %d", bytes->len);
@@ -357,6 +362,7 @@ Bit_Set_256 dw_i2c_check_bus_changes_for_connector(
    DBGTRC_DONE(debug, TRACE_GROUP, "Returning Bit_Set_256: %s", BS256_REPR(bs_new_buses_w_edid));
    return bs_new_buses_w_edid;
 }
+#endif
 
 
 #ifdef BAD
@@ -448,13 +454,185 @@ void debug_watch_state(int connector_number, char * cname) {
 }
 
 
+/** State of the udev watch loop that persists across events */
+typedef struct {
+   Bit_Set_256  bs_cur_buses_w_edid;
+   Bit_Set_256  bs_sleepy_buses;
+   time_t       last_drm_change_timestamp;
+   GArray *     deferred_events;
+   Dw_Debouncer * debouncer;
+   bool         watch_dpms;
+   bool         debug_sysfs_state;
+} Udev_Watch_State;
+
+
+/** Processes a single udev event.
+ *
+ *  @param  dev    udev device describing the event
+ *  @param  state  watch loop state, updated
+ */
+static void
+dw_process_udev_event(struct udev_device * dev, Udev_Watch_State * state) {
+   bool debug = false;
+   DBGTRC_STARTING(debug, TRACE_GROUP, "dev=%p", dev);
+
+   Udev_Event_Detail * cd = collect_udev_event_detail(dev);
+   assert(cd);      // mollify coverity scan
+    if (IS_DBGTRC(debug || report_udev_events, DDCA_TRC_NONE))
+      dbgrpt_udev_event_detail(cd, 2);
+    // xxx("Event received");
+
+   if (!streq(cd->prop_subsystem, "i2c-dev") &&  !streq(cd->prop_subsystem, "drm")) {
+      DBGMSG("Unexpected subsystem: %s", cd->prop_subsystem);
+   }
+
+   else if (  streq(cd->prop_subsystem, "i2c-dev") && streq(cd->prop_action, "add") ) {
+      // const char * sysname = cd->sysname;     // e.g i2c-27
+      // const char * attr_name = cd->attr_name;
+      int busno = i2c_name_to_busno(cd->sysname);
+      if (busno < 0) {
+         MSG_W_SYSLOG(DDCA_SYSLOG_ERROR, "sysname is not i2c-n");
+      }
+      else {
+         I2C_Bus_Info * businfo =  i2c_find_bus_info_in_gptrarray_by_busno(all_i2c_buses, busno);
+         if (businfo) {
+            DBGMSG("Unexpected businfo record %p already exists for bus %d", businfo, busno);
+            // TO DO: check for use in non-removed drefs
+            i2c_reset_bus_info(businfo);
+         }
+         else {
+            businfo = i2c_get_and_check_bus_info(busno);
+         }
+         // Error_Info * err = i2c_check_bus2(businfo);
+         // ERRINFO_FREE_WITH_REPORT(err, debug || IS_TRACING() || report_freed_exceptions);
+         i2c_dbgrpt_bus_info(businfo, /*include_sysinfo*/ true, 0);
+
+      }
+   }
+
+   else if ( streq(cd->prop_subsystem, "drm") &&
+              streq(cd->prop_action,   "add") ) {
+      DBGTRC_NOPREFIX(true, DDCA_TRC_NONE, "Processing subsystem drm, action add");
+      Bit_Set_256  bs_udev_buses =    i2c_detect_attached_buses_as_bitset();
+      Bit_Set_256  bs_known_buses = EMPTY_BIT_SET_256;
+      for (int ndx = 0; ndx < all_i2c_buses->len; ndx++) {
+         I2C_Bus_Info * cur = g_ptr_array_index(all_i2c_buses, ndx);
+         // need to check if valid?
+         bs_known_buses = bs256_insert(bs_known_buses, cur->busno);
+      }
+
+      DBGTRC_NOPREFIX(true, DDCA_TRC_NONE, "udev buses: %s", BS256_REPR(bs_udev_buses));
+      DBGTRC_NOPREFIX(true, DDCA_TRC_NONE, "known_buses: %s", BS256_REPR(bs_known_buses));
+
+      BS256 buses_added = bs256_minus(bs_udev_buses, bs_known_buses);
+      DBGTRC_NOPREFIX(true, DDCA_TRC_NONE, "Buses added: %s", BS256_REPR(buses_added));
+      if (bs256_count(buses_added) > 0) {
+         Bit_Set_256_Iterator iter = bs256_iter_new(buses_added);
+         while (true) {
+            int busno = bs256_iter_next(iter);
+            if (busno < 0)
+               break;
+            I2C_Bus_Info * businfo = i2c_get_and_check_bus_info(busno);
+            // I2C_Bus_Info * businfo = i2c_add_bus(busno);
+            // i2c_check_bus2(businfo);
+            i2c_dbgrpt_bus_info(businfo, /* include_sysinfo */ true, 2);
+            DBGTRC_NOPREFIX(true, DDCA_TRC_NONE, "Adding businfo record for /dev/"I2C"-%d", busno);
+         }
+      }
+   }
+
+   else if ( streq(cd->prop_subsystem,  "drm") &&
+             streq(cd->prop_action,     "change") ) {
+      // xxx("drm change");
+      bool processed = false;
+      time_t prev_change_timestamp = state->last_drm_change_timestamp;
+      state->last_drm_change_timestamp = cur_realtime_nanosec();
+      time_t delta_time = state->last_drm_change_timestamp - prev_change_timestamp;
+      DBGTRC_NOPREFIX(true, DDCA_TRC_NONE, "nanosec since prev drm/change event: %jd", delta_time);
+      if (use_sysfs_connector_id) {
+         char * cname = NULL;
+         int connector_number = -1;
+         if (cd && streq(cd->prop_action, "change")
+                             && cd->prop_connector) {  // seen null when MST hub added
+            bool valid_number = str_to_int(cd->prop_connector, &connector_number, 10);
+            assert(valid_number);
+            cname = get_sys_drm_connector_name_by_connector_id(connector_number);
+            DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE,
+                  "get_sys_drm_connector_name_by_connector_id() returned: %s", cname);
+
+            if (state->debug_sysfs_state) {   // move debug statements out of mainline
+               debug_watch_state(connector_number, cname);
+            }  // debug_sysfs_state
+
+            if (cname) {
+               DBGTRC_NOPREFIX(true, DDCA_TRC_NONE, "1) Using connector id %d, name =%s", connector_number, cname);
+               dw_debounce_connector_event(state->debouncer, cname, state->bs_cur_buses_w_edid);
+               // xxx("drm change case1");
+               processed = true;
+            }
+#ifdef UDEV_I2C_DEV
+            if (!processed) {
+               if (drm_udev_detail &&
+                     (streq(drm_udev_detail->prop_action,"add")||streq(drm_udev_detail->prop_action, "remove") )
+                     && drm_udev_detail->sysname)
+               {
+                  int busno = i2c_name_to_busno(drm_udev_detail->sysname);
+                  cname = get_sys_drm_connector_name_by_busno(busno);
+               }
+               if (cname) {
+                  DBGTRC(true, DDCA_TRC_NONE,
+                        "2) connector name reported by get_sys_drm_connector_name_by_busno(): %s",
+                        cname);
+                  state->bs_cur_buses_w_edid = dw_i2c_check_bus_changes_for_connector(
+                                     connector_number, cname, state->bs_cur_buses_w_edid, state->deferred_events);
+                  processed = true;
+               }
+            }
+            if (!processed) {
+               if (i2c_dev_udev_detail && i2c_dev_udev_detail->sysname
+                   && (streq(drm_udev_detail->prop_action,"add")||streq(drm_udev_detail->prop_action, "remove")) )
+               {
+                  int busno = i2c_name_to_busno(i2c_dev_udev_detail->sysname);
+                  cname = get_sys_drm_connector_name_by_busno(busno);
+               }
+               if (cname) {
+                  DBGTRC_NOPREFIX(true, DDCA_TRC_NONE,
+                        "3) connector name reported by get_sys_drm_connector_name_by_busno(): %s", cname);
+                  state->bs_cur_buses_w_edid = dw_i2c_check_bus_changes_for_connector(
+                                     connector_number, cname, state->bs_cur_buses_w_edid, state->deferred_events);
+                  processed = true;
+               }
+            }
+#endif
+         }
+         free(cname);
+      }
+
+      if (!processed) {
+         DBGTRC_NOPREFIX(true, DDCA_TRC_NONE, "4) Debouncing check of all buses");
+         dw_debounce_rescan_event(state->debouncer, state->bs_cur_buses_w_edid);
+      }
+   } // subsystem drm, action change
+
+   free_udev_event_detail(cd);
+   cd = NULL;
+
+   DBGTRC_DONE(debug, TRACE_GROUP, "");
+}
+
+
 /** Main loop watching for display changes. Runs as thread.
+ *
+ *  The thread blocks in epoll_wait() on a set containing the udev monitor,
+ *  the termination eventfd, a timerfd that is armed only while deferred
+ *  events are pending, and a timerfd that is armed only while a connector
+ *  change is being debounced.  It therefore consumes no CPU while idle, and reacts
+ *  to hotplug events as soon as they are delivered.
  *
  *  @param data   #Watch_Displays_Data passed from creator thread
  */
 gpointer dw_watch_displays_udev(gpointer data) {
    bool debug = false;
-   bool debug_sysfs_state = false;
    bool use_deferred_event_queue = false;
 
    Watch_Displays_Data * wdd = data;
@@ -467,19 +645,15 @@ gpointer dw_watch_displays_udev(gpointer data) {
    DBGTRC_NOPREFIX(debug, TRACE_GROUP, "Watching for dpms events: %s",
           sbool(wdd->event_classes & DDCA_EVENT_CLASS_DPMS));
 
-   bool watch_dpms = wdd->event_classes & DDCA_EVENT_CLASS_DPMS;
+   Udev_Watch_State state = {0};
+   state.watch_dpms = wdd->event_classes & DDCA_EVENT_CLASS_DPMS;
+   state.debug_sysfs_state = false;
+   state.bs_sleepy_buses = EMPTY_BIT_SET_256;
 
    pid_t cur_pid = getpid();
    pid_t cur_tid = get_thread_id();
    DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE, "Our process id: %d, our thread id: %d", cur_pid, cur_tid);
 
-#ifdef NEVER_USED
-   GPtrArray * sleepy_connectors = NULL;
-   if (watch_dpms)
-      sleepy_connectors = g_ptr_array_new_with_free_func(g_free);
-#endif
-   BS256 bs_sleepy_buses = EMPTY_BIT_SET_256;
-
    struct udev* udev = udev_new();
    struct udev_monitor* mon = udev_monitor_new_from_netlink(udev, "udev");
    // Alternative subsystem devtype values that did not detect changes:
@@ -492,16 +666,13 @@ gpointer dw_watch_displays_udev(gpointer data) {
 // #endif
    // udev_monitor_filter_add_match_subsystem_devtype(mon, "i2c", NULL);
    udev_monitor_enable_receiving(mon);
-
-   // make udev_monitor_receive_device() blocking
-   // int fd = udev_monitor_get_fd(mon);
-   // set_fd_blocking(fd);
+   int udev_fd = udev_monitor_get_fd(mon);    // nonblocking
 
    // Sysfs_Connector_Names current_connector_names = get_sysfs_drm_connector_names();
-   Bit_Set_256 bs_cur_buses_w_edid =
+   state.bs_cur_buses_w_edid =
          buses_bitset_from_businfo_array(all_i2c_buses, /*only_connected=*/ true);
    DBGTRC_NOPREFIX(debug, TRACE_GROUP, "Initial i2c buses with edids: %s",
-         BS256_REPR(bs_cur_buses_w_edid));
+         BS256_REPR(state.bs_cur_buses_w_edid));
    if (IS_DBGTRC(debug, DDCA_TRC_NONE)) {
       rpt_vstring(0, "Initial I2C buses:");
       i2c_dbgrpt_buses_summary(1);
@@ -515,253 +686,114 @@ gpointer dw_watch_displays_udev(gpointer data) {
       }
    }
 
-   GArray * deferred_events = NULL;
    if (use_deferred_event_queue)
-      deferred_events = g_array_new( false,      // zero_terminated
-                                     false,       // clear
-                                     sizeof(DDCA_Display_Status_Event));
-   if (debug_sysfs_state) {
+      state.deferred_events = g_array_new( false,      // zero_terminated
+                                           false,       // clear
+                                           sizeof(DDCA_Display_Status_Event));
+   if (state.debug_sysfs_state) {
       rpt_label(0, "Initial sysfs state:");
       dbgrpt_sysfs_basic_connector_attributes(1);
    }
-   ASSERT_IFF(deferred_events, use_deferred_event_queue);
-
-   struct udev_device * dev = NULL;
-   time_t last_drm_change_timestamp = 0;
-   bool skip_next_sleep = false;
-   while (true) {
-      if (wdd->event_classes & DDCA_EVENT_CLASS_DISPLAY_CONNECTION) {
-         dev = udev_monitor_receive_device(mon);
-      }
-      if (dev) {
-         DBGTRC(debug || report_udev_events, DDCA_TRC_NONE, "Udev event received");
-      }
-
-      while (!dev) {
-         uint32_t slept = 0;   // will contain length of final sleep
-         if (deferred_events && deferred_events->len > 0) {
-            dw_emit_deferred_events(deferred_events);
-         }
-         else {     // skip polling loop sleep if deferred events were output
-            if (!skip_next_sleep) {
-               slept = dw_split_sleep(wdd->watch_loop_millisec);
-            }
-         }
-         skip_next_sleep = false;
-
-         if (terminate_watch_thread) {
-            // n. slept == 0 if no sleep was performed
-            DBGTRC_DONE(debug, TRACE_GROUP,
-                  "Terminating thread.  Final polling sleep was %d millisec.", slept);
-           dw_free_watch_displays_data(wdd);
-           //  int rc = udev_monitor_filter_remove(mon);
-           udev_monitor_unref(mon);
-           udev_unref(udev);
-#ifdef WATCH_DPMS
-           if (watch_dpms)
-              g_ptr_array_free(sleepy_connectors, true);
-#endif
-
-            free_current_traced_function_stack();
-            g_thread_exit(0);
-            assert(false);    // avoid clang warning re wdd use after free
-         }
-
-#ifdef WATCH_DPMS
-         if (watch_dpms) {
-            // DBGTRC_NOPREFIX(debug, TRACE_GROUP, "Before ddc_check_bus_asleep(), bs_sleepy_buses: %s",
-            //      BS256_REPR(bs_sleepy_buses));
-            // emits dpms events directly or places them on deferred_events queue
-            bs_sleepy_buses = ddc_i2c_check_bus_asleep(
-                  bs_cur_buses_w_edid, bs_sleepy_buses, deferred_events);
-            // DBGTRC_NOPREFIX(debug, TRACE_GROUP, "After ddc_check_bus_asleep(), bs_sleepy_buses: %s",
-            //       BS256_REPR(bs_sleepy_buses));
-         }
-#endif
-
-         dw_terminate_if_invalid_thread_or_process(cur_pid, cur_tid);
-
-         if (wdd->event_classes & DDCA_EVENT_CLASS_DISPLAY_CONNECTION) {
-            dev = udev_monitor_receive_device(mon);
-         }
-         if (dev) {
-            DBGTRC(debug || report_udev_events, DDCA_TRC_NONE, "Udev event received");
-         }
-      }  // end of udev_monitor_receive_dev() polling loop
-
-      DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE, "==> udev_event received");
-      assert(dev);
-
-#ifdef DEBUGGING
-      // WHICH REPORT TO USE?
-      if (true) {
-         DBGTRC_NOPREFIX(true, DDCA_TRC_NONE, "Got Device\n");
-         dbgrpt_udev_device(dev, /*verbose=*/false, 2);
-      }
-
-      report_udev_device(dev, 3 );
-#endif
-
-      skip_next_sleep = true;
+   ASSERT_IFF(state.deferred_events, use_deferred_event_queue);
 
-      Udev_Event_Detail * cd = collect_udev_event_detail(dev);
-      assert(cd);      // mollify coverity scan
-       if (IS_DBGTRC(debug || report_udev_events, DDCA_TRC_NONE))
-         dbgrpt_udev_event_detail(cd, 2);
-       // xxx("Event received");
+   state.debouncer = dw_new_debouncer(state.deferred_events);
 
-      if (!streq(cd->prop_subsystem, "i2c-dev") &&  !streq(cd->prop_subsystem, "drm")) {
-         DBGMSG("Unexpected subsystem: %s", cd->prop_subsystem);
-      }
-
-      else if (  streq(cd->prop_subsystem, "i2c-dev") && streq(cd->prop_action, "add") ) {
-         // const char * sysname = cd->sysname;     // e.g i2c-27
-         // const char * attr_name = cd->attr_name;
-         int busno = i2c_name_to_busno(cd->sysname);
-         if (busno < 0) {
-            MSG_W_SYSLOG(DDCA_SYSLOG_ERROR, "sysname is not i2c-n");
-         }
-         else {
-            I2C_Bus_Info * businfo =  i2c_find_bus_info_in_gptrarray_by_busno(all_i2c_buses, busno);
-            if (businfo) {
-               DBGMSG("Unexpected businfo record %p already exists for bus %d", businfo, busno);
-               // TO DO: check for use in non-removed drefs
-               i2c_reset_bus_info(businfo);
-            }
-            else {
-               businfo = i2c_get_and_check_bus_info(busno);
-            }
-            // Error_Info * err = i2c_check_bus2(businfo);
-            // ERRINFO_FREE_WITH_REPORT(err, debug || IS_TRACING() || report_freed_exceptions);
-            i2c_dbgrpt_bus_info(businfo, /*include_sysinfo*/ true, 0);
+   int terminate_fd = dw_terminate_watch_fd();
+   int timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+   int debounce_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+   int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+   bool ok = terminate_fd >= 0 && timer_fd >= 0 && debounce_fd >= 0 && epoll_fd >= 0;
+   if (!ok) {
+      SYSLOG2(DDCA_SYSLOG_ERROR, "Unable to create file descriptors for udev watch loop");
+   }
+   else {
+      ok = dw_epoll_add_input_fd(epoll_fd, terminate_fd) &&
+           dw_epoll_add_input_fd(epoll_fd, timer_fd)     &&
+           dw_epoll_add_input_fd(epoll_fd, debounce_fd);
+      if (ok && (wdd->event_classes & DDCA_EVENT_CLASS_DISPLAY_CONNECTION))
+         ok = dw_epoll_add_input_fd(epoll_fd, udev_fd);
+   }
 
-         }
+   bool terminate = !ok;
+   while (!terminate) {
+      struct epoll_event events[4];
+      int ct = epoll_wait(epoll_fd, events, 4, -1);
+      if (ct < 0) {
+         if (errno == EINTR)
+            continue;
+         SYSLOG2(DDCA_SYSLOG_ERROR, "epoll_wait() failed. errno=%s", linux_errno_desc(errno));
+         break;
       }
+      dw_count_watch_wakeup(wdd->watch_mode);
 
-      else if ( streq(cd->prop_subsystem, "drm") &&
-                 streq(cd->prop_action,   "add") ) {
-         DBGTRC_NOPREFIX(true, DDCA_TRC_NONE, "Processing subsystem drm, action add");
-         Bit_Set_256  bs_udev_buses =    i2c_detect_attached_buses_as_bitset();
-         Bit_Set_256  bs_known_buses = EMPTY_BIT_SET_256;
-         for (int ndx = 0; ndx < all_i2c_buses->len; ndx++) {
-            I2C_Bus_Info * cur = g_ptr_array_index(all_i2c_buses, ndx);
-            // need to check if valid?
-            bs_known_buses = bs256_insert(bs_known_buses, cur->busno);
+      for (int ndx = 0; ndx < ct; ndx++) {
+         int fd = events[ndx].data.fd;
+         if (fd == terminate_fd) {
+            terminate = true;
          }
-
-         DBGTRC_NOPREFIX(true, DDCA_TRC_NONE, "udev buses: %s", BS256_REPR(bs_udev_buses));
-         DBGTRC_NOPREFIX(true, DDCA_TRC_NONE, "known_buses: %s", BS256_REPR(bs_known_buses));
-
-         BS256 buses_added = bs256_minus(bs_udev_buses, bs_known_buses);
-         DBGTRC_NOPREFIX(true, DDCA_TRC_NONE, "Buses added: %s", BS256_REPR(buses_added));
-         if (bs256_count(buses_added) > 0) {
-            Bit_Set_256_Iterator iter = bs256_iter_new(buses_added);
-            while (true) {
-               int busno = bs256_iter_next(iter);
-               if (busno < 0)
-                  break;
-               I2C_Bus_Info * businfo = i2c_get_and_check_bus_info(busno);
-               // I2C_Bus_Info * businfo = i2c_add_bus(busno);
-               // i2c_check_bus2(businfo);
-               i2c_dbgrpt_bus_info(businfo, /* include_sysinfo */ true, 2);
-               DBGTRC_NOPREFIX(true, DDCA_TRC_NONE, "Adding businfo record for /dev/"I2C"-%d", busno);
+         else if (fd == timer_fd) {
+            uint64_t expirations;
+            if (read(timer_fd, &expirations, sizeof(expirations)) > 0 &&
+                state.deferred_events && state.deferred_events->len > 0)
+            {
+               dw_emit_deferred_events(state.deferred_events);
             }
          }
-      }
-
-      else if ( streq(cd->prop_subsystem,  "drm") &&
-                streq(cd->prop_action,     "change") ) {
-         // xxx("drm change");
-         bool processed = false;
-         time_t prev_change_timestamp = last_drm_change_timestamp;
-         last_drm_change_timestamp = cur_realtime_nanosec();
-         time_t delta_time = last_drm_change_timestamp - prev_change_timestamp;
-         DBGTRC_NOPREFIX(true, DDCA_TRC_NONE, "nanosec since prev drm/change event: %jd", delta_time);
-         if (use_sysfs_connector_id) {
-            char * cname = NULL;
-            int connector_number = -1;
-            if (cd && streq(cd->prop_action, "change")
-                                && cd->prop_connector) {  // seen null when MST hub added
-               bool valid_number = str_to_int(cd->prop_connector, &connector_number, 10);
-               assert(valid_number);
-               cname = get_sys_drm_connector_name_by_connector_id(connector_number);
-               DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE,
-                     "get_sys_drm_connector_name_by_connector_id() returned: %s", cname);
-
-               if (debug_sysfs_state) {   // move debug statements out of mainline
-                  debug_watch_state(connector_number, cname);
-               }  // debug_sysfs_state
-
-               if (cname) {
-                  DBGTRC_NOPREFIX(true, DDCA_TRC_NONE, "1) Using connector id %d, name =%s", connector_number, cname);
-                  bs_cur_buses_w_edid = dw_i2c_check_bus_changes_for_connector(
-                                        connector_number, cname, bs_cur_buses_w_edid,
-                                        deferred_events);
-                  // xxx("drm change case1");
-                  processed = true;
-               }
-   #ifdef UDEV_I2C_DEV
-               if (!processed) {
-                  if (drm_udev_detail &&
-                        (streq(drm_udev_detail->prop_action,"add")||streq(drm_udev_detail->prop_action, "remove") )
-                        && drm_udev_detail->sysname)
-                  {
-                     int busno = i2c_name_to_busno(drm_udev_detail->sysname);
-                     cname = get_sys_drm_connector_name_by_busno(busno);
-                  }
-                  if (cname) {
-                     DBGTRC(true, DDCA_TRC_NONE,
-                           "2) connector name reported by get_sys_drm_connector_name_by_busno(): %s",
-                           cname);
-                     bs_cur_buses_w_edid = dw_i2c_check_bus_changes_for_connector(
-                                        connector_number, cname, bs_cur_buses_w_edid, deferred_events);
-                     processed = true;
-                  }
+         else if (fd == debounce_fd) {
+            uint64_t expirations;
+            if (read(debounce_fd, &expirations, sizeof(expirations)) > 0) {
+               // emits display change events or queues them
+               state.bs_cur_buses_w_edid = dw_debouncer_process_expired(
+                                              state.debouncer, state.bs_cur_buses_w_edid);
+               if (state.watch_dpms) {
+                  // remove buses marked asleep if they no longer have a monitor so they will
+                  // not be considered asleep when reconnected
+                  state.bs_sleepy_buses = bs256_and(state.bs_sleepy_buses, state.bs_cur_buses_w_edid);
                }
-               if (!processed) {
-                  if (i2c_dev_udev_detail && i2c_dev_udev_detail->sysname
-                      && (streq(drm_udev_detail->prop_action,"add")||streq(drm_udev_detail->prop_action, "remove")) )
-                  {
-                     int busno = i2c_name_to_busno(i2c_dev_udev_detail->sysname);
-                     cname = get_sys_drm_connector_name_by_busno(busno);
-                  }
-                  if (cname) {
-                     DBGTRC_NOPREFIX(true, DDCA_TRC_NONE,
-                           "3) connector name reported by get_sys_drm_connector_name_by_busno(): %s", cname);
-                     bs_cur_buses_w_edid = dw_i2c_check_bus_changes_for_connector(
-                                        connector_number, cname, bs_cur_buses_w_edid, deferred_events);
-                     processed = true;
-                  }
-               }
-   #endif
             }
-            free(cname);
          }
-
-         if (!processed) {
-            DBGTRC_NOPREFIX(true, DDCA_TRC_NONE, "4) Calling ddc_i2c_check_bus_changes");
-            // emits display change events or queues them
-            bs_cur_buses_w_edid = dw_i2c_check_bus_changes(bs_cur_buses_w_edid, deferred_events);
+         else if (fd == udev_fd) {
+            struct udev_device * dev = NULL;
+            while (!terminate_watch_thread && (dev = udev_monitor_receive_device(mon))) {
+               DBGTRC(debug || report_udev_events, DDCA_TRC_NONE, "Udev event received");
+#ifdef DEBUGGING
+               dbgrpt_udev_device(dev, /*verbose=*/false, 2);
+               report_udev_device(dev, 3 );
+#endif
+               dw_process_udev_event(dev, &state);
+               udev_device_unref(dev);
+               DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE, "==> udev event processed");
+            }
          }
+      }
+      if (terminate || terminate_watch_thread)
+         break;
 
-        if (watch_dpms) {
-           // remove buses marked asleep if they no longer have a monitor so they will
-           // not be considered asleep when reconnected
-           bs_sleepy_buses = bs256_and(bs_sleepy_buses, bs_cur_buses_w_edid);
-        }
-      } // subsystem drm, action change
+      dw_terminate_if_invalid_thread_or_process(cur_pid, cur_tid);
 
-      free_udev_event_detail(cd);
-      cd = NULL;
-      udev_device_unref(dev);
-      dev = NULL;
+      // Wake when the earliest connector quiet period ends, if any
+      dw_arm_timerfd(debounce_fd, MAX(0, dw_debouncer_next_timeout_millisec(state.debouncer)));
 
-      DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE, "==> udev event processed");
-   }  // while
+      // Deferred events are emitted one watch loop interval after they were queued
+      if (state.deferred_events && state.deferred_events->len > 0)
+         dw_arm_timerfd(timer_fd, wdd->watch_loop_millisec);
+   }
 
-   // This is not the real function exit point.  Function termination occurs
-   // using g_thread_exit within the udev event polling loop.
-   assert(false);
+   DBGTRC_DONE(debug, TRACE_GROUP, "Terminating thread");
+   if (epoll_fd >= 0)
+      close(epoll_fd);
+   if (timer_fd >= 0)
+      close(timer_fd);
+   if (debounce_fd >= 0)
+      close(debounce_fd);
+   dw_free_debouncer(state.debouncer);
+   if (state.deferred_events)
+      g_array_free(state.deferred_events, true);
+   dw_free_watch_displays_data(wdd);
+   //  int rc = udev_monitor_filter_remove(mon);
+   udev_monitor_unref(mon);
+   udev_unref(udev);
+   free_current_traced_function_stack();
    return NULL;
 }
 
@@ -775,13 +807,16 @@ void init_dw_udev() {
 #ifdef UNUSED
    RTTI_ADD_FUNC(ddc_i2c_filter_sleep_events);
 #endif
+#ifdef OLD
    RTTI_ADD_FUNC(dw_i2c_check_bus_changes);
    RTTI_ADD_FUNC(dw_i2c_check_bus_changes_for_connector);
    RTTI_ADD_FUNC(dw_i2c_stabilized_bus_by_connector_id);
    RTTI_ADD_FUNC(dw_i2c_stabilized_single_bus_by_connector_name);
+#endif
 #ifdef WATCH_DPMS
    RTTI_ADD_FUNC(ddc_i2c_check_bus_asleep);
 #endif
+   RTTI_ADD_FUNC(dw_process_udev_event);
    RTTI_ADD_FUNC(dw_watch_displays_udev);
 #endif
 }
@@ -0,0 +1,484 @@
+/** @file dw_vcp_monitor.c
+ *
+ *  Polls displays for VCP feature value changes made using the display's
+ *  own controls, i.e. the On Screen Display, and reports each change as a
+ *  #DDCA_Display_Status_Event of type #DDCA_EVENT_VCP_VALUE_CHANGED.
+ *
+ *  This is the library counterpart of the WATCH command (app_watch.c).
+ *  Feature x02 (New Control Value) is read to determine whether changes
+ *  exist.  If so, feature x52 (Active Control) is read to obtain the id of
+ *  the changed feature, and the value of that feature is read.  For MCCS
+ *  versions 2.2 and 3.0, x52 is a FIFO that is read until it returns x00.
+ *  Finally x02 is reset.
+ *
+ *  A single thread services all monitored displays.  Each display has its
+ *  own polling interval.  The interval drops to the minimum when a change is
+ *  seen, since the user is likely still adjusting the display, and doubles
+ *  after each poll that finds no change, up to the maximum.  The minimum is
+ *  scaled by the bus's current dynamic sleep adjustment multiplier, so a
+ *  display that needs longer DDC sleeps is also polled less aggressively.
+ *  Displays that are due at the same time are polled in parallel on the
+ *  worker pool.
+ *
+ *  A display that is open by a client is not polled until it is closed.
+ */
+
+// Copyright (C) 2025 Sanford Rockowitz <rockowitz@minsoft.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/** \cond */
+#include <assert.h>
+#include <glib-2.0/glib.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+/** \endcond */
+
+#include "public/ddcutil_status_codes.h"
+#include "public/ddcutil_types.h"
+
+#include "util/error_info.h"
+#include "util/timestamp.h"
+
+#include "base/core.h"
+#include "base/displays.h"
+#include "base/dsa2.h"
+#include "base/parms.h"
+#include "base/rtti.h"
+#include "base/vcp_version.h"
+#include "base/worker_pool.h"
+
+#include "ddc/ddc_packet_io.h"
+#include "ddc/ddc_vcp.h"
+#include "ddc/ddc_vcp_version.h"
+
+#include "dw_status_events.h"
+
+#include "dw_vcp_monitor.h"
+
+
+// Trace class for this file
+static DDCA_Trace_Group TRACE_GROUP = DDCA_TRC_CONN;
+
+int vcp_monitor_min_interval_millis = DEFAULT_VCP_MONITOR_MIN_INTERVAL_MILLIS;
+int vcp_monitor_max_interval_millis = DEFAULT_VCP_MONITOR_MAX_INTERVAL_MILLIS;
+
+/** Guards against a display whose x52 FIFO never empties */
+#define MAX_CHANGES_PER_POLL 20
+
+typedef struct {
+   Display_Ref * dref;
+   uint64_t      due_nanos;           // monotonic time of next poll
+   int           interval_millis;     // current polling interval
+   bool          initialized;         // VCP version determined, x02 reset
+   bool          x52_is_fifo;         // MCCS version >= 2.2
+   bool          polling;             // being polled by a worker
+   bool          unsupported;         // display does not report changes, not polled
+   int           changes_reported;
+} Vcp_Monitor_Entry;
+
+static GMutex      monitor_mutex;
+static GCond       monitor_cond;
+static GPtrArray * monitor_entries = NULL;    // Vcp_Monitor_Entry *
+static GThread *   monitor_thread  = NULL;
+static bool        monitor_terminate = false;
+
+
+static Vcp_Monitor_Entry *
+find_monitor_entry(Display_Ref * dref, guint * ndx_loc) {
+   for (guint ndx = 0; ndx < monitor_entries->len; ndx++) {
+      Vcp_Monitor_Entry * entry = g_ptr_array_index(monitor_entries, ndx);
+      if (entry->dref == dref) {
+         if (ndx_loc)
+            *ndx_loc = ndx;
+         return entry;
+      }
+   }
+   return NULL;
+}
+
+
+/** Returns the shortest polling interval for a display, i.e. the configured
+ *  minimum scaled by the current DSA sleep multiplier for its bus.
+ */
+static int
+min_interval_millis(Display_Ref * dref) {
+   int result = vcp_monitor_min_interval_millis;
+   if (dsa2_is_enabled() && dref->io_path.io_mode == DDCA_IO_I2C) {
+      struct Results_Table * rtable =
+            dsa2_get_results_table_by_busno(dref->io_path.path.i2c_busno, false);
+      if (rtable) {
+         DDCA_Sleep_Multiplier mult = dsa2_get_adjusted_sleep_mult(rtable);
+         if (mult > 1.0)
+            result = result * mult;
+      }
+   }
+   return MIN(result, vcp_monitor_max_interval_millis);
+}
+
+
+static void
+reset_x02(Display_Handle * dh) {
+   Error_Info * erec = ddc_set_nontable_vcp_value(dh, 0x02, 0x01);
+   if (erec) {
+      MSG_W_SYSLOG(DDCA_SYSLOG_WARNING, "Error resetting feature x02 on %s: %s",
+                                        dh_repr(dh), errinfo_summary(erec));
+      errinfo_free(erec);
+   }
+}
+
+
+static void
+emit_vcp_value_changed(Display_Handle * dh, Byte feature_code, uint16_t value) {
+   Display_Ref * dref = dh->dref;
+   DDCA_Display_Status_Event evt = dw_create_display_status_event(
+         DDCA_EVENT_VCP_VALUE_CHANGED,
+         dref->drm_connector,
+         dref,
+         dref->io_path);
+   evt.vcp_feature_code = feature_code;
+   evt.vcp_value = value;
+   dw_emit_display_status_record(evt);
+}
+
+
+/** Reads the id of a changed feature from x52 and, if it is not x00,
+ *  reads the feature's current value and emits an event.
+ *
+ *  @param  dh                 display handle
+ *  @param  feature_code_loc   where to return the feature id read from x52
+ *  @return error reading x52, NULL if none
+ */
+static Error_Info *
+report_changed_feature(Display_Handle * dh, Byte * feature_code_loc) {
+   bool debug = false;
+   Parsed_Nontable_Vcp_Response * response = NULL;
+   Error_Info * result = ddc_get_nontable_vcp_value(dh, 0x52, &response);
+   if (!result) {
+      *feature_code_loc = response->sl;
+      free(response);
+      response = NULL;
+      DBGTRC_NOPREFIX(debug, TRACE_GROUP, "x52 returned 0x%02x", *feature_code_loc);
+      if (*feature_code_loc) {
+         // A table feature or a read failure is still reported, with value 0
+         uint16_t value = 0;
+         Error_Info * erec = ddc_get_nontable_vcp_value(dh, *feature_code_loc, &response);
+         if (erec) {
+            DBGTRC_NOPREFIX(debug, TRACE_GROUP, "Error reading feature 0x%02x: %s",
+                                                *feature_code_loc, errinfo_summary(erec));
+            errinfo_free(erec);
+         }
+         else {
+            value = response->sh << 8 | response->sl;
+            free(response);
+         }
+         emit_vcp_value_changed(dh, *feature_code_loc, value);
+      }
+   }
+   return result;
+}
+
+
+/** Checks a display for changed feature values, emitting an event for
+ *  each change.
+ *
+ *  @param  dh                display handle
+ *  @param  entry             monitor entry for the display
+ *  @param  changes_seen_loc  set true if any changes were reported
+ *  @return error, NULL if none
+ */
+static Error_Info *
+read_vcp_changes(Display_Handle * dh, Vcp_Monitor_Entry * entry, bool * changes_seen_loc) {
+   bool debug = false;
+   DBGTRC_STARTING(debug, TRACE_GROUP, "dh=%s", dh_repr(dh));
+   *changes_seen_loc = false;
+
+   if (!entry->initialized) {
+      DDCA_MCCS_Version_Spec vspec = get_vcp_version_by_dh(dh);
+      entry->x52_is_fifo = !vcp_version_le(vspec, DDCA_VSPEC_V21);
+      reset_x02(dh);
+      entry->initialized = true;
+   }
+
+   Parsed_Nontable_Vcp_Response * response = NULL;
+   Error_Info * result = ddc_get_nontable_vcp_value(dh, 0x02, &response);
+   if (result) {
+      if (result->status_code == DDCRC_REPORTED_UNSUPPORTED ||
+          result->status_code == DDCRC_DETERMINED_UNSUPPORTED)
+      {
+         result = errinfo_new_with_cause(DDCRC_DETERMINED_UNSUPPORTED, result, __func__,
+               "Feature x02 (New Control Value) is unsupported");
+      }
+   }
+   else {
+      Byte x02_value = response->sl;
+      free(response);
+      DBGTRC_NOPREFIX(debug, TRACE_GROUP, "x02 value: 0x%02x", x02_value);
+      if (x02_value == 0xff) {
+         result = errinfo_new(DDCRC_DETERMINED_UNSUPPORTED, __func__,
+                              "Feature x02 (New Control Value) reports No User Controls");
+      }
+      else if (x02_value == 0x02) {
+         int max_reads = (entry->x52_is_fifo) ? MAX_CHANGES_PER_POLL : 1;
+         for (int ctr = 0; ctr < max_reads; ctr++) {
+            Byte feature_code = 0x00;
+            result = report_changed_feature(dh, &feature_code);
+            if (result || feature_code == 0x00)
+               break;
+            *changes_seen_loc = true;
+         }
+         if (!result)
+            reset_x02(dh);
+         else if (result->status_code == DDCRC_REPORTED_UNSUPPORTED ||
+                  result->status_code == DDCRC_DETERMINED_UNSUPPORTED)
+         {
+            result = errinfo_new_with_cause(DDCRC_DETERMINED_UNSUPPORTED, result, __func__,
+                  "Feature x02 reports changed values exist, but feature x52 (Active Control) is unsupported");
+         }
+      }
+      else if (x02_value != 0x01) {
+         result = errinfo_new(DDCRC_DETERMINED_UNSUPPORTED, __func__,
+                     "Feature x02 (New Control Value) reports unexpected value 0x%02x", x02_value);
+      }
+   }
+
+   DBGTRC_RET_ERRINFO(debug, TRACE_GROUP, result, "*changes_seen_loc=%s", sbool(*changes_seen_loc));
+   return result;
+}
+
+
+/** Polls a single display.  Executed on the worker pool.
+ *
+ *  @param  data  #Vcp_Monitor_Entry
+ *  @return NULL
+ */
+static void *
+poll_display(void * data) {
+   bool debug = false;
+   Vcp_Monitor_Entry * entry = data;
+   Display_Ref * dref = entry->dref;
+   DBGTRC_STARTING(debug, TRACE_GROUP, "dref=%s, interval_millis=%d",
+                                       dref_reprx_t(dref), entry->interval_millis);
+
+   bool changes_seen = false;
+   bool display_busy = false;
+   Display_Handle * dh = NULL;
+   Error_Info * erec = ddc_open_display(dref, CALLOPT_NONE, &dh);
+   if (erec) {
+      display_busy = (erec->status_code == DDCRC_LOCKED || erec->status_code == DDCRC_ALREADY_OPEN);
+   }
+   else {
+      erec = read_vcp_changes(dh, entry, &changes_seen);
+      ddc_close_display_wo_return(dh);
+   }
+
+   if (erec && erec->status_code == DDCRC_DETERMINED_UNSUPPORTED) {
+      MSG_W_SYSLOG(DDCA_SYSLOG_WARNING, "Display %s does not report VCP feature changes: %s",
+                                        dref_reprx_t(dref), erec->detail);
+      entry->unsupported = true;
+   }
+   else if (erec && !display_busy) {
+      SYSLOG2(DDCA_SYSLOG_NOTICE, "Error polling %s for VCP feature changes: %s",
+                                  dref_reprx_t(dref), errinfo_summary(erec));
+   }
+
+   // Adjust the schedule.  A busy display is tried again at the same interval.
+   int min_millis = min_interval_millis(dref);
+   if (changes_seen) {
+      entry->changes_reported++;
+      entry->interval_millis = min_millis;
+   }
+   else if (!display_busy) {
+      entry->interval_millis = MIN(MAX(entry->interval_millis*2, min_millis),
+                                   vcp_monitor_max_interval_millis);
+   }
+   uint64_t interval_nanos = MILLIS2NANOS((uint64_t) entry->interval_millis);
+   entry->due_nanos = cur_monotonic_nanosec() + interval_nanos;
+
+   DBGTRC_DONE(debug, TRACE_GROUP, "changes_seen=%s, display_busy=%s, erec=%s, next interval=%d",
+         sbool(changes_seen), sbool(display_busy), errinfo_summary(erec), entry->interval_millis);
+   ERRINFO_FREE(erec);
+   return NULL;
+}
+
+
+/** Function executed by the monitor thread.
+ *
+ *  Waits until the earliest poll is due, or the set of monitored displays
+ *  changes, then polls all displays that are due.
+ */
+static gpointer
+vcp_monitor_thread_func(gpointer data) {
+   bool debug = false;
+   DBGTRC_STARTING(debug, TRACE_GROUP, "");
+
+   GPtrArray * due = g_ptr_array_new();
+   g_mutex_lock(&monitor_mutex);
+   while (!monitor_terminate) {
+      uint64_t now = cur_monotonic_nanosec();
+      uint64_t next_due = 0;
+      g_ptr_array_set_size(due, 0);
+      for (guint ndx = 0; ndx < monitor_entries->len; ndx++) {
+         Vcp_Monitor_Entry * entry = g_ptr_array_index(monitor_entries, ndx);
+         if (entry->unsupported || (entry->dref->flags & DREF_REMOVED))
+            continue;
+         if (entry->due_nanos <= now)
+            g_ptr_array_add(due, entry);
+         else if (next_due == 0 || entry->due_nanos < next_due)
+            next_due = entry->due_nanos;
+      }
+
+      if (due->len == 0) {
+         if (next_due == 0)
+            g_cond_wait(&monitor_cond, &monitor_mutex);
+         else
+            g_cond_wait_until(&monitor_cond, &monitor_mutex,
+                              g_get_monotonic_time() + NANOS2MICROS(next_due - now));
+         continue;
+      }
+
+      for (guint ndx = 0; ndx < due->len; ndx++)
+         ((Vcp_Monitor_Entry *) g_ptr_array_index(due, ndx))->polling = true;
+      g_mutex_unlock(&monitor_mutex);
+
+      DBGTRC_NOPREFIX(debug, TRACE_GROUP, "Polling %d display(s)", due->len);
+      if (due->len == 1) {
+         poll_display(g_ptr_array_index(due, 0));
+      }
+      else {
+         Worker_Batch * batch = wp_new_batch("vcp_monitor");
+         for (guint ndx = 0; ndx < due->len; ndx++)
+            wp_batch_add(batch, poll_display, g_ptr_array_index(due, ndx));
+         g_ptr_array_free(wp_batch_wait(batch), true);
+      }
+
+      g_mutex_lock(&monitor_mutex);
+      for (guint ndx = 0; ndx < due->len; ndx++) {
+         Vcp_Monitor_Entry * entry = g_ptr_array_index(due, ndx);
+         entry->polling = false;
+      }
+      // entries removed during the poll are freed by dw_stop_vcp_monitor()
+      g_cond_broadcast(&monitor_cond);    // for dw_stop_vcp_monitor() waiting on a poll
+   }
+   g_mutex_unlock(&monitor_mutex);
+   g_ptr_array_free(due, true);
+
+   DBGTRC_DONE(debug, TRACE_GROUP, "");
+   return NULL;
+}
+
+
+/** Starts monitoring a display for VCP feature value changes.
+ *  It is not an error if the display is already monitored.
+ *
+ *  @param  dref  display reference
+ *  @retval DDCRC_OK
+ *  @retval DDCRC_INVALID_OPERATION  DDC communication not working
+ */
+DDCA_Status dw_start_vcp_monitor(Display_Ref * dref) {
+   bool debug = false;
+   DBGTRC_STARTING(debug, TRACE_GROUP, "dref=%s", dref_reprx_t(dref));
+
+   DDCA_Status ddcrc = DDCRC_OK;
+   if (!(dref->flags & DREF_DDC_COMMUNICATION_WORKING)) {
+      ddcrc = DDCRC_INVALID_OPERATION;
+   }
+   else {
+      g_mutex_lock(&monitor_mutex);
+      if (!find_monitor_entry(dref, NULL)) {
+         Vcp_Monitor_Entry * entry = calloc(1, sizeof(Vcp_Monitor_Entry));
+         entry->dref = dref;
+         entry->interval_millis = min_interval_millis(dref);
+         entry->due_nanos = cur_monotonic_nanosec();
+         g_ptr_array_add(monitor_entries, entry);
+         if (!monitor_thread) {
+            monitor_terminate = false;
+            monitor_thread = g_thread_new("vcp_monitor", vcp_monitor_thread_func, NULL);
+         }
+         g_cond_broadcast(&monitor_cond);
+      }
+      g_mutex_unlock(&monitor_mutex);
+   }
+
+   DBGTRC_RET_DDCRC(debug, TRACE_GROUP, ddcrc, "");
+   return ddcrc;
+}
+
+
+/** Stops monitoring a display.  If the display is currently being polled,
+ *  waits for the poll to complete, so that no further events for the
+ *  display are emitted once this function returns.
+ *
+ *  @param  dref  display reference
+ *  @retval DDCRC_OK
+ *  @retval DDCRC_NOT_FOUND  display not being monitored
+ */
+DDCA_Status dw_stop_vcp_monitor(Display_Ref * dref) {
+   bool debug = false;
+   DBGTRC_STARTING(debug, TRACE_GROUP, "dref=%s", dref_reprx_t(dref));
+
+   DDCA_Status ddcrc = DDCRC_OK;
+   g_mutex_lock(&monitor_mutex);
+   guint ndx = 0;
+   Vcp_Monitor_Entry * entry = find_monitor_entry(dref, &ndx);
+   if (!entry) {
+      ddcrc = DDCRC_NOT_FOUND;
+   }
+   else {
+      g_ptr_array_remove_index(monitor_entries, ndx);
+      // The monitor thread still references the entry while polling it,
+      // but never frees it.
+      while (entry->polling)
+         g_cond_wait(&monitor_cond, &monitor_mutex);
+      free(entry);
+   }
+   g_mutex_unlock(&monitor_mutex);
+
+   DBGTRC_RET_DDCRC(debug, TRACE_GROUP, ddcrc, "");
+   return ddcrc;
+}
+
+
+/** Stops monitoring all displays and terminates the monitor thread. */
+void dw_stop_all_vcp_monitors() {
+   bool debug = false;
+   DBGTRC_STARTING(debug, TRACE_GROUP, "monitor_thread=%p", monitor_thread);
+
+   g_mutex_lock(&monitor_mutex);
+   GThread * thread = monitor_thread;
+   monitor_terminate = true;
+   g_cond_broadcast(&monitor_cond);
+   g_mutex_unlock(&monitor_mutex);
+
+   if (thread)
+      g_thread_join(thread);
+
+   g_mutex_lock(&monitor_mutex);
+   for (guint ndx = 0; ndx < monitor_entries->len; ndx++)
+      free(g_ptr_array_index(monitor_entries, ndx));
+   g_ptr_array_set_size(monitor_entries, 0);
+   monitor_thread = NULL;
+   g_mutex_unlock(&monitor_mutex);
+
+   DBGTRC_DONE(debug, TRACE_GROUP, "");
+}
+
+
+void init_dw_vcp_monitor() {
+   g_mutex_lock(&monitor_mutex);
+   if (!monitor_entries)
+      monitor_entries = g_ptr_array_new();
+   g_mutex_unlock(&monitor_mutex);
+
+   RTTI_ADD_FUNC(read_vcp_changes);
+   RTTI_ADD_FUNC(poll_display);
+   RTTI_ADD_FUNC(vcp_monitor_thread_func);
+   RTTI_ADD_FUNC(dw_start_vcp_monitor);
+   RTTI_ADD_FUNC(dw_stop_vcp_monitor);
+   RTTI_ADD_FUNC(dw_stop_all_vcp_monitors);
+}
+
+
+void terminate_dw_vcp_monitor() {
+   dw_stop_all_vcp_monitors();
+}
@@ -0,0 +1,30 @@
+/** @file dw_vcp_monitor.h
+ *
+ *  Poll displays for VCP feature value changes made using the display's
+ *  own controls, reporting them as display status events
+ */
+
+// Copyright (C) 2025 Sanford Rockowitz <rockowitz@minsoft.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef DW_VCP_MONITOR_H_
+#define DW_VCP_MONITOR_H_
+
+/** \cond */
+#include <stdbool.h>
+
+#include "public/ddcutil_types.h"
+/** \endcond */
+
+#include "base/displays.h"
+
+extern int vcp_monitor_min_interval_millis;
+extern int vcp_monitor_max_interval_millis;
+
+DDCA_Status dw_start_vcp_monitor(Display_Ref * dref);
+DDCA_Status dw_stop_vcp_monitor(Display_Ref * dref);
+void        dw_stop_all_vcp_monitors();
+void        init_dw_vcp_monitor();
+void        terminate_dw_vcp_monitor();
+
+#endif /* DW_VCP_MONITOR_H_ */
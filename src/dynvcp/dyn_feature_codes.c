@@ -20,6 +20,7 @@
 #include "base/feature_metadata.h"
 #include "base/monitor_model_key.h"
 #include "base/rtti.h"
+#include "base/vcp_version.h"
 
 #include "vcp/vcp_feature_codes.h"
 
@@ -374,6 +375,91 @@ dyn_get_feature_metadata_by_dh(
 }
 
 
+// Per-display feature metadata tables
+
+// Guards replacement of Display_Ref.metadata_table.  Tables themselves are immutable.
+static GMutex metadata_table_mutex;
+
+/** Builds the #Feature_Metadata_Table for a display.
+ *
+ *  @param  dref   display reference
+ *  @param  vspec  VCP version of the display
+ *  @return newly allocated table
+ */
+static Feature_Metadata_Table *
+dyn_build_feature_metadata_table(
+      Display_Ref *          dref,
+      DDCA_MCCS_Version_Spec vspec)
+{
+   bool debug = false;
+   DBGTRC_STARTING(debug, TRACE_GROUP, "dref=%s, vspec=%d.%d, dfr=%p",
+                                       dref_repr_t(dref), vspec.major, vspec.minor, dref->dfr);
+
+   Feature_Metadata_Table * table = calloc(1, sizeof(Feature_Metadata_Table));
+   memcpy(table->marker, FEATURE_METADATA_TABLE_MARKER, 4);
+   table->vcp_version = vspec;
+   table->dfr = dref->dfr;
+   int found_ct = 0;
+   for (int code = 0; code < 256; code++) {
+      Display_Feature_Metadata * dfm =
+            dyn_get_feature_metadata_by_dfr_and_vspec_dfm(code, dref->dfr, vspec, /*with_default*/ false);
+      if (dfm) {
+         dfm->display_ref = dref;
+         table->internal[code] = dfm;
+         table->external[code] = dfm_to_ddca_feature_metadata(dfm);
+         table->external[code]->feature_flags |= DDCA_PERSISTENT_METADATA;
+         found_ct++;
+      }
+   }
+
+   DBGTRC_DONE(debug, TRACE_GROUP, "Returning %p, %d features defined", table, found_ct);
+   return table;
+}
+
+
+/** Returns the #Feature_Metadata_Table for a display, building it on first use
+ *  or if the user defined features or VCP version have changed since it was built.
+ *
+ *  @param  dh  display handle
+ *  @return table, owned by the display reference
+ */
+Feature_Metadata_Table *
+dyn_get_feature_metadata_table(Display_Handle * dh) {
+   Display_Ref * dref = dh->dref;
+   // ensure dh->dref->vcp_version set without incurring additional open/close
+   DDCA_MCCS_Version_Spec vspec = get_vcp_version_by_dh(dh);
+
+   g_mutex_lock(&metadata_table_mutex);
+   Feature_Metadata_Table * table = dref->metadata_table;
+   if (!table || table->dfr != dref->dfr || !vcp_version_eq(table->vcp_version, vspec)) {
+      Feature_Metadata_Table * new_table = dyn_build_feature_metadata_table(dref, vspec);
+      new_table->prior = table;
+      dref->metadata_table = new_table;
+      table = new_table;
+   }
+   g_mutex_unlock(&metadata_table_mutex);
+   return table;
+}
+
+
+/** Returns the metadata for a feature from the display's #Feature_Metadata_Table.
+ *
+ *  Equivalent to #dyn_get_feature_metadata_by_dh() with check_udf = true and
+ *  with_default = false, but the result is shared and must not be freed.
+ *
+ *  @param  id  feature code
+ *  @param  dh  display handle
+ *  @return pointer into the table, NULL if the feature is not defined
+ */
+const Display_Feature_Metadata *
+dyn_get_feature_metadata_by_dh_const(
+      DDCA_Vcp_Feature_Code id,
+      Display_Handle *      dh)
+{
+   return dyn_get_feature_metadata_table(dh)->internal[id];
+}
+
+
 // Functions that apply formatting
 
 bool
@@ -529,6 +615,7 @@ void init_dyn_feature_codes() {
    RTTI_ADD_FUNC(dyn_get_feature_metadata_by_mmk_and_vspec);
    RTTI_ADD_FUNC(dyn_get_feature_metadata_by_dref);
    RTTI_ADD_FUNC(dyn_get_feature_metadata_by_dh);
+   RTTI_ADD_FUNC(dyn_build_feature_metadata_table);
    RTTI_ADD_FUNC(dyn_format_feature_detail);
    RTTI_ADD_FUNC(dyn_format_feature_detail_sl_lookup);
    RTTI_ADD_FUNC(dyn_format_feature_detail_sl_lookup_with_sh);
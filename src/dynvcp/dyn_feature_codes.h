@@ -40,6 +40,15 @@ dyn_get_feature_metadata_by_dh(
       bool                       check_udf,
       bool                       with_default);
 
+Feature_Metadata_Table *
+dyn_get_feature_metadata_table(
+      Display_Handle *           dh);
+
+const Display_Feature_Metadata *
+dyn_get_feature_metadata_by_dh_const(
+      DDCA_Vcp_Feature_Code      id,
+      Display_Handle *           dh);
+
 bool
 dyn_format_nontable_feature_detail(
       Display_Feature_Metadata * dfm,
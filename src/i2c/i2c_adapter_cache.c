@@ -0,0 +1,448 @@
+/** @file i2c_adapter_cache.c
+ *
+ *  Persistent classification of I2C adapters, used to avoid examining
+ *  adapters that can never have a display attached.
+ *
+ *  Each adapter is identified by its resolved sysfs path, which includes
+ *  the PCI path of the video card, and by its driver.  The cache file also
+ *  records the kernel release.  If the kernel release changes, the entire
+ *  cache is discarded.  If the identity of an individual adapter changes,
+ *  e.g. because a different driver is bound or a bus number has been
+ *  reassigned, that adapter is reclassified.
+ *
+ *  Adapters are classified as:
+ *  - ignorable, e.g. SMBus or sensor adapters, or adapters whose device
+ *    class is not a display controller
+ *  - candidate, i.e. the adapter may have a display attached
+ *
+ *  Ignorable adapters are skipped by display detection without opening them.
+ *
+ *  Only properties of the adapter itself are cached.  Whether a video adapter
+ *  bus currently has a connector or an EDID is not, since that changes as
+ *  monitors are turned on, MST hubs are attached, etc.
+ */
+
+// Copyright (C) 2025 Sanford Rockowitz <rockowitz@minsoft.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/** \cond */
+#include <assert.h>
+#include <errno.h>
+#include <glib-2.0/glib.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/utsname.h>
+/** \endcond */
+
+#include "util/file_util.h"
+#include "util/file_util_base.h"
+#include "util/i2c_util.h"
+#include "util/report_util.h"
+#include "util/string_util.h"
+#include "util/xdg_util.h"
+
+#include "base/core.h"
+#include "base/i2c_bus_base.h"
+#include "base/parms.h"
+#include "base/rtti.h"
+
+#include "sysfs/sysfs_base.h"
+
+#include "i2c/i2c_adapter_cache.h"
+
+// Trace class for this file
+static DDCA_Trace_Group TRACE_GROUP = DDCA_TRC_I2C;
+
+#define ADAPTER_CACHE_MAX_BUSNO 256
+#define ADAPTER_CACHE_FORMAT 2     // format 1 could contain NO_CONNECTOR entries
+
+bool adapter_cache_enabled = DEFAULT_ENABLE_CACHED_ADAPTERS;
+
+typedef struct {
+   I2C_Adapter_Class adapter_class;
+   char *            sysfs_path;         ///< resolved path of <sysfs root>/bus/i2c/devices/i2c-N
+   char *            driver;
+   char *            name;               ///< adapter name, informational only
+   bool              identity_checked;   ///< identity confirmed in this execution
+} Adapter_Cache_Entry;
+
+static Adapter_Cache_Entry * adapter_cache[ADAPTER_CACHE_MAX_BUSNO];
+static GMutex adapter_cache_mutex;
+static bool   adapter_cache_loaded = false;
+static bool   adapter_cache_modified = false;
+
+
+static const char * adapter_class_names[] = {
+      "UNCLASSIFIED",
+      "CANDIDATE",
+      "IGNORABLE",
+};
+
+
+const char * i2c_adapter_class_name(I2C_Adapter_Class adapter_class) {
+   if (adapter_class >= 0 && adapter_class < G_N_ELEMENTS(adapter_class_names))
+      return adapter_class_names[adapter_class];
+   return "INVALID";
+}
+
+
+static I2C_Adapter_Class adapter_class_by_name(const char * name) {
+   for (int ndx = 0; ndx < G_N_ELEMENTS(adapter_class_names); ndx++) {
+      if (streq(name, adapter_class_names[ndx]))
+         return ndx;
+   }
+   return I2C_ADAPTER_UNCLASSIFIED;
+}
+
+
+static void free_adapter_cache_entry(Adapter_Cache_Entry * entry) {
+   if (entry) {
+      free(entry->sysfs_path);
+      free(entry->driver);
+      free(entry->name);
+      free(entry);
+   }
+}
+
+
+static void clear_adapter_cache_entries() {
+   for (int busno = 0; busno < ADAPTER_CACHE_MAX_BUSNO; busno++) {
+      free_adapter_cache_entry(adapter_cache[busno]);
+      adapter_cache[busno] = NULL;
+   }
+}
+
+
+static char * adapter_cache_file_name() {
+   return xdg_cache_home_file("ddcutil", ADAPTERS_CACHE_FILENAME);
+}
+
+
+static char * current_kernel_release() {
+   struct utsname utsbuf;
+   if (uname(&utsbuf) != 0)
+      return NULL;
+   return g_strdup(utsbuf.release);
+}
+
+
+static char * adapter_sysfs_path(int busno) {
+   char buf[PATH_MAX];
+   g_snprintf(buf, sizeof(buf), "%s/i2c-%d", sysfs_bus_i2c_devices, busno);
+   return realpath(buf, NULL);
+}
+
+
+/** Loads the cache file.  Called with #adapter_cache_mutex locked.
+ *  Errors are not fatal, the cache is simply rebuilt.
+ */
+static void load_adapter_cache() {
+   bool debug = false;
+   DBGTRC_STARTING(debug, TRACE_GROUP, "");
+
+   adapter_cache_loaded = true;
+   int loaded_ct = 0;
+   char * fn = adapter_cache_file_name();
+   if (!fn)
+      goto bye;
+   GPtrArray * lines = g_ptr_array_new_with_free_func(g_free);
+   int linect = file_getlines(fn, lines, false);
+   char * kernel = current_kernel_release();
+   if (linect < 2 ||
+       !str_starts_with(g_ptr_array_index(lines,0), "FORMAT ") ||
+       atoi((char*)g_ptr_array_index(lines,0) + strlen("FORMAT ")) != ADAPTER_CACHE_FORMAT ||
+       !str_starts_with(g_ptr_array_index(lines,1), "KERNEL ") ||
+       !kernel ||
+       !streq((char*)g_ptr_array_index(lines,1) + strlen("KERNEL "), kernel))
+   {
+      DBGTRC_NOPREFIX(debug, TRACE_GROUP, "Missing, invalid, or obsolete cache file %s", fn);
+      adapter_cache_modified = (linect > 0);   // rewrite obsolete file
+   }
+   else {
+      for (int ndx = 2; ndx < lines->len; ndx++) {
+         char * line = g_ptr_array_index(lines, ndx);
+         if (strlen(line) == 0 || line[0] == '*' || line[0] == '#')
+            continue;
+         // i2c-N CLASS DRIVER SYSFS_PATH NAME
+         gchar ** pieces = g_strsplit(line, " ", 5);
+         if (g_strv_length(pieces) >= 4) {
+            int busno = i2c_name_to_busno(pieces[0]);
+            I2C_Adapter_Class adapter_class = adapter_class_by_name(pieces[1]);
+            if (busno >= 0 && busno < ADAPTER_CACHE_MAX_BUSNO &&
+                adapter_class != I2C_ADAPTER_UNCLASSIFIED)
+            {
+               Adapter_Cache_Entry * entry = calloc(1, sizeof(Adapter_Cache_Entry));
+               entry->adapter_class = adapter_class;
+               entry->driver = (streq(pieces[2], "-")) ? NULL : g_strdup(pieces[2]);
+               entry->sysfs_path = g_strdup(pieces[3]);
+               entry->name = (pieces[4]) ? g_strdup(pieces[4]) : NULL;
+               free_adapter_cache_entry(adapter_cache[busno]);
+               adapter_cache[busno] = entry;
+               loaded_ct++;
+            }
+         }
+         g_strfreev(pieces);
+      }
+   }
+   free(kernel);
+   g_ptr_array_free(lines, true);
+   free(fn);
+
+bye:
+   DBGTRC_DONE(debug, TRACE_GROUP, "Loaded %d entries", loaded_ct);
+}
+
+
+/** Returns the cache entry for a bus, if the identity of the adapter
+ *  currently at that bus number matches the entry.  A stale entry is
+ *  discarded.  Called with #adapter_cache_mutex locked.
+ *
+ *  @param  busno            I2C bus number
+ *  @param  sysfs_path_loc   where to return current resolved sysfs path,
+ *                           if no valid entry exists
+ *  @return valid entry, NULL if none
+ */
+static Adapter_Cache_Entry * get_valid_entry(int busno, char ** sysfs_path_loc) {
+   bool debug = false;
+   *sysfs_path_loc = NULL;
+   if (!adapter_cache_loaded)
+      load_adapter_cache();
+
+   char * sysfs_path = adapter_sysfs_path(busno);
+   Adapter_Cache_Entry * entry = adapter_cache[busno];
+   if (entry) {
+      bool valid = sysfs_path && streq(sysfs_path, entry->sysfs_path);
+      if (valid && !entry->identity_checked) {
+         char * driver = get_i2c_sysfs_driver_by_busno(busno);
+         valid = streq(driver, entry->driver) || (!driver && !entry->driver);
+         free(driver);
+         entry->identity_checked = valid;
+      }
+      if (!valid) {
+         DBGTRC_NOPREFIX(debug, TRACE_GROUP, "busno=%d, discarding stale entry for %s",
+               busno, entry->sysfs_path);
+         free_adapter_cache_entry(entry);
+         adapter_cache[busno] = NULL;
+         adapter_cache_modified = true;
+         entry = NULL;
+      }
+   }
+   if (entry)
+      free(sysfs_path);
+   else
+      *sysfs_path_loc = sysfs_path;
+   return entry;
+}
+
+
+/** Creates a cache entry for the adapter currently at a bus number.
+ *  Called with #adapter_cache_mutex locked.
+ */
+static Adapter_Cache_Entry *
+new_entry(int busno, char * sysfs_path, I2C_Adapter_Class adapter_class) {
+   Adapter_Cache_Entry * entry = calloc(1, sizeof(Adapter_Cache_Entry));
+   entry->adapter_class = adapter_class;
+   entry->sysfs_path = sysfs_path;      // takes ownership
+   entry->driver = get_i2c_sysfs_driver_by_busno(busno);
+   entry->name = get_i2c_device_sysfs_name(busno);
+   entry->identity_checked = true;
+   assert(!adapter_cache[busno]);
+   adapter_cache[busno] = entry;
+   adapter_cache_modified = true;
+   return entry;
+}
+
+
+/** Checks whether an I2C bus can be skipped during display detection
+ *  because it cannot be a DDC/CI connected monitor, e.g. it is an SMBus
+ *  device.
+ *
+ *  Uses the persistent classification if the adapter is unchanged,
+ *  otherwise classifies the adapter using sysfs.
+ *
+ *  @param  busno  I2C bus number
+ *  @return true if ignorable, false if not
+ */
+bool i2c_adapter_is_ignorable(int busno) {
+   bool debug = false;
+   DBGTRC_STARTING(debug, TRACE_GROUP, "busno=%d", busno);
+
+   bool result = false;
+   if (!adapter_cache_enabled || busno < 0 || busno >= ADAPTER_CACHE_MAX_BUSNO) {
+      result = sysfs_is_ignorable_i2c_device(busno);
+   }
+   else {
+      g_mutex_lock(&adapter_cache_mutex);
+      char * sysfs_path = NULL;
+      Adapter_Cache_Entry * entry = get_valid_entry(busno, &sysfs_path);
+      if (!entry) {
+         bool ignorable = sysfs_is_ignorable_i2c_device(busno);
+         if (sysfs_path) {
+            entry = new_entry(busno, sysfs_path,
+                              (ignorable) ? I2C_ADAPTER_IGNORABLE : I2C_ADAPTER_CANDIDATE);
+         }
+         result = ignorable;
+      }
+      else {
+         result = (entry->adapter_class == I2C_ADAPTER_IGNORABLE);
+      }
+      g_mutex_unlock(&adapter_cache_mutex);
+   }
+
+   DBGTRC_RET_BOOL(debug, TRACE_GROUP, result, "");
+   return result;
+}
+
+
+/** Records the classification of an I2C adapter.
+ *
+ *  @param  busno          I2C bus number
+ *  @param  adapter_class  classification
+ */
+void i2c_adapter_record_class(int busno, I2C_Adapter_Class adapter_class) {
+   bool debug = false;
+   DBGTRC_STARTING(debug, TRACE_GROUP, "busno=%d, adapter_class=%s",
+         busno, i2c_adapter_class_name(adapter_class));
+
+   if (adapter_cache_enabled && busno >= 0 && busno < ADAPTER_CACHE_MAX_BUSNO) {
+      g_mutex_lock(&adapter_cache_mutex);
+      char * sysfs_path = NULL;
+      Adapter_Cache_Entry * entry = get_valid_entry(busno, &sysfs_path);
+      if (!entry) {
+         if (sysfs_path)
+            new_entry(busno, sysfs_path, adapter_class);
+      }
+      else if (entry->adapter_class != adapter_class) {
+         entry->adapter_class = adapter_class;
+         adapter_cache_modified = true;
+      }
+      g_mutex_unlock(&adapter_cache_mutex);
+   }
+
+   DBGTRC_DONE(debug, TRACE_GROUP, "");
+}
+
+
+/** Saves the adapter classifications in file ddcutil/adapters within the
+ *  user's XDG cache directory, typically $HOME/.cache.  Does nothing if
+ *  the classifications have not changed.
+ *
+ *  @retval 0      success
+ *  @retval -errno if unable to write the file
+ */
+Status_Errno i2c_save_adapter_cache() {
+   bool debug = false;
+   DBGTRC_STARTING(debug, TRACE_GROUP, "adapter_cache_modified=%s", SBOOL(adapter_cache_modified));
+
+   Status_Errno result = 0;
+   int saved_ct = 0;
+   g_mutex_lock(&adapter_cache_mutex);
+   if (!adapter_cache_enabled || !adapter_cache_modified)
+      goto bye;
+
+   char * fn = adapter_cache_file_name();
+   char * kernel = current_kernel_release();
+   if (!fn || !kernel) {
+      result = -ENOENT;
+      free(fn);
+      free(kernel);
+      goto bye;
+   }
+   FILE * fp = NULL;
+   result = fopen_mkdir(fn, "w", ferr(), &fp);
+   if (!fp) {
+      result = -errno;
+      MSG_W_SYSLOG(DDCA_SYSLOG_WARNING, "Error opening %s: %s", fn, strerror(errno));
+   }
+   else {
+      fprintf(fp, "FORMAT %d\n", ADAPTER_CACHE_FORMAT);
+      fprintf(fp, "KERNEL %s\n", kernel);
+      fprintf(fp, "* DEV CLASS DRIVER SYSFS_PATH NAME\n");
+      for (int busno = 0; busno < ADAPTER_CACHE_MAX_BUSNO; busno++) {
+         Adapter_Cache_Entry * entry = adapter_cache[busno];
+         if (entry && entry->sysfs_path) {
+            fprintf(fp, "i2c-%d %s %s %s %s\n",
+                  busno,
+                  i2c_adapter_class_name(entry->adapter_class),
+                  (entry->driver) ? entry->driver : "-",
+                  entry->sysfs_path,
+                  (entry->name) ? entry->name : "");
+            saved_ct++;
+         }
+      }
+      fclose(fp);
+      adapter_cache_modified = false;
+   }
+   free(fn);
+   free(kernel);
+
+bye:
+   g_mutex_unlock(&adapter_cache_mutex);
+   DBGTRC_RET_DDCRC(debug, TRACE_GROUP, result, "Saved %d entries", saved_ct);
+   return result;
+}
+
+
+/** Deletes the adapter cache file and discards all classifications.
+ *  It is not an error if the file does not exist.
+ *
+ *  @retval -errno if deletion fails for any reason other than non-existence
+ *  @retval  0     success
+ */
+Status_Errno i2c_erase_adapter_cache() {
+   bool debug = false;
+   DBGTRC_STARTING(debug, TRACE_GROUP, "");
+
+   Status_Errno result = 0;
+   g_mutex_lock(&adapter_cache_mutex);
+   clear_adapter_cache_entries();
+   adapter_cache_loaded = true;
+   adapter_cache_modified = false;
+   char * fn = adapter_cache_file_name();
+   if (fn) {
+      if (remove(fn) < 0 && errno != ENOENT)
+         result = -errno;
+      free(fn);
+   }
+   g_mutex_unlock(&adapter_cache_mutex);
+
+   DBGTRC_RET_DDCRC(debug, TRACE_GROUP, result, "");
+   return result;
+}
+
+
+void dbgrpt_adapter_cache(int depth) {
+   int d1 = depth+1;
+   rpt_vstring(depth, "I2C adapter cache: enabled=%s, loaded=%s, modified=%s",
+         SBOOL(adapter_cache_enabled), SBOOL(adapter_cache_loaded), SBOOL(adapter_cache_modified));
+   g_mutex_lock(&adapter_cache_mutex);
+   for (int busno = 0; busno < ADAPTER_CACHE_MAX_BUSNO; busno++) {
+      Adapter_Cache_Entry * entry = adapter_cache[busno];
+      if (entry) {
+         rpt_vstring(d1, "i2c-%-3d %-12s %-10s %s (%s)",
+               busno, i2c_adapter_class_name(entry->adapter_class),
+               (entry->driver) ? entry->driver : "-",
+               entry->sysfs_path, (entry->name) ? entry->name : "");
+      }
+   }
+   g_mutex_unlock(&adapter_cache_mutex);
+}
+
+
+void init_i2c_adapter_cache() {
+   RTTI_ADD_FUNC(load_adapter_cache);
+   RTTI_ADD_FUNC(i2c_adapter_is_ignorable);
+   RTTI_ADD_FUNC(i2c_adapter_record_class);
+   RTTI_ADD_FUNC(i2c_save_adapter_cache);
+   RTTI_ADD_FUNC(i2c_erase_adapter_cache);
+}
+
+
+void terminate_i2c_adapter_cache() {
+   g_mutex_lock(&adapter_cache_mutex);
+   clear_adapter_cache_entries();
+   adapter_cache_loaded = false;
+   g_mutex_unlock(&adapter_cache_mutex);
+}
@@ -0,0 +1,40 @@
+/** @file i2c_adapter_cache.h
+ *
+ *  Persistent classification of I2C adapters, used to avoid examining
+ *  adapters that can never have a display attached.
+ */
+
+// Copyright (C) 2025 Sanford Rockowitz <rockowitz@minsoft.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef I2C_ADAPTER_CACHE_H_
+#define I2C_ADAPTER_CACHE_H_
+
+/** \cond */
+#include <glib-2.0/glib.h>
+#include <stdbool.h>
+/** \endcond */
+
+#include "util/error_info.h"
+
+#include "base/core.h"
+#include "base/status_code_mgt.h"
+
+typedef enum {
+   I2C_ADAPTER_UNCLASSIFIED,     ///< not yet classified
+   I2C_ADAPTER_CANDIDATE,        ///< may have a display attached, must be examined
+   I2C_ADAPTER_IGNORABLE,        ///< SMBus, sensor, non-video adapter, etc.
+} I2C_Adapter_Class;
+
+extern bool adapter_cache_enabled;
+
+const char * i2c_adapter_class_name(I2C_Adapter_Class adapter_class);
+bool         i2c_adapter_is_ignorable(int busno);
+void         i2c_adapter_record_class(int busno, I2C_Adapter_Class adapter_class);
+Status_Errno i2c_save_adapter_cache();
+Status_Errno i2c_erase_adapter_cache();
+void         dbgrpt_adapter_cache(int depth);
+void         init_i2c_adapter_cache();
+void         terminate_i2c_adapter_cache();
+
+#endif /* I2C_ADAPTER_CACHE_H_ */
@@ -38,6 +38,7 @@
 #include "util/sysfs_filter_functions.h"
 #include "util/sysfs_i2c_util.h"
 #include "util/sysfs_util.h"
+#include "util/timestamp.h"
 #include "util/traced_function_stack.h"
 #ifdef ENABLE_UDEV
 #include "util/udev_i2c_util.h"
@@ -49,6 +50,7 @@
 
 #include "base/core.h"
 #include "base/ddc_errno.h"
+#include "base/detection_timing.h"
 #include "base/display_lock.h"
 #include "base/flock.h"
 #include "base/i2c_bus_base.h"
@@ -60,6 +62,7 @@
 #include "base/sleep.h"
 #include "base/status_code_mgt.h"
 #include "base/tuned_sleep.h"
+#include "base/worker_pool.h"
 
 #include "sysfs/sysfs_i2c_info.h"
 #include "sysfs/sysfs_dpms.h"
@@ -75,6 +78,7 @@
 
 #include "i2c/i2c_strategy_dispatcher.h"
 #include "i2c/i2c_execute.h"
+#include "i2c/i2c_adapter_cache.h"
 #include "i2c/i2c_edid.h"
 
 #include "i2c/i2c_bus_core.h"
@@ -87,6 +91,7 @@ bool all_video_adapters_implement_drm = false;
 bool use_drm_connector_states = false;
 bool try_get_edid_from_sysfs_first = true;
 int  i2c_businfo_async_threshold = DEFAULT_BUS_CHECK_ASYNC_THRESHOLD;
+int  i2c_fd_pool_millisec = DEFAULT_I2C_FD_POOL_MILLISEC;
 
 
 // quick and dirty for debugging
@@ -120,7 +125,7 @@ Byte_Value_Array get_i2c_devices_by_existence_test(bool include_ignorable_device
    Byte_Value_Array bva = bva_create();
    for (int busno=0; busno < I2C_BUS_MAX; busno++) {
       if (i2c_device_exists(busno)) {
-         if (include_ignorable_devices || !sysfs_is_ignorable_i2c_device(busno))
+         if (include_ignorable_devices || !i2c_adapter_is_ignorable(busno))
             bva_append(bva, busno);
       }
    }
@@ -205,6 +210,184 @@ Error_Info * i2c_open_bus_basic(const char * filename,  Byte callopts, int* fd_l
 }
 
 
+//
+// Pool of idle /dev/i2c-N file descriptors
+//
+// Clients that open a display, perform one operation, and close it again
+// pay for open() and close() of the device each time.  When a bus is closed,
+// its file descriptor is instead kept for i2c_fd_pool_millisec.  The
+// cross-instance lock is released, so other processes can use the bus in
+// the meantime, but the descriptor is reused if the bus is reopened.  A
+// background thread closes descriptors that have been idle too long.
+//
+
+typedef struct {
+   int      busno;
+   int      fd;
+   uint64_t expires_nanos;
+} Pooled_Fd;
+
+static GMutex      fd_pool_mutex;
+static GCond       fd_pool_cond;
+static GPtrArray * fd_pool = NULL;            // Pooled_Fd *
+static GThread *   fd_pool_thread = NULL;
+static bool        fd_pool_terminate = false;
+static int         fd_pool_reuse_ct = 0;
+
+
+/** Function executed by the thread that closes idle file descriptors. */
+static gpointer
+fd_pool_thread_func(gpointer data) {
+   bool debug = false;
+   DBGTRC_STARTING(debug, TRACE_GROUP, "");
+
+   g_mutex_lock(&fd_pool_mutex);
+   while (!fd_pool_terminate) {
+      uint64_t now = cur_monotonic_nanosec();
+      uint64_t next_expiry = 0;
+      for (int ndx = fd_pool->len-1; ndx >= 0; ndx--) {
+         Pooled_Fd * pfd = g_ptr_array_index(fd_pool, ndx);
+         if (pfd->expires_nanos <= now) {
+            DBGTRC_NOPREFIX(debug, TRACE_GROUP, "Closing idle fd %d for /dev/"I2C"-%d",
+                                                pfd->fd, pfd->busno);
+            i2c_close_bus_basic(pfd->busno, pfd->fd, CALLOPT_NONE);
+            g_ptr_array_remove_index_fast(fd_pool, ndx);
+            free(pfd);
+         }
+         else if (next_expiry == 0 || pfd->expires_nanos < next_expiry) {
+            next_expiry = pfd->expires_nanos;
+         }
+      }
+      if (next_expiry == 0)
+         g_cond_wait(&fd_pool_cond, &fd_pool_mutex);
+      else
+         g_cond_wait_until(&fd_pool_cond, &fd_pool_mutex,
+                           g_get_monotonic_time() + NANOS2MICROS(next_expiry - now));
+   }
+   g_mutex_unlock(&fd_pool_mutex);
+
+   DBGTRC_DONE(debug, TRACE_GROUP, "");
+   return NULL;
+}
+
+
+/** Removes an idle file descriptor for a bus from the pool.
+ *
+ *  A descriptor whose device node no longer exists, e.g. because the
+ *  adapter was removed, is closed rather than returned.
+ *
+ *  @param  busno  I2C bus number
+ *  @return file descriptor, -1 if none
+ */
+static int
+take_pooled_fd(int busno) {
+   bool debug = false;
+   int fd = -1;
+   g_mutex_lock(&fd_pool_mutex);
+   if (fd_pool) {
+      for (guint ndx = 0; ndx < fd_pool->len; ndx++) {
+         Pooled_Fd * pfd = g_ptr_array_index(fd_pool, ndx);
+         if (pfd->busno == busno) {
+            fd = pfd->fd;
+            g_ptr_array_remove_index_fast(fd_pool, ndx);
+            free(pfd);
+            break;
+         }
+      }
+   }
+   g_mutex_unlock(&fd_pool_mutex);
+
+   if (fd >= 0) {
+      struct stat statbuf;
+      if (fstat(fd, &statbuf) < 0 || statbuf.st_nlink == 0) {
+         DBGTRC_NOPREFIX(debug, TRACE_GROUP, "Pooled fd %d for /dev/"I2C"-%d is stale", fd, busno);
+         i2c_close_bus_basic(busno, fd, CALLOPT_NONE);
+         fd = -1;
+      }
+      else {
+         g_mutex_lock(&fd_pool_mutex);
+         fd_pool_reuse_ct++;
+         g_mutex_unlock(&fd_pool_mutex);
+      }
+   }
+   DBGTRC_EXECUTED(debug, TRACE_GROUP, "busno=%d, returning %d", busno, fd);
+   return fd;
+}
+
+
+/** Places the file descriptor of a bus being closed in the pool.
+ *
+ *  Only descriptors opened read/write are pooled, since those are what
+ *  #i2c_open_bus() reuses.
+ *
+ *  @param  busno  I2C bus number
+ *  @param  fd     file descriptor, whose cross-instance lock has been released
+ *  @return true if the descriptor was pooled, false if the caller must close it
+ */
+static bool
+pool_fd(int busno, int fd) {
+   bool debug = false;
+   bool pooled = false;
+   int flags = fcntl(fd, F_GETFL);
+   if (i2c_fd_pool_millisec > 0 && flags >= 0 && (flags & O_ACCMODE) == O_RDWR) {
+      g_mutex_lock(&fd_pool_mutex);
+      if (!fd_pool_terminate) {
+         if (!fd_pool)
+            fd_pool = g_ptr_array_new();
+         bool busno_pooled = false;
+         for (guint ndx = 0; ndx < fd_pool->len; ndx++) {
+            if ( ((Pooled_Fd *) g_ptr_array_index(fd_pool, ndx))->busno == busno)
+               busno_pooled = true;
+         }
+         if (!busno_pooled) {
+            Pooled_Fd * pfd = calloc(1, sizeof(Pooled_Fd));
+            pfd->busno = busno;
+            pfd->fd = fd;
+            pfd->expires_nanos = cur_monotonic_nanosec() + MILLIS2NANOS((uint64_t) i2c_fd_pool_millisec);
+            g_ptr_array_add(fd_pool, pfd);
+            if (!fd_pool_thread)
+               fd_pool_thread = g_thread_new("i2c_fd_pool", fd_pool_thread_func, NULL);
+            g_cond_signal(&fd_pool_cond);
+            pooled = true;
+         }
+      }
+      g_mutex_unlock(&fd_pool_mutex);
+   }
+   DBGTRC_EXECUTED(debug, TRACE_GROUP, "busno=%d, fd=%d, returning %s", busno, fd, sbool(pooled));
+   return pooled;
+}
+
+
+/** Closes all pooled file descriptors and stops the thread that
+ *  closes idle descriptors.
+ */
+void
+i2c_close_pooled_fds() {
+   bool debug = false;
+   g_mutex_lock(&fd_pool_mutex);
+   fd_pool_terminate = true;
+   g_cond_signal(&fd_pool_cond);
+   GThread * thread = fd_pool_thread;
+   fd_pool_thread = NULL;
+   g_mutex_unlock(&fd_pool_mutex);
+   if (thread)
+      g_thread_join(thread);
+
+   g_mutex_lock(&fd_pool_mutex);
+   if (fd_pool) {
+      for (guint ndx = 0; ndx < fd_pool->len; ndx++) {
+         Pooled_Fd * pfd = g_ptr_array_index(fd_pool, ndx);
+         i2c_close_bus_basic(pfd->busno, pfd->fd, CALLOPT_NONE);
+         free(pfd);
+      }
+      g_ptr_array_free(fd_pool, true);
+      fd_pool = NULL;
+   }
+   DBGTRC_EXECUTED(debug, TRACE_GROUP, "fd_pool_reuse_ct=%d", fd_pool_reuse_ct);
+   g_mutex_unlock(&fd_pool_mutex);
+}
+
+
 /** Open an I2C bus device.
  *
  *  @param busno     bus number
@@ -273,6 +456,11 @@ Error_Info * i2c_open_bus(
       if (cur_error) {
          DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE, "lock_display_by_dpath(%s) returned %s", filename,
                          psc_desc(cur_error->status_code));
+         // lock_display() has already waited its turn in the lock queue,
+         // no point in retrying
+         if (cur_error->status_code == DDCRC_LOCKED ||
+             cur_error->status_code == DDCRC_ALREADY_OPEN)
+            total_wait_millisec = open_max_wait_millisec + 1;
       }
       else {
          device_locked = true;
@@ -280,8 +468,15 @@ Error_Info * i2c_open_bus(
                "lock_display_by_dpath(%s) succeeded", dpath_repr_t(&dpath));
       }
 
-      // 2) Open the device
-      if (!cur_error) {
+      // 2) Open the device, or reuse an idle file descriptor
+      if (!cur_error && !(callopts & CALLOPT_RDONLY)) {
+         *fd_loc = take_pooled_fd(busno);
+         if (*fd_loc >= 0) {
+            device_opened = true;
+            DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE, "Reusing fd %d for %s", *fd_loc, filename);
+         }
+      }
+      if (!cur_error && !device_opened) {
          cur_error = i2c_open_bus_basic(filename, callopts, fd_loc);
          if (!cur_error) {
             device_opened = true;
@@ -439,12 +634,17 @@ Status_Errno i2c_close_bus(int busno, int fd, Call_Options callopts) {
       }
    }
 
-   // 2) Close the device
-   DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE, "Calling i2c_close_bus for /dev/i2c-%d...", busno);
-   result = i2c_close_bus_basic(busno, fd, callopts);
-   assert(result == 0);   // TODO; handle failure
-   DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE, "/dev/i2c-%d.  i2c_close_bus_basic() returned %d", busno, result);
-   assert(result == 0);   // TODO; handle failure
+   // 2) Close the device, unless its file descriptor is kept for reuse
+   if (pool_fd(busno, fd)) {
+      DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE, "/dev/i2c-%d. fd %d kept for reuse", busno, fd);
+   }
+   else {
+      DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE, "Calling i2c_close_bus for /dev/i2c-%d...", busno);
+      result = i2c_close_bus_basic(busno, fd, callopts);
+      assert(result == 0);   // TODO; handle failure
+      DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE, "/dev/i2c-%d.  i2c_close_bus_basic() returned %d", busno, result);
+      assert(result == 0);   // TODO; handle failure
+   }
 
    // 1) Release the cross-thread lock
    DDCA_IO_Path dpath;
@@ -598,12 +798,12 @@ Error_Info * i2c_check_bus_responsive_using_drm(const char * drm_connector_name)
 
    Error_Info * result = NULL;
    char * status;
-   RPT_ATTR_TEXT(-1, &status, "/sys/class/drm", drm_connector_name, "status");
+   RPT_ATTR_TEXT(-1, &status, sysfs_class_drm, drm_connector_name, "status");
    if (streq(status, "disconnected"))   // *** WRONG Nvidia driver always reports "disconnected"
          result = ERRINFO_NEW(DDCRC_DISCONNECTED, "Display was disconnected");
    else {
       char * dpms;
-      RPT_ATTR_TEXT(-1, &dpms, "/sys/class/drm", drm_connector_name, "dpms");
+      RPT_ATTR_TEXT(-1, &dpms, sysfs_class_drm, drm_connector_name, "dpms");
       if ( !streq(dpms, "On"))
          result = ERRINFO_NEW(DDCRC_DPMS_ASLEEP, "Display is in a DPMS sleep mode");
    }
@@ -853,7 +1053,7 @@ void compare_edid_read_methods(int fd, I2C_Bus_Info * businfo) {
       GByteArray*  sysfs_edid_bytes = NULL;
       // int d = IS_DBGTRC(debug, TRACE_GROUP) ? 1 : -1;
       int d = -1;
-      RPT_ATTR_EDID(d, &sysfs_edid_bytes, "/sys/class/drm", businfo->drm_connector_name, "edid");
+      RPT_ATTR_EDID(d, &sysfs_edid_bytes, sysfs_class_drm, businfo->drm_connector_name, "edid");
       if (sysfs_edid_bytes && true_i2c_edid) {
          if (memcmp(true_i2c_edid->bytes, sysfs_edid_bytes, 128) == 0) {
             DBGMSG("Correct edid now read from sysfs");
@@ -891,8 +1091,8 @@ void compare_edid_read_methods(int fd, I2C_Bus_Info * businfo) {
 bool is_displaylink_device(int busno) {
    bool debug = false;
    bool result = false;
-   char bus_path[40];
-   g_snprintf(bus_path, 40, "/sys/bus/i2c/devices/i2c-%d", busno);
+   char bus_path[PATH_MAX];
+   g_snprintf(bus_path, PATH_MAX, "%s/i2c-%d", sysfs_bus_i2c_devices, busno);
    char * name;
    RPT_ATTR_TEXT((debug)? 1 : -1, &name, bus_path, "name");
    if (name) {
@@ -964,7 +1164,7 @@ Found_Sys_Drm_Connector find_sys_drm_connector_by_busno_or_edid(
       char * cname = g_ptr_array_index(drm_connector_names, ndx);
       if (check_busno) {
          Connector_Bus_Numbers * cbn = calloc(1, sizeof(Connector_Bus_Numbers));
-         get_connector_bus_numbers("/sys/class/drm", cname, cbn);
+         get_connector_bus_numbers(sysfs_class_drm, cname, cbn);
          if (cbn->i2c_busno == busno){
             found = true;
             result.connector_name = strdup(cname);
@@ -980,7 +1180,7 @@ Found_Sys_Drm_Connector find_sys_drm_connector_by_busno_or_edid(
          if (result.found_by != DRM_CONNECTOR_FOUND_BY_BUSNO) {
             GByteArray*  edid_bytes_array = NULL;
             possibly_write_detect_to_status_by_connector_name(cname);
-            RPT_ATTR_EDID(d, &edid_bytes_array, "/sys/class/drm", cname, "edid");
+            RPT_ATTR_EDID(d, &edid_bytes_array, sysfs_class_drm, cname, "edid");
             if (edid_bytes_array && edid_bytes_array->len >= 128) {
                 DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE, "Got edid from sysfs: %s",
                       edid_summary_from_bytes(edid_bytes_array->data));
@@ -1023,7 +1223,7 @@ Byte * get_connector_edid(const char * connector_name) {
    Byte * result = NULL;
    GByteArray*  edid_bytes = NULL;
    possibly_write_detect_to_status_by_connector_name(connector_name);
-   RPT_ATTR_EDID(d, &edid_bytes, "/sys/class/drm", connector_name, "edid");
+   RPT_ATTR_EDID(d, &edid_bytes, sysfs_class_drm, connector_name, "edid");
    DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE, "edid_bytes=%p", edid_bytes);
    if (edid_bytes && edid_bytes->len >= 128) {
       DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE, "edid_bytes->len=%d", edid_bytes->len);
@@ -1066,11 +1266,11 @@ Byte * get_connector_edid(const char * connector_name) {
     // int d = ( IS_DBGTRC(debug, TRACE_GROUP) ) ? 1 : -1;
     assert(busno >= 0);
     assert(busno != 255);
-    char sysfs_name[30];
+    char sysfs_name[PATH_MAX];
     char dev_name[15];
     char i2cN[10];  // only need 8, but coverity complains
     g_snprintf(i2cN, 10, "i2c-%d", busno);
-    g_snprintf(sysfs_name, 30, "/sys/bus/i2c/devices/%s", i2cN);
+    g_snprintf(sysfs_name, PATH_MAX, "%s/%s", sysfs_bus_i2c_devices, i2cN);
     g_snprintf(dev_name,   15, "/dev/%s", i2cN);
     DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE, "sysfs_name = |%s|, dev_name = |%s|", sysfs_name, dev_name);
     bool edid_exists = false;
@@ -1093,7 +1293,7 @@ Byte * get_connector_edid(const char * connector_name) {
 
     bool is_displaylink = is_displaylink_device(busno);
 
-    bool drm_card_connector_directories_exist = directory_exists("/sys/class/drm");
+    bool drm_card_connector_directories_exist = directory_exists(sysfs_class_drm);
     // *** Try to find the drm connector by bus number
 
     if (drm_card_connector_directories_exist) {
@@ -1266,7 +1466,7 @@ Byte * get_connector_edid(const char * connector_name) {
 
     GPtrArray * connector_names = g_ptr_array_new_with_free_func(free_sys_drm_connector);
     dir_filtered_ordered_foreach(
-          "/sys/class/drm",
+          sysfs_class_drm,
           is_drm_connector,      // filter function
           NULL,                  // ordering function
           add_one_drm_connector_name,
@@ -1483,11 +1683,11 @@ Error_Info * i2c_check_bus(I2C_Bus_Info * businfo) {
    bool try_get_edid_from_sysfs_first = true;
 
    // int busno = businfo->busno;
-   char sysfs_name[30];
+   char sysfs_name[PATH_MAX];
    char dev_name[15];
    char i2cN[10];  // only need 8, but coverity complains
    g_snprintf(i2cN, 10, "i2c-%d", businfo->busno);
-   g_snprintf(sysfs_name, 30, "/sys/bus/i2c/devices/%s", i2cN);
+   g_snprintf(sysfs_name, PATH_MAX, "%s/%s", sysfs_bus_i2c_devices, i2cN);
    g_snprintf(dev_name,   15, "/dev/%s", i2cN);
    DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE, "sysfs_name = |%s|, dev_name = |%s|", sysfs_name, dev_name);
    // int d = (IS_DBGTRC(debug, DDCA_TRC_NONE)) ? 1 : -1;
@@ -1508,6 +1708,7 @@ Error_Info * i2c_check_bus(I2C_Bus_Info * businfo) {
       goto bye;
    }
 
+   uint64_t phase_start = DTIM_START();
    if (!primitive_sysfs) {
       if (!businfo->driver) {
          Sysfs_I2C_Info * driver_info = get_i2c_driver_info(businfo->busno, -1);
@@ -1522,6 +1723,8 @@ Error_Info * i2c_check_bus(I2C_Bus_Info * businfo) {
             master_err = ERRINFO_NEW(DDCRC_OTHER, "Display controller for bus %d has class %s",
                   businfo->busno, driver_info->adapter_class);
             free_sysfs_i2c_info(driver_info);
+            i2c_adapter_record_class(businfo->busno, I2C_ADAPTER_IGNORABLE);
+            dtim_record_phase(businfo->busno, DTIM_PHASE_SYSFS, phase_start);
             goto bye;
          }
          free_sysfs_i2c_info(driver_info);
@@ -1561,6 +1764,8 @@ Error_Info * i2c_check_bus(I2C_Bus_Info * businfo) {
       }
    }
 
+   dtim_record_phase(businfo->busno, DTIM_PHASE_SYSFS, phase_start);
+
    // *** Possibly try to get the EDID from sysfs
    bool checked_connector_for_edid = false;
    if (businfo->drm_connector_name)  {   // i.e. DRM_CONNECTOR_FOUND_BY_BUSNO
@@ -1568,12 +1773,14 @@ Error_Info * i2c_check_bus(I2C_Bus_Info * businfo) {
       if ((try_get_edid_from_sysfs_first && businfo->flags&I2C_BUS_SYSFS_KNOWN_RELIABLE)  ||
             (businfo->flags&I2C_BUS_DISPLAYLINK))   // X50 can't be read for DisplayLink, must use sysfs
       {
+         phase_start = DTIM_START();
          Parsed_Edid * edid = get_parsed_edid_for_businfo_using_sysfs(businfo);
          if (edid) {
             businfo->edid = edid;
             businfo->flags |= I2C_BUS_SYSFS_EDID;
          }
          checked_connector_for_edid = true;
+         dtim_record_phase(businfo->busno, DTIM_PHASE_SYSFS_EDID, phase_start);
       }
    }
 
@@ -1581,10 +1788,12 @@ Error_Info * i2c_check_bus(I2C_Bus_Info * businfo) {
 
    DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE, "Calling i2c_open_bus for /dev/i2c-%d..", businfo->busno);
    int fd = -1;
+   phase_start = DTIM_START();
    master_err = i2c_open_bus(businfo->busno, CALLOPT_WAIT, &fd);
 #ifdef ALT_LOCK_REC
    master_err = i2c_open_bus(businfo->busno, businfo->CALLOPT_WAIT, &fd);
 #endif
+   dtim_record_phase(businfo->busno, DTIM_PHASE_OPEN, phase_start);
    if (master_err) {
       businfo->open_errno = master_err->status_code;
       goto bye;
@@ -1603,7 +1812,9 @@ Error_Info * i2c_check_bus(I2C_Bus_Info * businfo) {
    if (!checked_connector_for_edid) {
       DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE, "busno=%d, calling i2c_get_parsed_edid", businfo->busno);
       assert(!businfo->edid);
+      phase_start = DTIM_START();
       DDCA_Status ddcrc = i2c_get_parsed_edid_by_fd(fd, &businfo->edid);
+      dtim_record_phase(businfo->busno, DTIM_PHASE_X50_EDID, phase_start);
       DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE, "busno=%d, i2c_get_parsed_edid_by_fd() returned %s",
                     businfo->busno, psc_desc(ddcrc));
       // NB It's quite possible that bus has no edid
@@ -1619,7 +1830,9 @@ Error_Info * i2c_check_bus(I2C_Bus_Info * businfo) {
    // If there's an EDID on the bus and we don't yet have the connector name
    // based on a busno match, try EDID match
    if (!businfo->drm_connector_name && businfo->edid && drm_card_connector_directories_exist) {
+      phase_start = DTIM_START();
       set_connector_for_businfo_using_edid(businfo);
+      dtim_record_phase(businfo->busno, DTIM_PHASE_SYSFS, phase_start);
    }
 
    DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE, "Bus %s: connector_name=%s, found by: %s",
@@ -1661,7 +1874,9 @@ Error_Info * i2c_check_bus(I2C_Bus_Info * businfo) {
          // trying to reload cached display information for a display no
          // longer present
 
+         phase_start = DTIM_START();
          check_x37_for_businfo(fd,businfo);
+         dtim_record_phase(businfo->busno, DTIM_PHASE_X37_PROBE, phase_start);
       }
    }
 
@@ -1694,11 +1909,11 @@ void i2c_recheck_bus(I2C_Bus_Info * businfo) {
    assert(businfo->busno != 255);
    // bool try_get_edid_from_sysfs_first = true;
    // int busno = businfo->busno;
-   char sysfs_name[30];
+   char sysfs_name[PATH_MAX];
    char dev_name[15];
    char i2cN[10];  // only need 8, but coverity complains
    g_snprintf(i2cN, 10, "i2c-%d", businfo->busno);
-   g_snprintf(sysfs_name, 30, "/sys/bus/i2c/devices/%s", i2cN);
+   g_snprintf(sysfs_name, PATH_MAX, "%s/%s", sysfs_bus_i2c_devices, i2cN);
    g_snprintf(dev_name,   15, "/dev/%s", i2cN);
    DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE, "sysfs_name = |%s|, dev_name = |%s|", sysfs_name, dev_name);
    // int d = (IS_DBGTRC(debug, DDCA_TRC_NONE)) ? 1 : -1;
@@ -1841,17 +2056,16 @@ i2c_threaded_initial_checks_by_businfo(gpointer data) {
    DBGTRC_STARTING(debug, TRACE_GROUP, "bus = /dev/i2c-%d", businfo->busno );
 
    Error_Info * err = i2c_check_bus(businfo);
-   // g_thread_exit(NULL);
 
    DBGTRC_RET_ERRINFO(debug, TRACE_GROUP, err, "bus=/dev/i2c-%d", businfo->busno );
-   free_current_traced_function_stack();
    return err;
 }
 
 
-/** Spawns threads to perform initial checks and waits for them all to complete.
+/** Performs initial checks on each bus using the shared worker pool,
+ *  and waits for them all to complete.
  *
- *  @param all_displays #GPtrArray of pointers to #I2c_Bus_Info
+ *  @param i2c_buses #GPtrArray of pointers to #I2C_Bus_Info
  */
 STATIC void
 i2c_async_scan(GPtrArray * i2c_buses) {
@@ -1859,28 +2073,13 @@ i2c_async_scan(GPtrArray * i2c_buses) {
    DBGTRC_STARTING(debug, TRACE_GROUP, "i2c_buses=%p, bus count=%d",
                                        i2c_buses, i2c_buses->len);
 
-   GPtrArray * threads = g_ptr_array_new();
-   for (int ndx = 0; ndx < i2c_buses->len; ndx++) {
-      I2C_Bus_Info * businfo = g_ptr_array_index(i2c_buses, ndx);
-      TRACED_ASSERT( memcmp(businfo->marker, I2C_BUS_INFO_MARKER, 4) == 0 );
-
-      char buf[16];
-      g_snprintf(buf, 16, "/dev/i2c-%d", businfo->busno);
-      GThread * th =
-      g_thread_new(
-            buf,                // thread name
-            i2c_threaded_initial_checks_by_businfo,
-            businfo);                            // pass pointer to display ref as data
-      g_ptr_array_add(threads, th);
-   }
-   DBGMSF(debug, "Started %d threads", threads->len);
-   for (int ndx = 0; ndx < threads->len; ndx++) {
-      GThread * thread = g_ptr_array_index(threads, ndx);
-      Error_Info * err = g_thread_join(thread);  // implicitly unrefs the GThread
+   GPtrArray * errors = wp_run_parallel("i2c_async_scan", i2c_buses,
+                                        i2c_threaded_initial_checks_by_businfo);
+   for (int ndx = 0; ndx < errors->len; ndx++) {
+      Error_Info * err = g_ptr_array_index(errors, ndx);
       ERRINFO_FREE_WITH_REPORT(err, IS_DBGTRC(debug, TRACE_GROUP) || is_report_ddc_errors_enabled() );
    }
-   DBGMSF(debug, "Threads joined");
-   g_ptr_array_free(threads, true);
+   g_ptr_array_free(errors, true);
 
    DBGTRC_DONE(debug, TRACE_GROUP, "");
 }
@@ -1931,7 +2130,7 @@ get_i2c_device_numbers_using_udev(bool include_ignorable_devices) {
          int busno = udev_i2c_device_summary_busno(summary);
          assert(busno >= 0);
          assert(busno <= 127);
-         if ( include_ignorable_devices || !sysfs_is_ignorable_i2c_device(busno) )
+         if ( include_ignorable_devices || !i2c_adapter_is_ignorable(busno) )
             bva_append(bva, busno);
       }
       free_udev_device_summaries(summaries);
@@ -2033,7 +2232,9 @@ GPtrArray * i2c_detect_buses0() {
    // GPtrArray * i2c_infos = get_all_i2c_info(true, -1);
    // dbgrpt_all_sysfs_i2c_info(i2c_infos, 2);
 
+   uint64_t phase_start = DTIM_START();
    BS256 bs_attached_buses = i2c_detect_attached_buses_as_bitset();
+   dtim_record_phase(DTIM_ALL_BUSES, DTIM_PHASE_BUS_ENUM, phase_start);
    Bit_Set_256_Iterator iter = bs256_iter_new(bs_attached_buses);
    GPtrArray * buses = g_ptr_array_sized_new(bs256_count(bs_attached_buses));
    while (true) {
@@ -2057,6 +2258,8 @@ GPtrArray * i2c_detect_buses0() {
       i2c_async_scan(buses);
    }
 
+   i2c_save_adapter_cache();
+
    if (debug) {
       for (int ndx = 0; ndx < buses->len; ndx++) {
          I2C_Bus_Info * businfo = g_ptr_array_index(buses, ndx);
@@ -2116,6 +2319,9 @@ int i2c_detect_buses() {
    DBGTRC_STARTING(debug, DDCA_TRC_I2C, "all_i2c_buses = %p", all_i2c_buses);
 
    if (!all_i2c_buses) {
+      // the bus scan is the first part of a detection cycle,
+      // continued by ddc_detect_all_displays()
+      dtim_start_detection();
       all_i2c_buses = i2c_detect_buses0();
       g_ptr_array_set_free_func(all_i2c_buses, (GDestroyNotify) i2c_free_bus_info);
    }
@@ -2336,12 +2542,12 @@ void i2c_report_active_bus(I2C_Bus_Info * businfo, int depth) {
       // rpt_vstring(d1, "I2C address 0x37 (DDC) responsive:  %-5s", sbool(businfo->flags & I2C_BUS_ADDR_0X37));
 
       char fn[PATH_MAX];     // yes, PATH_MAX is dangerous, but not as used here
-      sprintf(fn, "/sys/bus/i2c/devices/i2c-%d/name", businfo->busno);
+      g_snprintf(fn, PATH_MAX, "%s/i2c-%d/name", sysfs_bus_i2c_devices, businfo->busno);
       char * sysattr_name = file_get_first_line(fn, /* verbose*/ false);
       // rpt_vstring(d1, "%-*s%s", title_width, fn, sysattr_name);
       DO_OUTPUT(d1, title_width, fn, sysattr_name);
       free(sysattr_name);
-      sprintf(fn, "/sys/bus/i2c/devices/i2c-%d", businfo->busno);
+      g_snprintf(fn, PATH_MAX, "%s/i2c-%d", sysfs_bus_i2c_devices, businfo->busno);
       char * path = NULL;
       GET_ATTR_REALPATH(&path, fn);
       // rpt_vstring(d1, "PCI device path:                       %s", path);
@@ -2393,6 +2599,7 @@ static void init_i2c_bus_core_func_name_table() {
    RTTI_ADD_FUNC(i2c_check_edid_exists_by_dh);
    RTTI_ADD_FUNC(i2c_check_open_bus_alive);
    RTTI_ADD_FUNC(i2c_close_bus);
+   RTTI_ADD_FUNC(i2c_close_pooled_fds);
    RTTI_ADD_FUNC(i2c_detect_attached_buses);
    RTTI_ADD_FUNC(i2c_detect_buses);
    RTTI_ADD_FUNC(i2c_detect_buses0);
@@ -2408,6 +2615,8 @@ static void init_i2c_bus_core_func_name_table() {
    RTTI_ADD_FUNC(is_adapter_class_display_controller);
    RTTI_ADD_FUNC(is_laptop_drm_connector_name);
    RTTI_ADD_FUNC(is_laptop_for_businfo);
+   RTTI_ADD_FUNC(pool_fd);
+   RTTI_ADD_FUNC(take_pooled_fd);
 }
 
 
@@ -2418,6 +2627,7 @@ void subinit_i2c_bus_core() {
 
 void init_i2c_bus_core() {
    init_i2c_bus_core_func_name_table();
+   fd_pool_terminate = false;
    open_failures_reported = EMPTY_BIT_SET_256;
 }
 
@@ -35,6 +35,7 @@ extern bool all_video_adapters_implement_drm;
 extern bool use_drm_connector_states;
 extern bool try_get_edid_from_sysfs_first;
 extern int  i2c_businfo_async_threshold;
+extern int  i2c_fd_pool_millisec;
 extern bool cross_instance_locks_enabled;
 
 Byte_Value_Array get_i2c_devices_by_existence_test(bool include_ignorable_devices);
@@ -51,7 +52,9 @@ Error_Info *     i2c_open_bus(int busno, Byte callopts, int * fd_loc);
 #ifdef ALT_LOCK_REC
 Error_Info *     i2c_open_bus(int busno, Display_Lock_Record lockrec, Byte callopts, int * fd_loc);
 #endif
+Status_Errno     i2c_close_bus_basic(int busno, int fd, Call_Options callopts);
 Status_Errno     i2c_close_bus(int busno, int fd, Call_Options callopts);
+void             i2c_close_pooled_fds();
 
 // Bus inspection
 I2C_Bus_Info *   i2c_get_and_check_bus_info(int busno);
@@ -5,6 +5,7 @@
 
 #include "base/i2c_bus_base.h"
 
+#include "i2c_adapter_cache.h"
 #include "i2c_bus_core.h"
 #include "i2c_edid.h"
 #include "i2c_execute.h"
@@ -12,6 +13,7 @@
 
 /** Master initializer for directory i2c */
 void init_i2c_services() {
+   init_i2c_adapter_cache();
    init_i2c_bus_core();
    init_i2c_edid();
    init_i2c_execute();
@@ -19,5 +21,7 @@ void init_i2c_services() {
 }
 
 void terminate_i2c_services() {
+   i2c_close_pooled_fds();
+   terminate_i2c_adapter_cache();
    terminate_i2c_bus_base();
 }
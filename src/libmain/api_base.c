@@ -12,6 +12,7 @@
 #include <dlfcn.h>     // _GNU_SOURCE for dladdr()
 #include <errno.h>
 #include <glib-2.0/glib.h>
+#include <inttypes.h>
 #include <signal.h>
 #include <string.h>
 #include <syslog.h>
@@ -26,6 +27,7 @@
 #include "util/regex_util.h"
 #include "util/report_util.h"
 #include "util/sysfs_filter_functions.h"
+#include "util/timestamp.h"
 #include "util/traced_function_stack.h"
 #include "util/xdg_util.h"
 
@@ -36,6 +38,7 @@
 #include "base/display_lock.h"
 #include "base/core.h"
 #include "base/dsa2.h"
+#include "base/feature_value_cache.h"
 #include "base/parms.h"
 #include "base/per_display_data.h"
 #include "base/per_thread_data.h"
@@ -48,6 +51,7 @@
 
 #include "sysfs/sysfs_base.h"
 
+#include "i2c/i2c_adapter_cache.h"
 #include "i2c/i2c_bus_core.h"   // for testing watch_devices
 #include "i2c/i2c_execute.h"    // for i2c_set_addr()
 
@@ -61,12 +65,16 @@
 #include "ddc/ddc_vcp.h"
 
 #ifdef WATCH_DISPLAYS
+#include "dw/dw_callback_executor.h"
+#include "dw/dw_common.h"
 #include "dw/dw_main.h"
 #include "dw/dw_services.h"
 #endif
 
 #include "libmain/api_error_info_internal.h"
 #include "libmain/api_base_internal.h"
+#include "libmain/api_capabilities_internal.h"
+#include "libmain/api_displays_internal.h"
 #include "libmain/api_services_internal.h"
 
 //
@@ -87,11 +95,20 @@ static FILE * flog = NULL;
 static DDCA_Stats_Type requested_stats = 0;
 static bool per_display_stats = false;
 static bool dsa_detail_stats;
-static int    active_calls = 0;
-static int    max_active_calls = 0;
-static GMutex active_calls_mutex;
-static bool   api_quiesced = false;
-static GMutex api_quiesced_mutex;
+
+// API entry gating.  The count of active API calls that respect quiesce and
+// the count of outstanding quiesce requests share a single atomic int, so
+// that entering and leaving an API call takes a single atomic add.  Only a
+// caller of quiesce_api() ever blocks, on quiesce_cond, and it is awakened by
+// the last active call to exit.
+#define API_GATE_QUIESCE_UNIT   (1 << 20)
+#define API_GATE_ACTIVE_MASK    (API_GATE_QUIESCE_UNIT - 1)
+#define API_GATE_ACTIVE(_gate)  ((_gate) & API_GATE_ACTIVE_MASK)
+#define API_GATE_QUIESCED(_gate) ((_gate) >= API_GATE_QUIESCE_UNIT)
+static gint   api_gate = 0;
+static gint   max_active_calls = 0;
+static GMutex quiesce_mutex;
+static GCond  quiesce_cond;
 
 
 //
@@ -209,22 +226,41 @@ ddca_libddcutil_filename(void) {
 }
 
 
+/** Wakes a thread waiting in #quiesce_api() if the API is being quiesced
+ *  and no active API calls remain.
+ *
+ *  @param  gate  value of api_gate after the active call count was decremented
+ */
+static void wake_quiescer_if_idle(gint gate) {
+   if (API_GATE_QUIESCED(gate) && API_GATE_ACTIVE(gate) == 0) {
+      g_mutex_lock(&quiesce_mutex);
+      g_cond_broadcast(&quiesce_cond);
+      g_mutex_unlock(&quiesce_mutex);
+   }
+}
+
+
 bool increment_active_api_calls(const char * funcname) {
    bool debug = false;
-   DBGTRC_STARTING(debug, DDCA_TRC_NONE, "funcname=%s, active_calls=%d", funcname, active_calls);
+   DBGTRC_STARTING(debug, DDCA_TRC_NONE, "funcname=%s, active_calls=%d",
+                                         funcname, API_GATE_ACTIVE(g_atomic_int_get(&api_gate)));
 
    bool result = true;
-   g_mutex_lock(&api_quiesced_mutex);  // blocks API calls from starting
-   g_mutex_lock(&active_calls_mutex);
-   if (api_quiesced || library_disabled)
+   gint gate = g_atomic_int_add(&api_gate, 1) + 1;
+   if (API_GATE_QUIESCED(gate) || library_disabled) {
+      gate = g_atomic_int_add(&api_gate, -1) - 1;
+      wake_quiescer_if_idle(gate);
       result = false;
+   }
    else {
-      active_calls++;
-      if (active_calls > max_active_calls)
-         max_active_calls = active_calls;
+      gint active = API_GATE_ACTIVE(gate);
+      gint max_active = g_atomic_int_get(&max_active_calls);
+      while (active > max_active &&
+             !g_atomic_int_compare_and_exchange(&max_active_calls, max_active, active))
+      {
+         max_active = g_atomic_int_get(&max_active_calls);
+      }
    }
-   g_mutex_unlock(&active_calls_mutex);
-   g_mutex_unlock(&api_quiesced_mutex);
 
    DBGTRC_DONE(debug, DDCA_TRC_NONE, "funcname=%s, returning %s", funcname, SBOOL(result));
    return result;
@@ -233,17 +269,22 @@ bool increment_active_api_calls(const char * funcname) {
 
 void decrement_active_api_calls(const char * funcname) {
    bool debug = false;
-   DBGTRC_STARTING(debug, DDCA_TRC_NONE, "funcname=%s, active_calls=%d", funcname, active_calls);
+   DBGTRC_STARTING(debug, DDCA_TRC_NONE, "funcname=%s, active_calls=%d",
+                                         funcname, API_GATE_ACTIVE(g_atomic_int_get(&api_gate)));
 
    bool oops = false;
-   g_mutex_lock(&active_calls_mutex);
-   if (active_calls > 0) {
-      active_calls--;
+   gint gate = g_atomic_int_get(&api_gate);
+   while (API_GATE_ACTIVE(gate) > 0 &&
+          !g_atomic_int_compare_and_exchange(&api_gate, gate, gate-1))
+   {
+      gate = g_atomic_int_get(&api_gate);
+   }
+   if (API_GATE_ACTIVE(gate) > 0) {
+      wake_quiescer_if_idle(gate-1);
    }
    else {
       oops = true;
    }
-   g_mutex_unlock(&active_calls_mutex);
    if (oops) {
       MSG_W_SYSLOG(DDCA_SYSLOG_ERROR, "Unmatched active call ct in %s", funcname);
    }
@@ -256,48 +297,42 @@ void decrement_active_api_calls(const char * funcname) {
  *
  *  When quiesced, API calls that can affect monitor state terminate immediately with status DDCRC_QUIESCED.
  *
- *  This function waits at most 3000 miliseconds for outstanding API calls to complete.
- *  If calls are still outstanding, an error messages is written to the system log,
- *  but this does not prevent queiescing,
+ *  This function waits at most #QUIESCE_API_MAX_WAIT_MILLISEC for outstanding API
+ *  calls to complete.  If calls are still outstanding, an error messages is written
+ *  to the system log, but this does not prevent queiescing.
+ *
+ *  Calls may be nested.  The API remains quiesced until each call has been
+ *  matched by a call to #unquiesce_api().
  */
 void quiesce_api() {
    bool debug = false;
    DBGTRC_STARTING(debug, DDCA_TRC_API, "");
 
    SYSLOG2(DDCA_SYSLOG_NOTICE, "Quiescing libddcutil API...");
-   bool oops = false;
-   int slept_nanosec = 0;
-
-   g_mutex_lock(&api_quiesced_mutex);
-
-   g_mutex_lock(&active_calls_mutex);
-   if (active_calls > 0) {
-      int poll_max_millisec = 3000;       // move to parms.h
-      int poll_interval_millisec = 100;   // move to parms.h
-      int poll_max_nanosec = poll_max_millisec * 1000;
-      int poll_interval_nanosec = poll_interval_millisec * 1000;
-      oops = true;
-      for (; slept_nanosec < poll_max_nanosec; slept_nanosec += poll_interval_nanosec) {
-         usleep(poll_interval_nanosec);
-         if (active_calls == 0) {
-            oops = false;
-            break;
-         }
+   uint64_t start_nanos = cur_monotonic_nanosec();
+
+   g_mutex_lock(&quiesce_mutex);
+   gint gate = g_atomic_int_add(&api_gate, API_GATE_QUIESCE_UNIT) + API_GATE_QUIESCE_UNIT;
+   gint64 end_time = g_get_monotonic_time() + QUIESCE_API_MAX_WAIT_MILLISEC * G_TIME_SPAN_MILLISECOND;
+   while (API_GATE_ACTIVE(gate) > 0) {
+      if (!g_cond_wait_until(&quiesce_cond, &quiesce_mutex, end_time)) {
+         gate = g_atomic_int_get(&api_gate);
+         break;
       }
+      gate = g_atomic_int_get(&api_gate);
    }
-   g_mutex_unlock(&active_calls_mutex);
-
-   api_quiesced = true;
-   g_mutex_unlock(&api_quiesced_mutex);
+   g_mutex_unlock(&quiesce_mutex);
+   int active_calls = API_GATE_ACTIVE(gate);
 
-   if (oops) {
+   if (active_calls > 0) {
       MSG_W_SYSLOG(DDCA_SYSLOG_ERROR, "Error queiscing libdducitl API. %d active API calls outstanding.", active_calls);
    }
    else {
       SYSLOG2(DDCA_SYSLOG_NOTICE, "Quiesce libddcutil API complete");
    }
 
-   DBGTRC_DONE(debug, DDCA_TRC_API, "Terminating with %d active API calls outstanding. Waited %d millisec", active_calls, slept_nanosec/1000);
+   DBGTRC_DONE(debug, DDCA_TRC_API, "Terminating with %d active API calls outstanding. Waited %"PRIu64" millisec",
+                                    active_calls, NANOS2MILLIS(cur_monotonic_nanosec() - start_nanos));
 }
 
 
@@ -308,9 +343,11 @@ void unquiesce_api() {
    DBGTRC_STARTING(debug, DDCA_TRC_API, "");
 
    SYSLOG2(DDCA_SYSLOG_NOTICE, "Unquiescing libddcutil API...");
-   g_mutex_lock(&api_quiesced_mutex);
-   api_quiesced = false;
-   g_mutex_unlock(&api_quiesced_mutex);
+   gint gate = g_atomic_int_get(&api_gate);
+   if (API_GATE_QUIESCED(gate))
+      g_atomic_int_add(&api_gate, -API_GATE_QUIESCE_UNIT);
+   else
+      SYSLOG2(DDCA_SYSLOG_ERROR, "unquiesce_api() called when API not quiesced");
 
    DBGTRC_DONE(debug, DDCA_TRC_API, "");
 }
@@ -643,8 +680,16 @@ _ddca_terminate(void) {
       if (display_caching_enabled)
          ddc_store_displays_cache();
       ddc_discard_detected_displays();
-      if (requested_stats)
+      ddci_release_cached_display_info_snapshots();
+      if (requested_stats) {
          ddc_report_stats_main(requested_stats, per_display_stats, dsa_detail_stats, false, 0);
+#ifdef WATCH_DISPLAYS
+         if (requested_stats & DDCA_STATS_CALLS) {
+            dw_report_callback_executor_stats(0);
+            dw_report_watch_stats(0);
+         }
+#endif
+      }
 #ifdef WATCH_DISPLAYS
       DDCA_Display_Event_Class active_classes;
       if (dw_is_watch_displays_executing())
@@ -653,6 +698,7 @@ _ddca_terminate(void) {
       // sleep(5); // still needed?
       terminate_dw_services();
 #endif
+      terminate_api_capabilities();
       terminate_ddc_services();
       terminate_base_services();
       free_regex_hash_table();
@@ -1266,6 +1312,49 @@ ddca_is_verify_enabled() {
 }
 
 
+bool
+ddca_enable_feature_value_cache(bool onoff) {
+   bool old = feature_value_cache_enabled;
+   feature_value_cache_enabled = onoff;
+   return old;
+}
+
+
+bool
+ddca_is_feature_value_cache_enabled() {
+   return feature_value_cache_enabled;
+}
+
+
+bool
+ddca_enable_adapter_cache(bool onoff) {
+   bool old = adapter_cache_enabled;
+   adapter_cache_enabled = onoff;
+   return old;
+}
+
+
+bool
+ddca_is_adapter_cache_enabled() {
+   return adapter_cache_enabled;
+}
+
+
+DDCA_Status
+ddca_set_feature_value_cache_ttl(
+      DDCA_Vcp_Feature_Code  feature_code,
+      int                    ttl_millis)
+{
+   bool debug = false;
+   API_PROLOGX(debug, NORESPECT_QUIESCE, "feature_code=0x%02x, ttl_millis=%d", feature_code, ttl_millis);
+   DDCA_Status psc = API_PRECOND_RVALUE(ttl_millis >= DDCA_CACHE_TTL_DEFAULT);
+   if (psc == 0)
+      fvc_set_ttl_override(feature_code, ttl_millis);
+   API_EPILOG_BEFORE_RETURN(debug, NORESPECT_QUIESCE, psc, "");
+   return psc;
+}
+
+
 #ifdef REMOVED
 
 // *** FOR CURRENT THREAD
@@ -1466,14 +1555,8 @@ ddca_is_force_slave_address_enabled(void) {
 void
 ddca_reset_stats(void) {
    DBGMSG("Executing");
-   g_mutex_lock(&api_quiesced_mutex);
-   g_mutex_lock(&active_calls_mutex);
-
    ddc_reset_stats_main();
-   max_active_calls = 0;
-
-   g_mutex_unlock(&active_calls_mutex);
-   g_mutex_unlock(&api_quiesced_mutex);
+   g_atomic_int_set(&max_active_calls, API_GATE_ACTIVE(g_atomic_int_get(&api_gate)));
 }
 
 
@@ -1490,9 +1573,17 @@ ddca_show_stats(
    if (stats_types) {
       ddc_report_stats_main( stats_types, per_display_stats, per_display_stats, false, depth);
       rpt_nl();
+#ifdef WATCH_DISPLAYS
+      if (stats_types & DDCA_STATS_CALLS) {
+         dw_report_callback_executor_stats(depth);
+         rpt_nl();
+         dw_report_watch_stats(depth);
+         rpt_nl();
+      }
+#endif
    }
 
-   rpt_vstring(0, "Max concurrent API calls: %d", max_active_calls);
+   rpt_vstring(0, "Max concurrent API calls: %d", g_atomic_int_get(&max_active_calls));
 #ifdef REDUNDANT
    if (stats_types & DDCA_STATS_API) {
       if (ptd_api_profiling_enabled) {
@@ -1515,6 +1606,7 @@ ddca_report_locks(
 void init_api_base() {
    // DBGMSG("Executing");
    RTTI_ADD_FUNC(_ddca_terminate);
+   RTTI_ADD_FUNC(ddca_set_feature_value_cache_ttl);
    RTTI_ADD_FUNC(ddca_start_watch_displays);
    RTTI_ADD_FUNC(ddca_stop_watch_displays);
    RTTI_ADD_FUNC(ddca_get_active_watch_classes);
@@ -68,8 +68,7 @@ ddca_get_capabilities_string(
          char * p_cap_string = NULL;
          ddc_excp = ddc_get_capabilities_string(dh, &p_cap_string);
          psc = (ddc_excp) ? ddc_excp->status_code : 0;
-         save_thread_error_detail(error_info_to_ddca_detail(ddc_excp));
-         errinfo_free(ddc_excp);
+         save_thread_error_info(ddc_excp);
          if (psc == 0) {
             // make copy to prevent caller from mucking around in ddcutil's
             // internal data structures
@@ -136,6 +135,142 @@ dbgrpt_ddca_capabilities(DDCA_Capabilities * p_caps, int depth) {
 #endif
 
 
+//
+// Parsed capabilities
+//
+
+// Parsing the capabilities string of the same monitor is repeated by
+// clients, e.g. once per display on each refresh.  Since the result
+// depends only on the capabilities string, the converted result is
+// retained and subsequent requests are satisfied by copying it.
+#define MAX_PARSED_CAPABILITIES_CACHE_SIZE 16
+static GHashTable * parsed_capabilities_cache = NULL;  // capabilities string -> DDCA_Capabilities *
+static GMutex       parsed_capabilities_cache_mutex;
+
+
+static void
+free_ddca_capabilities(DDCA_Capabilities * pcaps) {
+   if (pcaps) {
+      assert(memcmp(pcaps->marker, DDCA_CAPABILITIES_MARKER, 4) == 0);
+      free(pcaps->unparsed_string);
+      for (int ndx = 0; ndx < pcaps->vcp_code_ct; ndx++) {
+         DDCA_Cap_Vcp * cur_vcp = &pcaps->vcp_codes[ndx];
+         assert(memcmp(cur_vcp->marker, DDCA_CAP_VCP_MARKER, 4) == 0);
+         cur_vcp->marker[3] = 'x';
+         free(cur_vcp->values);
+      }
+      free(pcaps->vcp_codes);
+      free(pcaps->cmd_codes);
+      ntsa_free(pcaps->messages, true);
+      pcaps->marker[3] = 'x';
+      free(pcaps);
+   }
+}
+
+
+/** Converts the internal form of parsed capabilities to #DDCA_Capabilities.
+ *
+ *  @param  pcaps                internal parsed capabilities
+ *  @param  capabilities_string  unparsed capabilities string
+ *  @return newly allocated #DDCA_Capabilities
+ */
+static DDCA_Capabilities *
+convert_parsed_capabilities(Parsed_Capabilities * pcaps, char * capabilities_string) {
+   bool debug = false;
+   DDCA_Capabilities * result = calloc(1, sizeof(DDCA_Capabilities));
+   memcpy(result->marker, DDCA_CAPABILITIES_MARKER, 4);
+   result->unparsed_string = g_strdup(capabilities_string);     // needed?
+   result->version_spec = pcaps->parsed_mccs_version;
+   DBGMSF(debug, "version: %d.%d", result->version_spec.major,  result->version_spec.minor);
+   Byte_Value_Array bva = pcaps->commands;
+   if (bva) {
+      result->cmd_ct = bva_length(bva);
+      result->cmd_codes = malloc(result->cmd_ct);
+      memcpy(result->cmd_codes, bva_bytes(bva), result->cmd_ct);
+   }
+   // n. needen't set vcp_code_ct if !pcaps, calloc() has done it
+   if (pcaps->vcp_features) {
+      result->vcp_code_ct = pcaps->vcp_features->len;
+      result->vcp_codes = calloc(result->vcp_code_ct, sizeof(DDCA_Cap_Vcp));
+      DBGMSF(debug, "allocate %d bytes at %p", result->vcp_code_ct * sizeof(DDCA_Cap_Vcp), result->vcp_codes);
+      for (int ndx = 0; ndx < result->vcp_code_ct; ndx++) {
+         DDCA_Cap_Vcp * cur_cap_vcp = &result->vcp_codes[ndx];
+         DBGMSF(debug, "cur_cap_vcp = %p", &result->vcp_codes[ndx]);
+         memcpy(cur_cap_vcp->marker, DDCA_CAP_VCP_MARKER, 4);
+         Capabilities_Feature_Record * cur_cfr = g_ptr_array_index(pcaps->vcp_features, ndx);
+         DBGMSF(debug, "Capabilities_Feature_Record * cur_cfr = %p", cur_cfr);
+         assert(memcmp(cur_cfr->marker, CAPABILITIES_FEATURE_MARKER, 4) == 0);
+         if (debug)
+            dbgrpt_capabilities_feature_record(cur_cfr, 2);
+         //    show_capabilities_feature(cur_cfr, result->version_spec);
+         cur_cap_vcp->feature_code = cur_cfr->feature_id;
+         DBGMSF(debug, "cur_cfr = %p, feature_code - 0x%02x", cur_cfr, cur_cfr->feature_id);
+
+         // cur_cap_vcp->raw_values = g_strdup(cur_cfr->value_string);
+         // TODO: get values from Byte_Bit_Flags cur_cfr->bbflags
+#ifdef CFR_BVA
+         Byte_Value_Array bva = cur_cfr->values;
+         if (bva) {
+            cur_cap_vcp->value_ct = bva_length(bva);
+            cur_cap_vcp->values = calloc( cur_cap_vcp->value_ct, sizeof(Byte));
+            memcpy(cur_cap_vcp->values, bva_bytes(bva), cur_cap_vcp->value_ct);
+         }
+#endif
+#ifdef CFR_BBF
+         if (cur_cfr->bbflags) {
+            cur_cap_vcp->value_ct = bbf_count_set(cur_cfr->bbflags);
+            cur_cap_vcp->values   = calloc(1, cur_cap_vcp->value_ct);
+            bbf_to_bytes(cur_cfr->bbflags, cur_cap_vcp->values, cur_cap_vcp->value_ct);
+         }
+#endif
+      }
+   }
+
+   // DBGMSG("pcaps->messages = %p", pcaps->messages);
+   // if (pcaps->messages) {
+   //    DBGMSG("pcaps->messages->len = %d", pcaps->messages->len);
+   // }
+
+   if (pcaps->messages && pcaps->messages->len > 0) {
+      result->msg_ct = pcaps->messages->len;
+      result->messages = g_ptr_array_to_ntsa(pcaps->messages, /*duplicate=*/ true);
+   }
+
+   return result;
+}
+
+
+/** Makes a deep copy of a #DDCA_Capabilities struct.
+ *
+ *  @param  old  instance to copy
+ *  @return newly allocated copy
+ */
+static DDCA_Capabilities *
+copy_ddca_capabilities(DDCA_Capabilities * old) {
+   DDCA_Capabilities * result = calloc(1, sizeof(DDCA_Capabilities));
+   memcpy(result, old, sizeof(DDCA_Capabilities));
+   result->unparsed_string = g_strdup(old->unparsed_string);
+   if (old->cmd_codes) {
+      result->cmd_codes = malloc(old->cmd_ct);
+      memcpy(result->cmd_codes, old->cmd_codes, old->cmd_ct);
+   }
+   if (old->vcp_codes) {
+      result->vcp_codes = calloc(old->vcp_code_ct, sizeof(DDCA_Cap_Vcp));
+      memcpy(result->vcp_codes, old->vcp_codes, old->vcp_code_ct * sizeof(DDCA_Cap_Vcp));
+      for (int ndx = 0; ndx < old->vcp_code_ct; ndx++) {
+         DDCA_Cap_Vcp * cur = &result->vcp_codes[ndx];
+         if (cur->values) {
+            cur->values = malloc(cur->value_ct);
+            memcpy(cur->values, old->vcp_codes[ndx].values, cur->value_ct);
+         }
+      }
+   }
+   if (old->messages)
+      result->messages = ntsa_copy(old->messages, /*dup=*/ true);
+   return result;
+}
+
+
 DDCA_Status
 ddca_parse_capabilities_string(
       char *                   capabilities_string,
@@ -149,6 +284,21 @@ ddca_parse_capabilities_string(
    DDCA_Status ddcrc = DDCRC_BAD_DATA;
    DDCA_Capabilities * result = NULL;
 
+   if (capabilities_string) {
+      g_mutex_lock(&parsed_capabilities_cache_mutex);
+      DDCA_Capabilities * cached = (parsed_capabilities_cache)
+            ? g_hash_table_lookup(parsed_capabilities_cache, capabilities_string)
+            : NULL;
+      if (cached)
+         result = copy_ddca_capabilities(cached);
+      g_mutex_unlock(&parsed_capabilities_cache_mutex);
+      if (result) {
+         DBGTRC_NOPREFIX(debug, DDCA_TRC_API, "Using previously parsed capabilities");
+         ddcrc = 0;
+         goto bye;
+      }
+   }
+
    // need to control messages?
    Parsed_Capabilities * pcaps = parse_capabilities_string(capabilities_string);
    if (pcaps) {
@@ -157,68 +307,24 @@ ddca_parse_capabilities_string(
          dyn_report_parsed_capabilities(pcaps, NULL, NULL, 2);
          DBGMSG("Convert to DDCA_Capabilities...");
       }
-      result = calloc(1, sizeof(DDCA_Capabilities));
-      memcpy(result->marker, DDCA_CAPABILITIES_MARKER, 4);
-      result->unparsed_string = g_strdup(capabilities_string);     // needed?
-      result->version_spec = pcaps->parsed_mccs_version;
-      DBGMSF(debug, "version: %d.%d", result->version_spec.major,  result->version_spec.minor);
-      Byte_Value_Array bva = pcaps->commands;
-      if (bva) {
-         result->cmd_ct = bva_length(bva);
-         result->cmd_codes = malloc(result->cmd_ct);
-         memcpy(result->cmd_codes, bva_bytes(bva), result->cmd_ct);
-      }
-      // n. needen't set vcp_code_ct if !pcaps, calloc() has done it
-      if (pcaps->vcp_features) {
-         result->vcp_code_ct = pcaps->vcp_features->len;
-         result->vcp_codes = calloc(result->vcp_code_ct, sizeof(DDCA_Cap_Vcp));
-         DBGMSF(debug, "allocate %d bytes at %p", result->vcp_code_ct * sizeof(DDCA_Cap_Vcp), result->vcp_codes);
-         for (int ndx = 0; ndx < result->vcp_code_ct; ndx++) {
-            DDCA_Cap_Vcp * cur_cap_vcp = &result->vcp_codes[ndx];
-            DBGMSF(debug, "cur_cap_vcp = %p", &result->vcp_codes[ndx]);
-            memcpy(cur_cap_vcp->marker, DDCA_CAP_VCP_MARKER, 4);
-            Capabilities_Feature_Record * cur_cfr = g_ptr_array_index(pcaps->vcp_features, ndx);
-            DBGMSF(debug, "Capabilities_Feature_Record * cur_cfr = %p", cur_cfr);
-            assert(memcmp(cur_cfr->marker, CAPABILITIES_FEATURE_MARKER, 4) == 0);
-            if (debug)
-               dbgrpt_capabilities_feature_record(cur_cfr, 2);
-            //    show_capabilities_feature(cur_cfr, result->version_spec);
-            cur_cap_vcp->feature_code = cur_cfr->feature_id;
-            DBGMSF(debug, "cur_cfr = %p, feature_code - 0x%02x", cur_cfr, cur_cfr->feature_id);
-
-            // cur_cap_vcp->raw_values = g_strdup(cur_cfr->value_string);
-            // TODO: get values from Byte_Bit_Flags cur_cfr->bbflags
-#ifdef CFR_BVA
-            Byte_Value_Array bva = cur_cfr->values;
-            if (bva) {
-               cur_cap_vcp->value_ct = bva_length(bva);
-               cur_cap_vcp->values = calloc( cur_cap_vcp->value_ct, sizeof(Byte));
-               memcpy(cur_cap_vcp->values, bva_bytes(bva), cur_cap_vcp->value_ct);
-            }
-#endif
-#ifdef CFR_BBF
-            if (cur_cfr->bbflags) {
-               cur_cap_vcp->value_ct = bbf_count_set(cur_cfr->bbflags);
-               cur_cap_vcp->values   = calloc(1, cur_cap_vcp->value_ct);
-               bbf_to_bytes(cur_cfr->bbflags, cur_cap_vcp->values, cur_cap_vcp->value_ct);
-            }
-#endif
-         }
-      }
-
-      // DBGMSG("pcaps->messages = %p", pcaps->messages);
-      // if (pcaps->messages) {
-      //    DBGMSG("pcaps->messages->len = %d", pcaps->messages->len);
-      // }
-
-      if (pcaps->messages && pcaps->messages->len > 0) {
-         result->msg_ct = pcaps->messages->len;
-         result->messages = g_ptr_array_to_ntsa(pcaps->messages, /*duplicate=*/ true);
-      }
-
+      result = convert_parsed_capabilities(pcaps, capabilities_string);
       ddcrc = 0;
       free_parsed_capabilities(pcaps);
+
+      g_mutex_lock(&parsed_capabilities_cache_mutex);
+      if (!parsed_capabilities_cache)
+         parsed_capabilities_cache = g_hash_table_new_full(g_str_hash, g_str_equal,
+               g_free, (GDestroyNotify) free_ddca_capabilities);
+      if (g_hash_table_size(parsed_capabilities_cache) < MAX_PARSED_CAPABILITIES_CACHE_SIZE &&
+          !g_hash_table_contains(parsed_capabilities_cache, capabilities_string))
+      {
+         g_hash_table_insert(parsed_capabilities_cache,
+               g_strdup(capabilities_string), copy_ddca_capabilities(result));
+      }
+      g_mutex_unlock(&parsed_capabilities_cache_mutex);
    }
+
+bye:
    *parsed_capabilities_loc = result;
    API_EPILOG_BEFORE_RETURN(debug, NORESPECT_QUIESCE, ddcrc,
          "*parsed_capabilities_loc=%p", *parsed_capabilities_loc);
@@ -240,22 +346,7 @@ ddca_free_parsed_capabilities(
    if (traced_function_stack_enabled)
       reset_current_traced_function_stack();
    DBGTRC_STARTING(debug, DDCA_TRC_API, "pcaps=%p", pcaps);
-   if (pcaps) {
-      assert(memcmp(pcaps->marker, DDCA_CAPABILITIES_MARKER, 4) == 0);
-      free(pcaps->unparsed_string);
-      DBGMSF(debug, "vcp_code_ct = %d", pcaps->vcp_code_ct);
-      for (int ndx = 0; ndx < pcaps->vcp_code_ct; ndx++) {
-         DDCA_Cap_Vcp * cur_vcp = &pcaps->vcp_codes[ndx];
-         assert(memcmp(cur_vcp->marker, DDCA_CAP_VCP_MARKER, 4) == 0);
-         cur_vcp->marker[3] = 'x';
-         free(cur_vcp->values);
-      }
-      free(pcaps->vcp_codes);
-      free(pcaps->cmd_codes);
-      ntsa_free(pcaps->messages, true);
-      pcaps->marker[3] = 'x';
-      free(pcaps);
-   }
+   free_ddca_capabilities(pcaps);
    DBGTRC_DONE(debug, DDCA_TRC_API, "");
 }
 
@@ -585,6 +676,16 @@ ddca_feature_list_from_capabilities(
    return result;
 }
 
+void terminate_api_capabilities() {
+   g_mutex_lock(&parsed_capabilities_cache_mutex);
+   if (parsed_capabilities_cache) {
+      g_hash_table_destroy(parsed_capabilities_cache);
+      parsed_capabilities_cache = NULL;
+   }
+   g_mutex_unlock(&parsed_capabilities_cache_mutex);
+}
+
+
 void init_api_capabilities() {
    RTTI_ADD_FUNC(ddca_free_parsed_capabilities);
    RTTI_ADD_FUNC(ddca_get_capabilities_string);
@@ -46,6 +46,7 @@ ddca_mccs_version_id_desc(
 #endif
 
 void init_api_capabilities();
+void terminate_api_capabilities();
 
 #endif /* API_CAPABILITIES_INTERNAL_H_ */
 
@@ -37,9 +37,11 @@
 #include "ddc/ddc_vcp_version.h"
 
 #include "dw/dw_common.h"
+#include "dw/dw_event_ring.h"
 #include "dw/dw_main.h"
 #include "dw/dw_status_events.h"
 #include "dw/dw_udev.h"
+#include "dw/dw_vcp_monitor.h"
 
 #include "libmain/api_base_internal.h"
 #include "libmain/api_error_info_internal.h"
@@ -1204,7 +1206,8 @@ ddca_free_display_info(DDCA_Display_Info * info_rec) {
    API_PROLOG_NO_DISPLAY_IO(debug, "info_rec=%p", info_rec);
    if (info_rec && memcmp(info_rec->marker, DDCA_DISPLAY_INFO_MARKER, 4) == 0) {
       // DDCA_IO_Path path = info_rec->path;
-      // DDCA_Display_Info contains no pointers, can simply be free'd.
+      // The dref in DDCA_Display_Info is not owned by the struct,
+      // so it can simply be free'd.
       info_rec->marker[3] = 'x';
       free(info_rec);
    }
@@ -1218,7 +1221,8 @@ ddca_free_display_info2(DDCA_Display_Info2 * info_rec) {
    bool debug = false;
    API_PROLOG_NO_DISPLAY_IO(debug, "info_rec=%p", info_rec);
    if (info_rec && memcmp(info_rec->marker, DDCA_DISPLAY_INFO_MARKER, 4) == 0) {
-      // DDCA_Display_Info contains no pointers, can simply be free'd
+      // The dref in DDCA_Display_Info2 is not owned by the struct,
+      // so it can simply be free'd.
       info_rec->marker[3] = 'x';
       free(info_rec);
    }
@@ -1227,19 +1231,27 @@ ddca_free_display_info2(DDCA_Display_Info2 * info_rec) {
 }
 
 
+static bool is_live_snapshot(const DDCA_Display_Info_List * dlist);
+
 void
 ddca_free_display_info_list(DDCA_Display_Info_List * dlist) {
    bool debug = false;
    API_PROLOG_NO_DISPLAY_IO(debug, "dlist=%p", dlist);
    if (dlist) {
-      // n. DDCA_Display_Info contains no pointers,
-      // DDCA_Display_Info_List can simply be free'd.
-      for (int ndx = 0; ndx < dlist->ct; ndx++) {
-          DDCA_Display_Info * info_rec = &dlist->info[ndx];
-          if (memcmp(info_rec->marker, DDCA_DISPLAY_INFO_MARKER, 4) == 0)
-             info_rec->marker[3] = 'x';
+      if (is_live_snapshot(dlist)) {
+         SYSLOG2(DDCA_SYSLOG_ERROR,
+               "%p is a display information snapshot, use ddca_release_display_info_snapshot()", dlist);
+      }
+      else {
+         // n. The drefs in DDCA_Display_Info are not owned by the list,
+         // DDCA_Display_Info_List can simply be free'd.
+         for (int ndx = 0; ndx < dlist->ct; ndx++) {
+             DDCA_Display_Info * info_rec = &dlist->info[ndx];
+             if (memcmp(info_rec->marker, DDCA_DISPLAY_INFO_MARKER, 4) == 0)
+                info_rec->marker[3] = 'x';
+         }
+         free(dlist);
       }
-      free(dlist);
    }
    API_EPILOG_NO_RETURN(debug, false, "");
    // DBGTRC_DONE(debug, DDCA_TRC_API, "");
@@ -1247,6 +1259,196 @@ ddca_free_display_info_list(DDCA_Display_Info_List * dlist) {
 }
 
 
+//
+// Display information snapshots
+//
+
+// A snapshot is a single allocation: a header followed by a
+// DDCA_Display_Info_List.  Clients only ever see the list.
+// Live snapshots are recorded in live_snapshots, keyed by list pointer,
+// so that a pointer passed back by a client is validated before the
+// header preceding it is touched.
+
+#define DISPLAY_INFO_SNAPSHOT_MARKER "DISN"
+typedef struct {
+   char   marker[4];
+   gint   refct;
+   int    generation;
+   bool   include_invalid_displays;
+} Display_Info_Snapshot;
+
+// round up so that the list following the header is suitably aligned
+#define SNAPSHOT_HEADER_SIZE ((sizeof(Display_Info_Snapshot) + 15) & ~((size_t)15))
+
+static GMutex                   snapshot_mutex;        // guards all of the following
+static Display_Info_Snapshot *  cached_snapshots[2];   // indexed by include_invalid_displays
+static GHashTable *             live_snapshots;        // list pointer -> Display_Info_Snapshot
+
+
+static inline DDCA_Display_Info_List *
+snapshot_list(Display_Info_Snapshot * snapshot) {
+   return (DDCA_Display_Info_List *) ((char *) snapshot + SNAPSHOT_HEADER_SIZE);
+}
+
+
+// Returns the live snapshot whose list is dlist, or NULL if dlist is not
+// a live snapshot, e.g. a list from ddca_get_display_info_list2() or a
+// snapshot that has already been freed.  Caller must hold snapshot_mutex.
+static inline Display_Info_Snapshot *
+snapshot_from_list(const DDCA_Display_Info_List * dlist) {
+   if (!live_snapshots)
+      return NULL;
+   return g_hash_table_lookup(live_snapshots, dlist);
+}
+
+
+static bool
+is_live_snapshot(const DDCA_Display_Info_List * dlist) {
+   g_mutex_lock(&snapshot_mutex);
+   bool result = snapshot_from_list(dlist);
+   g_mutex_unlock(&snapshot_mutex);
+   return result;
+}
+
+
+// Caller must hold snapshot_mutex.
+static void
+unref_snapshot(Display_Info_Snapshot * snapshot) {
+   if (g_atomic_int_dec_and_test(&snapshot->refct)) {
+      g_hash_table_remove(live_snapshots, snapshot_list(snapshot));
+      snapshot->marker[3] = 'x';
+      free(snapshot);
+   }
+}
+
+
+/** Builds a snapshot of the current display set.
+ *
+ *  @param  include_invalid_displays  if true, include displays that do not support DDC
+ *  @param  generation                display set generation the snapshot reflects
+ *  @return newly allocated snapshot, with reference count 1
+ *
+ *  @remark
+ *  Caller must hold snapshot_mutex.
+ */
+static Display_Info_Snapshot *
+ddci_build_display_info_snapshot(bool include_invalid_displays, int generation) {
+   bool debug = false;
+   DBGTRC_STARTING(debug, TRACE_GROUP, "include_invalid_displays=%s, generation=%d",
+                                       sbool(include_invalid_displays), generation);
+
+   GPtrArray * filtered_displays = ddc_get_filtered_display_refs(
+                                      include_invalid_displays,
+                                      false);  // include_removed_drefs
+   int filtered_ct = filtered_displays->len;
+   size_t reqd_size = SNAPSHOT_HEADER_SIZE +
+                      offsetof(DDCA_Display_Info_List,info) + filtered_ct * sizeof(DDCA_Display_Info);
+   Display_Info_Snapshot * snapshot = calloc(1, reqd_size);
+   memcpy(snapshot->marker, DISPLAY_INFO_SNAPSHOT_MARKER, 4);
+   snapshot->refct = 1;
+   snapshot->generation = generation;
+   snapshot->include_invalid_displays = include_invalid_displays;
+
+   DDCA_Display_Info_List * dlist = snapshot_list(snapshot);
+   dlist->ct = filtered_ct;
+   for (int ndx = 0; ndx < filtered_ct; ndx++) {
+      Display_Ref * dref = g_ptr_array_index(filtered_displays, ndx);
+      ddci_init_display_info(dref, &dlist->info[ndx]);
+      add_published_dref_id_by_dref(dref);
+   }
+   g_ptr_array_free(filtered_displays, true);
+
+   if (!live_snapshots)
+      live_snapshots = g_hash_table_new(g_direct_hash, g_direct_equal);
+   g_hash_table_insert(live_snapshots, dlist, snapshot);
+
+   DBGTRC_DONE(debug, TRACE_GROUP, "Returning snapshot %p, list %p, %d displays",
+                                   snapshot, dlist, filtered_ct);
+   return snapshot;
+}
+
+
+DDCA_Status
+ddca_get_display_info_snapshot(
+      bool                             include_invalid_displays,
+      const DDCA_Display_Info_List **  dlist_loc,
+      int *                            generation_loc)
+{
+   bool debug = false;
+   free_thread_error_detail();
+   API_PROLOGX(debug, RESPECT_QUIESCE, "include_invalid_displays=%s", sbool(include_invalid_displays));
+   API_PRECOND_W_EPILOG(dlist_loc);
+
+   ddc_ensure_displays_detected();
+   // read the generation before building, so that a snapshot built while
+   // the display set is changing is replaced on the next call
+   int generation = ddc_get_display_set_generation();
+   int ndx = (include_invalid_displays) ? 1 : 0;
+   bool rebuilt = false;
+
+   g_mutex_lock(&snapshot_mutex);
+   Display_Info_Snapshot * snapshot = cached_snapshots[ndx];
+   if (!snapshot || snapshot->generation != generation) {
+      if (snapshot)
+         unref_snapshot(snapshot);    // clients holding it keep it alive
+      snapshot = ddci_build_display_info_snapshot(include_invalid_displays, generation);
+      cached_snapshots[ndx] = snapshot;
+      rebuilt = true;
+   }
+   g_atomic_int_inc(&snapshot->refct);          // reference for the caller
+   g_mutex_unlock(&snapshot_mutex);
+
+   if (rebuilt)
+      set_ddca_error_detail_from_open_errors();
+   *dlist_loc = snapshot_list(snapshot);
+   if (generation_loc)
+      *generation_loc = generation;
+
+   API_EPILOG_RET_DDCRC(debug, RESPECT_QUIESCE, 0, "*dlist_loc=%p, generation=%d, rebuilt=%s, %d displays",
+         *dlist_loc, generation, sbool(rebuilt), (*dlist_loc)->ct);
+}
+
+
+void
+ddca_release_display_info_snapshot(
+      const DDCA_Display_Info_List * dlist)
+{
+   bool debug = false;
+   API_PROLOG_NO_DISPLAY_IO(debug, "dlist=%p", dlist);
+   if (dlist) {
+      g_mutex_lock(&snapshot_mutex);
+      Display_Info_Snapshot * snapshot = snapshot_from_list(dlist);
+      if (snapshot)
+         unref_snapshot(snapshot);
+      g_mutex_unlock(&snapshot_mutex);
+      if (!snapshot)
+         SYSLOG2(DDCA_SYSLOG_ERROR, "%p is not a live display information snapshot", dlist);
+   }
+   API_EPILOG_NO_RETURN(debug, false, "");
+   DISABLE_API_CALL_TRACING();
+}
+
+
+int
+ddca_get_display_set_generation(void) {
+   return ddc_get_display_set_generation();
+}
+
+
+/** Releases the library's references to cached display information snapshots. */
+void
+ddci_release_cached_display_info_snapshots() {
+   g_mutex_lock(&snapshot_mutex);
+   for (int ndx = 0; ndx < 2; ndx++) {
+      if (cached_snapshots[ndx]) {
+         unref_snapshot(cached_snapshots[ndx]);
+         cached_snapshots[ndx] = NULL;
+      }
+   }
+   g_mutex_unlock(&snapshot_mutex);
+}
+
+
 static DDCA_Status
 ddci_report_display_info(
       DDCA_Display_Info * dinfo,
@@ -1541,6 +1743,102 @@ ddca_unregister_display_status_callback(DDCA_Display_Status_Callback_Func func)
 }
 
 
+DDCA_Status
+ddca_open_display_status_event_fd(int * fd_loc) {
+   bool debug = false;
+   free_thread_error_detail();
+   API_PROLOGX(debug, RESPECT_QUIESCE, "fd_loc=%p", fd_loc);
+
+#ifdef WATCH_DISPLAYS
+   DDCA_Status result = DDCRC_INVALID_OPERATION;
+ #ifdef ENABLE_UDEV
+    if (check_all_video_adapters_implement_drm())
+       result = dw_open_event_fd(fd_loc);
+ #endif
+#else
+    DDCA_Status result = DDCRC_UNIMPLEMENTED;
+#endif
+
+   API_EPILOG_RET_DDCRC(debug, RESPECT_QUIESCE, result, "*fd_loc=%d", (fd_loc) ? *fd_loc : -1);
+   return result;
+}
+
+
+DDCA_Status
+ddca_get_next_display_status_event(DDCA_Display_Status_Event * event_loc) {
+   bool debug = false;
+   free_thread_error_detail();
+   API_PROLOGX(debug, NORESPECT_QUIESCE, "event_loc=%p", event_loc);
+
+#ifdef WATCH_DISPLAYS
+   DDCA_Status result = dw_get_next_event(event_loc);
+#else
+   DDCA_Status result = DDCRC_UNIMPLEMENTED;
+#endif
+
+   API_EPILOG_RET_DDCRC(debug, NORESPECT_QUIESCE, result, "");
+   return result;
+}
+
+
+DDCA_Status
+ddca_close_display_status_event_fd() {
+   bool debug = false;
+   free_thread_error_detail();
+   API_PROLOGX(debug, NORESPECT_QUIESCE, "");
+
+#ifdef WATCH_DISPLAYS
+   DDCA_Status result = dw_close_event_fd();
+#else
+   DDCA_Status result = DDCRC_UNIMPLEMENTED;
+#endif
+
+   API_EPILOG_RET_DDCRC(debug, NORESPECT_QUIESCE, result, "");
+   return result;
+}
+
+
+DDCA_Status
+ddca_start_vcp_change_monitor(DDCA_Display_Ref ddca_dref) {
+   bool debug = false;
+   Display_Ref * dref0 = dref_from_published_ddca_dref(ddca_dref);
+   API_PROLOGX(debug, RESPECT_QUIESCE, "ddca_dref=%p, dref0=%s", ddca_dref, dref_reprx_t(dref0));
+
+#ifdef WATCH_DISPLAYS
+   DDCA_Status ddcrc = 0;
+   WITH_VALIDATED_DR4(ddca_dref, ddcrc, DREF_VALIDATE_EDID,
+         {
+            ddcrc = dw_start_vcp_monitor(dref);
+         }
+   )
+#else
+   DDCA_Status ddcrc = DDCRC_UNIMPLEMENTED;
+#endif
+
+   API_EPILOG_RET_DDCRC(debug, RESPECT_QUIESCE, ddcrc, "ddca_dref=%p", ddca_dref);
+   return ddcrc;
+}
+
+
+DDCA_Status
+ddca_stop_vcp_change_monitor(DDCA_Display_Ref ddca_dref) {
+   bool debug = false;
+   free_thread_error_detail();
+   // not validated, so that monitoring of a disconnected display can be stopped
+   Display_Ref * dref = dref_from_published_ddca_dref(ddca_dref);
+   API_PROLOGX(debug, NORESPECT_QUIESCE, "ddca_dref=%p, dref=%s", ddca_dref, dref_reprx_t(dref));
+
+#ifdef WATCH_DISPLAYS
+   DDCA_Status ddcrc = (dref) ? dw_stop_vcp_monitor(dref) : DDCRC_ARG;
+#else
+   DDCA_Status ddcrc = DDCRC_UNIMPLEMENTED;
+#endif
+
+   API_EPILOG_RET_DDCRC(debug, NORESPECT_QUIESCE, ddcrc, "ddca_dref=%p", ddca_dref);
+   return ddcrc;
+}
+
+
 const char *
    ddca_display_event_type_name(DDCA_Display_Event_Type event_type) {
 #ifdef WATCH_DISPLAYS
@@ -1637,6 +1935,9 @@ bool ddca_is_dynamic_sleep_enabled()
 void init_api_displays() {
    RTTI_ADD_FUNC(ddca_close_display);
    RTTI_ADD_FUNC(ddca_get_display_info_list2);
+   RTTI_ADD_FUNC(ddca_get_display_info_snapshot);
+   RTTI_ADD_FUNC(ddca_release_display_info_snapshot);
+   RTTI_ADD_FUNC(ddci_build_display_info_snapshot);
    RTTI_ADD_FUNC(ddca_get_display_info);
    RTTI_ADD_FUNC(ddca_get_display_info2);
    RTTI_ADD_FUNC(ddci_get_display_ref);
@@ -1649,6 +1950,11 @@ void init_api_displays() {
    RTTI_ADD_FUNC(ddca_report_display_by_dref);
    RTTI_ADD_FUNC(ddca_register_display_status_callback);
    RTTI_ADD_FUNC(ddca_unregister_display_status_callback);
+   RTTI_ADD_FUNC(ddca_open_display_status_event_fd);
+   RTTI_ADD_FUNC(ddca_get_next_display_status_event);
+   RTTI_ADD_FUNC(ddca_close_display_status_event_fd);
+   RTTI_ADD_FUNC(ddca_start_vcp_change_monitor);
+   RTTI_ADD_FUNC(ddca_stop_vcp_change_monitor);
    RTTI_ADD_FUNC(ddci_init_display_info);
    RTTI_ADD_FUNC(ddci_init_display_info2);
 #ifdef OLD
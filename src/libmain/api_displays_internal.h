@@ -55,6 +55,8 @@ DDCA_Status validate_ddca_display_handle(DDCA_Display_Handle ddca_dh, Display_Ha
 const char *
 ddci_dh_repr(DDCA_Display_Handle ddca_dh);
 
+void ddci_release_cached_display_info_snapshots();
+
 void init_api_displays();
 
 #endif /* API_DISPLAYS_INTERNAL_H_ */
@@ -166,15 +166,28 @@ void free_thread_error_detail() {
       free_error_detail(settings->error_detail);
       settings->error_detail = NULL;
    }
+   if (settings->error_info) {
+      errinfo_free(settings->error_info);
+      settings->error_info = NULL;
+   }
 }
 
 
 /** Gets the #DDCA_Error_Detail record for the current thread
+ *
+ *  If an #Error_Info was saved by #save_thread_error_info(), it is
+ *  converted now.
  *
  *  @return #DDCA_Error_Detail instance, NULL if none
  */
 DDCA_Error_Detail * get_thread_error_detail() {
    Thread_Output_Settings * settings = get_thread_settings();
+   if (settings->error_info) {
+      assert(!settings->error_detail);
+      settings->error_detail = error_info_to_ddca_detail(settings->error_info);
+      errinfo_free(settings->error_info);
+      settings->error_info = NULL;
+   }
    return settings->error_detail;
 }
 
@@ -189,12 +202,24 @@ void save_thread_error_detail(DDCA_Error_Detail * error_detail) {
    if (debug)
       report_error_detail(error_detail, 2);
 
+   free_thread_error_detail();
    Thread_Output_Settings * settings = get_thread_settings();
-   if (settings->error_detail)
-      free_error_detail(settings->error_detail);
    settings->error_detail = error_detail;
 
    DBGMSF(debug, "Done");
 }
 
 
+/** Saves an #Error_Info as the error detail for the current thread.
+ *
+ *  Ownership of **erec** passes to the thread.  Conversion to a
+ *  #DDCA_Error_Detail is deferred until #get_thread_error_detail()
+ *  is called, which most clients never do.
+ *
+ *  @param erec  #Error_Info to save, may be NULL
+ */
+void save_thread_error_info(Error_Info * erec) {
+   free_thread_error_detail();
+   Thread_Output_Settings * settings = get_thread_settings();
+   settings->error_info = erec;
+}
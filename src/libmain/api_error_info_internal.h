@@ -19,5 +19,6 @@ void report_error_detail(DDCA_Error_Detail * ddca_erec, int depth);
 void free_thread_error_detail();
 DDCA_Error_Detail * get_thread_error_detail();
 void save_thread_error_detail(DDCA_Error_Detail * error_detail);
+void save_thread_error_info(Error_Info * erec);
 
 #endif /* API_ERROR_INFO_INTERNAL_H_ */
@@ -21,6 +21,7 @@
 
 #include "base/core.h"
 #include "base/displays.h"
+#include "base/feature_lists.h"
 #include "base/monitor_model_key.h"
 #include "base/rtti.h"
 
@@ -80,26 +81,22 @@ typedef struct {
 #endif
 
 
-DDCA_Status
-ddca_get_non_table_vcp_value(
+static DDCA_Status
+ddci_get_non_table_vcp_value(
       DDCA_Display_Handle        ddca_dh,
       DDCA_Vcp_Feature_Code      feature_code,
+      DDCA_Read_Flags            flags,
       DDCA_Non_Table_Vcp_Value*  valrec)
 {
    bool debug = false;
-   free_thread_error_detail();
-   API_PROLOGX(debug, true, "ddca_dh=%p, feature_code=0x%02x, valrec=%p",
-                               ddca_dh, feature_code, valrec );
-   DDCA_Status psc = API_PRECOND_RVALUE(valrec);
-   if (psc != 0)
-      goto bye;
-
+   DDCA_Status psc = 0;
    WITH_VALIDATED_DH3(ddca_dh, psc,  {
        Error_Info * ddc_excp = NULL;
        Parsed_Nontable_Vcp_Response * code_info;
-       ddc_excp = ddc_get_nontable_vcp_value(
+       ddc_excp = ddc_get_nontable_vcp_value_cached(
                      dh,
                      feature_code,
+                     flags & DDCA_READ_FORCE_BUS,
                      &code_info);
 
        if (!ddc_excp) {
@@ -116,11 +113,59 @@ ddca_get_non_table_vcp_value(
        }
        else {
           psc = ddc_excp->status_code;
-          save_thread_error_detail(error_info_to_ddca_detail(ddc_excp));
-          ERRINFO_FREE_WITH_REPORT(ddc_excp, IS_DBGTRC(debug, DDCA_TRC_API));
+          if (IS_DBGTRC(debug, DDCA_TRC_API))
+             errinfo_report(ddc_excp, 1);
+          save_thread_error_info(ddc_excp);
           // DBGTRC_RET_DDCRC(debug, DDCA_TRC_API, psc, "");
        }
     } );
+   return psc;
+}
+
+
+DDCA_Status
+ddca_get_non_table_vcp_value(
+      DDCA_Display_Handle        ddca_dh,
+      DDCA_Vcp_Feature_Code      feature_code,
+      DDCA_Non_Table_Vcp_Value*  valrec)
+{
+   bool debug = false;
+   free_thread_error_detail();
+   API_PROLOGX(debug, true, "ddca_dh=%p, feature_code=0x%02x, valrec=%p",
+                               ddca_dh, feature_code, valrec );
+   DDCA_Status psc = API_PRECOND_RVALUE(valrec);
+   if (psc != 0)
+      goto bye;
+
+   psc = ddci_get_non_table_vcp_value(ddca_dh, feature_code, DDCA_READ_NORMAL, valrec);
+
+bye:
+   if (psc == 0)
+      API_EPILOG_BEFORE_RETURN(debug, true, psc,
+            "valrec:  mh=0x%02x, ml=0x%02x, sh=0x%02x, sl=0x%02x",
+             valrec->mh, valrec->ml, valrec->sh, valrec->sl);
+   else
+      API_EPILOG_BEFORE_RETURN(debug, true, psc, "");
+   return psc;
+}
+
+
+DDCA_Status
+ddca_get_non_table_vcp_value_with_flags(
+      DDCA_Display_Handle        ddca_dh,
+      DDCA_Vcp_Feature_Code      feature_code,
+      DDCA_Read_Flags            flags,
+      DDCA_Non_Table_Vcp_Value*  valrec)
+{
+   bool debug = false;
+   free_thread_error_detail();
+   API_PROLOGX(debug, true, "ddca_dh=%p, feature_code=0x%02x, flags=0x%02x, valrec=%p",
+                               ddca_dh, feature_code, flags, valrec );
+   DDCA_Status psc = API_PRECOND_RVALUE(valrec);
+   if (psc != 0)
+      goto bye;
+
+   psc = ddci_get_non_table_vcp_value(ddca_dh, feature_code, flags, valrec);
 
 bye:
    if (psc == 0)
@@ -133,6 +178,144 @@ bye:
 }
 
 
+DDCA_Status
+ddca_prepare_non_table_vcp_read(
+      DDCA_Display_Handle        ddca_dh,
+      DDCA_Vcp_Feature_Code      feature_code,
+      DDCA_Prepared_Request *    request_loc)
+{
+   bool debug = false;
+   free_thread_error_detail();
+   API_PROLOGX(debug, RESPECT_QUIESCE, "ddca_dh=%p, feature_code=0x%02x, request_loc=%p",
+                                       ddca_dh, feature_code, request_loc);
+   DDCA_Status psc = API_PRECOND_RVALUE(request_loc);
+   if (psc != 0)
+      goto bye;
+   *request_loc = NULL;
+
+   WITH_VALIDATED_DH3(ddca_dh, psc, {
+         const Display_Feature_Metadata * dfm = dyn_get_feature_metadata_by_dh_const(feature_code, dh);
+         if (dfm && (dfm->version_feature_flags & DDCA_TABLE)) {
+            psc = DDCRC_INVALID_OPERATION;
+            save_thread_error_detail(new_ddca_error_detail(psc,
+                  "Feature 0x%02x is a table feature", feature_code));
+         }
+         else {
+            *request_loc = ddc_prepare_nontable_vcp_request(dh, feature_code);
+         }
+   } );
+
+bye:
+   API_EPILOG_BEFORE_RETURN(debug, RESPECT_QUIESCE, psc, "*request_loc=%p", (request_loc) ? *request_loc : NULL);
+   return psc;
+}
+
+
+DDCA_Status
+ddca_execute_prepared_read(
+      DDCA_Prepared_Request      request,
+      DDCA_Non_Table_Vcp_Value*  valrec)
+{
+   bool debug = false;
+   free_thread_error_detail();
+   API_PROLOGX(debug, RESPECT_QUIESCE, "request=%p, valrec=%p", request, valrec);
+   Prepared_Vcp_Request * preq = request;
+   DDCA_Status psc = API_PRECOND_RVALUE(ddc_is_prepared_vcp_request(preq));
+   if (psc == 0)
+      psc = API_PRECOND_RVALUE(valrec);
+   if (psc != 0)
+      goto bye;
+
+   // NULL if the display has been closed
+   Display_Handle * prepared_dh = ddc_get_prepared_vcp_request_dh(preq);
+   if (!prepared_dh) {
+      psc = DDCRC_ARG;
+      save_thread_error_detail(new_ddca_error_detail(psc,
+            "Display for prepared request has been closed"));
+      goto bye;
+   }
+
+   WITH_VALIDATED_DH3(prepared_dh, psc, {
+       Parsed_Nontable_Vcp_Response * code_info;
+       Error_Info * ddc_excp = ddc_execute_prepared_nontable_vcp_request(preq, &code_info);
+       if (!ddc_excp) {
+          valrec->mh = code_info->mh;
+          valrec->ml = code_info->ml;
+          valrec->sh = code_info->sh;
+          valrec->sl = code_info->sl;
+          free(code_info);
+       }
+       else {
+          psc = ddc_excp->status_code;
+          if (IS_DBGTRC(debug, DDCA_TRC_API))
+             errinfo_report(ddc_excp, 1);
+          save_thread_error_info(ddc_excp);
+       }
+   } );
+
+bye:
+   API_EPILOG_BEFORE_RETURN(debug, RESPECT_QUIESCE, psc, "");
+   return psc;
+}
+
+
+void
+ddca_free_prepared_request(
+      DDCA_Prepared_Request      request)
+{
+   bool debug = false;
+   API_PROLOG_NO_DISPLAY_IO(debug, "request=%p", request);
+   Prepared_Vcp_Request * preq = request;
+   if (preq && ddc_is_prepared_vcp_request(preq))
+      ddc_free_prepared_vcp_request(preq);
+   API_EPILOG_NO_RETURN(debug, false, "");
+   DISABLE_API_CALL_TRACING();
+}
+
+
+DDCA_Status
+ddca_get_multiple_vcp_values(
+      DDCA_Display_Handle        ddca_dh,
+      DDCA_Feature_List *        feature_list,
+      DDCA_Vcp_Batch_Entry **    entries_loc,
+      int *                      entry_ct_loc)
+{
+   bool debug = false;
+   free_thread_error_detail();
+   API_PROLOGX(debug, true, "ddca_dh=%p, feature_list=%p, entries_loc=%p, entry_ct_loc=%p",
+                            ddca_dh, feature_list, entries_loc, entry_ct_loc);
+   DDCA_Status psc = API_PRECOND_RVALUE(feature_list && entries_loc && entry_ct_loc);
+   if (psc != 0)
+      goto bye;
+   *entries_loc = NULL;
+   *entry_ct_loc = 0;
+
+   WITH_VALIDATED_DH3(ddca_dh, psc,  {
+       int entry_ct = feature_list_count(feature_list);
+       DDCA_Vcp_Batch_Entry * entries = calloc(entry_ct+1, sizeof(DDCA_Vcp_Batch_Entry));
+       int ndx = 0;
+       for (int code = 0; code < 256; code++) {
+          if (feature_list_contains(feature_list, code))
+             entries[ndx++].feature_code = code;
+       }
+       Error_Info * ddc_excp = ddc_get_multiple_nontable_vcp_values(dh, entries, entry_ct);
+       if (ddc_excp) {
+          psc = ddc_excp->status_code;
+          if (IS_DBGTRC(debug, DDCA_TRC_API))
+             errinfo_report(ddc_excp, 1);
+          save_thread_error_info(ddc_excp);
+       }
+       *entries_loc = entries;
+       *entry_ct_loc = entry_ct;
+    } );
+
+bye:
+   API_EPILOG_BEFORE_RETURN(debug, true, psc, "*entry_ct_loc=%d",
+                            (entry_ct_loc) ? *entry_ct_loc : -1);
+   return psc;
+}
+
+
 // untested
 DDCA_Status
 ddca_get_table_vcp_value(
@@ -156,8 +339,7 @@ ddca_get_table_vcp_value(
          Buffer * p_table_bytes = NULL;
          ddc_excp =  ddc_get_table_vcp_value(dh, feature_code, &p_table_bytes);
          psc = (ddc_excp) ? ddc_excp->status_code : 0;
-         save_thread_error_detail(error_info_to_ddca_detail(ddc_excp));
-         errinfo_free(ddc_excp);
+         save_thread_error_info(ddc_excp);
          if (psc == 0) {
             assert(p_table_bytes);  // avoid coverity warning
             int len = p_table_bytes->len;
@@ -205,8 +387,7 @@ ddci_get_vcp_value(
                *pvalrec = NULL;
                ddc_excp = ddc_get_vcp_value(dh, feature_code, call_type, pvalrec);
                psc = (ddc_excp) ? ddc_excp->status_code : 0;
-               save_thread_error_detail(error_info_to_ddca_detail(ddc_excp));
-               errinfo_free(ddc_excp);
+               save_thread_error_info(ddc_excp);
                DBGTRC_RET_DDCRC(debug, DDCA_TRC_API, psc, "*pvalrec=%p", *pvalrec);
          }
    );
@@ -818,8 +999,9 @@ ddci_set_single_vcp_value(
    WITH_VALIDATED_DH3(ddca_dh, psc, {
          Error_Info * ddc_excp = ddc_set_verified_vcp_value_with_retry(dh, valrec, verified_value_loc);
          psc = (ddc_excp) ? ddc_excp->status_code : 0;
-         save_thread_error_detail(error_info_to_ddca_detail(ddc_excp));
-         ERRINFO_FREE_WITH_REPORT(ddc_excp, IS_DBGTRC(debug, DDCA_TRC_API));
+         if (IS_DBGTRC(debug, DDCA_TRC_API))
+            errinfo_report(ddc_excp, 1);
+         save_thread_error_info(ddc_excp);
       } );
    DBGTRC_RET_DDCRC(debug, DDCA_TRC_API, psc, "");
    return psc;
@@ -1157,6 +1339,37 @@ bye:
 }
 
 
+DDCA_Status
+ddca_set_multiple_vcp_values(
+      DDCA_Display_Handle      ddca_dh,
+      DDCA_Vcp_Batch_Entry *   entries,
+      int                      entry_ct)
+{
+   bool debug = false;
+   free_thread_error_detail();
+   API_PROLOGX(debug, RESPECT_QUIESCE, "ddca_dh=%p, entries=%p, entry_ct=%d",
+                                       ddca_dh, entries, entry_ct);
+   DDCA_Status psc = API_PRECOND_RVALUE(entry_ct >= 0 && (entries || entry_ct == 0));
+   if (psc != 0)
+      goto bye;
+
+   WITH_VALIDATED_DH3(ddca_dh, psc,
+      {
+         Error_Info * ddc_excp = ddc_set_multiple_nontable_vcp_values(dh, entries, entry_ct);
+         if (ddc_excp) {
+            psc = ddc_excp->status_code;
+            if (IS_DBGTRC(debug, DDCA_TRC_API))
+               errinfo_report(ddc_excp, 1);
+            save_thread_error_info(ddc_excp);
+         }
+      }
+   );
+bye:
+   API_EPILOG_BEFORE_RETURN(debug, RESPECT_QUIESCE, psc, "");
+   return psc;
+}
+
+
 DDCA_Status
 ddca_set_profile_related_values(
       DDCA_Display_Handle  ddca_dh,
@@ -1172,8 +1385,7 @@ ddca_set_profile_related_values(
          Error_Info * ddc_excp = loadvcp_by_string(profile_values_string, dh);
          psc = (ddc_excp) ? ddc_excp->status_code : 0;
          if (ddc_excp) {
-            save_thread_error_detail(error_info_to_ddca_detail(ddc_excp));
-            errinfo_free(ddc_excp);
+            save_thread_error_info(ddc_excp);
          }
          DBGTRC_RET_DDCRC(debug, DDCA_TRC_API, psc, "");
       }
@@ -1248,7 +1460,13 @@ void init_api_access_feature_codes() {
 void init_api_feature_access() {
    // DBGMSG("Executing");
    RTTI_ADD_FUNC(ddca_get_non_table_vcp_value);
+   RTTI_ADD_FUNC(ddca_get_non_table_vcp_value_with_flags);
+   RTTI_ADD_FUNC(ddca_prepare_non_table_vcp_read);
+   RTTI_ADD_FUNC(ddca_execute_prepared_read);
+   RTTI_ADD_FUNC(ddci_get_non_table_vcp_value);
+   RTTI_ADD_FUNC(ddca_get_multiple_vcp_values);
    RTTI_ADD_FUNC(ddca_set_non_table_vcp_value);
+   RTTI_ADD_FUNC(ddca_set_multiple_vcp_values);
    RTTI_ADD_FUNC(ddci_set_single_vcp_value);
 }
 
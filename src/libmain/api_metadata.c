@@ -23,6 +23,7 @@
 
 #include "vcp/vcp_feature_codes.h"
 
+#include "ddc/ddc_read_capabilities.h"
 #include "ddc/ddc_vcp_version.h"
 
 #include "dynvcp/dyn_feature_codes.h"
@@ -224,6 +225,39 @@ feature_list_from_dyn_feature_set(Dyn_Feature_Set * fset)
 
 
 
+/** Converts the ids of the features listed in a capabilities string
+ *  to a #DDCA_Feature_List.
+ *
+ *  @param  ids                     feature ids
+ *  @param  vspec                   VCP version of display
+ *  @param  include_table_features  if false, Table type features are omitted
+ *  @return feature list
+ */
+static DDCA_Feature_List
+feature_list_from_capabilities_ids(
+      Bit_Set_256             ids,
+      DDCA_MCCS_Version_Spec  vspec,
+      bool                    include_table_features)
+{
+   DDCA_Feature_List vcplist = {{0}};
+   Bit_Set_256_Iterator iter = bs256_iter_new(ids);
+   int feature_code;
+   while ( (feature_code = bs256_iter_next(iter)) >= 0) {
+      if (!include_table_features) {
+         VCP_Feature_Table_Entry * vfte = vcp_find_feature_by_hexid_w_default(feature_code);
+         bool is_table = is_table_feature_by_vcp_version(vfte, vspec);
+         if (vfte->vcp_global_flags & DDCA_SYNTHETIC_VCP_FEATURE_TABLE_ENTRY)
+            free_synthetic_vcp_entry(vfte);
+         if (is_table)
+            continue;
+      }
+      feature_list_add(&vcplist, feature_code);
+   }
+   bs256_iter_free(iter);
+   return vcplist;
+}
+
+
 DDCA_Status
 ddca_get_feature_list_by_dref(
       DDCA_Feature_Subset_Id  feature_set_id,
@@ -272,9 +306,7 @@ ddca_get_feature_list_by_dref(
                   subset = VCP_SUBSET_NONE;
                   break;
                case DDCA_SUBSET_CAPABILITIES:
-                  subset = VCP_SUBSET_NONE;
-                  // Currently handled in ddcui
-                  DBGMSG("DDCA_SUBSET_CAPABILITIES -> VCP_SUBSET_NONE");
+                  subset = VCP_SUBSET_NONE;    // handled below
                   break;
                case DDCA_SUBSET_SCAN:
                   subset = VCP_SUBSET_SCAN;
@@ -286,16 +318,31 @@ ddca_get_feature_list_by_dref(
                   break;
                }
                DBGMSF(debug, "subset=%d=%s", subset, feature_subset_name( subset));
-               Feature_Set_Flags flags = 0x00;
-               if (!include_table_features)
-                  flags |= FSF_NOTABLE;
-               Dyn_Feature_Set * fset = dyn_create_feature_set(subset, dref, flags);
-               // VCP_Feature_Set fset = create_feature_set(subset, vspec, !include_table_features);
-
-               // TODO: function variant that takes result location as a parm, avoid memcpy
-               DDCA_Feature_List result = feature_list_from_dyn_feature_set(fset);
-               memcpy(feature_list_loc, &result, 32);
-               dyn_free_feature_set(fset);
+               if (feature_set_id == DDCA_SUBSET_CAPABILITIES) {
+                  // no DDC communication, see ddca_get_capabilities_feature_list()
+                  Bit_Set_256 ids;
+                  if (ddc_get_known_capabilities_feature_ids(dref, &ids)) {
+                     *feature_list_loc = feature_list_from_capabilities_ids(ids, vspec, include_table_features);
+                  }
+                  else {
+                     feature_list_clear(feature_list_loc);
+                     psc = DDCRC_NOT_FOUND;
+                     save_thread_error_detail(new_ddca_error_detail(psc,
+                           "Capabilities string for %s not yet read", dref_repr_t(dref)));
+                  }
+               }
+               else {
+                  Feature_Set_Flags flags = 0x00;
+                  if (!include_table_features)
+                     flags |= FSF_NOTABLE;
+                  Dyn_Feature_Set * fset = dyn_create_feature_set(subset, dref, flags);
+                  // VCP_Feature_Set fset = create_feature_set(subset, vspec, !include_table_features);
+
+                  // TODO: function variant that takes result location as a parm, avoid memcpy
+                  DDCA_Feature_List result = feature_list_from_dyn_feature_set(fset);
+                  memcpy(feature_list_loc, &result, 32);
+                  dyn_free_feature_set(fset);
+               }
          }
    );
 
@@ -308,6 +355,37 @@ ddca_get_feature_list_by_dref(
 }
 
 
+DDCA_Status
+ddca_get_capabilities_feature_list(
+      DDCA_Display_Handle     ddca_dh,
+      bool                    include_table_features,
+      DDCA_Feature_List*      feature_list_loc)
+{
+   bool debug = false;
+   free_thread_error_detail();
+   API_PROLOGX(debug, RESPECT_QUIESCE, "ddca_dh=%p->%s, include_table_features=%s, feature_list_loc=%p",
+          ddca_dh, dh_repr(ddca_dh), sbool(include_table_features), feature_list_loc);
+   API_PRECOND_W_EPILOG(feature_list_loc);
+   feature_list_clear(feature_list_loc);
+   DDCA_Status psc = 0;
+   WITH_VALIDATED_DH3(
+         ddca_dh, psc,
+         {
+               Bit_Set_256 ids;
+               Error_Info * ddc_excp = ddc_get_capabilities_feature_ids(dh, &ids);
+               psc = (ddc_excp) ? ddc_excp->status_code : 0;
+               save_thread_error_info(ddc_excp);
+               if (psc == 0) {
+                  *feature_list_loc = feature_list_from_capabilities_ids(
+                        ids, get_vcp_version_by_dh(dh), include_table_features);
+               }
+         }
+      );
+   API_EPILOG_RET_DDCRC(debug, RESPECT_QUIESCE, psc, "Feature list: %s",
+         feature_list_string(feature_list_loc, "", ","));
+}
+
+
 bool
 ddca_feature_list_eq(
       DDCA_Feature_List vcplist1,
@@ -624,15 +702,22 @@ ddca_get_feature_metadata_by_dh(
                   dbgrpt_display_ref(dh->dref, true, 1);
 
                DDCA_Feature_Metadata * external_metadata = NULL;
-               Display_Feature_Metadata * internal_metadata =
-                  dyn_get_feature_metadata_by_dh(feature_code, dh, /*check_udf=*/ true, create_default_if_not_found);
-               if (!internal_metadata) {
-                  psc = DDCRC_NOT_FOUND;
+               const Display_Feature_Metadata * shared_metadata =
+                  dyn_get_feature_metadata_by_dh_const(feature_code, dh);
+               if (shared_metadata) {
+                  // caller owns the copy
+                  external_metadata = dfm_to_ddca_feature_metadata((Display_Feature_Metadata *) shared_metadata);
                }
-               else {
-                  external_metadata = dfm_to_ddca_feature_metadata(internal_metadata);
-                  dfm_free(internal_metadata);
+               else if (create_default_if_not_found) {
+                  Display_Feature_Metadata * internal_metadata =
+                     dyn_get_feature_metadata_by_dh(feature_code, dh, /*check_udf=*/ true, true);
+                  if (internal_metadata) {
+                     external_metadata = dfm_to_ddca_feature_metadata(internal_metadata);
+                     dfm_free(internal_metadata);
+                  }
                }
+               if (!external_metadata)
+                  psc = DDCRC_NOT_FOUND;
                *metadata_loc = external_metadata;
                ASSERT_IFF(psc == 0, *metadata_loc);
                 if (psc == 0 && IS_DBGTRC(debug,TRACE_GROUP)) {
@@ -644,6 +729,32 @@ ddca_get_feature_metadata_by_dh(
 }
 
 
+DDCA_Status
+ddca_get_persistent_feature_metadata_by_dh(
+      DDCA_Vcp_Feature_Code           feature_code,
+      DDCA_Display_Handle             ddca_dh,
+      const DDCA_Feature_Metadata **  metadata_loc)
+{
+   bool debug = false;
+   free_thread_error_detail();
+   API_PROLOGX(debug, RESPECT_QUIESCE, "feature_code=0x%02x, ddca_dh=%p->%s, metadata_loc=%p",
+          feature_code, ddca_dh, dh_repr(ddca_dh), metadata_loc);
+   API_PRECOND_W_EPILOG(metadata_loc);
+   *metadata_loc = NULL;
+   DDCA_Status psc = 0;
+   WITH_VALIDATED_DH3(
+         ddca_dh, psc,
+         {
+               Feature_Metadata_Table * table = dyn_get_feature_metadata_table(dh);
+               *metadata_loc = table->external[feature_code];
+               if (!*metadata_loc)
+                  psc = DDCRC_NOT_FOUND;
+         }
+      );
+   API_EPILOG_RET_DDCRC(debug, RESPECT_QUIESCE, psc, "*metadata_loc=%p", *metadata_loc);
+}
+
+
 #ifdef OLD
 // frees the contents of info, not info itself
 DDCA_Status
@@ -981,9 +1092,10 @@ ddca_dfr_check_by_dref(DDCA_Display_Ref ddca_dref)
             if (ddc_excp) {
                if (ddc_excp->status_code != DDCRC_NOT_FOUND) {
                   psc = ddc_excp->status_code;
-                  save_thread_error_detail(error_info_to_ddca_detail(ddc_excp));
+                  save_thread_error_info(ddc_excp);
                }
-               errinfo_free(ddc_excp);
+               else
+                  errinfo_free(ddc_excp);
             }
       }
    );
@@ -1007,9 +1119,10 @@ ddca_dfr_check_by_dh(DDCA_Display_Handle ddca_dh)
             if (ddc_excp) {
                if (ddc_excp->status_code != DDCRC_NOT_FOUND) {
                   psc = ddc_excp->status_code;
-                  save_thread_error_detail(error_info_to_ddca_detail(ddc_excp));
+                  save_thread_error_info(ddc_excp);
                }
-               errinfo_free(ddc_excp);
+               else
+                  errinfo_free(ddc_excp);
            }
       }
    );
@@ -1022,6 +1135,7 @@ ddca_dfr_check_by_dh(DDCA_Display_Handle ddca_dh)
 void init_api_metadata() {
    RTTI_ADD_FUNC(ddca_free_feature_metadata);
    RTTI_ADD_FUNC(ddca_get_feature_list_by_dref);
+   RTTI_ADD_FUNC(ddca_get_capabilities_feature_list);
    RTTI_ADD_FUNC(ddca_get_feature_metadata_by_vspec);
    RTTI_ADD_FUNC(ddca_get_feature_metadata_by_dref);
    RTTI_ADD_FUNC(ddca_get_feature_metadata_by_dh);
@@ -1029,5 +1143,6 @@ void init_api_metadata() {
    RTTI_ADD_FUNC(ddca_get_simple_nc_feature_value_name_by_table);
    RTTI_ADD_FUNC(ddca_dfr_check_by_dref);   // error because deprecated
    RTTI_ADD_FUNC(ddca_dfr_check_by_dh);
+   RTTI_ADD_FUNC(ddca_get_persistent_feature_metadata_by_dh);
 }
 
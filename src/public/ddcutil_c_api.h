@@ -256,6 +256,86 @@ ddca_enable_verify(
 bool
 ddca_is_verify_enabled(void);
 
+/** Controls whether non-table feature values read from displays are cached.
+ *
+ *  When enabled, #ddca_get_non_table_vcp_value() and
+ *  #ddca_get_multiple_vcp_values() return a cached value if one exists
+ *  and has not expired.  By default values of static read-only features,
+ *  such as the VCP version, are cached for the life of the display.
+ *  Values of other features expire after a few seconds.  They are also
+ *  discarded when the library writes to the display, and when feature x02
+ *  (New Control Value) reports that values have been changed using the
+ *  display's own controls.
+ *
+ * @param[in] onoff true/false
+ * @return  prior value
+ *
+ * @remark This setting is global to all threads.
+ * @since 2.2.2
+ */
+bool
+ddca_enable_feature_value_cache(
+      bool onoff);
+
+/** Query whether non-table feature values are cached.
+ *
+ * @retval true  feature values are cached
+ * @retval false feature values are always read from the display
+ * @since 2.2.2
+ */
+bool
+ddca_is_feature_value_cache_enabled(void);
+
+/** Controls whether the classification of I2C adapters is cached.
+ *
+ *  When enabled, adapters that cannot have a display attached, e.g. SMBus
+ *  or sensor adapters, are recorded in file ddcutil/adapters in the user's
+ *  XDG cache directory, and are not examined by subsequent display detection.
+ *  When disabled, the file is neither read nor written.
+ *
+ * @param[in] onoff true/false
+ * @return  prior value
+ *
+ * @remark
+ * This setting is global to all threads.  It takes effect with the next
+ * display detection.  The initial value can be set using library option
+ * **--disable-adapter-cache**.
+ * @since 2.2.2
+ */
+bool
+ddca_enable_adapter_cache(
+      bool onoff);
+
+/** Query whether the classification of I2C adapters is cached.
+ *
+ * @retval true  adapter classifications are cached
+ * @retval false adapters are classified on each display detection
+ * @since 2.2.2
+ */
+bool
+ddca_is_adapter_cache_enabled(void);
+
+/** Sets how long a cached value of a feature is used before the feature
+ *  is reread, overriding the default for the feature's class.
+ *
+ *  @param[in] feature_code  VCP feature code
+ *  @param[in] ttl_millis    time to live in milliseconds, 0 if the feature is
+ *                           never to be cached, #DDCA_CACHE_TTL_FOREVER if it
+ *                           is only to be reread after being invalidated, or
+ *                           #DDCA_CACHE_TTL_DEFAULT to restore the default
+ *  @retval DDCRC_OK   success
+ *  @retval DDCRC_ARG  invalid **ttl_millis**
+ *
+ *  @remark
+ *  The setting applies to all displays.  It takes effect the next time
+ *  the feature is read from a display.
+ *  @since 2.2.2
+ */
+DDCA_Status
+ddca_set_feature_value_cache_ttl(
+      DDCA_Vcp_Feature_Code  feature_code,
+      int                    ttl_millis);
+
 
 //
 // Performance
@@ -521,8 +601,8 @@ ddca_get_display_info(
  *
  *  @remark
  *  This is a convenience function. #DDCA_Display_Info is copied to
- *  the client and contains no pointers.  It could simply be free()'d
- *  by the client.
+ *  the client.  Its only pointer, the display reference, is not owned
+ *  by the struct, so it could simply be free()'d by the client.
  *
  *  @since 1.2.0
  */
@@ -552,8 +632,8 @@ ddca_get_display_info2(
  *
  *  @remark
  *  This is a convenience function. #DDCA_Display_Info2 is copied to
- *  the client and contains no pointers.  It could simply be free()'d
- *  by the client.
+ *  the client.  Its only pointer, the display reference, is not owned
+ *  by the struct, so it could simply be free()'d by the client.
  *
  *  @since 2.2.1
  */
@@ -576,14 +656,66 @@ ddca_get_display_info_list2(
  *  @param[in] dlist pointer to #DDCA_Display_Info_List
  *
  *  @remark
- *  This is a convenience function. #DDCA_Display_Info_List
- *  contains no pointers and is copied to the client. It could
- *  simply be free'd by the client.
+ *  This is a convenience function. #DDCA_Display_Info_List is copied
+ *  to the client.  The display references it contains are not owned by
+ *  the list, so it could simply be free'd by the client.
+ *  A list returned by #ddca_get_display_info_snapshot() is not freed;
+ *  use #ddca_release_display_info_snapshot().
  */
 void
 ddca_free_display_info_list(
       DDCA_Display_Info_List * dlist);
 
+/** Gets a shared, read-only snapshot of the detected displays.
+ *
+ *  The snapshot is rebuilt only when the set of displays changes.
+ *  Otherwise the same list is returned to every caller without copying,
+ *  making this function suitable for clients that poll the display list.
+ *
+ *  @param[in]  include_invalid_displays if true, displays that do not support DDC are included
+ *  @param[out] dlist_loc       where to return pointer to the snapshot
+ *  @param[out] generation_loc  if non-NULL, where to return the display set
+ *                              generation the snapshot reflects
+ *  @retval     0  always succeeds
+ *
+ *  @remark
+ *  The snapshot must not be modified, and must be released using
+ *  #ddca_release_display_info_snapshot(), not free()'d.
+ *  @since 2.2.2
+ */
+DDCA_Status
+ddca_get_display_info_snapshot(
+      bool                             include_invalid_displays,
+      const DDCA_Display_Info_List **  dlist_loc,
+      int *                            generation_loc);
+
+/** Releases a display information snapshot.
+ *
+ *  @param[in] dlist pointer returned by #ddca_get_display_info_snapshot()
+ *
+ *  @remark
+ *  A pointer that is not a live snapshot, e.g. a list returned by
+ *  #ddca_get_display_info_list2() or a snapshot that has already been
+ *  released, is reported to the system log and otherwise ignored.
+ *  @since 2.2.2
+ */
+void
+ddca_release_display_info_snapshot(
+      const DDCA_Display_Info_List * dlist);
+
+/** Returns a counter that is incremented whenever displays are detected,
+ *  connected, disconnected, or redetected.
+ *
+ *  Clients can compare the value with the generation returned by
+ *  #ddca_get_display_info_snapshot() to decide whether to refresh
+ *  their display list without calling into display detection.
+ *
+ *  @return display set generation
+ *  @since 2.2.2
+ */
+int
+ddca_get_display_set_generation(void);
+
 /** @deprecated use report_display_info2()
  *  Presents a report on a single display.
  *  The report is written to the current FOUT device for the current thread.
@@ -1206,6 +1338,37 @@ ddca_get_feature_metadata_by_dh(
       bool                        create_default_if_not_found,
       DDCA_Feature_Metadata **    meta_loc);
 
+/** Gets shared, read-only metadata for a VCP feature.
+ *
+ *  Metadata for all features is computed once per display, taking into
+ *  account any user supplied feature definition and the display's VCP version.
+ *  This function returns a pointer into that table, so repeated calls
+ *  perform no allocation.
+ *
+ *  @param[in]  feature_code     VCP feature code
+ *  @param[in]  ddca_dh          display handle
+ *  @param[out] metadata_loc     return pointer to metadata here
+ *  @return     status code
+ *  @retval     DDCRC_ARG        invalid display handle
+ *  @retval     DDCRC_NOT_FOUND  feature not defined for the display
+ *
+ *  @remark
+ *  The returned instance has #DDCA_PERSISTENT_METADATA set.  It must not be
+ *  modified or freed.
+ *  @remark
+ *  The table is owned by the display reference, not the display handle.
+ *  The returned pointer remains valid after the display is closed, until
+ *  the display reference is released, i.e. until the display is
+ *  disconnected, #ddca_redetect_displays() is called, or the library
+ *  is terminated.
+ *  @since 2.2.2
+ */
+DDCA_Status
+ddca_get_persistent_feature_metadata_by_dh(
+      DDCA_Vcp_Feature_Code           feature_code,
+      DDCA_Display_Handle             ddca_dh,
+      const DDCA_Feature_Metadata **  metadata_loc);
+
 /** Frees a #DDCA_Feature_Metadata instance
  *
  *  @param[in] metadata pointer to instance
@@ -1321,7 +1484,16 @@ ddca_feature_list_id_name(
  *  @param[out] points to feature list to be filled in
  *  @retval     DDCRC_ARG  invalid display reference
  *  @retval     DDCRC_OK   success
+ *  @retval     DDCRC_NOT_FOUND  #DDCA_SUBSET_CAPABILITIES specified and
+ *                               the capabilities string has not been read
  *
+ *  @remark
+ *  For #DDCA_SUBSET_CAPABILITIES, the features listed in the display's
+ *  capabilities string are returned if the string is already known,
+ *  either because it has been read or because it is in the capabilities
+ *  cache.  No DDC communication is performed.
+ *  Use #ddca_get_capabilities_feature_list() to read the features from
+ *  the display.  (Since 2.2.2)
  *  @since 0.9.0
  */
 DDCA_Status
@@ -1331,6 +1503,30 @@ ddca_get_feature_list_by_dref(
       bool                    include_table_features,
       DDCA_Feature_List*      feature_list_loc);
 
+/** Gets a #DDCA_Feature_List of the features listed in a display's
+ *  capabilities string.
+ *
+ *  Unless the capabilities string is already known, only the portion of
+ *  the string through the "vcp" segment is read.  The resulting feature
+ *  ids are retained, so subsequent calls for the display, including
+ *  #ddca_get_feature_list_by_dref() with #DDCA_SUBSET_CAPABILITIES,
+ *  perform no DDC communication.
+ *
+ *  @param[in]  ddca_dh                display handle
+ *  @param[in]  include_table_features if true, Table type features are included
+ *  @param[out] feature_list_loc       points to feature list to be filled in
+ *  @retval     DDCRC_OK   success
+ *  @retval     DDCRC_ARG  invalid display handle
+ *  @return     status code of reading the capabilities string
+ *
+ *  @since 2.2.2
+ */
+DDCA_Status
+ddca_get_capabilities_feature_list(
+      DDCA_Display_Handle     ddca_dh,
+      bool                    include_table_features,
+      DDCA_Feature_List*      feature_list_loc);
+
 /** Empties a #DDCA_Feature_List
  *
  *  @param[in]  vcplist pointer to feature list
@@ -1541,6 +1737,120 @@ ddca_get_non_table_vcp_value(
        DDCA_Vcp_Feature_Code      feature_code,
        DDCA_Non_Table_Vcp_Value*  valrec);
 
+/** Gets the value of a non-table VCP feature, with options.
+ *
+ *  @param[in]  ddca_dh       display handle
+ *  @param[in]  feature_code  VCP feature code
+ *  @param[in]  flags         e.g. #DDCA_READ_FORCE_BUS to bypass the
+ *                            feature value cache
+ *  @param[out] valrec        pointer to response buffer provided by the caller,
+ *                            which will be filled in
+ *  @return status code
+ *
+ *  @remark
+ *  A value read from the display replaces any cached value.
+ *  @remark
+ *  If the returned status code is other than **DDCRC_OK**, a detailed
+ *  error report can be obtained using #ddca_get_error_detail()
+ *  @since 2.2.2
+ */
+DDCA_Status
+ddca_get_non_table_vcp_value_with_flags(
+       DDCA_Display_Handle        ddca_dh,
+       DDCA_Vcp_Feature_Code      feature_code,
+       DDCA_Read_Flags            flags,
+       DDCA_Non_Table_Vcp_Value*  valrec);
+
+/** Prepares a request to read the same non-table VCP feature repeatedly.
+ *
+ *  The DDC request is encoded once, so that #ddca_execute_prepared_read()
+ *  performs only the exchange with the display.  Intended for clients that
+ *  poll a feature.
+ *
+ *  @param[in]  ddca_dh       display handle
+ *  @param[in]  feature_code  VCP feature code
+ *  @param[out] request_loc   where to return the prepared request
+ *  @retval     DDCRC_OK
+ *  @retval     DDCRC_ARG     invalid display handle
+ *  @retval     DDCRC_INVALID_OPERATION  feature is a table feature
+ *
+ *  @remark
+ *  The request is bound to the display handle, and cannot be executed
+ *  after the display is closed, even if the display is reopened.  It must
+ *  still be freed using #ddca_free_prepared_request().
+ *  @since 2.2.2
+ */
+DDCA_Status
+ddca_prepare_non_table_vcp_read(
+       DDCA_Display_Handle        ddca_dh,
+       DDCA_Vcp_Feature_Code      feature_code,
+       DDCA_Prepared_Request *    request_loc);
+
+/** Executes a request prepared by #ddca_prepare_non_table_vcp_read().
+ *
+ *  The value is always read from the display.  The feature value cache
+ *  is not consulted.
+ *
+ *  @param[in]  request   prepared request
+ *  @param[out] valrec    pointer to response buffer provided by the caller,
+ *                        which will be filled in
+ *  @return status code
+ *  @retval DDCRC_ARG     invalid request, or its display handle has been closed
+ *
+ *  @remark
+ *  If the returned status code is other than **DDCRC_OK**, a detailed
+ *  error report can be obtained using #ddca_get_error_detail()
+ *  @since 2.2.2
+ */
+DDCA_Status
+ddca_execute_prepared_read(
+       DDCA_Prepared_Request      request,
+       DDCA_Non_Table_Vcp_Value*  valrec);
+
+/** Frees a request prepared by #ddca_prepare_non_table_vcp_read().
+ *
+ *  @param[in]  request   prepared request, may be NULL
+ *  @since 2.2.2
+ */
+void
+ddca_free_prepared_request(
+       DDCA_Prepared_Request      request);
+
+/** Gets the values of multiple non-table VCP features for a single display.
+ *
+ *  The display handle is validated and locked once for the entire batch,
+ *  and the features are read in ascending feature code order.
+ *
+ *  A failure reading an individual feature is reported in the
+ *  **status** field of its entry, and does not terminate the batch.
+ *  If communication with the display fails entirely (e.g. the display
+ *  is disconnected or asleep), the batch is abandoned, the remaining entries
+ *  are given the same status, and that status is returned.
+ *
+ *  @param[in]  ddca_dh       display handle
+ *  @param[in]  feature_list  features to read
+ *  @param[out] entries_loc   where to return pointer to newly allocated array
+ *                            of #DDCA_Vcp_Batch_Entry, one per feature
+ *  @param[out] entry_ct_loc  where to return number of entries in array
+ *  @return status code, **DDCRC_OK** if the batch was processed, even if
+ *          some features could not be read
+ *
+ *  @remark
+ *  The caller is responsible for freeing the returned array using free().
+ *  An array is returned if the batch was abandoned, containing whatever
+ *  values were read.
+ *  @remark
+ *  If the returned status code is other than **DDCRC_OK**, a detailed
+ *  error report can be obtained using #ddca_get_error_detail()
+ *  @since 2.2.2
+ */
+DDCA_Status
+ddca_get_multiple_vcp_values(
+       DDCA_Display_Handle        ddca_dh,
+       DDCA_Feature_List *        feature_list,
+       DDCA_Vcp_Batch_Entry **    entries_loc,
+       int *                      entry_ct_loc);
+
 /** Gets the value of a table VCP feature.
  *
  *  @param[in]  ddca_dh         display handle
@@ -1761,6 +2071,45 @@ ddca_set_profile_related_values(
       DDCA_Display_Handle  ddca_dh,
       char *               profile_values_string);
 
+/** Sets the values of multiple non-table VCP features for a single display.
+ *
+ *  The features are written in array order, back to back, with only the
+ *  delays required by the DDC/CI protocol between them.  If verification
+ *  is enabled (see #ddca_enable_verify()), the features are then reread
+ *  in a single pass once all writes have been performed, rather than
+ *  each feature being reread immediately after it is written.
+ *
+ *  On return, the **status** field of each entry reports the result for
+ *  that feature:
+ *  - **DDCRC_OK**      the value was written, and if checked, verified
+ *  - **DDCRC_VERIFY**  the value was written, but the value read back differs
+ *  - other             the write, or the read for verification, failed
+ *
+ *  If communication with the display fails entirely (e.g. the display
+ *  is disconnected or asleep), the batch is abandoned, entries not yet
+ *  processed are given the same status, and that status is returned.
+ *
+ *  @param[in]     ddca_dh   display handle
+ *  @param[in,out] entries   array of entries, with **feature_code** and
+ *                           **value.sh**, **value.sl** set for each
+ *  @param[in]     entry_ct  number of entries
+ *  @return status code, **DDCRC_OK** if the batch was processed, even if
+ *          some features were not successfully set
+ *
+ *  @remark
+ *  Writes are not undone if a later write fails.  Order the entries
+ *  so that any partially applied state is acceptable.
+ *  @remark
+ *  If the returned status code is other than **DDCRC_OK**, a detailed
+ *  error report can be obtained using #ddca_get_error_detail()
+ *  @since 2.2.2
+ */
+DDCA_Status
+ddca_set_multiple_vcp_values(
+      DDCA_Display_Handle      ddca_dh,
+      DDCA_Vcp_Batch_Entry *   entries,
+      int                      entry_ct);
+
 
 //
 //  Report display status changes
@@ -1792,6 +2141,98 @@ ddca_register_display_status_callback(DDCA_Display_Status_Callback_Func func);
 DDCA_Status
 ddca_unregister_display_status_callback(DDCA_Display_Status_Callback_Func func);
 
+/** Returns a file descriptor that becomes readable when a display status
+ *  event is available, as an alternative to registering a callback.
+ *  The descriptor can be added to the client's poll(), epoll, or main loop
+ *  sources.  Events are retrieved using #ddca_get_next_display_status_event().
+ *  Calling this function again returns the same descriptor.
+ *
+ *  Events are reported only while display watching is active,
+ *  see #ddca_start_watch_displays().
+ *
+ *  @param[out] fd_loc  where to return the file descriptor
+ *  @retval     DDCRC_OK
+ *  @retval     DDCRC_ARG               fd_loc is NULL
+ *  @retval     DDCRC_INVALID_OPERATION ddcutil not built with UDEV support,
+ *                                      or not all video devices support DRM
+ *
+ *  @remark
+ *  The descriptor is owned by libddcutil.  The client must not read from
+ *  or close it, but should call #ddca_close_display_status_event_fd().
+ *  @since 2.2.2
+ */
+DDCA_Status
+ddca_open_display_status_event_fd(int * fd_loc);
+
+/** Retrieves the oldest undelivered display status event.  Does not block.
+ *
+ *  When the descriptor returned by #ddca_open_display_status_event_fd()
+ *  is readable, the client should call this function repeatedly until it
+ *  returns DDCRC_NOT_FOUND.
+ *
+ *  @param[out] event_loc  where to return the event
+ *  @retval     DDCRC_OK
+ *  @retval     DDCRC_NOT_FOUND          no event available
+ *  @retval     DDCRC_ARG                event_loc is NULL
+ *  @retval     DDCRC_INVALID_OPERATION  event descriptor not open
+ *
+ *  @remark
+ *  Events must be retrieved by a single thread at a time.
+ *  @remark
+ *  At most 64 undelivered events are held.  Further events are discarded.
+ *  @since 2.2.2
+ */
+DDCA_Status
+ddca_get_next_display_status_event(DDCA_Display_Status_Event * event_loc);
+
+/** Closes the descriptor returned by #ddca_open_display_status_event_fd().
+ *  Undelivered events are discarded.
+ *
+ *  @retval     DDCRC_OK
+ *  @retval     DDCRC_INVALID_OPERATION  event descriptor not open
+ *
+ *  @since 2.2.2
+ */
+DDCA_Status
+ddca_close_display_status_event_fd();
+
+/** Starts polling a display for VCP feature values changed using the
+ *  display's own controls, e.g. its On Screen Display.  Each change is
+ *  reported as a #DDCA_Display_Status_Event of type
+ *  DDCA_EVENT_VCP_VALUE_CHANGED, delivered to registered callbacks and
+ *  to the event descriptor returned by #ddca_open_display_status_event_fd().
+ *
+ *  Displays are polled more frequently after a change is seen and less
+ *  frequently when idle.  A display is not polled while it is open.
+ *  It is not an error if the display is already being monitored.
+ *
+ *  @param[in] ddca_dref  display reference
+ *  @retval    DDCRC_OK
+ *  @retval    DDCRC_ARG                invalid display reference
+ *  @retval    DDCRC_INVALID_OPERATION  display does not support DDC communication
+ *
+ *  @remark
+ *  Requires that the display implement features x02 (New Control Value)
+ *  and x52 (Active Control).  A display that does not is no longer polled,
+ *  and a message is written to the system log.
+ *  @remark
+ *  Resetting feature x02 causes some displays to close the On Screen Display.
+ *  @since 2.2.2
+ */
+DDCA_Status
+ddca_start_vcp_change_monitor(DDCA_Display_Ref ddca_dref);
+
+/** Stops polling a display for VCP feature value changes.
+ *
+ *  @param[in] ddca_dref  display reference
+ *  @retval    DDCRC_OK
+ *  @retval    DDCRC_NOT_FOUND  display not being monitored
+ *
+ *  @since 2.2.2
+ */
+DDCA_Status
+ddca_stop_vcp_change_monitor(DDCA_Display_Ref ddca_dref);
+
 /** Returns the name of a #DDCA_Display_Event_Class
  *
  *  @param  event_class event class id
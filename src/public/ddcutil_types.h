@@ -152,6 +152,7 @@ typedef enum {
    DDCA_STATS_CALLS    = 0x04,    ///< system calls
    DDCA_STATS_ELAPSED  = 0x08,    ///< total elapsed time
    DDCA_STATS_API      = 0x10,    ///< API specific stats
+   DDCA_STATS_DETECTION= 0x20,    ///< display detection phase timings
    DDCA_STATS_ALL      = 0xFF     ///< indicates all statistics types
 } DDCA_Stats_Type;
 
@@ -563,6 +564,38 @@ typedef struct {
 #define VALREC_MAX_VAL(valrec) ( valrec->val.c_nc.mh << 8 | valrec->val.c_nc.ml )
 
 
+/** Value and status of one non-table feature in a batch operation
+ *  such as #ddca_get_multiple_vcp_values()
+ *
+ *  @since 2.2.2
+ */
+typedef struct {
+   DDCA_Vcp_Feature_Code    feature_code;  /**< VCP feature code */
+   DDCA_Status              status;        /**< status of the operation for this feature */
+   DDCA_Non_Table_Vcp_Value value;         /**< feature value */
+} DDCA_Vcp_Batch_Entry;
+
+/** Options for reading a feature value
+ *
+ *  @since 2.2.2
+ */
+typedef enum {
+   DDCA_READ_NORMAL     = 0x00,   /**< use the feature value cache, if enabled */
+   DDCA_READ_FORCE_BUS  = 0x01,   /**< always read the value from the display */
+} DDCA_Read_Flags;
+
+/** Opaque handle for a read request prepared by #ddca_prepare_non_table_vcp_read()
+ *
+ *  @since 2.2.2
+ */
+typedef void * DDCA_Prepared_Request;
+
+/** Special time to live values for #ddca_set_feature_value_cache_ttl()
+ *  @since 2.2.2 */
+#define DDCA_CACHE_TTL_FOREVER   (-1)   /**< cached value is never reread */
+#define DDCA_CACHE_TTL_DEFAULT   (-2)   /**< use the default for the feature */
+
+
 //
 // For reporting display status changes to client
 //
@@ -573,15 +606,20 @@ typedef struct {
 //!
 //! As of ddcutil 2.2.0, events of type DDCA_EVENT_DPMS_AWAKE and
 //! DDCA_EVENT_DPMS_ASLEEP are no longer issued.
+//!
+//! DDCA_EVENT_VCP_VALUE_CHANGED, which replaces DDCA_EVENT_UNUSED2,
+//! added in 2.2.2
 typedef enum {
    DDCA_EVENT_DPMS_AWAKE,
    DDCA_EVENT_DPMS_ASLEEP,
    DDCA_EVENT_DISPLAY_CONNECTED,
    DDCA_EVENT_DISPLAY_DISCONNECTED,
    DDCA_EVENT_DDC_ENABLED,
-   DDCA_EVENT_UNUSED2,
+   DDCA_EVENT_VCP_VALUE_CHANGED,
 } DDCA_Display_Event_Type;
 
+#define DDCA_EVENT_UNUSED2 DDCA_EVENT_VCP_VALUE_CHANGED
+
 
 //! Specifies groups of Display_Status_Event_Type to watch for
 //!
@@ -614,6 +652,11 @@ typedef enum {
  *
  *  @remark
  *  Field flags with bit DDCA_DISPLAY_EVENT_DDC_WORKING added in 2.2.0
+ *
+ *  @remark
+ *  Fields vcp_feature_code and vcp_value, set for events of type
+ *  DDCA_EVENT_VCP_VALUE_CHANGED, added in 2.2.2.  They occupy what was
+ *  previously padding, so the size of the struct is unchanged.
  */
 
 #define DDCA_DISPLAY_EVENT_DDC_WORKING 0x08
@@ -625,6 +668,8 @@ typedef struct {
    char                    connector_name[32];
    DDCA_Display_Ref        dref;
    uint8_t                 flags;
+   uint8_t                 vcp_feature_code;   // DDCA_EVENT_VCP_VALUE_CHANGED
+   uint16_t                vcp_value;          // DDCA_EVENT_VCP_VALUE_CHANGED, current value (sh << 8 | sl)
    void *                  unused[1];
 } DDCA_Display_Status_Event;
 
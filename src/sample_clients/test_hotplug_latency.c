@@ -0,0 +1,370 @@
+/** @file test_hotplug_latency.c
+ *
+ *  Measures the time from a display connector change to delivery of the
+ *  corresponding DDCA_EVENT_DISPLAY_CONNECTED or DDCA_EVENT_DISPLAY_DISCONNECTED
+ *  event, without physically connecting and disconnecting a monitor.
+ *
+ *  A synthetic sysfs tree is built in a temporary directory.  It mirrors
+ *  /sys/class/drm and /sys/bus/i2c/devices using symbolic links, except that
+ *  the status, enabled, dpms, and edid attributes of the connector under test
+ *  are ordinary files.  libddcutil is pointed at the tree using environment
+ *  variable DDCUTIL_SYSFS_ROOT.  A disconnect is simulated by emptying the
+ *  edid file and setting status to "disconnected", a connect by restoring them.
+ *
+ *  In watch modes udev and drm the library waits for a kernel uevent, so
+ *  after each change a synthetic "change" uevent is requested for the video
+ *  card by writing to its uevent attribute, which requires root.  Watch mode
+ *  drm reads connector state using libdrm rather than sysfs, so changes to
+ *  the synthetic tree are not seen in that mode.
+ *
+ *  I2C communication still uses the real bus, so the connector under test
+ *  must have a monitor attached.
+ *
+ *  Usage: test_hotplug_latency [--watch-mode MODE] [--iterations N] CONNECTOR
+ *  e.g.   test_hotplug_latency --watch-mode poll card1-DP-2
+ */
+
+// Copyright (C) 2025 Sanford Rockowitz <rockowitz@minsoft.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE    // for nftw()
+#endif
+#include <dirent.h>
+#include <errno.h>
+#include <ftw.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "public/ddcutil_c_api.h"
+#include "public/ddcutil_status_codes.h"
+
+#define EVENT_TIMEOUT_SECONDS 30
+
+static const char * real_class_drm = "/sys/class/drm";
+static const char * real_bus_i2c_devices = "/sys/bus/i2c/devices";
+
+static pthread_mutex_t event_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  event_cond  = PTHREAD_COND_INITIALIZER;
+static DDCA_Display_Event_Type awaited_event_type;
+static const char *    awaited_connector;
+static uint64_t        event_received_nanos;     // 0 if awaited event not yet received
+
+
+static uint64_t cur_monotonic_nanos() {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+
+static void display_status_callback(DDCA_Display_Status_Event evt) {
+   uint64_t now = cur_monotonic_nanos();
+   pthread_mutex_lock(&event_mutex);
+   if (evt.event_type == awaited_event_type &&
+       strcmp(evt.connector_name, awaited_connector) == 0 &&
+       event_received_nanos == 0)
+   {
+      event_received_nanos = now;
+      pthread_cond_signal(&event_cond);
+   }
+   pthread_mutex_unlock(&event_mutex);
+}
+
+
+static bool write_file(const char * dir, const char * fn, const void * data, size_t len) {
+   char path[PATH_MAX];
+   snprintf(path, sizeof(path), "%s/%s", dir, fn);
+   FILE * f = fopen(path, "w");
+   if (!f) {
+      fprintf(stderr, "Unable to open %s: %s\n", path, strerror(errno));
+      return false;
+   }
+   bool ok = (fwrite(data, 1, len, f) == len);
+   fclose(f);
+   return ok;
+}
+
+
+static size_t read_file(const char * dir, const char * fn, char * buf, size_t bufsz) {
+   char path[PATH_MAX];
+   snprintf(path, sizeof(path), "%s/%s", dir, fn);
+   FILE * f = fopen(path, "r");
+   if (!f)
+      return 0;
+   size_t len = fread(buf, 1, bufsz, f);
+   fclose(f);
+   return len;
+}
+
+
+/** Replicates a directory as symbolic links to the real entries,
+ *  except for the attributes named in **copied_attrs**, which are copied.
+ */
+static bool mirror_dir(const char * real_dir, const char * fake_dir,
+                       const char * skipped_entry, const char ** copied_attrs)
+{
+   if (mkdir(fake_dir, 0755) != 0) {
+      fprintf(stderr, "Unable to create %s: %s\n", fake_dir, strerror(errno));
+      return false;
+   }
+   DIR * d = opendir(real_dir);
+   if (!d) {
+      fprintf(stderr, "Unable to open %s: %s\n", real_dir, strerror(errno));
+      return false;
+   }
+   bool ok = true;
+   struct dirent * ent;
+   while (ok && (ent = readdir(d))) {
+      if (strcmp(ent->d_name, ".") == 0 || strcmp(ent->d_name, "..") == 0)
+         continue;
+      if (skipped_entry && strcmp(ent->d_name, skipped_entry) == 0)
+         continue;
+      bool copy = false;
+      for (int ndx = 0; copied_attrs && copied_attrs[ndx]; ndx++) {
+         if (strcmp(ent->d_name, copied_attrs[ndx]) == 0)
+            copy = true;
+      }
+      char real_path[PATH_MAX];
+      char fake_path[PATH_MAX];
+      snprintf(real_path, sizeof(real_path), "%s/%s", real_dir, ent->d_name);
+      snprintf(fake_path, sizeof(fake_path), "%s/%s", fake_dir, ent->d_name);
+      if (copy) {
+         char buf[2048];
+         size_t len = read_file(real_dir, ent->d_name, buf, sizeof(buf));
+         ok = write_file(fake_dir, ent->d_name, buf, len);
+      }
+      else {
+         char * target = realpath(real_path, NULL);
+         ok = target && symlink(target, fake_path) == 0;
+         if (!ok)
+            fprintf(stderr, "Unable to link %s: %s\n", fake_path, strerror(errno));
+         free(target);
+      }
+   }
+   closedir(d);
+   return ok;
+}
+
+
+/** Builds the synthetic sysfs tree.
+ *
+ *  @param  root       root directory of the tree, already exists
+ *  @param  connector  connector under test
+ *  @return true if successful
+ */
+static bool build_sysfs_tree(const char * root, const char * connector) {
+   static const char * connector_attrs[] = {"status", "enabled", "dpms", "edid", NULL};
+   char fake_class[PATH_MAX];
+   char fake_drm[PATH_MAX];
+   char fake_connector[PATH_MAX];
+   char real_connector[PATH_MAX];
+   char fake_bus[PATH_MAX];
+   char fake_i2c[PATH_MAX];
+   char fake_i2c_devices[PATH_MAX];
+   snprintf(fake_class,       sizeof(fake_class),       "%s/class", root);
+   snprintf(fake_drm,         sizeof(fake_drm),         "%s/class/drm", root);
+   snprintf(fake_connector,   sizeof(fake_connector),   "%s/class/drm/%s", root, connector);
+   snprintf(real_connector,   sizeof(real_connector),   "%s/%s", real_class_drm, connector);
+   snprintf(fake_bus,         sizeof(fake_bus),         "%s/bus", root);
+   snprintf(fake_i2c,         sizeof(fake_i2c),         "%s/bus/i2c", root);
+   snprintf(fake_i2c_devices, sizeof(fake_i2c_devices), "%s/bus/i2c/devices", root);
+
+   bool ok = mkdir(fake_class, 0755) == 0 &&
+             mirror_dir(real_class_drm, fake_drm, connector, NULL) &&
+             mirror_dir(real_connector, fake_connector, NULL, connector_attrs) &&
+             mkdir(fake_bus, 0755) == 0 &&
+             mkdir(fake_i2c, 0755) == 0 &&
+             symlink(real_bus_i2c_devices, fake_i2c_devices) == 0;
+   return ok;
+}
+
+
+static int remove_tree_entry(const char * path, const struct stat * sb, int typeflag, struct FTW * ftwbuf) {
+   return remove(path);
+}
+
+
+/** Requests a synthetic change uevent for the card owning a connector. */
+static void trigger_uevent(const char * connector) {
+   char card[40];
+   snprintf(card, sizeof(card), "%s", connector);
+   char * p = strchr(card, '-');
+   if (p)
+      *p = '\0';
+   char dir[PATH_MAX];
+   snprintf(dir, sizeof(dir), "%s/%s", real_class_drm, card);
+   write_file(dir, "uevent", "change", 6);
+}
+
+
+/** Simulates a connector change and waits for the resulting event.
+ *
+ *  @return latency in nanoseconds, 0 if the event was not received
+ */
+static uint64_t simulate_change(const char * fake_connector, const char * connector,
+                                bool connect, const char * edid, size_t edid_len,
+                                bool use_uevent)
+{
+   pthread_mutex_lock(&event_mutex);
+   awaited_event_type = (connect) ? DDCA_EVENT_DISPLAY_CONNECTED : DDCA_EVENT_DISPLAY_DISCONNECTED;
+   awaited_connector  = connector;
+   event_received_nanos = 0;
+   pthread_mutex_unlock(&event_mutex);
+
+   uint64_t start_nanos = cur_monotonic_nanos();
+   if (connect) {
+      write_file(fake_connector, "edid", edid, edid_len);
+      write_file(fake_connector, "status", "connected\n", 10);
+   }
+   else {
+      write_file(fake_connector, "status", "disconnected\n", 13);
+      write_file(fake_connector, "edid", "", 0);
+   }
+   if (use_uevent)
+      trigger_uevent(connector);
+
+   struct timespec deadline;
+   clock_gettime(CLOCK_REALTIME, &deadline);
+   deadline.tv_sec += EVENT_TIMEOUT_SECONDS;
+   pthread_mutex_lock(&event_mutex);
+   int rc = 0;
+   while (event_received_nanos == 0 && rc != ETIMEDOUT)
+      rc = pthread_cond_timedwait(&event_cond, &event_mutex, &deadline);
+   uint64_t latency = (event_received_nanos) ? event_received_nanos - start_nanos : 0;
+   pthread_mutex_unlock(&event_mutex);
+   return latency;
+}
+
+
+typedef struct {
+   int      ct;
+   int      missed_ct;
+   uint64_t total_nanos;
+   uint64_t min_nanos;
+   uint64_t max_nanos;
+} Latency_Stats;
+
+
+static void record_latency(Latency_Stats * stats, uint64_t latency) {
+   if (latency == 0) {
+      stats->missed_ct++;
+      return;
+   }
+   if (stats->ct == 0 || latency < stats->min_nanos)
+      stats->min_nanos = latency;
+   if (latency > stats->max_nanos)
+      stats->max_nanos = latency;
+   stats->total_nanos += latency;
+   stats->ct++;
+}
+
+
+static void report_latency(const char * title, Latency_Stats * stats) {
+   if (stats->ct == 0)
+      printf("   %-12s no events received, %d timed out\n", title, stats->missed_ct);
+   else
+      printf("   %-12s min %8.1f  avg %8.1f  max %8.1f millisec, %d timed out\n", title,
+             stats->min_nanos / 1000000.0,
+             (stats->total_nanos / (double) stats->ct) / 1000000.0,
+             stats->max_nanos / 1000000.0,
+             stats->missed_ct);
+}
+
+
+int main(int argc, char** argv) {
+   const char * watch_mode = "poll";
+   int iterations = 5;
+   const char * connector = NULL;
+   bool args_ok = true;
+   for (int ndx = 1; ndx < argc; ndx++) {
+      if (strcmp(argv[ndx], "--watch-mode") == 0 && ndx+1 < argc)
+         watch_mode = argv[++ndx];
+      else if (strcmp(argv[ndx], "--iterations") == 0 && ndx+1 < argc)
+         iterations = atoi(argv[++ndx]);
+      else if (!connector && argv[ndx][0] != '-')
+         connector = argv[ndx];
+      else
+         args_ok = false;
+   }
+   if (!args_ok || !connector || iterations < 1) {
+      fprintf(stderr, "Usage: %s [--watch-mode MODE] [--iterations N] CONNECTOR\n", argv[0]);
+      return 1;
+   }
+
+   char edid[2048];
+   size_t edid_len;
+   {
+      char real_connector[PATH_MAX];
+      snprintf(real_connector, sizeof(real_connector), "%s/%s", real_class_drm, connector);
+      edid_len = read_file(real_connector, "edid", edid, sizeof(edid));
+   }
+   if (edid_len < 128) {
+      fprintf(stderr, "No monitor with an EDID found on connector %s\n", connector);
+      return 1;
+   }
+
+   char root[] = "/tmp/ddcutil-sysfs-XXXXXX";
+   if (!mkdtemp(root)) {
+      perror("mkdtemp() failed");
+      return 1;
+   }
+   int result = 1;
+   if (!build_sysfs_tree(root, connector))
+      goto bye;
+   char fake_connector[PATH_MAX];
+   snprintf(fake_connector, sizeof(fake_connector), "%s/class/drm/%s", root, connector);
+   setenv("DDCUTIL_SYSFS_ROOT", root, 1);
+
+   char libopts[100];
+   snprintf(libopts, sizeof(libopts), "--watch-mode %s", watch_mode);
+   DDCA_Status rc = ddca_init2(libopts, DDCA_SYSLOG_NOTICE, DDCA_INIT_OPTIONS_DISABLE_CONFIG_FILE, NULL);
+   if (rc != 0) {
+      printf("ddca_init2() returned %s\n", ddca_rc_name(rc));
+      goto bye;
+   }
+   DDCA_Display_Ref * drefs;
+   ddca_get_display_refs(false, &drefs);    // perform initial display detection
+   ddca_register_display_status_callback(display_status_callback);
+   rc = ddca_start_watch_displays(DDCA_EVENT_CLASS_DISPLAY_CONNECTION);
+   if (rc != 0) {
+      printf("ddca_start_watch_displays() returned %s\n", ddca_rc_name(rc));
+      goto bye;
+   }
+
+   bool use_uevent = strcmp(watch_mode, "udev") == 0 || strcmp(watch_mode, "drm") == 0;
+   if (use_uevent && geteuid() != 0)
+      printf("Synthetic uevents require root.  Events may not be detected.\n");
+
+   Latency_Stats disconnect_stats = {0};
+   Latency_Stats connect_stats = {0};
+   for (int ndx = 0; ndx < iterations; ndx++) {
+      uint64_t latency = simulate_change(fake_connector, connector, false, edid, edid_len, use_uevent);
+      record_latency(&disconnect_stats, latency);
+      printf("Iteration %d: disconnect %8.1f millisec", ndx+1, latency / 1000000.0);
+      latency = simulate_change(fake_connector, connector, true, edid, edid_len, use_uevent);
+      record_latency(&connect_stats, latency);
+      printf(", connect %8.1f millisec\n", latency / 1000000.0);
+   }
+
+   printf("\nEvent latency, watch mode %s, %d iterations:\n", watch_mode, iterations);
+   report_latency("Disconnect:", &disconnect_stats);
+   report_latency("Connect:",    &connect_stats);
+   printf("\n");
+   ddca_show_stats(DDCA_STATS_CALLS, false, 0);
+
+   ddca_stop_watch_displays(true);
+   result = (disconnect_stats.missed_ct + connect_stats.missed_ct == 0) ? 0 : 1;
+
+bye:
+   nftw(root, remove_tree_entry, 20, FTW_DEPTH | FTW_PHYS);
+   return result;
+}
@@ -0,0 +1,95 @@
+/** @file test_prepared_read.c
+ *
+ *  Checks that a prepared read cannot be executed once the display handle
+ *  it was prepared for has been closed, including after the display is
+ *  reopened and the new handle may occupy the same memory as the old one.
+ *
+ *  Requires a display that supports DDC/CI.  The first such display is used.
+ *
+ *  Usage: test_prepared_read
+ *  Exit status is 0 if all checks pass or no display is found, 1 otherwise.
+ */
+
+// Copyright (C) 2025 Sanford Rockowitz <rockowitz@minsoft.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "public/ddcutil_c_api.h"
+#include "public/ddcutil_status_codes.h"
+
+#define FEATURE_CODE 0x10     // brightness
+
+
+static bool check_rc(const char * what, DDCA_Status rc, DDCA_Status expected) {
+   bool ok = (rc == expected);
+   printf("%-50s returned %-12s expected %-12s %s\n",
+          what, ddca_rc_name(rc), ddca_rc_name(expected), (ok) ? "OK" : "FAILED");
+   return ok;
+}
+
+
+int main(int argc, char** argv) {
+   DDCA_Status rc = ddca_init2(NULL, DDCA_SYSLOG_NOTICE, DDCA_INIT_OPTIONS_DISABLE_CONFIG_FILE, NULL);
+   if (rc != 0) {
+      printf("ddca_init2() returned %s\n", ddca_rc_name(rc));
+      return 1;
+   }
+
+   DDCA_Display_Info_List * dlist = NULL;
+   ddca_get_display_info_list2(false, &dlist);
+   if (dlist->ct == 0) {
+      printf("No display found, test skipped\n");
+      ddca_free_display_info_list(dlist);
+      return 0;
+   }
+   DDCA_Display_Ref dref = dlist->info[0].dref;
+
+   bool ok = true;
+   DDCA_Display_Handle dh = NULL;
+   DDCA_Prepared_Request request = NULL;
+   DDCA_Non_Table_Vcp_Value valrec;
+
+   rc = ddca_open_display2(dref, true, &dh);
+   if (!check_rc("ddca_open_display2()", rc, DDCRC_OK)) {
+      ok = false;
+      goto bye;
+   }
+   rc = ddca_prepare_non_table_vcp_read(dh, FEATURE_CODE, &request);
+   if (!check_rc("ddca_prepare_non_table_vcp_read()", rc, DDCRC_OK)) {
+      ok = false;
+      ddca_close_display(dh);
+      goto bye;
+   }
+   rc = ddca_execute_prepared_read(request, &valrec);
+   ok &= check_rc("ddca_execute_prepared_read() while open", rc, DDCRC_OK);
+
+   rc = ddca_close_display(dh);
+   ok &= check_rc("ddca_close_display()", rc, DDCRC_OK);
+
+   rc = ddca_execute_prepared_read(request, &valrec);
+   ok &= check_rc("ddca_execute_prepared_read() after close", rc, DDCRC_ARG);
+
+   // the new handle may be allocated at the address of the closed one
+   DDCA_Display_Handle dh2 = NULL;
+   rc = ddca_open_display2(dref, true, &dh2);
+   if (check_rc("ddca_open_display2() again", rc, DDCRC_OK)) {
+      if (dh2 == dh)
+         printf("New display handle reuses address of closed handle\n");
+      rc = ddca_execute_prepared_read(request, &valrec);
+      ok &= check_rc("ddca_execute_prepared_read() after reopen", rc, DDCRC_ARG);
+      ddca_close_display(dh2);
+   }
+   else {
+      ok = false;
+   }
+
+   ddca_free_prepared_request(request);
+
+bye:
+   ddca_free_display_info_list(dlist);
+   printf("%s\n", (ok) ? "All checks passed" : "Some checks FAILED");
+   return (ok) ? 0 : 1;
+}
@@ -12,6 +12,7 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <glib-2.0/glib.h>
+#include <limits.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -47,6 +48,51 @@
 
 static const DDCA_Trace_Group  TRACE_GROUP = DDCA_TRC_SYSFS;
 
+
+//
+// Root of the sysfs tree
+//
+
+// Normally SYS.  Can be changed, using environment variable DDCUTIL_SYSFS_ROOT,
+// to point to a synthetic tree of DRM connector and I2C device directories,
+// so that display hotplug handling can be exercised without real monitors.
+char * sysfs_root            = SYS;
+char * sysfs_class_drm       = SYS"/class/drm";
+char * sysfs_bus_i2c_devices = SYS"/bus/i2c/devices";
+static bool sysfs_root_overridden = false;
+
+
+/** Sets the directory used in place of /sys when reading DRM connector
+ *  and I2C device attributes.
+ *
+ *  @param root  directory name, NULL to restore the default
+ */
+void set_sysfs_root(const char * root) {
+   bool debug = false;
+   DBGTRC_STARTING(debug, TRACE_GROUP, "root=%s", root);
+
+   if (sysfs_root_overridden) {
+      free(sysfs_root);
+      free(sysfs_class_drm);
+      free(sysfs_bus_i2c_devices);
+   }
+   if (root && strlen(root) > 0 && !streq(root, SYS)) {
+      sysfs_root            = g_strdup(root);
+      sysfs_class_drm       = g_strdup_printf("%s/class/drm", root);
+      sysfs_bus_i2c_devices = g_strdup_printf("%s/bus/i2c/devices", root);
+      sysfs_root_overridden = true;
+   }
+   else {
+      sysfs_root            = SYS;
+      sysfs_class_drm       = SYS"/class/drm";
+      sysfs_bus_i2c_devices = SYS"/bus/i2c/devices";
+      sysfs_root_overridden = false;
+   }
+
+   DBGTRC_DONE(debug, TRACE_GROUP, "sysfs_class_drm=%s", sysfs_class_drm);
+}
+
+
 //
 // Predicate Functions
 //
@@ -377,7 +423,7 @@ void dbgrpt_sysfs_basic_connector_attributes(int depth) {
    DBGTRC_STARTING(debug, TRACE_GROUP, "");
    int d0 = depth;
    rpt_nl();
-   char * dname = "/sys/class/drm";
+   char * dname = sysfs_class_drm;
 
    rpt_vstring(d0, "*** Examining %s for card-connector dirs that appear to be connected ***", dname);
    dir_filtered_ordered_foreach(
@@ -482,7 +528,7 @@ char * get_sys_drm_connector_name_by_connector_id(int connector_id) {
    accum.connector_name = NULL;
 
    dir_foreach_terminatable(
-         "/sys/class/drm",
+         sysfs_class_drm,
          predicate_cardN_connector,       // filter function
          check_connector_id,
          &accum,
@@ -509,7 +555,7 @@ char * get_sys_drm_connector_name_by_busno(int busno) {
    accum.connector_name = NULL;
 
    dir_foreach_terminatable(
-         "/sys/class/drm",
+         sysfs_class_drm,
          predicate_cardN_connector,       // filter function
          check_busno,
          &accum,
@@ -571,7 +617,7 @@ bool all_sys_drm_connectors_have_connector_id_direct() {
    Check_Connector_Id_Present_Accumulator accum;
    accum.all_connectors_have_connector_id = true;
    dir_foreach_terminatable(
-         "/sys/class/drm",
+         sysfs_class_drm,
          predicate_cardN_connector,       // filter function
          check_connector_id_present,
          &accum,
@@ -647,7 +693,7 @@ find_adapter_and_get_driver(char * path, int depth) {
  */
 char * get_driver_for_busno(int busno) {
    char path[PATH_MAX];
-   g_snprintf(path, PATH_MAX, "/sys/bus/i2c/devices/i2c-%d", busno);
+   g_snprintf(path, PATH_MAX, "%s/i2c-%d", sysfs_bus_i2c_devices, busno);
    char * result = find_adapter_and_get_driver(path, -1);
    return result;
 }
@@ -668,8 +714,8 @@ void possibly_write_detect_to_status(const char * driver, const char * connector
    bool do_driver = streq(driver, "nvidia");
    if (enable_write_detect_to_status && do_driver && connector) {
       DBGTRC_NOPREFIX(debug, DDCA_TRC_NONE, "Writing detect to status");
-      char path[50];
-      g_snprintf(path, 50, "/sys/class/drm/%s/status", connector);
+      char path[PATH_MAX];
+      g_snprintf(path, PATH_MAX, "%s/%s/status", sysfs_class_drm, connector);
       FILE * f = fopen(path, "w");
       if (f) {
          fputs("detect", f);
@@ -703,8 +749,8 @@ void possibly_write_detect_to_status_by_connector_name(const char * connector) {
    bool debug = false;
    int d = (debug) ? 1 : -1;
    if (enable_write_detect_to_status) {
-      char path[50];
-      g_snprintf(path, 50, "/sys/class/drm/%s", connector);
+      char path[PATH_MAX];
+      g_snprintf(path, PATH_MAX, "%s/%s", sysfs_class_drm, connector);
       char * driver = find_adapter_and_get_driver(path, d);
       if (driver) {
          possibly_write_detect_to_status(driver, connector);
@@ -807,7 +853,7 @@ bool sysfs_connector_directories_exist() {
    DBGTRC_STARTING(debug, TRACE_GROUP, "executed = %s", sbool(executed));
 
    if (!executed) {
-      char * dirname = SYS"/class/drm";
+      char * dirname = sysfs_class_drm;
       Found_Accumulator accumulator;
       accumulator.found = false;
       dir_foreach_terminatable(
@@ -834,7 +880,7 @@ bool sysfs_connector_directories_exist() {
  */
 Sysfs_Connector_Names get_sysfs_drm_connector_names() {
    bool debug = false;
-   const char * dname = SYS"/class/drm";
+   const char * dname = sysfs_class_drm;
    DBGTRC_STARTING(debug, TRACE_GROUP, "Examining %s", dname);
 
    Sysfs_Connector_Names connector_names = {NULL, NULL};
@@ -943,7 +989,7 @@ char * find_sysfs_drm_connector_name_by_edid(GPtrArray* connector_names, Byte *
       GByteArray * sysfs_edid;
       int depth = (debug) ? 1 : -1;
       possibly_write_detect_to_status_by_connector_name(connector_name);
-      RPT_ATTR_EDID(depth, &sysfs_edid, "/sys/class/drm", connector_name, "edid");
+      RPT_ATTR_EDID(depth, &sysfs_edid, sysfs_class_drm, connector_name, "edid");
       if (sysfs_edid) {
          if (sysfs_edid->len >= 128 && memcmp(sysfs_edid->data, edid, 128) == 0)
             result = g_strdup(connector_name);
@@ -1053,7 +1099,7 @@ void check_sysfs_reliability() {
    Sysfs_Reliability_Accumulator * accum = calloc(1, sizeof(Sysfs_Reliability_Accumulator));
    int depth=0;
    dir_foreach(
-         "/sys/class/drm",
+         sysfs_class_drm,
          predicate_cardN_connector,       // filter function
          check_connector_reliability,
          accum,
@@ -1174,8 +1220,8 @@ bool is_sysfs_reliable() {
 char *
 get_i2c_device_sysfs_name(int busno)
 {
-   char workbuf[50];
-   snprintf(workbuf, 50, "/sys/bus/i2c/devices/i2c-%d/name", busno);
+   char workbuf[PATH_MAX];
+   snprintf(workbuf, PATH_MAX, "%s/i2c-%d/name", sysfs_bus_i2c_devices, busno);
    char * name = file_get_first_line(workbuf, /*verbose */ false);
    // DBGMSG("busno=%d, returning: %s", busno, bool_repr(result));
    return name;
@@ -1288,7 +1334,7 @@ get_i2c_sysfs_driver_by_busno(int busno) {
    int depth = (debug) ? 2 : -1;
 
    char * driver_name = NULL;
-   char workbuf[100];
+   char workbuf[PATH_MAX];
 #ifdef FAILS_FOR_NVIDIA
    snprintf(workbuf, 100, "/sys/bus/i2c/devices/i2c-%d/device/driver/module", busno);
    DBGF(debug, "workbuf(1) = %s", workbuf);
@@ -1299,7 +1345,7 @@ get_i2c_sysfs_driver_by_busno(int busno) {
       driver_name = get_rpath_basename(workbuf);
    }
 #endif
-   snprintf(workbuf, 100, "/sys/bus/i2c/devices/i2c-%d", busno);
+   snprintf(workbuf, PATH_MAX, "%s/i2c-%d", sysfs_bus_i2c_devices, busno);
    DBGF(debug, "workbuf(3) = %s", workbuf);
    char * adapter_path  = sysfs_find_adapter(workbuf);
    if (adapter_path) {
@@ -1382,12 +1428,12 @@ get_i2c_device_sysfs_class(int busno) {
    DBGTRC_STARTING(debug, TRACE_GROUP, "busno=%d");
 
    uint32_t result = 0;
-   char workbuf[100];
-   snprintf(workbuf, 100, "/sys/bus/i2c/devices/i2c-%d/device", busno);
+   char workbuf[PATH_MAX];
+   snprintf(workbuf, PATH_MAX, "%s/i2c-%d/device", sysfs_bus_i2c_devices, busno);
 
    char * s_class = read_sysfs_attr(workbuf, "class", /*verbose*/ false);
    if (!s_class) {
-     snprintf(workbuf, 100, "/sys/bus/i2c/devices/i2c-%d/device/device/device", busno);
+     snprintf(workbuf, PATH_MAX, "%s/i2c-%d/device/device/device", sysfs_bus_i2c_devices, busno);
      s_class = read_sysfs_attr(workbuf, "class", /*verbose*/ false);
    }
    if (s_class) {
@@ -1483,7 +1529,7 @@ int search_all_businfo_records_by_connector_name(char *connector_name) {
    // int busno = conn->i2c_busno;
    // free(conn);
    Connector_Bus_Numbers *cbn = calloc(1, sizeof(Connector_Bus_Numbers));
-   get_connector_bus_numbers("/sys/class/drm", connector_name, cbn);
+   get_connector_bus_numbers(sysfs_class_drm, connector_name, cbn);
    int busno = cbn->i2c_busno;
    free_connector_bus_numbers(cbn);
    if (busno < 0) {
@@ -1508,6 +1554,7 @@ int search_all_businfo_records_by_connector_name(char *connector_name) {
 
 /** Module initialization */
 void init_i2c_sysfs_base() {
+   RTTI_ADD_FUNC(set_sysfs_root);
    RTTI_ADD_FUNC(possibly_write_detect_to_status);
    RTTI_ADD_FUNC(sysfs_find_adapter);
    RTTI_ADD_FUNC(get_i2c_sysfs_driver_by_busno);
@@ -1526,4 +1573,11 @@ void init_i2c_sysfs_base() {
 #ifdef UNUSED
    RTTI_ADD_FUNC(get_sys_video_devices);
 #endif
+
+   char * root = getenv("DDCUTIL_SYSFS_ROOT");
+   if (root && strlen(root) > 0) {
+      set_sysfs_root(root);
+      SYSLOG2(DDCA_SYSLOG_NOTICE, "Using %s in place of %s for DRM connector and I2C device attributes",
+                                  sysfs_root, SYS);
+   }
 }
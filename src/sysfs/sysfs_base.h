@@ -17,6 +17,11 @@ extern bool force_sysfs_unreliable;
 extern bool force_sysfs_reliable;
 extern bool enable_write_detect_to_status;
 
+extern char * sysfs_root;
+extern char * sysfs_class_drm;
+extern char * sysfs_bus_i2c_devices;
+void        set_sysfs_root(const char * root);
+
 // predicate functions
 // typedef Dir_Filter_Func
 bool        is_n_nnnn(const char * dirname, const char * simple_fn);
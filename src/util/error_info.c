@@ -636,31 +636,31 @@ default_status_code_desc(int rc) {
 }
 
 
-/** Appends a comma separated string of the status code names of the
- *  causes in an array of #Error_Info to an existing string.
+/** Appends a comma separated string of the names of an array of status
+ *  codes to an existing string.
  *  Multiple consecutive identical names are replaced with a
  *  single name and a parenthesized instance count.
  *
- *  \param  erec     pointer to array of pointers to #Error_Info instances
- *  \param  error_ct number of errors
- *  \return modified comma separated string
+ *  \param  status_codes  array of status codes
+ *  \param  ct            number of status codes
+ *  \param  gs            append result here
+ *  \return modified string
  */
 static GString *
-errinfo_array_summary_gs(
-      struct error_info **  errors,    ///<  pointer to array of pointers to #Error_Info
-      int                   error_ct,  ///<  number of causal errors
-      GString *             gs)        ///<  append result here
+status_code_array_summary_gs(
+      int *      status_codes,
+      int        ct,
+      GString *  gs)
 {
    bool first = true;
 
    int ndx = 0;
-   while (ndx < error_ct) {
-      // printf("(%s) this error = %p\n", __func__, errors[ndx]);
-      int this_psc = errors[ndx]->status_code;
+   while (ndx < ct) {
+      int this_psc = status_codes[ndx];
       int cur_ct = 1;
 
-      for (int i = ndx+1; i < error_ct; i++) {
-         if (errors[i]->status_code != this_psc)
+      for (int i = ndx+1; i < ct; i++) {
+         if (status_codes[i] != this_psc)
             break;
          cur_ct++;
       }
@@ -686,6 +686,30 @@ errinfo_array_summary_gs(
 }
 
 
+/** Appends a comma separated string of the status code names of the
+ *  causes in an array of #Error_Info to an existing string.
+ *  Multiple consecutive identical names are replaced with a
+ *  single name and a parenthesized instance count.
+ *
+ *  \param  erec     pointer to array of pointers to #Error_Info instances
+ *  \param  error_ct number of errors
+ *  \return modified comma separated string
+ */
+static GString *
+errinfo_array_summary_gs(
+      struct error_info **  errors,    ///<  pointer to array of pointers to #Error_Info
+      int                   error_ct,  ///<  number of causal errors
+      GString *             gs)        ///<  append result here
+{
+   int * status_codes = g_new(int, error_ct+1);
+   for (int ndx = 0; ndx < error_ct; ndx++)
+      status_codes[ndx] = errors[ndx]->status_code;
+   status_code_array_summary_gs(status_codes, error_ct, gs);
+   g_free(status_codes);
+   return gs;
+}
+
+
 /** Returns a comma separated string of the status code names of the
  *  causes in an array of #Error_Info.
  *  Multiple consecutive identical names are replaced with a
@@ -711,6 +735,30 @@ errinfo_array_summary(
 }
 
 
+/** Returns a comma separated string of the names of an array of status codes.
+ *  Multiple consecutive identical names are replaced with a
+ *  single name and a parenthesized instance count.
+ *
+ *  Allows callers that track failures as plain status codes to
+ *  produce the same summary as #errinfo_array_summary().
+ *
+ *  \param  status_codes  array of status codes
+ *  \param  ct            number of status codes
+ *  \return comma separated string, caller is responsible for freeing
+ */
+char *
+errinfo_status_array_summary(
+      int *  status_codes,
+      int    ct)
+{
+   GString * gs = g_string_new(NULL);
+   status_code_array_summary_gs(status_codes, ct, gs);
+   char * result = gs->str;
+   g_string_free(gs, false);
+   return result;
+}
+
+
 /** Returns a comma separated string of the names of the status codes in the
  *  causes of the specified #Error_Info.
  *  Multiple consecutive identical names are replaced with a
@@ -134,6 +134,10 @@ char * errinfo_array_summary(
       Error_Info **  errors,
       int            error_ct);
 
+char * errinfo_status_array_summary(
+      int *          status_codes,
+      int            ct);
+
 char * errinfo_causes_string(
       Error_Info *   erec);
 
@@ -94,6 +94,22 @@ uint64_t cur_realtime_nanosec() {
 }
 
 
+/** Returns the current value of the monotonic clock in nanoseconds.
+ *
+ *  Unlike #cur_realtime_nanosec(), the value is not affected by changes
+ *  to the system time, so is suitable for measuring intervals.
+ *
+ *  @return timestamp, in nanoseconds
+ */
+uint64_t cur_monotonic_nanosec() {
+   struct timespec tvNow;
+   clock_gettime(CLOCK_MONOTONIC, &tvNow);
+   uint64_t result = tvNow.tv_sec * (uint64_t)(1000*1000*1000);
+   result += tvNow.tv_nsec;     // must do addition separately on 32 bit
+   return result;
+}
+
+
 /** Reports history of generated timestamps
  *
  * @remark
@@ -21,6 +21,7 @@ extern "C" {
 // Timestamp Generation
 //
 uint64_t cur_realtime_nanosec();   // Returns the current value of the realtime clock in nanoseconds
+uint64_t cur_monotonic_nanosec();  // Returns the current value of the monotonic clock in nanoseconds
 void     show_timestamp_history(); // For debugging
 uint64_t elapsed_time_nanosec();   // nanoseconds since start of program, first call initializes
 char *   formatted_elapsed_time_t(guint precision); // printable elapsed time